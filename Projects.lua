@@ -19,3 +19,7 @@ group ""
 include "XYZEngine"
 include "XYZEditor"	
 include "XYZScriptCore"
+
+group "Tests"
+		include "XYZTests"
+group ""
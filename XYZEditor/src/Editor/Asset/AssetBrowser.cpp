@@ -9,6 +9,7 @@
 #include "XYZ/Asset/AssimpModelImporter.h"
 #include "XYZ/Scene/Scene.h"
 #include "XYZ/Scene/SceneSerializer.h"
+#include "XYZ/Scene/SceneBinarySerializer.h"
 #include "XYZ/Renderer/Font.h"
 #include "XYZ/ImGui/ImGui.h"
 #include "XYZ/Debug/Profiler.h"
@@ -142,7 +143,11 @@ namespace XYZ {
 				});
 			m_FileManager.RegisterExtension(Asset::GetExtension(AssetType::Scene), {
 				EditorLayer::GetData().IconsTexture,
-				EditorLayer::GetData().IconsSpriteSheet->GetTexCoords(ED::SceneIcon)
+				EditorLayer::GetData().IconsSpriteSheet->GetTexCoords(ED::SceneIcon),
+				nullptr, // Hover
+				nullptr, // Left click
+				nullptr, // Double left click
+				[&](const std::filesystem::path& path) -> bool { return assetRightClickMenuScene(path); } // Right click
 				});
 		}
 
@@ -435,5 +440,36 @@ namespace XYZ {
 			}
 			return result;
 		}
+		bool AssetBrowser::assetRightClickMenuScene(const std::filesystem::path& path)
+		{
+			if (ImGui::IsMouseClicked(ImGuiMouseButton_Right) && ImGui::IsWindowHovered())
+			{
+				ImGui::OpenPopup("RightClickMenu");
+			}
+			bool result = false;
+			if (ImGui::BeginPopup("RightClickMenu"))
+			{
+				// Saving through asset manager keeps format of file
+				const std::string scenePath = path.string();
+				const bool binary = SceneBinarySerializer::IsBinaryScene(scenePath);
+				if (ImGui::MenuItem(binary ? "Convert To Text" : "Convert To Binary"))
+				{
+					Ref<Scene> scene = AssetManager::GetAsset<Scene>(path);
+					if (binary)
+					{
+						SceneSerializer serializer;
+						serializer.Serialize(scenePath, scene);
+					}
+					else
+					{
+						SceneBinarySerializer serializer;
+						serializer.Serialize(scenePath, scene);
+					}
+					result = true;
+				}
+				ImGui::EndPopup();
+			}
+			return result;
+		}
 	}
 }
\ No newline at end of file
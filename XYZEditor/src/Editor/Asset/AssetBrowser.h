@@ -39,6 +39,7 @@ namespace XYZ {
 			bool assetRightClickMenuMESH(const std::filesystem::path& path);
 			bool assetRightClickMenuANIMMESH(const std::filesystem::path& path);
 			bool assetRightClickMenuTextureSource(const std::filesystem::path& path);
+			bool assetRightClickMenuScene(const std::filesystem::path& path);
 
 			template <typename T, typename ...Args>
 			static Ref<T> assetRightClickMenu(const std::filesystem::path& path, const std::string& assetName, const char* menuName, Args&& ...args);
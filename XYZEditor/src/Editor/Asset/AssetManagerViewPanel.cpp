@@ -25,9 +25,28 @@ namespace XYZ {
 		{
 			if (ImGui::Begin("Asset View", &open))
 			{
-				MemoryPoolView view(AssetManager::GetMemoryPool());
+				MemoryPoolView view(AssetManager::GetAllocator());
 				view.OnImGuiRender();
 				
+				if (UI::BeginTreeNode("Streaming"))
+				{
+					const AssetStreamStatistics stats = AssetManager::GetStreamer().GetStatistics();
+					const std::string memory = Utils::BytesToString(stats.BytesInFlight) + " / " + Utils::BytesToString(stats.MemoryBudget);
+					if (ImGui::BeginTable("##StreamingTable", 2, ImGuiTableFlags_SizingFixedFit))
+					{
+						UI::TextTableRow("%s", "Queued:", "%u", stats.QueuedRequests);
+						UI::TextTableRow("%s", "Decoding:", "%u", stats.DecodingRequests);
+						UI::TextTableRow("%s", "Memory:", "%s", memory.c_str());
+						UI::TextTableRow("%s", "Completed:", "%u", stats.CompletedRequests);
+						UI::TextTableRow("%s", "Cancelled:", "%u", stats.CancelledRequests);
+						UI::TextTableRow("%s", "Failed:", "%u", stats.FailedRequests);
+						UI::TextTableRow("%s", "Coalesced:", "%u", stats.CoalescedRequests);
+						UI::TextTableRow("%s", "Average Latency:", "%.3f ms", stats.AverageLatency);
+						UI::TextTableRow("%s", "Max Latency:", "%.3f ms", stats.MaxLatency);
+						ImGui::EndTable();
+					}
+					UI::EndTreeNode();
+				}
 				if (UI::BeginTreeNode("Asset Metadata"))
 				{
 					static char searchBuffer[_MAX_PATH];
@@ -79,7 +98,7 @@ namespace XYZ {
 
 		void AssetManagerViewPanel::displayAllMetadata()
 		{
-			for (const auto& [handle, metadata] : AssetManager::Get().m_Registry)
+			for (const AssetMetadata& metadata : AssetManager::Get().m_Registry)
 			{
 				std::string handle = metadata.Handle.ToString();
 				std::string filePath = metadata.FilePath.string();
@@ -114,7 +133,7 @@ namespace XYZ {
 
 		void AssetManagerViewPanel::displaySearchedMetadata(const std::string& searchString)
 		{
-			for (const auto &[handle, metadata] : AssetManager::Get().m_Registry)
+			for (const AssetMetadata& metadata : AssetManager::Get().m_Registry)
 			{
 				std::string handle = metadata.Handle.ToString();
 				std::string filePath = metadata.FilePath.string();
@@ -35,6 +35,7 @@ namespace XYZ {
 				{
 					component.Playing = playing;
 				}
+				ImGui::Checkbox("Update Bone Entities", &component.UpdateBoneEntities);
 			});
 		}
 		void AnimationComponentInspector::SetSceneEntity(const SceneEntity& entity)
@@ -7,27 +7,45 @@ namespace XYZ {
 	namespace Editor {
 		MemoryPoolView::MemoryPoolView(const MemoryPool& pool)
 			:
-			m_Pool(pool)
+			m_Pool(&pool)
+		{
+		}
+		MemoryPoolView::MemoryPoolView(const SlabAllocator& allocator)
+			:
+			m_Allocator(&allocator)
 		{
 		}
 		void MemoryPoolView::OnImGuiRender()
 		{	
 			XYZ_ASSERT(ImGui::GetCurrentWindow(), "ImGui must have active window");
+			if (m_Pool)
+				drawPool(*m_Pool);
+			else
+				drawAllocator(*m_Allocator);
+		}
+
+		template <typename Pool>
+		void MemoryPoolView::drawStats(const Pool& pool)
+		{
 			if (ImGui::BeginTable("##MemoryStats", 2, ImGuiTableFlags_SizingFixedFit))
 			{
-				UI::TextTableRow("%s", "Block Size: ", "%u", m_Pool.GetBlockSize());
-				UI::TextTableRow("%s", "Block Count: ", "%u", m_Pool.GetNumBlocks());
-				UI::TextTableRow("%s", "Memory Used: ", "%u", m_Pool.GetMemoryUsed());
-				UI::TextTableRow("%s", "Allocation Count: ", "%u", m_Pool.GetNumAllocations());
+				UI::TextTableRow("%s", "Block Size: ", "%u", pool.GetBlockSize());
+				UI::TextTableRow("%s", "Block Count: ", "%u", pool.GetNumBlocks());
+				UI::TextTableRow("%s", "Memory Used: ", "%u", pool.GetMemoryUsed());
+				UI::TextTableRow("%s", "Allocation Count: ", "%u", pool.GetNumAllocations());
 
 				ImGui::EndTable();
 			}
-			
+		}
+
+		void MemoryPoolView::drawPool(const MemoryPool& pool)
+		{
+			drawStats(pool);
 			if (UI::BeginTreeNode("Allocations"))
 			{
 				if (ImGui::BeginTable("##AllocNames", 2, ImGuiTableFlags_SizingFixedFit))
 				{
-					const auto& allocations = m_Pool.GetAllocations();
+					const auto& allocations = pool.GetAllocations();
 					for (int32_t i = 0; i < allocations.Range(); ++i)
 					{
 						if (allocations.Valid(i))
@@ -41,7 +59,7 @@ namespace XYZ {
 			{
 				if (ImGui::BeginTable("##FreeChunks", 3, ImGuiTableFlags_SizingFixedFit))
 				{
-					const auto& freeChunks = m_Pool.GetFreeChunks();
+					const auto& freeChunks = pool.GetFreeChunks();
 					for (const auto& chunk : freeChunks)
 					{
 						// TODO:
@@ -52,5 +70,33 @@ namespace XYZ {
 				UI::EndTreeNode();
 			}		
 		}
+
+		void MemoryPoolView::drawAllocator(const SlabAllocator& allocator)
+		{
+			drawStats(allocator);
+			if (UI::BeginTreeNode("Size Classes"))
+			{
+				if (ImGui::BeginTable("##SizeClasses", 3, ImGuiTableFlags_SizingFixedFit))
+				{
+					ImGui::TableSetupColumn("Block Size");
+					ImGui::TableSetupColumn("Slabs");
+					ImGui::TableSetupColumn("Used Blocks");
+					ImGui::TableHeadersRow();
+
+					const auto stats = allocator.GetSizeClassStats();
+					for (size_t i = 0; i < stats.size(); ++i)
+					{
+						if (stats[i].NumSlabs == 0)
+							continue;
+
+						// Last entry holds dedicated slabs of big allocations
+						const char* format = i + 1 == stats.size() ? "> %u" : "%u";
+						UI::TextTableRow(format, stats[i].BlockSize, "%u", stats[i].NumSlabs, "%u", stats[i].UsedBlocks);
+					}
+					ImGui::EndTable();
+				}
+				UI::EndTreeNode();
+			}
+		}
 	}
-}
\ No newline at end of file
+}
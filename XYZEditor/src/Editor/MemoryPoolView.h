@@ -1,5 +1,6 @@
 #pragma once
 #include "XYZ/Utils/DataStructures/MemoryPool.h"
+#include "XYZ/Utils/DataStructures/SlabAllocator.h"
 
 namespace XYZ {
 	namespace Editor {
@@ -7,11 +8,20 @@ namespace XYZ {
 		{
 		public:
 			MemoryPoolView(const MemoryPool& pool);
+			MemoryPoolView(const SlabAllocator& allocator);
 
 			void OnImGuiRender();
 
 		private:
-			const MemoryPool& m_Pool;
+			template <typename Pool>
+			void drawStats(const Pool& pool);
+
+			void drawPool(const MemoryPool& pool);
+			void drawAllocator(const SlabAllocator& allocator);
+
+		private:
+			const MemoryPool*	 m_Pool = nullptr;
+			const SlabAllocator* m_Allocator = nullptr;
 		};
 	}
 }
\ No newline at end of file
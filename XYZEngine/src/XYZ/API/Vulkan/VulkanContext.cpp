@@ -3,6 +3,7 @@
 
 #include "VulkanValidation.h"
 #include "VulkanAllocator.h"
+#include "VulkanPipelineCache.h"
 
 #include "XYZ/Core/Application.h"
 
@@ -28,7 +29,6 @@ namespace XYZ {
 	VulkanContext::VulkanContext()
 		:
 		m_DebugReportCallback(VK_NULL_HANDLE),
-		m_PipelineCache(VK_NULL_HANDLE),
 		m_WindowHandle(nullptr)
 	{
 	}
@@ -96,11 +96,13 @@ namespace XYZ {
 		m_SwapChain.Init(s_VulkanInstance, m_Device);
 		m_SwapChain.InitSurface(m_WindowHandle);
 		VulkanAllocator::Init(m_Device);
+		VulkanPipelineCache::Init(m_Device);
 	}
 
 	void VulkanContext::Shutdown()
 	{
 		VK_CHECK_RESULT(vkDeviceWaitIdle(m_Device->GetVulkanDevice()));
+		VulkanPipelineCache::Shutdown(m_Device);
 		VulkanAllocator::Shutdown();
 		m_SwapChain.Destroy();
 		m_Device->Destroy();
@@ -36,7 +36,6 @@ namespace XYZ {
 		GLFWwindow*				  m_WindowHandle;
 
 		VkDebugReportCallbackEXT  m_DebugReportCallback;
-		VkPipelineCache			  m_PipelineCache;
 		VulkanSwapChain			  m_SwapChain;
 
 		inline static VkInstance s_VulkanInstance;
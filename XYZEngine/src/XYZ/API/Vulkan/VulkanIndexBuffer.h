@@ -1,6 +1,7 @@
 #pragma once
 #include "XYZ/Renderer/Buffer.h"
 #include "XYZ/Utils/DataStructures/ByteBuffer.h"
+#include "XYZ/Utils/DataStructures/ThreadQueue.h"
 #include "VulkanAllocator.h"
 
 namespace XYZ {
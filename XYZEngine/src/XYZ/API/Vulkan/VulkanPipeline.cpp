@@ -3,6 +3,9 @@
 
 #include "VulkanContext.h"
 #include "VulkanFramebuffer.h"
+#include "VulkanPipelineCache.h"
+
+#include "XYZ/Debug/Timer.h"
 
 namespace XYZ {
 	namespace Utils
@@ -295,7 +298,9 @@ namespace XYZ {
 
 		VkDevice device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_VulkanPipeline));
+		Stopwatch timer;
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VulkanPipelineCache::GetVulkanPipelineCache(), 1, &pipelineCreateInfo, nullptr, &m_VulkanPipeline));
+		VulkanPipelineCache::RecordPipelineCreation(timer.Elapsed());
 	}
 
 	void VulkanPipeline::destroy(VkPipelineLayout pipelineLayout, VkPipeline vulkanPipeline)
@@ -0,0 +1,195 @@
+#include "stdafx.h"
+#include "VulkanPipelineCache.h"
+
+#include <fstream>
+#include <mutex>
+
+namespace XYZ {
+
+	static const std::filesystem::path s_CacheDirectory = "Resources/Cache";
+	static const std::filesystem::path s_CachePath = "Resources/Cache/Pipeline.cache";
+
+	static constexpr char	  sc_CacheMagic[4] = { 'X', 'P', 'C', 'H' };
+	static constexpr uint32_t sc_CacheVersion = 1;
+
+	// Driver data is preceded by our header, truncated or damaged file is rejected before driver sees it
+	struct CacheHeader
+	{
+		char	 Magic[4];
+		uint32_t Version;
+		uint64_t DataSize;
+		uint64_t DataHash;
+	};
+
+	// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE header at start of driver data
+	static constexpr size_t sc_DriverHeaderSize = 16 + VK_UUID_SIZE;
+
+	struct VulkanPipelineCacheData
+	{
+		VkPipelineCache	   Cache = VK_NULL_HANDLE;
+		PipelineCacheStats Stats;
+		std::mutex		   StatsMutex;
+	};
+
+	static VulkanPipelineCacheData* s_Data = nullptr;
+
+	namespace Utils {
+		static uint64_t HashData(const uint8_t* data, size_t size)
+		{
+			// FNV-1a
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		static uint32_t ReadUInt32(const uint8_t* data)
+		{
+			uint32_t value;
+			memcpy(&value, data, sizeof(uint32_t));
+			return value;
+		}
+
+		static bool IsCompatible(const std::vector<uint8_t>& data, const VkPhysicalDeviceProperties& properties)
+		{
+			if (data.size() < sc_DriverHeaderSize)
+				return false;
+
+			const uint32_t headerSize = ReadUInt32(&data[0]);
+			const uint32_t headerVersion = ReadUInt32(&data[4]);
+			const uint32_t vendorID = ReadUInt32(&data[8]);
+			const uint32_t deviceID = ReadUInt32(&data[12]);
+			return headerSize >= sc_DriverHeaderSize
+				&& headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				&& vendorID == properties.vendorID
+				&& deviceID == properties.deviceID
+				&& memcmp(&data[16], properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+	}
+
+	void VulkanPipelineCache::Init(Ref<VulkanDevice> device)
+	{
+		s_Data = new VulkanPipelineCacheData();
+
+		std::vector<uint8_t> data;
+		if (!load(device, s_CachePath, data))
+			data.clear();
+
+		VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		pipelineCacheCreateInfo.initialDataSize = data.size();
+		pipelineCacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		const VkResult result = vkCreatePipelineCache(device->GetVulkanDevice(), &pipelineCacheCreateInfo, nullptr, &s_Data->Cache);
+		if (result != VK_SUCCESS && !data.empty())
+		{
+			XYZ_CORE_WARN("Pipeline cache data rejected by driver, starting with empty cache");
+			data.clear();
+			pipelineCacheCreateInfo.initialDataSize = 0;
+			pipelineCacheCreateInfo.pInitialData = nullptr;
+			VK_CHECK_RESULT(vkCreatePipelineCache(device->GetVulkanDevice(), &pipelineCacheCreateInfo, nullptr, &s_Data->Cache));
+		}
+		s_Data->Stats.LoadedSize = data.size();
+		if (!data.empty())
+			XYZ_CORE_INFO("Pipeline cache loaded {} bytes", data.size());
+	}
+
+	void VulkanPipelineCache::Shutdown(Ref<VulkanDevice> device)
+	{
+		const PipelineCacheStats stats = GetStats();
+		XYZ_CORE_INFO("Pipeline cache {}: {} pipelines created in {} ms",
+			stats.LoadedSize != 0 ? "warm" : "cold", stats.PipelinesCreated, stats.CreationTime);
+
+		if (!save(device, s_CachePath))
+			XYZ_CORE_WARN("Failed to save pipeline cache {}", s_CachePath.string());
+
+		vkDestroyPipelineCache(device->GetVulkanDevice(), s_Data->Cache, nullptr);
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void VulkanPipelineCache::RecordPipelineCreation(float milliseconds)
+	{
+		std::scoped_lock lock(s_Data->StatsMutex);
+		s_Data->Stats.PipelinesCreated++;
+		s_Data->Stats.CreationTime += milliseconds;
+	}
+
+	VkPipelineCache VulkanPipelineCache::GetVulkanPipelineCache()
+	{
+		return s_Data->Cache;
+	}
+
+	PipelineCacheStats VulkanPipelineCache::GetStats()
+	{
+		std::scoped_lock lock(s_Data->StatsMutex);
+		return s_Data->Stats;
+	}
+
+	bool VulkanPipelineCache::load(Ref<VulkanDevice> device, const std::filesystem::path& filepath, std::vector<uint8_t>& data)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		if (!stream)
+			return false;
+
+		CacheHeader header;
+		if (!stream.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader))
+			|| memcmp(header.Magic, sc_CacheMagic, sizeof(sc_CacheMagic)) != 0
+			|| header.Version != sc_CacheVersion)
+			return false;
+
+		std::error_code error;
+		const uintmax_t fileSize = std::filesystem::file_size(filepath, error);
+		if (error || fileSize - sizeof(CacheHeader) != header.DataSize)
+			return false;
+
+		data.resize(header.DataSize);
+		if (!stream.read(reinterpret_cast<char*>(data.data()), data.size())
+			|| Utils::HashData(data.data(), data.size()) != header.DataHash)
+			return false;
+
+		if (!Utils::IsCompatible(data, device->GetPhysicalDevice()->GetProperties()))
+		{
+			XYZ_CORE_INFO("Pipeline cache was written by different driver or device, starting with empty cache");
+			return false;
+		}
+		return true;
+	}
+
+	bool VulkanPipelineCache::save(Ref<VulkanDevice> device, const std::filesystem::path& filepath)
+	{
+		const VkDevice vulkanDevice = device->GetVulkanDevice();
+		size_t size = 0;
+		VK_CHECK_RESULT(vkGetPipelineCacheData(vulkanDevice, s_Data->Cache, &size, nullptr));
+		std::vector<uint8_t> data(size);
+		VK_CHECK_RESULT(vkGetPipelineCacheData(vulkanDevice, s_Data->Cache, &size, data.data()));
+		data.resize(size);
+
+		CacheHeader header{};
+		memcpy(header.Magic, sc_CacheMagic, sizeof(sc_CacheMagic));
+		header.Version = sc_CacheVersion;
+		header.DataSize = data.size();
+		header.DataHash = Utils::HashData(data.data(), data.size());
+
+		std::error_code error;
+		std::filesystem::create_directories(s_CacheDirectory, error);
+
+		// Written next to cache and renamed, interrupted write does not replace valid cache
+		std::filesystem::path tempPath = filepath;
+		tempPath += ".tmp";
+		{
+			std::ofstream fout(tempPath, std::ios::binary);
+			if (!fout)
+				return false;
+			fout.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+			fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+			if (!fout.good())
+				return false;
+		}
+		std::filesystem::rename(tempPath, filepath, error);
+		return !error;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Vulkan.h"
+#include "VulkanDevice.h"
+
+#include <filesystem>
+
+namespace XYZ {
+
+	struct PipelineCacheStats
+	{
+		uint32_t PipelinesCreated = 0;
+		float	 CreationTime = 0.0f; // Milliseconds
+		size_t	 LoadedSize = 0;	  // Zero if cache started cold
+	};
+
+	// One cache shared by every graphics and compute pipeline of device. Data is saved on shutdown
+	// and loaded on next start only if it was written by same driver and device
+	class VulkanPipelineCache
+	{
+	public:
+		static void Init(Ref<VulkanDevice> device);
+		static void Shutdown(Ref<VulkanDevice> device);
+
+		// Time is reported by pipelines, so cold and warm startup can be compared
+		static void RecordPipelineCreation(float milliseconds);
+
+		static VkPipelineCache	  GetVulkanPipelineCache();
+		static PipelineCacheStats GetStats();
+
+	private:
+		static bool load(Ref<VulkanDevice> device, const std::filesystem::path& filepath, std::vector<uint8_t>& data);
+		static bool save(Ref<VulkanDevice> device, const std::filesystem::path& filepath);
+	};
+}
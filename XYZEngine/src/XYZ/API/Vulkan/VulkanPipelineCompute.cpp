@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "VulkanPipelineCompute.h"
+#include "VulkanPipelineCache.h"
 
+#include "XYZ/Debug/Timer.h"
 
 namespace XYZ {
 	static VkFence s_ComputeFence = nullptr;
@@ -108,15 +110,13 @@ namespace XYZ {
 	{
 		VkPipelineLayout pipelineLayout = m_ComputePipelineLayout;
 		VkPipeline		 vulkanPipeline = m_ComputePipeline;
-		VkPipelineCache  cache = m_PipelineCache;
-		Renderer::SubmitResource([pipelineLayout, vulkanPipeline, cache]() {
+		Renderer::SubmitResource([pipelineLayout, vulkanPipeline]() {
 			if (pipelineLayout != VK_NULL_HANDLE && vulkanPipeline != VK_NULL_HANDLE)
 			{
 				const VkDevice device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 				VK_CHECK_RESULT(vkDeviceWaitIdle(device));
 				vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 				vkDestroyPipeline(device, vulkanPipeline, nullptr);
-				vkDestroyPipelineCache(device, cache, nullptr);
 			}
 			});
 	}
@@ -168,11 +168,9 @@ namespace XYZ {
 		}
 		computePipelineCreateInfo.stage = shaderStage;
 
-		VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-
-		VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &m_PipelineCache));
-		VK_CHECK_RESULT(vkCreateComputePipelines(device, m_PipelineCache, 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline));
+		Stopwatch timer;
+		VK_CHECK_RESULT(vkCreateComputePipelines(device, VulkanPipelineCache::GetVulkanPipelineCache(), 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline));
+		VulkanPipelineCache::RecordPipelineCreation(timer.Elapsed());
 	}
 	void VulkanPipelineCompute::createSpecializationInfo(VkSpecializationInfo& info, std::vector<VkSpecializationMapEntry>& mapEntries, std::vector<std::byte>& data)
 	{
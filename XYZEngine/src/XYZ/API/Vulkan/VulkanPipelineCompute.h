@@ -37,7 +37,6 @@ namespace XYZ {
 		PipelineSpecialization m_Specialization;
 
 		VkPipelineLayout m_ComputePipelineLayout = nullptr;
-		VkPipelineCache m_PipelineCache = nullptr;
 		VkPipeline m_ComputePipeline = nullptr;
 
 		VkCommandBuffer m_ActiveComputeCommandBuffer = nullptr;
@@ -5,6 +5,7 @@
 #include <ozz/animation/offline/raw_animation.h>
 #include <ozz/animation/offline/animation_builder.h>
 #include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/blending_job.h>
 #include <ozz/animation/runtime/local_to_model_job.h>
 #include <ozz/animation/runtime/sampling_job.h>
 #include <ozz/base/span.h>
@@ -13,19 +14,24 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <array>
+#include <algorithm>
+#include <cmath>
+
 namespace XYZ {
 
+	template <typename T>
+	static ozz::span<const T> ConstSpan(const ozz::vector<T>& vector)
+	{
+		return ozz::span<const T>(vector.data(), vector.size());
+	}
+
 	SamplingContext::SamplingContext()
 	{
 	}
 	SamplingContext::SamplingContext(const SamplingContext& other)
-		:
-		LocalTranslations(other.LocalTranslations),
-		LocalScales(other.LocalScales),
-		LocalRotations(other.LocalRotations),
-		m_LocalSpaceSoaTransforms(other.m_LocalSpaceSoaTransforms)
 	{
-		m_Context.Resize(other.m_Context.max_tracks());
+		*this = other;
 	}
 
 	SamplingContext& SamplingContext::operator=(const SamplingContext& other)
@@ -33,9 +39,34 @@ namespace XYZ {
 		LocalTranslations = other.LocalTranslations;
 		LocalScales = other.LocalScales;
 		LocalRotations = other.LocalRotations;
+		for (uint32_t i = 0; i < sc_TrackCount; ++i)
+		{
+			Track& track = m_Tracks[i];
+			const Track& otherTrack = other.m_Tracks[i];
+			// Sampling cache can not be copied, it is rebuilt on next sample
+			track.Context.Resize(otherTrack.Context.max_tracks());
+			track.LocalSpaceSoaTransforms = otherTrack.LocalSpaceSoaTransforms;
+			track.Animation = nullptr;
+			track.State = otherTrack.State;
+			track.Time = otherTrack.Time;
+		}
 		m_LocalSpaceSoaTransforms = other.m_LocalSpaceSoaTransforms;
+		m_BaseJointWeights = other.m_BaseJointWeights;
+		m_ModelSpaceTransforms = other.m_ModelSpaceTransforms;
+
+		m_StateMachine = other.m_StateMachine;
+		m_Controller = other.m_Controller;
+		m_ControllerVersion = other.m_ControllerVersion;
+		m_DefaultState = other.m_DefaultState;
+		m_CurrentTrack = other.m_CurrentTrack;
+		m_FadeTime = other.m_FadeTime;
+		m_FadeDuration = other.m_FadeDuration;
+		m_ResetTime = other.m_ResetTime;
+		for (uint32_t i = 0; i < sc_MaxLayers; ++i)
+			m_LayerWeights[i] = other.m_LayerWeights[i];
 
-		m_Context.Resize(other.m_Context.max_tracks());
+		m_SaoSize = other.m_SaoSize;
+		m_Size = other.m_Size;
 		return *this;
 	}
 	void SamplingContext::resize(uint32_t size)
@@ -43,10 +74,15 @@ namespace XYZ {
 		if (m_Size != size)
 		{
 			m_Size = size;
-			m_Context.Resize(size);
+			for (Track& track : m_Tracks)
+			{
+				track.Context.Resize(size);
+				track.Animation = nullptr;
+			}
 			LocalTranslations.resize(size);
 			LocalScales.resize(size);
 			LocalRotations.resize(size);
+			m_ModelSpaceTransforms.resize(size);
 		}
 	}
 
@@ -55,46 +91,172 @@ namespace XYZ {
 		if (m_SaoSize != size)
 		{
 			m_SaoSize = size;
-			m_LocalSpaceSoaTransforms.resize(size);		
+			for (Track& track : m_Tracks)
+				track.LocalSpaceSoaTransforms.resize(size);
+			m_LocalSpaceSoaTransforms.resize(size);
+			m_BaseJointWeights.resize(size);
+		}
+	}
+
+	void SamplingContext::UpdateLocalTransforms()
+	{
+		for (int i = 0; i < m_LocalSpaceSoaTransforms.size(); ++i)
+		{
+			ozz::math::SimdFloat4 translations[4];
+			ozz::math::SimdFloat4 scales[4];
+			ozz::math::SimdFloat4 rotations[4];
+
+			ozz::math::Transpose3x4(&m_LocalSpaceSoaTransforms[i].translation.x, translations);
+			ozz::math::Transpose3x4(&m_LocalSpaceSoaTransforms[i].scale.x, scales);
+			ozz::math::Transpose4x4(&m_LocalSpaceSoaTransforms[i].rotation.x, rotations);
+
+			for (int j = 0; j < 4; ++j)
+			{
+				auto index = i * 4 + j;
+				if (index >= LocalTranslations.size())
+					break;
+
+				ozz::math::Store3PtrU(translations[j], glm::value_ptr(LocalTranslations[index]));
+				ozz::math::Store3PtrU(scales[j], glm::value_ptr(LocalScales[index]));
+				ozz::math::StorePtrU(rotations[j], glm::value_ptr(LocalRotations[index]));
+			}
 		}
 	}
 
-	void AnimationController::Update(float& animationTime, SamplingContext& context)
+	void AnimationController::Update(float& animationTime, Timestep ts, SamplingContext& context, uint32_t maxJointDepth)
 	{
-		if (m_AnimationStates.empty())
+		if (m_AnimationStates.empty() || !m_SkeletonAsset.Raw() || !m_SkeletonAsset->IsValid())
 			return;
 
-		float ratio = animationTime / m_AnimationStates[m_StateIndex]->GetAnimation().duration();
-		if (ratio >= 1.0f)
+		const ozz::animation::Skeleton& skeleton = m_SkeletonAsset->GetSkeleton();
+		context.resize(skeleton.num_joints());
+		context.resizeSao(skeleton.num_soa_joints());
+		bindContext(context);
+
+		// Default state changed on shared controller, every instance follows it
+		if (context.m_DefaultState != m_StateIndex && m_StateIndex < m_AnimationStates.size())
+		{
+			context.m_DefaultState = m_StateIndex;
+			if (!TransitionTo(context, m_StateIndex))
+				SetCurrentState(context, m_StateIndex);
+		}
+		if (context.m_ResetTime)
 		{
 			animationTime = 0.0f;
-			ratio = 0.0f;
+			context.m_ResetTime = false;
+		}
+
+		SamplingContext::Track& current = context.m_Tracks[context.m_CurrentTrack];
+		SamplingContext::Track& previous = context.m_Tracks[context.m_CurrentTrack ^ 1];
+		current.Time = animationTime;
+
+		float fadeWeight = 1.0f;
+		if (context.m_FadeDuration > 0.0f)
+		{
+			fadeWeight = context.m_FadeTime / context.m_FadeDuration;
+			if (fadeWeight >= 1.0f)
+			{
+				fadeWeight = 1.0f;
+				context.m_FadeDuration = 0.0f;
+			}
+		}
+
+		const uint32_t layerCount = static_cast<uint32_t>(std::min<size_t>(m_Layers.size(), SamplingContext::sc_MaxLayers));
+		bool blend = context.m_FadeDuration > 0.0f;
+		for (uint32_t i = 0; i < layerCount; ++i)
+			blend |= context.m_LayerWeights[i] > 0.0f;
+
+		if (blend)
+		{
+			sampleTrack(current, current.LocalSpaceSoaTransforms);
+			if (context.m_FadeDuration > 0.0f)
+				sampleTrack(previous, previous.LocalSpaceSoaTransforms);
+			for (uint32_t i = 0; i < layerCount; ++i)
+			{
+				SamplingContext::Track& layerTrack = context.m_Tracks[2 + i];
+				if (context.m_LayerWeights[i] > 0.0f)
+					sampleTrack(layerTrack, layerTrack.LocalSpaceSoaTransforms);
+			}
+			updateBlending(context, fadeWeight, layerCount);
 		}
+		else
+		{
+			// Single state is sampled directly to pose, no blending required
+			sampleTrack(current, context.m_LocalSpaceSoaTransforms);
+		}
+
+		if (maxJointDepth < m_SkeletonDepth && m_JointDepths.size() == skeleton.num_joints())
+			updateModelSpaceReduced(context, maxJointDepth);
+		else
+			updateModelSpace(context);
 
-		if (m_SkeletonAsset.Raw() && m_SkeletonAsset->IsValid())
+		advanceTrack(current, ts);
+		if (context.m_FadeDuration > 0.0f)
 		{
-			context.resize(m_SkeletonAsset->GetSkeleton().num_joints());
-			context.resizeSao(m_SkeletonAsset->GetSkeleton().num_soa_joints());
-			updateSampling(ratio, context);
+			advanceTrack(previous, ts);
+			context.m_FadeTime += ts;
 		}
+		for (uint32_t i = 0; i < layerCount; ++i)
+			advanceTrack(context.m_Tracks[2 + i], ts);
+
+		animationTime = current.Time;
+	}
+
+	bool AnimationController::TransitionTo(SamplingContext& context, size_t index) const
+	{
+		if (index >= m_AnimationStates.size())
+			return false;
+
+		bindContext(context);
+		if (context.m_StateMachine.GetCurrentState() == index)
+			return true;
+
+		const uint32_t from = context.m_StateMachine.GetCurrentState();
+		if (!context.m_StateMachine.TransitionTo(static_cast<uint32_t>(index)))
+			return false;
+
+		startTransition(context, index, findTransitionDuration(from, index));
+		return true;
 	}
+
+	void AnimationController::SetCurrentState(SamplingContext& context, size_t index) const
+	{
+		if (index >= m_AnimationStates.size())
+			return;
+
+		bindContext(context);
+		context.m_StateMachine.SetState(static_cast<uint32_t>(index));
+		startTransition(context, index, 0.0f);
+	}
+
+	void AnimationController::SetLayerWeight(SamplingContext& context, size_t layerIndex, float weight) const
+	{
+		bindContext(context);
+		if (layerIndex < m_Layers.size() && layerIndex < SamplingContext::sc_MaxLayers)
+			context.m_LayerWeights[layerIndex] = std::clamp(weight, 0.0f, 1.0f);
+	}
+
 	void AnimationController::SetSkeletonAsset(const Ref<SkeletonAsset>& skeletonAsset)
 	{
 		m_SkeletonAsset = skeletonAsset;
+		for (auto& layer : m_Layers)
+			buildJointWeights(layer);
+		computeJointData();
+		m_Version++;
 	}
 	void AnimationController::SetCurrentState(const std::string& name)
 	{
-		for (size_t i = 0; i < m_AnimationNames.size(); ++i)
-		{
-			if (m_AnimationNames[i] == name)
-			{
-				m_StateIndex = i;
-				return;
-			}
-		}
+		const size_t index = FindState(name);
+		if (index != m_AnimationNames.size())
+			m_StateIndex = index;
 	}
 	void AnimationController::AddState(const std::string_view name, const Ref<AnimationAsset>& animation)
 	{
+		if (m_AnimationNames.size() >= SamplingContext::sc_MaxStates)
+		{
+			XYZ_CORE_ERROR("Animation controller supports at most {} states", SamplingContext::sc_MaxStates);
+			return;
+		}
 		for (const auto& animName : m_AnimationNames)
 		{
 			if (animName == name)
@@ -105,46 +267,359 @@ namespace XYZ {
 		}
 		m_AnimationNames.push_back(std::string(name));
 		m_AnimationStates.push_back(animation);
+		m_Version++;
 	}
 	void AnimationController::SetState(size_t index, const std::string_view name, const Ref<AnimationAsset>& animation)
 	{
 		m_AnimationNames[index] = name;
 		m_AnimationStates[index] = animation;
+		m_Version++;
+	}
+
+	void AnimationController::SetTransition(size_t from, size_t to, float duration)
+	{
+		if (from >= m_AnimationStates.size() || to >= m_AnimationStates.size())
+		{
+			XYZ_CORE_ERROR("Invalid transition from state {} to state {}", from, to);
+			return;
+		}
+		m_StateMachine.SetAllowTransition(static_cast<uint32_t>(from), static_cast<uint32_t>(to), true);
+		m_Version++;
+		for (auto& transition : m_Transitions)
+		{
+			if (transition.From == from && transition.To == to)
+			{
+				transition.Duration = duration;
+				return;
+			}
+		}
+		m_Transitions.push_back({ static_cast<uint32_t>(from), static_cast<uint32_t>(to), duration });
+	}
+
+	void AnimationController::RemoveTransition(size_t from, size_t to)
+	{
+		for (auto it = m_Transitions.begin(); it != m_Transitions.end(); ++it)
+		{
+			if (it->From == from && it->To == to)
+			{
+				m_StateMachine.SetAllowTransition(it->From, it->To, false);
+				m_Transitions.erase(it);
+				m_Version++;
+				return;
+			}
+		}
+	}
+
+	void AnimationController::AddLayer(const std::string_view name, size_t state, float weight, const std::string_view rootJoint)
+	{
+		if (m_Layers.size() >= SamplingContext::sc_MaxLayers)
+		{
+			XYZ_CORE_ERROR("Animation controller supports at most {} layers", SamplingContext::sc_MaxLayers);
+			return;
+		}
+		if (state >= m_AnimationStates.size())
+		{
+			XYZ_CORE_ERROR("Invalid state {} for layer {}", state, name);
+			return;
+		}
+		AnimationLayer& layer = m_Layers.emplace_back();
+		layer.Name = name;
+		layer.State = static_cast<uint32_t>(state);
+		layer.Weight = weight;
+		layer.RootJoint = rootJoint;
+		buildJointWeights(layer);
+		m_Version++;
+	}
+
+	void AnimationController::RemoveLayer(size_t index)
+	{
+		m_Layers.erase(m_Layers.begin() + index);
+		m_Version++;
 	}
 
-	void AnimationController::updateSampling(float ratio, SamplingContext& context)
+	size_t AnimationController::FindState(const std::string_view name) const
 	{
-		ozz::animation::SamplingJob sampling_job;
-		sampling_job.animation = &m_AnimationStates[m_StateIndex]->GetAnimation();
-		sampling_job.context = &context.m_Context;
-		sampling_job.ratio = ratio;
-		sampling_job.output = ozz::make_span(context.m_LocalSpaceSoaTransforms);
-		if (!sampling_job.Run())
+		for (size_t i = 0; i < m_AnimationNames.size(); ++i)
+		{
+			if (m_AnimationNames[i] == name)
+				return i;
+		}
+		return m_AnimationNames.size();
+	}
+
+	void AnimationController::bindContext(SamplingContext& context) const
+	{
+		if (context.m_Controller == this && context.m_ControllerVersion == m_Version)
+			return;
+
+		// Instance keeps its state when controller is only modified
+		uint32_t currentState = static_cast<uint32_t>(m_StateIndex);
+		if (context.m_Controller == this && context.m_StateMachine.GetCurrentState() < m_AnimationStates.size())
+			currentState = context.m_StateMachine.GetCurrentState();
+		else
+			context.m_DefaultState = m_StateIndex;
+
+		context.m_Controller = this;
+		context.m_ControllerVersion = m_Version;
+		context.m_StateMachine = m_StateMachine;
+		context.m_StateMachine.SetState(currentState);
+		context.m_Tracks[context.m_CurrentTrack].State = currentState;
+		context.m_FadeDuration = 0.0f;
+
+		for (uint32_t i = 0; i < SamplingContext::sc_MaxLayers; ++i)
+		{
+			SamplingContext::Track& layerTrack = context.m_Tracks[2 + i];
+			if (i < m_Layers.size())
+			{
+				context.m_LayerWeights[i] = m_Layers[i].Weight;
+				layerTrack.State = m_Layers[i].State;
+			}
+			else
+			{
+				context.m_LayerWeights[i] = 0.0f;
+			}
+		}
+	}
+
+	void AnimationController::startTransition(SamplingContext& context, size_t index, float duration) const
+	{
+		if (duration > 0.0f)
+		{
+			// Current track starts fading out, interrupted fade drops its oldest state
+			context.m_CurrentTrack ^= 1;
+			context.m_FadeTime = 0.0f;
+			context.m_FadeDuration = duration;
+		}
+		else
+		{
+			context.m_FadeDuration = 0.0f;
+		}
+		SamplingContext::Track& current = context.m_Tracks[context.m_CurrentTrack];
+		current.State = static_cast<uint32_t>(index);
+		current.Time = 0.0f;
+		context.m_ResetTime = true;
+	}
+
+	void AnimationController::advanceTrack(SamplingContext::Track& track, float ts) const
+	{
+		if (track.State >= m_AnimationStates.size() || !m_AnimationStates[track.State].Raw())
+			return;
+
+		const float duration = m_AnimationStates[track.State]->GetAnimation().duration();
+		track.Time += ts;
+		if (track.Time >= duration)
+			track.Time = duration > 0.0f ? std::fmod(track.Time, duration) : 0.0f;
+	}
+
+	bool AnimationController::sampleTrack(SamplingContext::Track& track, ozz::vector<ozz::math::SoaTransform>& output) const
+	{
+		if (track.State >= m_AnimationStates.size() || !m_AnimationStates[track.State].Raw())
+			return false;
+
+		const ozz::animation::Animation& animation = m_AnimationStates[track.State]->GetAnimation();
+		if (track.Animation != &animation)
+		{
+			track.Context.Invalidate();
+			track.Animation = &animation;
+		}
+
+		const float duration = animation.duration();
+		ozz::animation::SamplingJob samplingJob;
+		samplingJob.animation = &animation;
+		samplingJob.context = &track.Context;
+		samplingJob.ratio = duration > 0.0f ? std::clamp(track.Time / duration, 0.0f, 1.0f) : 0.0f;
+		samplingJob.output = ozz::make_span(output);
+		if (!samplingJob.Run())
 		{
 			XYZ_CORE_ERROR("ozz animation sampling job failed!");
+			return false;
+		}
+		return true;
+	}
+
+	void AnimationController::updateBlending(SamplingContext& context, float fadeWeight, uint32_t layerCount) const
+	{
+		// Masked layers override base states, base weight of every joint is reduced by weights of layers
+		const ozz::math::SimdFloat4 one = ozz::math::simd_float4::one();
+		for (auto& weight : context.m_BaseJointWeights)
+			weight = one;
+
+		std::array<ozz::animation::BlendingJob::Layer, SamplingContext::sc_TrackCount> layers;
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < layerCount; ++i)
+		{
+			const float weight = context.m_LayerWeights[i];
+			if (weight <= 0.0f)
+				continue;
+
+			const AnimationLayer& layer = m_Layers[i];
+			const ozz::math::SimdFloat4 layerWeight = ozz::math::simd_float4::Load1(weight);
+			for (size_t j = 0; j < context.m_BaseJointWeights.size(); ++j)
+			{
+				const ozz::math::SimdFloat4 mask = layer.JointWeights.empty() ? one : layer.JointWeights[j];
+				context.m_BaseJointWeights[j] = ozz::math::Max(context.m_BaseJointWeights[j] - mask * layerWeight, ozz::math::simd_float4::zero());
+			}
+
+			auto& blendLayer = layers[count++];
+			blendLayer.transform = ConstSpan(context.m_Tracks[2 + i].LocalSpaceSoaTransforms);
+			blendLayer.weight = weight;
+			blendLayer.joint_weights = ConstSpan(layer.JointWeights);
+		}
+
+		auto& currentLayer = layers[count++];
+		currentLayer.transform = ConstSpan(context.m_Tracks[context.m_CurrentTrack].LocalSpaceSoaTransforms);
+		currentLayer.weight = context.m_FadeDuration > 0.0f ? fadeWeight : 1.0f;
+		currentLayer.joint_weights = ConstSpan(context.m_BaseJointWeights);
+		if (context.m_FadeDuration > 0.0f)
+		{
+			auto& previousLayer = layers[count++];
+			previousLayer.transform = ConstSpan(context.m_Tracks[context.m_CurrentTrack ^ 1].LocalSpaceSoaTransforms);
+			previousLayer.weight = 1.0f - fadeWeight;
+			previousLayer.joint_weights = ConstSpan(context.m_BaseJointWeights);
 		}
 
+		ozz::animation::BlendingJob blendingJob;
+		blendingJob.layers = ozz::span<const ozz::animation::BlendingJob::Layer>(layers.data(), count);
+		blendingJob.rest_pose = m_SkeletonAsset->GetSkeleton().joint_rest_poses();
+		blendingJob.output = ozz::make_span(context.m_LocalSpaceSoaTransforms);
+		if (!blendingJob.Run())
+		{
+			XYZ_CORE_ERROR("ozz animation blending job failed!");
+		}
+	}
+
+	void AnimationController::updateModelSpace(SamplingContext& context) const
+	{
+		ozz::animation::LocalToModelJob localToModelJob;
+		localToModelJob.skeleton = &m_SkeletonAsset->GetSkeleton();
+		localToModelJob.input = ConstSpan(context.m_LocalSpaceSoaTransforms);
+		localToModelJob.output = ozz::make_span(context.m_ModelSpaceTransforms);
+		if (!localToModelJob.Run())
+		{
+			XYZ_CORE_ERROR("ozz animation local to model job failed!");
+		}
+	}
+
+	void AnimationController::updateModelSpaceReduced(SamplingContext& context, uint32_t maxJointDepth) const
+	{
+		const ozz::animation::Skeleton& skeleton = m_SkeletonAsset->GetSkeleton();
+		const auto parents = skeleton.joint_parents();
+
+		ozz::math::SimdFloat4 translations[4];
+		ozz::math::SimdFloat4 scales[4];
+		ozz::math::SimdFloat4 rotations[4];
+		int transposedBlock = -1;
+		for (int i = 0; i < skeleton.num_joints(); ++i)
+		{
+			ozz::math::Float4x4 local;
+			if (m_JointDepths[i] <= maxJointDepth)
+			{
+				// Four joints are transposed at once, joints of block are mostly processed together
+				const int block = i / 4;
+				if (block != transposedBlock)
+				{
+					const ozz::math::SoaTransform& soa = context.m_LocalSpaceSoaTransforms[block];
+					ozz::math::Transpose3x4(&soa.translation.x, translations);
+					ozz::math::Transpose3x4(&soa.scale.x, scales);
+					ozz::math::Transpose4x4(&soa.rotation.x, rotations);
+					transposedBlock = block;
+				}
+				const int lane = i % 4;
+				local = ozz::math::Float4x4::FromAffine(translations[lane], rotations[lane], scales[lane]);
+			}
+			else
+			{
+				local = m_RestLocalTransforms[i];
+			}
+
+			const int parent = parents[i];
+			if (parent == ozz::animation::Skeleton::kNoParent)
+				context.m_ModelSpaceTransforms[i] = local;
+			else
+				context.m_ModelSpaceTransforms[i] = context.m_ModelSpaceTransforms[parent] * local;
+		}
+	}
+
+	void AnimationController::computeJointData()
+	{
+		m_JointDepths.clear();
+		m_RestLocalTransforms.clear();
+		m_SkeletonDepth = 0;
+		if (!m_SkeletonAsset.Raw() || !m_SkeletonAsset->IsValid())
+			return;
+
+		const ozz::animation::Skeleton& skeleton = m_SkeletonAsset->GetSkeleton();
+		const auto parents = skeleton.joint_parents();
+		const auto restPoses = skeleton.joint_rest_poses();
 
-		for (int i = 0; i < context.m_LocalSpaceSoaTransforms.size(); ++i)
+		m_JointDepths.resize(skeleton.num_joints());
+		m_RestLocalTransforms.resize(skeleton.num_joints());
+		for (int i = 0; i < skeleton.num_joints(); ++i)
+		{
+			const int parent = parents[i];
+			m_JointDepths[i] = parent == ozz::animation::Skeleton::kNoParent ? 0 : m_JointDepths[parent] + 1;
+			m_SkeletonDepth = std::max(m_SkeletonDepth, m_JointDepths[i]);
+		}
+
+		for (int block = 0; block < skeleton.num_soa_joints(); ++block)
 		{
 			ozz::math::SimdFloat4 translations[4];
 			ozz::math::SimdFloat4 scales[4];
 			ozz::math::SimdFloat4 rotations[4];
+			ozz::math::Transpose3x4(&restPoses[block].translation.x, translations);
+			ozz::math::Transpose3x4(&restPoses[block].scale.x, scales);
+			ozz::math::Transpose4x4(&restPoses[block].rotation.x, rotations);
+			for (int lane = 0; lane < 4 && block * 4 + lane < skeleton.num_joints(); ++lane)
+				m_RestLocalTransforms[block * 4 + lane] = ozz::math::Float4x4::FromAffine(translations[lane], rotations[lane], scales[lane]);
+		}
+	}
 
-			ozz::math::Transpose3x4(&context.m_LocalSpaceSoaTransforms[i].translation.x, translations);
-			ozz::math::Transpose3x4(&context.m_LocalSpaceSoaTransforms[i].scale.x, scales);
-			ozz::math::Transpose4x4(&context.m_LocalSpaceSoaTransforms[i].rotation.x, rotations);
+	float AnimationController::findTransitionDuration(size_t from, size_t to) const
+	{
+		for (const auto& transition : m_Transitions)
+		{
+			if (transition.From == from && transition.To == to)
+				return transition.Duration;
+		}
+		return 0.0f;
+	}
 
-			for (int j = 0; j < 4; ++j)
-			{
-				auto index = i * 4 + j;
-				if (index >= context.LocalTranslations.size())
-					break;
+	void AnimationController::buildJointWeights(AnimationLayer& layer) const
+	{
+		layer.JointWeights.clear();
+		if (layer.RootJoint.empty() || !m_SkeletonAsset.Raw() || !m_SkeletonAsset->IsValid())
+			return;
 
-				ozz::math::Store3PtrU(translations[j], glm::value_ptr(context.LocalTranslations[index]));
-				ozz::math::Store3PtrU(scales[j], glm::value_ptr(context.LocalScales[index]));
-				ozz::math::StorePtrU(rotations[j], glm::value_ptr(context.LocalRotations[index]));
+		const ozz::animation::Skeleton& skeleton = m_SkeletonAsset->GetSkeleton();
+		const auto jointNames = skeleton.joint_names();
+		int root = -1;
+		for (int i = 0; i < skeleton.num_joints(); ++i)
+		{
+			if (layer.RootJoint == jointNames[i])
+			{
+				root = i;
+				break;
 			}
 		}
+		if (root == -1)
+		{
+			XYZ_CORE_WARN("Root joint {} of layer {} not found in skeleton", layer.RootJoint, layer.Name);
+			return;
+		}
+
+		// Joints are sorted depth first, parent is always before its children
+		const auto parents = skeleton.joint_parents();
+		std::vector<float> weights(skeleton.num_soa_joints() * 4, 0.0f);
+		weights[root] = 1.0f;
+		for (int i = root + 1; i < skeleton.num_joints(); ++i)
+		{
+			const int parent = parents[i];
+			if (parent != ozz::animation::Skeleton::kNoParent && weights[parent] > 0.0f)
+				weights[i] = 1.0f;
+		}
+
+		layer.JointWeights.resize(skeleton.num_soa_joints());
+		for (int i = 0; i < skeleton.num_soa_joints(); ++i)
+			layer.JointWeights[i] = ozz::math::simd_float4::Load(weights[i * 4], weights[i * 4 + 1], weights[i * 4 + 2], weights[i * 4 + 3]);
 	}
-}
\ No newline at end of file
+}
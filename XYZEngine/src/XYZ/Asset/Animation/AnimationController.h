@@ -1,5 +1,6 @@
 #pragma once
 #include "XYZ/Core/Timestep.h"
+#include "XYZ/FSM/StateMachine.h"
 #include "AnimationAsset.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -11,70 +12,168 @@
 #include <ozz/animation/runtime/skeleton.h>
 #include <ozz/base/containers/vector.h>
 #include <ozz/base/maths/soa_transform.h>
+#include <ozz/base/maths/simd_math.h>
 #include <ozz/base/memory/unique_ptr.h>
 
+#include <limits>
+
 namespace XYZ {
 
+	class AnimationController;
+
+	// Per instance state of controller, all buffers are allocated when skeleton changes and reused every frame
 	struct XYZ_API SamplingContext
 	{
+		static constexpr uint32_t sc_MaxStates = 32;
+		static constexpr uint32_t sc_MaxLayers = 4;
+
 		SamplingContext();
 		SamplingContext(const SamplingContext& other);
 
 		SamplingContext& operator=(const SamplingContext& other);
 
+		// Converts sampled SoA pose to local transforms, only required when something reads them
+		void UpdateLocalTransforms();
+
+		const ozz::vector<ozz::math::Float4x4>& GetModelSpaceTransforms() const { return m_ModelSpaceTransforms; }
+
+		uint32_t GetCurrentState() const { return m_StateMachine.GetCurrentState(); }
+		bool	 IsInTransition()  const { return m_FadeDuration > 0.0f; }
+
 		std::vector<glm::vec3> LocalTranslations;
 		std::vector<glm::vec3> LocalScales;
 		std::vector<glm::quat> LocalRotations;
-	
+
 	private:
 		void resize(uint32_t size);
 		void resizeSao(uint32_t size);
 
-
 	private:
-		ozz::animation::SamplingJob::Context m_Context;
+		struct Track
+		{
+			ozz::animation::SamplingJob::Context Context;
+			ozz::vector<ozz::math::SoaTransform> LocalSpaceSoaTransforms;
+			const ozz::animation::Animation*	 Animation = nullptr; // Sampling cache is valid only for this animation
+			uint32_t							 State = 0;
+			float								 Time = 0.0f;
+		};
+		// Current and fading out state swap between first two tracks, rest is used by layers
+		static constexpr uint32_t sc_TrackCount = 2 + sc_MaxLayers;
+
+		Track								 m_Tracks[sc_TrackCount];
 		ozz::vector<ozz::math::SoaTransform> m_LocalSpaceSoaTransforms;
-	
+		ozz::vector<ozz::math::SimdFloat4>	 m_BaseJointWeights;
+		ozz::vector<ozz::math::Float4x4>	 m_ModelSpaceTransforms;
+
+		StateMachine<sc_MaxStates> m_StateMachine;
+		const AnimationController* m_Controller = nullptr;
+		uint32_t				   m_ControllerVersion = 0;
+		size_t					   m_DefaultState = 0;
+		uint32_t				   m_CurrentTrack = 0;
+		float					   m_FadeTime = 0.0f;
+		float					   m_FadeDuration = 0.0f;
+		bool					   m_ResetTime = false;
+		float					   m_LayerWeights[sc_MaxLayers] = {};
+
 		uint32_t m_SaoSize = 0;
 		uint32_t m_Size = 0;
 
 		friend class AnimationController;
 	};
 
+	struct AnimationTransition
+	{
+		uint32_t From;
+		uint32_t To;
+		float	 Duration; // Length of cross-fade in seconds
+	};
+
+	// Layer blends its state over base states, only joints under root joint are affected
+	struct AnimationLayer
+	{
+		std::string Name;
+		uint32_t	State = 0;
+		float		Weight = 1.0f;
+		std::string RootJoint; // Empty means whole skeleton
+
+		ozz::vector<ozz::math::SimdFloat4> JointWeights;
+	};
+
 	// Controls which animation (or animations) is playing on a mesh.
+	// Controller is shared, everything that changes per instance lives in SamplingContext
 	class XYZ_API AnimationController : public Asset
 	{
 	public:
 		virtual ~AnimationController() = default;
 
-		void Update(float& animationTime, SamplingContext& context);
+		// Samples and blends active states and converts pose to model space, pose stays in SoA form.
+		// Time of current state is stored in animationTime and advanced by ts.
+		// Joints deeper than maxJointDepth keep rest pose relative to their parent
+		void Update(float& animationTime, Timestep ts, SamplingContext& context, uint32_t maxJointDepth = sc_FullDepth);
+
+		// Cross-fades instance to state if transition is allowed
+		bool TransitionTo(SamplingContext& context, size_t index) const;
+		// Switches instance to state without cross-fade
+		void SetCurrentState(SamplingContext& context, size_t index) const;
+		void SetLayerWeight(SamplingContext& context, size_t layerIndex, float weight) const;
 
 		void SetSkeletonAsset(const Ref<SkeletonAsset>& skeletonAsset);
+		// Default state, instances cross-fade to it when it changes
 		void SetCurrentState(size_t index) { m_StateIndex = index; };
 		void SetCurrentState(const std::string& name);
 		void AddState(const std::string_view name, const Ref<AnimationAsset>& animation);
 		void SetState(size_t index, const std::string_view name, const Ref<AnimationAsset>& animation);
 
+		void SetTransition(size_t from, size_t to, float duration);
+		void RemoveTransition(size_t from, size_t to);
+
+		void AddLayer(const std::string_view name, size_t state, float weight, const std::string_view rootJoint);
+		void RemoveLayer(size_t index);
+
 		size_t GetCurrentState() const { return m_StateIndex; }
+		size_t FindState(const std::string_view name) const;
 
 		const Ref<SkeletonAsset>&				GetSkeleton()		 const { return m_SkeletonAsset; }
 		const std::vector<std::string>&			GetStateNames()		 const { return m_AnimationNames; }
 		const std::vector<Ref<AnimationAsset>>& GetAnimationStates() const { return m_AnimationStates; }
-		
+		const std::vector<AnimationTransition>& GetTransitions()	 const { return m_Transitions; }
+		const std::vector<AnimationLayer>&		GetLayers()			 const { return m_Layers; }
+
 
 		static AssetType GetStaticType() { return AssetType::AnimationController; }
 		virtual AssetType GetAssetType() const override { return GetStaticType(); }
 
+		static constexpr uint32_t sc_FullDepth = std::numeric_limits<uint32_t>::max();
 	private:
-		void updateSampling(float ratio, SamplingContext& context);
-		
+		void bindContext(SamplingContext& context) const;
+		void startTransition(SamplingContext& context, size_t index, float duration) const;
+		void advanceTrack(SamplingContext::Track& track, float ts) const;
+		bool sampleTrack(SamplingContext::Track& track, ozz::vector<ozz::math::SoaTransform>& output) const;
+		void updateBlending(SamplingContext& context, float fadeWeight, uint32_t layerCount) const;
+		void updateModelSpace(SamplingContext& context) const;
+		void updateModelSpaceReduced(SamplingContext& context, uint32_t maxJointDepth) const;
+		void computeJointData();
+
+		float findTransitionDuration(size_t from, size_t to) const;
+		void  buildJointWeights(AnimationLayer& layer) const;
+
 
 	private:
 		Ref<SkeletonAsset>				 m_SkeletonAsset;
 		std::vector<Ref<AnimationAsset>> m_AnimationStates;
 		std::vector<std::string>		 m_AnimationNames;
+		std::vector<AnimationTransition> m_Transitions;
+		std::vector<AnimationLayer>		 m_Layers;
+
+		// Used by joint reduction, computed when skeleton is set
+		std::vector<uint32_t>			 m_JointDepths;
+		ozz::vector<ozz::math::Float4x4> m_RestLocalTransforms;
+		uint32_t						 m_SkeletonDepth = 0; // Depth of deepest joint
+
+		StateMachine<SamplingContext::sc_MaxStates> m_StateMachine;
+		// Bound instances rebind when states, transitions or layers change
+		uint32_t m_Version = 1;
 
-		
 		size_t m_StateIndex = 0;
 	};
-}
\ No newline at end of file
+}
@@ -1,9 +1,20 @@
 #include "stdafx.h"
 #include "Asset.h"
+#include "AssetAllocator.h"
 
 
 namespace XYZ {
 
+	void* Asset::operator new(size_t size)
+	{
+		return AssetAllocator::Allocate(static_cast<uint32_t>(size));
+	}
+
+	void Asset::operator delete(void* ptr)
+	{
+		AssetAllocator::Deallocate(ptr);
+	}
+
 	bool Asset::IsValid() const
 	{
 		const bool missing = m_Flags & (uint16_t)AssetFlag::Missing;
@@ -132,6 +132,10 @@ namespace XYZ {
 	{
 	public:
 		virtual ~Asset() = default;
+
+		// Assets are allocated by AssetAllocator, blocks are aligned to 16 bytes
+		static void* operator new(size_t size);
+		static void  operator delete(void* ptr);
 	
 		virtual AssetType GetAssetType() const = 0;
 		const AssetHandle& GetHandle() const { return m_Handle; }
@@ -1,7 +1,21 @@
 #include "stdafx.h"
 #include "AssetAllocator.h"
 
-
 namespace XYZ {
 
-}
\ No newline at end of file
+	void* AssetAllocator::Allocate(uint32_t size)
+	{
+		return GetAllocator().Allocate(size);
+	}
+
+	void AssetAllocator::Deallocate(const void* val)
+	{
+		GetAllocator().Deallocate(val);
+	}
+
+	SlabAllocator& AssetAllocator::GetAllocator()
+	{
+		static SlabAllocator* s_Allocator = new SlabAllocator();
+		return *s_Allocator;
+	}
+}
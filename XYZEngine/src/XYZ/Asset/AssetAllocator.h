@@ -1,14 +1,39 @@
 #pragma once
-#include "XYZ/Utils/DataStructures/MemoryPool.h"
+#include "XYZ/Utils/DataStructures/SlabAllocator.h"
 #include "Asset.h"
 
 namespace XYZ {
 
-	class AssetAllocator
+	// Allocations of asset system, assets themselves are allocated through it by Asset::operator new
+	class XYZ_API AssetAllocator
 	{
 	public:
-		// TODO: allocations
+		static void* Allocate(uint32_t size);
+		static void  Deallocate(const void* val);
 
+		// Never destroyed, assets held by statics may be released after AssetManager
+		static SlabAllocator& GetAllocator();
 
+		template <typename T, typename ...Args>
+		static T* New(Args&&... args);
+
+		template <typename T>
+		static void Delete(T* val);
 	};
-}
\ No newline at end of file
+
+	template <typename T, typename ...Args>
+	inline T* AssetAllocator::New(Args&&... args)
+	{
+		static_assert(alignof(T) <= 16, "Slab blocks are aligned to 16 bytes");
+		return new(Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+	}
+
+	template <typename T>
+	inline void AssetAllocator::Delete(T* val)
+	{
+		if (!val)
+			return;
+		val->~T();
+		Deallocate(val);
+	}
+}
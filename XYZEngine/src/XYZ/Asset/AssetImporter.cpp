@@ -58,6 +58,14 @@ namespace XYZ {
 	}
 
 	bool AssetImporter::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset)
+	{
+		std::string source;
+		if (!ReadSource(metadata, source))
+			return false;
+		return TryLoadData(metadata, source, asset);
+	}
+
+	bool AssetImporter::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset)
 	{
 		if (!s_Serializers[ToUnderlying(metadata.Type)])
 		{
@@ -65,10 +73,28 @@ namespace XYZ {
 			return false;
 		}
 
-		bool result = s_Serializers[ToUnderlying(metadata.Type)]->TryLoadData(metadata, asset);
+		bool result = s_Serializers[ToUnderlying(metadata.Type)]->TryLoadData(metadata, source, asset);
 		if (result)
 			asset->m_Handle = metadata.Handle;
 		return result;
 	}
 
+	bool AssetImporter::ReadSource(const AssetMetadata& metadata, std::string& source)
+	{
+		const auto& serializer = s_Serializers[ToUnderlying(metadata.Type)];
+		if (!serializer || !serializer->RequiresSource())
+			return true;
+
+		std::ifstream stream(metadata.FilePath, std::ios::binary | std::ios::ate);
+		if (!stream)
+		{
+			XYZ_CORE_WARN("Could not open asset file {0}", metadata.FilePath);
+			return false;
+		}
+		source.resize(static_cast<size_t>(stream.tellg()));
+		stream.seekg(0);
+		stream.read(source.data(), source.size());
+		return true;
+	}
+
 }
\ No newline at end of file
@@ -10,6 +10,10 @@ namespace XYZ {
 		static void Serialize(const AssetMetadata& metadata, WeakRef<Asset> asset);
 		static void Serialize(const Ref<Asset>& asset);
 		static bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset);
+		static bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset);
+
+		// Reads asset file if serializer of its type requires it
+		static bool ReadSource(const AssetMetadata& metadata, std::string& source);
 
 	private:
 		static std::array<Scope<AssetSerializer>, ToUnderlying(AssetType::NumTypes)> s_Serializers;
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "AssetManager.h"
 #include "XYZ/Project/Project.h"
+#include "XYZ/Debug/Profiler.h"
 
 #include <filesystem>
 
@@ -11,21 +12,26 @@ namespace XYZ
 {
 	static std::filesystem::path s_Directory = "Assets";
 	static AssetManager s_Instance;
+	static constexpr uint64_t sc_StreamingMemoryBudget = 256 * 1024 * 1024;
+	// Cache directory is written at runtime, it is not scanned so it does not invalidate registry cache
+	static const std::filesystem::path s_CacheDirectory = "Resources/Cache";
+	static const std::filesystem::path s_RegistryCachePath = "Resources/Cache/AssetRegistry.cache";
 
 	void AssetManager::Init()
 	{
 		AssetImporter::Init();
-		processDirectory(s_Directory);
-		processDirectory("Resources");
+		loadRegistry();
 
 		std::wstring wdir = s_Directory.wstring();
 		s_Instance.m_FileWatcher = std::make_shared<FileWatcher>(wdir);
 		
 		s_Instance.m_FileWatcher->AddOnFileChanged<&onFileChange>();
 		s_Instance.m_FileWatcher->Start();
+		s_Instance.m_Streamer.Start(sc_StreamingMemoryBudget);
 	}
 	void AssetManager::Shutdown()
 	{
+		s_Instance.m_Streamer.Stop();
 		s_Instance.m_LoadedAssets.Clear();
 		s_Instance.m_MemoryAssets.Clear();
 		s_Instance.m_FileWatcher->Stop();
@@ -78,15 +84,10 @@ namespace XYZ
 	std::vector<AssetMetadata> AssetManager::FindAllMetadata(AssetType type)
 	{
 		std::vector<AssetMetadata> result;
-
-		s_Instance.m_LoadedAssets.ForEach([type, &result](const AssetHandle& handle, WeakRef<Asset> asset) {
-			auto metadata = s_Instance.m_Registry.GetMetadata(handle);
-			if (metadata->Type == type)
-			{
-				result.push_back(*metadata);
-			}
+		result.reserve(s_Instance.m_Registry.GetCount(type));
+		s_Instance.m_Registry.ForEach(type, [&result](const AssetMetadata& metadata) {
+			result.push_back(metadata);
 		});
-
 		return result;
 	}
 	void AssetManager::ReloadAsset(const std::filesystem::path& filepath)
@@ -114,6 +115,11 @@ namespace XYZ
 		}
 	}
 
+	void AssetManager::CancelAssetAsync(const AssetHandle& assetHandle)
+	{
+		s_Instance.m_Streamer.Cancel(assetHandle);
+	}
+
 	const AssetMetadata& AssetManager::GetMetadata(const AssetHandle& handle)
 	{
 		auto metadata = s_Instance.m_Registry.GetMetadata(handle);
@@ -148,33 +154,6 @@ namespace XYZ
 		return s_Instance;
 	}
 
-	void AssetManager::loadAssetMetadata(const std::filesystem::path& filepath)
-	{
-		std::ifstream stream(filepath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-
-		YAML::Node data = YAML::Load(strStream.str());
-
-		auto handle = data["Handle"];
-		auto filePath = data["FilePath"];
-		auto type = data["Type"];
-
-		if (handle && filePath && type)
-		{
-			AssetHandle guid(handle.as<std::string>());
-			AssetMetadata metadata;
-			metadata.Handle = guid;
-			metadata.FilePath = filePath.as<std::string>();
-			metadata.Type = Utils::AssetTypeFromString(type.as<std::string>());
-			s_Instance.m_Registry.StoreMetadata(metadata);
-		}
-		else
-		{
-			XYZ_CORE_WARN("Failed to load asset meta data {0}", filepath);
-		}
-	}
-
 	void AssetManager::writeAssetMetadata(const AssetMetadata& metadata)
 	{
 		std::string filepath = metadata.FilePath.string();
@@ -189,19 +168,54 @@ namespace XYZ
 		fout << out.c_str();
 	}
 
-	void AssetManager::processDirectory(const std::filesystem::path& path)
+	void AssetManager::loadRegistry()
 	{
-		for (auto it : std::filesystem::directory_iterator(path))
+		XYZ_PROFILE_FUNC("AssetManager::loadRegistry");
+		Stopwatch timer;
+		AssetRegistry cachedRegistry;
+		std::vector<AssetRegistry::DirectoryStamp> directories;
+		std::vector<AssetRegistry::FileStamp> files;
+		if (cachedRegistry.LoadCache(s_RegistryCachePath, directories, files))
 		{
-			if (it.is_directory())
+			// Adding, removing or renaming file changes time of its directory
+			const bool unchanged = std::all_of(directories.begin(), directories.end(), [](const AssetRegistry::DirectoryStamp& directory) {
+				return AssetScanner::GetWriteTime(directory.Path) == directory.WriteTime;
+			});
+			// Editing meta file in place does not change time of its directory
+			uint32_t refreshed = 0;
+			if (unchanged && AssetScanner::RefreshChangedFiles(cachedRegistry, files, refreshed))
 			{
-				processDirectory(it.path());
-			}
-			else if (Utils::GetExtension(it.path().string()) == "meta")
-			{
-				loadAssetMetadata(it.path());
+				if (refreshed != 0 && !cachedRegistry.SaveCache(s_RegistryCachePath, directories, files))
+					XYZ_CORE_WARN("Failed to write asset registry cache {0}", s_RegistryCachePath);
+
+				s_Instance.m_Registry = std::move(cachedRegistry);
+				s_Instance.m_ScanStatistics = AssetScanStatistics();
+				s_Instance.m_ScanStatistics.CacheHit = true;
+				s_Instance.m_ScanStatistics.Directories = static_cast<uint32_t>(directories.size());
+				s_Instance.m_ScanStatistics.MetaFiles = static_cast<uint32_t>(files.size());
+				s_Instance.m_ScanStatistics.Parsed = refreshed;
+				s_Instance.m_ScanStatistics.Reused = static_cast<uint32_t>(files.size()) - refreshed;
+				s_Instance.m_ScanStatistics.TotalTime = timer.Elapsed();
+				XYZ_CORE_INFO("Asset registry loaded from cache, {0} assets in {1:.2f} ms", s_Instance.m_Registry.GetCount(), s_Instance.m_ScanStatistics.TotalTime);
+				return;
 			}
 		}
+
+		// Cached registry and stamps are still used to skip unchanged meta files
+		AssetScanner scanner;
+		scanner.Scan({ s_Directory, "Resources" }, s_CacheDirectory, cachedRegistry, files, s_Instance.m_Registry, &Application::Get().GetThreadPool());
+		s_Instance.m_ScanStatistics = scanner.GetStatistics();
+
+		std::error_code error;
+		std::filesystem::create_directories(s_CacheDirectory, error);
+		if (!s_Instance.m_Registry.SaveCache(s_RegistryCachePath, scanner.GetDirectories(), scanner.GetFiles()))
+			XYZ_CORE_WARN("Failed to write asset registry cache {0}", s_RegistryCachePath);
+
+		const AssetScanStatistics& stats = s_Instance.m_ScanStatistics;
+		XYZ_CORE_INFO("Asset scan: {0} directories, {1} meta files ({2} parsed, {3} reused, {4} failed) in {5:.2f} ms",
+			stats.Directories, stats.MetaFiles, stats.Parsed, stats.Reused, stats.Failed, stats.TotalTime);
+		XYZ_CORE_INFO("Asset scan thread time: enumerate {0:.2f} ms, read {1:.2f} ms, parse {2:.2f} ms, insert {3:.2f} ms",
+			stats.EnumerateTime, stats.ReadTime, stats.ParseTime, stats.InsertTime);
 	}
 
 
@@ -222,11 +236,13 @@ namespace XYZ
 		}
 		else if (type == FileWatcher::ChangeType::Removed)
 		{
-			const auto metadata = s_Instance.m_Registry.GetMetadata(path);
-			if (metadata)
+			const auto ptrMetadata = s_Instance.m_Registry.GetMetadata(path);
+			if (ptrMetadata)
 			{
-				s_Instance.m_Registry.RemoveMetadata((*metadata).Handle);
-				s_Instance.m_LoadedAssets.Erase((*metadata).Handle);
+				// Removing metadata invalidates pointer
+				const AssetHandle handle = ptrMetadata->Handle;
+				s_Instance.m_Registry.RemoveMetadata(handle);
+				s_Instance.m_LoadedAssets.Erase(handle);
 			}
 		}
 		else if (type == FileWatcher::ChangeType::RenamedOld)
@@ -3,7 +3,6 @@
 #include "XYZ/Core/Timestep.h"
 #include "XYZ/Core/Application.h"
 
-#include "XYZ/Utils/DataStructures/MemoryPool.h"
 #include "XYZ/Utils/DataStructures/ThreadQueue.h"
 #include "XYZ/Utils/DataStructures/ThreadUnorderedMap.h"
 
@@ -18,8 +17,11 @@
 #include "AssetSerializer.h"
 #include "AssetImporter.h"
 #include "AssetRegistry.h"
+#include "AssetScanner.h"
 #include "AssetLifeManager.h"
+#include "AssetStreamer.h"
 #include "Asset.h"
+#include "AssetAllocator.h"
 
 
 namespace XYZ {
@@ -86,8 +88,14 @@ namespace XYZ {
 		template <typename T>
 		static Ref<T> GetAsset(const std::filesystem::path& filepath);
 
+		// Priority can be calculated by AssetStreamer::CalculatePriority
 		template <typename T>
-		static std::future<Ref<T>> GetAssetAsync(const std::filesystem::path& filepath);
+		static AssetFuture<T> GetAssetAsync(const AssetHandle& assetHandle, float priority = 0.0f);
+
+		template <typename T>
+		static AssetFuture<T> GetAssetAsync(const std::filesystem::path& filepath, float priority = 0.0f);
+
+		static void CancelAssetAsync(const AssetHandle& assetHandle);
 
 		template<typename T>
 		static Ref<T> TryGetAsset(const AssetHandle& assetHandle);
@@ -110,7 +118,9 @@ namespace XYZ {
 		static const AssetMetadata& GetMetadata(const Ref<Asset>& asset) { return GetMetadata(asset->m_Handle); }
 		
 		static const std::filesystem::path&	GetAssetDirectory();
-		static const MemoryPool&			GetMemoryPool() { return Get().m_Pool; }
+		static SlabAllocator&				GetAllocator() { return AssetAllocator::GetAllocator(); }
+		static AssetStreamer&				GetStreamer() { return Get().m_Streamer; }
+		static const AssetScanStatistics&	GetScanStatistics() { return Get().m_ScanStatistics; }
 
 		static bool Exist(const AssetHandle& handle);
 		static bool Exist(const std::filesystem::path& filepath);
@@ -120,28 +130,29 @@ namespace XYZ {
 		static AssetManager& Get();
 
 	private:
-		static void loadAssetMetadata(const std::filesystem::path& filepath);
 		static void writeAssetMetadata(const AssetMetadata& metadata);
 
-		static void processDirectory(const std::filesystem::path& path);
+		static void loadRegistry();
 		
 
 		static void onFileChange(FileWatcher::ChangeType type, const std::filesystem::path& path);
 
 	private:
 
-		MemoryPool										  m_Pool = MemoryPool(1024 * 1024 * 10);
 		AssetRegistry									  m_Registry;
 		ThreadUnorderedMap<AssetHandle, WeakRef<Asset>>	  m_LoadedAssets;
 		ThreadUnorderedMap<AssetHandle, WeakRef<Asset>>   m_MemoryAssets;
 
 		std::shared_ptr<FileWatcher>					  m_FileWatcher;
 		std::shared_ptr<AssetLifeManager>				  m_AssetLifeManager;
+		AssetStreamer									  m_Streamer;
+		AssetScanStatistics								  m_ScanStatistics;
 
 	private:
 		friend Editor::AssetBrowser;
 		friend Editor::AssetManagerViewPanel;
 		friend class   AssetLifeManager;
+		friend class   AssetStreamer;
 	};
 	
 	
@@ -217,12 +228,23 @@ namespace XYZ {
 	}
 
 	template<typename T>
-	inline std::future<Ref<T>> AssetManager::GetAssetAsync(const std::filesystem::path& filepath)
+	inline AssetFuture<T> AssetManager::GetAssetAsync(const AssetHandle& assetHandle, float priority)
 	{
-		auto& threadPool = Application::Get().GetThreadPool();
-		return threadPool.SubmitJob([path = filepath]() {
-			return GetAsset<T>(path);
-		});
+		WeakRef<Asset> getAsset = nullptr;
+		if (Get().m_LoadedAssets.TryGet(assetHandle, getAsset) && getAsset.IsValid())
+		{
+			std::promise<Ref<Asset>> loaded;
+			loaded.set_value(getAsset.Raw());
+			return loaded.get_future().share();
+		}
+		return Get().m_Streamer.Request(GetMetadata(assetHandle), priority);
+	}
+
+	template<typename T>
+	inline AssetFuture<T> AssetManager::GetAssetAsync(const std::filesystem::path& filepath, float priority)
+	{
+		auto& metadata = GetMetadata(filepath);
+		return GetAssetAsync<T>(metadata.Handle, priority);
 	}
 
 
@@ -251,15 +273,21 @@ namespace XYZ {
 	template<typename T>
 	inline std::vector<Ref<T>> AssetManager::FindAllAssets(AssetType type)
 	{
-		std::vector<Ref<T>> result;
-
-		Get().m_LoadedAssets.ForEach([&result, type](const AssetHandle& handle, WeakRef<Asset> asset) {
-			auto metadata = Get().m_Registry.GetMetadata(handle);
-			if (metadata->Type == type)
-			{
-				result.push_back(GetAsset<T>(handle));
-			}
+		// Handles are copied first, loading asset may store new metadata
+		std::vector<AssetHandle> handles;
+		handles.reserve(Get().m_Registry.GetCount(type));
+		Get().m_Registry.ForEach(type, [&handles](const AssetMetadata& metadata) {
+			handles.push_back(metadata.Handle);
 		});
+
+		std::vector<Ref<T>> result;
+		result.reserve(handles.size());
+		for (const AssetHandle& handle : handles)
+		{
+			Ref<T> asset = GetAsset<T>(handle);
+			if (asset.Raw())
+				result.push_back(asset);
+		}
 		return result;
 	}
 
@@ -267,19 +295,14 @@ namespace XYZ {
 	inline std::vector<Ref<T>> AssetManager::FindAllLoadedAssets(AssetType type)
 	{
 		std::vector<Ref<T>> result;
-
-		Get().m_LoadedAssets.ForEach([&result, type](const AssetHandle& handle, WeakRef<Asset> asset) {
-			auto metadata = Get().m_Registry.GetMetadata(handle);
-			if (metadata->Type == type)
+		Get().m_Registry.ForEach(type, [&result](const AssetMetadata& metadata) {
+			WeakRef<Asset> getAsset = nullptr;
+			if (Get().m_LoadedAssets.TryGet(metadata.Handle, getAsset) && getAsset.IsValid())
 			{
-				WeakRef<Asset> getAsset = nullptr;
-				if (Get().m_LoadedAssets.TryGet(metadata->Handle, getAsset) && getAsset.IsValid())
-				{
-					Ref<T> asset = getAsset.As<T>().Raw();
-					result.push_back(asset);
-				}
+				Ref<T> asset = getAsset.As<T>().Raw();
+				result.push_back(asset);
 			}
-			});
+		});
 		return result;
 	}
 }
\ No newline at end of file
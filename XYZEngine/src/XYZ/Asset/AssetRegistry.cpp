@@ -2,37 +2,329 @@
 #include "AssetRegistry.h"
 
 #include "XYZ/Asset/AssetManager.h"
+#include "XYZ/Utils/MappedFile.h"
 
 namespace XYZ {
+
+	namespace {
+
+		constexpr char	   sc_CacheMagic[4] = { 'X', 'Y', 'Z', 'R' };
+		constexpr uint32_t sc_CacheVersion = 2;
+
+		struct StringRef
+		{
+			uint32_t Offset;
+			uint32_t Size;
+		};
+
+		struct CacheHeader
+		{
+			char	 Magic[4];
+			uint32_t Version;
+			uint32_t MetadataCount;
+			uint32_t DirectoryCount;
+			uint32_t FileCount;
+			uint32_t Padding;
+			uint64_t StringTableSize;
+		};
+
+		struct MetadataRecord
+		{
+			uint64_t  Handle[2];
+			StringRef Path;
+			uint32_t  Type;
+			uint32_t  Padding;
+		};
+
+		struct DirectoryRecord
+		{
+			StringRef Path;
+			int64_t	  WriteTime;
+		};
+
+		struct FileRecord
+		{
+			uint64_t  Handle[2];
+			StringRef Path;
+			int64_t	  WriteTime;
+			uint64_t  Size;
+		};
+	}
+
 	void AssetRegistry::StoreMetadata(const AssetMetadata& metadata)
 	{
-		m_AssetMetadata[metadata.Handle] = metadata;
-		m_AssetHandleMap[metadata.FilePath] = metadata.Handle;
+		const AssetPathID pathID = InternPath(metadata.FilePath);
+		const size_t typeIndex = static_cast<size_t>(metadata.Type);
+		uint32_t index = findIndex(metadata.Handle);
+		if (index == HashIndex::sc_Invalid)
+		{
+			index = static_cast<uint32_t>(m_Metadata.size());
+			m_Metadata.push_back(metadata);
+			m_MetadataPaths.push_back(pathID);
+			m_MetadataTypeSlots.push_back(static_cast<uint32_t>(m_TypeIndices[typeIndex].size()));
+			m_TypeIndices[typeIndex].push_back(index);
+			m_HandleIndex.Insert(metadata.Handle.Hash(), index);
+		}
+		else
+		{
+			AssetMetadata& stored = m_Metadata[index];
+			if (stored.Type != metadata.Type)
+			{
+				auto& oldTypeIndices = m_TypeIndices[static_cast<size_t>(stored.Type)];
+				const uint32_t slot = m_MetadataTypeSlots[index];
+				oldTypeIndices[slot] = oldTypeIndices.back();
+				m_MetadataTypeSlots[oldTypeIndices[slot]] = slot;
+				oldTypeIndices.pop_back();
+
+				m_MetadataTypeSlots[index] = static_cast<uint32_t>(m_TypeIndices[typeIndex].size());
+				m_TypeIndices[typeIndex].push_back(index);
+			}
+			const AssetPathID oldPathID = m_MetadataPaths[index];
+			if (oldPathID != pathID && m_PathMetadata[oldPathID] == index)
+				m_PathMetadata[oldPathID] = HashIndex::sc_Invalid;
+
+			stored = metadata;
+			m_MetadataPaths[index] = pathID;
+		}
+		m_PathMetadata[pathID] = index;
 	}
 
 	void AssetRegistry::RemoveMetadata(const AssetHandle& handle)
 	{
-		auto it = m_AssetMetadata.find(handle);
-		XYZ_ASSERT(it != m_AssetMetadata.end(), "");
-		m_AssetHandleMap.erase(it->second.FilePath);
-		m_AssetMetadata.erase(it);
+		const uint32_t index = findIndex(handle);
+		XYZ_ASSERT(index != HashIndex::sc_Invalid, "");
+		removeIndex(index);
+	}
+
+	void AssetRegistry::Reserve(size_t count)
+	{
+		m_MetadataPaths.reserve(count);
+		m_MetadataTypeSlots.reserve(count);
+		m_Paths.reserve(count);
+		m_PathMetadata.reserve(count);
+		m_HandleIndex.Reserve(static_cast<uint32_t>(count));
+		m_PathIndex.Reserve(static_cast<uint32_t>(count));
+	}
+
+	void AssetRegistry::Clear()
+	{
+		m_Metadata.clear();
+		m_MetadataPaths.clear();
+		m_MetadataTypeSlots.clear();
+		m_HandleIndex.Clear();
+		m_PathIndex.Clear();
+		m_Paths.clear();
+		m_PathMetadata.clear();
+		for (auto& typeIndices : m_TypeIndices)
+			typeIndices.clear();
 	}
-	
+
 	const AssetMetadata* AssetRegistry::GetMetadata(const AssetHandle& handle) const
 	{
-		auto it = m_AssetMetadata.find(handle);
-		if (it != m_AssetMetadata.end())
-			return &it->second;
+		const uint32_t index = findIndex(handle);
+		if (index != HashIndex::sc_Invalid)
+			return &m_Metadata[index];
 
 		return nullptr;
 	}
 	const AssetMetadata* AssetRegistry::GetMetadata(const std::filesystem::path& filepath) const
 	{
-		auto it = m_AssetHandleMap.find(filepath);
-		if (it != m_AssetHandleMap.end())
+		return GetMetadata(FindPathID(filepath));
+	}
+	const AssetMetadata* AssetRegistry::GetMetadata(AssetPathID pathID) const
+	{
+		if (pathID >= m_PathMetadata.size() || m_PathMetadata[pathID] == HashIndex::sc_Invalid)
+			return nullptr;
+		return &m_Metadata[m_PathMetadata[pathID]];
+	}
+
+	AssetPathID AssetRegistry::InternPath(const std::filesystem::path& filepath)
+	{
+		std::string path = normalizePath(filepath);
+		const size_t hash = std::hash<std::string>{}(path);
+		AssetPathID pathID = m_PathIndex.Find(hash, [&](uint32_t id) { return m_Paths[id] == path; });
+		if (pathID != HashIndex::sc_Invalid)
+			return pathID;
+
+		pathID = static_cast<AssetPathID>(m_Paths.size());
+		m_Paths.push_back(std::move(path));
+		m_PathMetadata.push_back(HashIndex::sc_Invalid);
+		m_PathIndex.Insert(hash, pathID);
+		return pathID;
+	}
+
+	AssetPathID AssetRegistry::FindPathID(const std::filesystem::path& filepath) const
+	{
+		const std::string path = normalizePath(filepath);
+		return m_PathIndex.Find(std::hash<std::string>{}(path), [&](uint32_t id) { return m_Paths[id] == path; });
+	}
+
+	bool AssetRegistry::SaveCache(const std::filesystem::path& filepath, const std::vector<DirectoryStamp>& directories, const std::vector<FileStamp>& files) const
+	{
+		std::vector<char> strings;
+		auto addString = [&](const std::string& str) {
+			const StringRef ref{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(str.size()) };
+			strings.insert(strings.end(), str.begin(), str.end());
+			return ref;
+		};
+
+		std::vector<MetadataRecord> metadataRecords;
+		metadataRecords.reserve(m_Metadata.size());
+		for (size_t i = 0; i < m_Metadata.size(); ++i)
 		{
-			return &m_AssetMetadata.find(it->second)->second;
+			const AssetMetadata& metadata = m_Metadata[i];
+			const uint64_t* handle = metadata.Handle.GetData();
+			metadataRecords.push_back({ { handle[0], handle[1] }, addString(m_Paths[m_MetadataPaths[i]]), static_cast<uint32_t>(metadata.Type), 0 });
 		}
-		return nullptr;
+		std::vector<DirectoryRecord> directoryRecords;
+		directoryRecords.reserve(directories.size());
+		for (const DirectoryStamp& directory : directories)
+			directoryRecords.push_back({ addString(directory.Path), directory.WriteTime });
+
+		std::vector<FileRecord> fileRecords;
+		fileRecords.reserve(files.size());
+		for (const FileStamp& file : files)
+		{
+			const uint64_t* handle = file.Handle.GetData();
+			fileRecords.push_back({ { handle[0], handle[1] }, addString(file.Path), file.WriteTime, file.Size });
+		}
+
+		CacheHeader header{};
+		memcpy(header.Magic, sc_CacheMagic, sizeof(sc_CacheMagic));
+		header.Version = sc_CacheVersion;
+		header.MetadataCount = static_cast<uint32_t>(metadataRecords.size());
+		header.DirectoryCount = static_cast<uint32_t>(directoryRecords.size());
+		header.FileCount = static_cast<uint32_t>(fileRecords.size());
+		header.StringTableSize = strings.size();
+
+		std::ofstream fout(filepath, std::ios::binary);
+		if (!fout)
+			return false;
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+		fout.write(reinterpret_cast<const char*>(metadataRecords.data()), metadataRecords.size() * sizeof(MetadataRecord));
+		fout.write(reinterpret_cast<const char*>(directoryRecords.data()), directoryRecords.size() * sizeof(DirectoryRecord));
+		fout.write(reinterpret_cast<const char*>(fileRecords.data()), fileRecords.size() * sizeof(FileRecord));
+		fout.write(strings.data(), strings.size());
+		return fout.good();
+	}
+
+	bool AssetRegistry::LoadCache(const std::filesystem::path& filepath, std::vector<DirectoryStamp>& directories, std::vector<FileStamp>& files)
+	{
+		MappedFile file(filepath.string());
+		if (!file.IsOpen() || file.GetSize() < sizeof(CacheHeader))
+			return false;
+
+		const uint8_t* data = file.GetData();
+		CacheHeader header;
+		memcpy(&header, data, sizeof(CacheHeader));
+		if (memcmp(header.Magic, sc_CacheMagic, sizeof(sc_CacheMagic)) != 0 || header.Version != sc_CacheVersion)
+			return false;
+
+		const uint64_t metadataOffset = sizeof(CacheHeader);
+		const uint64_t directoryOffset = metadataOffset + static_cast<uint64_t>(header.MetadataCount) * sizeof(MetadataRecord);
+		const uint64_t fileOffset = directoryOffset + static_cast<uint64_t>(header.DirectoryCount) * sizeof(DirectoryRecord);
+		const uint64_t stringOffset = fileOffset + static_cast<uint64_t>(header.FileCount) * sizeof(FileRecord);
+		if (stringOffset + header.StringTableSize != file.GetSize())
+			return false;
+
+		const char* strings = reinterpret_cast<const char*>(data + stringOffset);
+		auto getString = [&](const StringRef& ref, std::string& result) {
+			if (static_cast<uint64_t>(ref.Offset) + ref.Size > header.StringTableSize)
+				return false;
+			result.assign(strings + ref.Offset, ref.Size);
+			return true;
+		};
+
+		Clear();
+		Reserve(header.MetadataCount);
+		AssetMetadata metadata;
+		std::string path;
+		for (uint32_t i = 0; i < header.MetadataCount; ++i)
+		{
+			MetadataRecord record;
+			memcpy(&record, data + metadataOffset + i * sizeof(MetadataRecord), sizeof(MetadataRecord));
+			if (record.Type >= static_cast<uint32_t>(AssetType::NumTypes) || !getString(record.Path, path))
+			{
+				Clear();
+				return false;
+			}
+			metadata.Handle = AssetHandle(record.Handle[0], record.Handle[1]);
+			metadata.Type = static_cast<AssetType>(record.Type);
+			metadata.FilePath = path;
+			StoreMetadata(metadata);
+		}
+
+		directories.clear();
+		directories.reserve(header.DirectoryCount);
+		for (uint32_t i = 0; i < header.DirectoryCount; ++i)
+		{
+			DirectoryRecord record;
+			memcpy(&record, data + directoryOffset + i * sizeof(DirectoryRecord), sizeof(DirectoryRecord));
+			if (!getString(record.Path, path))
+			{
+				Clear();
+				return false;
+			}
+			directories.push_back({ path, record.WriteTime });
+		}
+
+		files.clear();
+		files.reserve(header.FileCount);
+		for (uint32_t i = 0; i < header.FileCount; ++i)
+		{
+			FileRecord record;
+			memcpy(&record, data + fileOffset + i * sizeof(FileRecord), sizeof(FileRecord));
+			if (!getString(record.Path, path))
+			{
+				Clear();
+				return false;
+			}
+			files.push_back({ path, record.WriteTime, record.Size, AssetHandle(record.Handle[0], record.Handle[1]) });
+		}
+		return true;
+	}
+
+	uint32_t AssetRegistry::findIndex(const AssetHandle& handle) const
+	{
+		return m_HandleIndex.Find(handle.Hash(), [&](uint32_t index) { return m_Metadata[index].Handle == handle; });
+	}
+
+	void AssetRegistry::removeIndex(uint32_t index)
+	{
+		const AssetHandle handle = m_Metadata[index].Handle;
+		m_HandleIndex.Erase(handle.Hash(), [&](uint32_t value) { return value == index; });
+
+		auto& typeIndices = m_TypeIndices[static_cast<size_t>(m_Metadata[index].Type)];
+		const uint32_t slot = m_MetadataTypeSlots[index];
+		typeIndices[slot] = typeIndices.back();
+		m_MetadataTypeSlots[typeIndices[slot]] = slot;
+		typeIndices.pop_back();
+
+		const AssetPathID pathID = m_MetadataPaths[index];
+		if (m_PathMetadata[pathID] == index)
+			m_PathMetadata[pathID] = HashIndex::sc_Invalid;
+
+		// Last metadata is moved to removed place, every index pointing to it is patched
+		const uint32_t last = static_cast<uint32_t>(m_Metadata.size()) - 1;
+		if (index != last)
+		{
+			m_Metadata[index] = std::move(m_Metadata[last]);
+			m_MetadataPaths[index] = m_MetadataPaths[last];
+			m_MetadataTypeSlots[index] = m_MetadataTypeSlots[last];
+
+			m_HandleIndex.Replace(m_Metadata[index].Handle.Hash(), [&](uint32_t value) { return value == last; }, index);
+			m_TypeIndices[static_cast<size_t>(m_Metadata[index].Type)][m_MetadataTypeSlots[index]] = index;
+			if (m_PathMetadata[m_MetadataPaths[index]] == last)
+				m_PathMetadata[m_MetadataPaths[index]] = index;
+		}
+		m_Metadata.pop_back();
+		m_MetadataPaths.pop_back();
+		m_MetadataTypeSlots.pop_back();
+	}
+
+	std::string AssetRegistry::normalizePath(const std::filesystem::path& filepath)
+	{
+		// Generic format uses forward slashes, same file gets same id regardless of separator
+		return filepath.generic_string();
 	}
-}
\ No newline at end of file
+}
@@ -2,32 +2,92 @@
 
 #include "Asset.h"
 
+#include "XYZ/Utils/DataStructures/HashIndex.h"
+
+#include <array>
+#include <deque>
 
 namespace XYZ {
-	struct PathHasher
-	{
-		std::size_t operator()(const std::filesystem::path& path) const
-		{
-			return hash_value(path);
-		}
-	};
 
+	using AssetPathID = uint32_t;
+
+	// Metadata is stored densely and indexed by handle and by interned path id.
+	// Pointers to metadata stay valid when metadata is stored, removing metadata may invalidate them
 	class XYZ_API AssetRegistry
 	{
 	public:
+		static constexpr AssetPathID sc_InvalidPathID = UINT32_MAX;
+
+		// Modification time of scanned directory, cache is valid only if none of them changed
+		struct DirectoryStamp
+		{
+			std::string Path;
+			int64_t		WriteTime;
+		};
+
+		// Meta file metadata was parsed from, file is parsed again only if time or size changed
+		struct FileStamp
+		{
+			std::string Path;
+			int64_t		WriteTime;
+			uint64_t	Size;
+			AssetHandle Handle;
+		};
+
 		void StoreMetadata(const AssetMetadata& metadata);
 		void RemoveMetadata(const AssetHandle& handle);
+		void Reserve(size_t count);
+		void Clear();
 
 		const AssetMetadata* GetMetadata(const AssetHandle& handle) const;
 		const AssetMetadata* GetMetadata(const std::filesystem::path& filepath) const;
+		const AssetMetadata* GetMetadata(AssetPathID pathID) const;
 		const AssetMetadata* GetMetadata(const Ref<Asset>& asset) const { return GetMetadata(asset->GetHandle()); }
 
-		std::unordered_map<AssetHandle, AssetMetadata>::iterator	   begin()		  { return m_AssetMetadata.begin(); }
-		std::unordered_map<AssetHandle, AssetMetadata>::iterator	   end()		  { return m_AssetMetadata.end(); }
-		std::unordered_map<AssetHandle, AssetMetadata>::const_iterator cbegin() const { return m_AssetMetadata.cbegin(); }
-		std::unordered_map<AssetHandle, AssetMetadata>::const_iterator cend()	const { return m_AssetMetadata.cend(); }
+		// Paths are never released, id stays valid after metadata is removed
+		AssetPathID		   InternPath(const std::filesystem::path& filepath);
+		AssetPathID		   FindPathID(const std::filesystem::path& filepath) const;
+		const std::string& GetPath(AssetPathID pathID) const { return m_Paths[pathID]; }
+
+		// Calls func(metadata) for every metadata of type
+		template <typename Func>
+		void ForEach(AssetType type, Func&& func) const;
+
+		size_t GetCount(AssetType type) const { return m_TypeIndices[static_cast<size_t>(type)].size(); }
+		size_t GetCount()				const { return m_Metadata.size(); }
+
+		bool SaveCache(const std::filesystem::path& filepath, const std::vector<DirectoryStamp>& directories, const std::vector<FileStamp>& files) const;
+		// Fails if file is missing or corrupted, stamps are returned for validation by caller
+		bool LoadCache(const std::filesystem::path& filepath, std::vector<DirectoryStamp>& directories, std::vector<FileStamp>& files);
+
+		std::deque<AssetMetadata>::iterator		  begin()		{ return m_Metadata.begin(); }
+		std::deque<AssetMetadata>::iterator		  end()			{ return m_Metadata.end(); }
+		std::deque<AssetMetadata>::const_iterator begin() const { return m_Metadata.cbegin(); }
+		std::deque<AssetMetadata>::const_iterator end()	  const { return m_Metadata.cend(); }
+
 	private:
-		std::unordered_map<AssetHandle, AssetMetadata>					   m_AssetMetadata;
-		std::unordered_map<std::filesystem::path, AssetHandle, PathHasher> m_AssetHandleMap;
+		uint32_t findIndex(const AssetHandle& handle) const;
+		void	 removeIndex(uint32_t index);
+
+		static std::string normalizePath(const std::filesystem::path& filepath);
+
+	private:
+		std::deque<AssetMetadata> m_Metadata;
+		std::vector<AssetPathID>  m_MetadataPaths;	   // Path id of metadata
+		std::vector<uint32_t>	  m_MetadataTypeSlots; // Position of metadata in its type index
+
+		HashIndex				  m_HandleIndex;	   // Handle to metadata index
+		HashIndex				  m_PathIndex;		   // Path string to path id
+		std::vector<std::string>  m_Paths;
+		std::vector<uint32_t>	  m_PathMetadata;	   // Path id to metadata index, ids are dense so no hashing is needed
+
+		std::array<std::vector<uint32_t>, static_cast<size_t>(AssetType::NumTypes)> m_TypeIndices;
 	};
-}
\ No newline at end of file
+
+	template <typename Func>
+	inline void AssetRegistry::ForEach(AssetType type, Func&& func) const
+	{
+		for (const uint32_t index : m_TypeIndices[static_cast<size_t>(type)])
+			func(m_Metadata[index]);
+	}
+}
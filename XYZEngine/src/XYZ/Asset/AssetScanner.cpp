@@ -0,0 +1,261 @@
+#include "stdafx.h"
+#include "AssetScanner.h"
+
+#include "XYZ/Core/ThreadPool.h"
+#include "XYZ/Debug/Profiler.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <yaml-cpp/yaml.h>
+
+namespace XYZ {
+	static void ReadSource(const std::string& filepath, std::string& source)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		std::stringstream strStream;
+		strStream << stream.rdbuf();
+		source = strStream.str();
+	}
+
+
+	void AssetScanner::Scan(
+		const std::vector<std::filesystem::path>& roots,
+		const std::filesystem::path& excluded,
+		const AssetRegistry& previousRegistry,
+		const std::vector<AssetRegistry::FileStamp>& previousFiles,
+		AssetRegistry& result,
+		ThreadPool* pool
+	)
+	{
+		XYZ_PROFILE_FUNC("AssetScanner::Scan");
+		Stopwatch totalTimer;
+		m_Statistics = AssetScanStatistics();
+		m_Directories.clear();
+		m_Files.clear();
+		buildPreviousFileIndex(previousFiles);
+
+		std::vector<DirectoryResult> directories;
+		std::vector<std::filesystem::path> level;
+		for (const auto& root : roots)
+		{
+			std::error_code error;
+			if (root != excluded && std::filesystem::is_directory(root, error))
+				level.push_back(root);
+		}
+
+		// Subdirectories are known only after parent is read, each level is one parallel pass
+		while (!level.empty())
+		{
+			const size_t first = directories.size();
+			const size_t count = level.size();
+			directories.resize(first + count);
+			for (size_t i = 0; i < count; ++i)
+				directories[first + i].Path = std::move(level[i]);
+
+			if (pool && count > sc_DirectoriesPerJob)
+			{
+				JobCounter counter;
+				for (size_t start = 0; start < count; start += sc_DirectoriesPerJob)
+				{
+					DirectoryResult* begin = &directories[first + start];
+					DirectoryResult* end = begin + std::min<size_t>(sc_DirectoriesPerJob, count - start);
+					pool->PushJob(counter, [this, begin, end, &excluded, &previousRegistry]() {
+						XYZ_PROFILE_FUNC("AssetScanner::Scan Job");
+						for (DirectoryResult* directory = begin; directory != end; ++directory)
+							scanDirectory(*directory, excluded, previousRegistry);
+					});
+				}
+				pool->Wait(counter);
+			}
+			else
+			{
+				for (size_t i = first; i < first + count; ++i)
+					scanDirectory(directories[i], excluded, previousRegistry);
+			}
+
+			level.clear();
+			for (size_t i = first; i < first + count; ++i)
+			{
+				for (auto& subdirectory : directories[i].Subdirectories)
+					level.push_back(std::move(subdirectory));
+			}
+		}
+
+		// Registry is filled on calling thread in directory order, result does not depend on job timing
+		Stopwatch insertTimer;
+		size_t fileCount = 0;
+		for (const DirectoryResult& directory : directories)
+			fileCount += directory.Files.size();
+
+		result.Clear();
+		result.Reserve(fileCount);
+		m_Directories.reserve(directories.size());
+		m_Files.reserve(fileCount);
+		for (DirectoryResult& directory : directories)
+		{
+			m_Directories.push_back({ directory.Path.generic_string(), directory.WriteTime });
+			m_Statistics.EnumerateTime += directory.EnumerateTime;
+			m_Statistics.ReadTime += directory.ReadTime;
+			m_Statistics.ParseTime += directory.ParseTime;
+			for (MetaFile& file : directory.Files)
+			{
+				if (!file.Valid)
+				{
+					// Not stamped, file is parsed again on next scan
+					XYZ_CORE_WARN("Failed to load asset meta data {0}", file.Stamp.Path);
+					m_Statistics.Failed++;
+					continue;
+				}
+				if (file.Reused)
+					m_Statistics.Reused++;
+				else
+					m_Statistics.Parsed++;
+
+				result.StoreMetadata(file.Metadata);
+				m_Files.push_back(std::move(file.Stamp));
+			}
+		}
+		m_Statistics.Directories = static_cast<uint32_t>(directories.size());
+		m_Statistics.MetaFiles = static_cast<uint32_t>(fileCount);
+		m_Statistics.InsertTime = insertTimer.Elapsed();
+		m_Statistics.TotalTime = totalTimer.Elapsed();
+
+		m_PreviousFiles = nullptr;
+		m_PreviousFileIndex.Clear();
+	}
+
+	bool AssetScanner::RefreshChangedFiles(AssetRegistry& registry, std::vector<AssetRegistry::FileStamp>& files, uint32_t& refreshed)
+	{
+		XYZ_PROFILE_FUNC("AssetScanner::RefreshChangedFiles");
+		refreshed = 0;
+		std::string source;
+		for (AssetRegistry::FileStamp& file : files)
+		{
+			std::error_code error;
+			const uint64_t size = std::filesystem::file_size(file.Path, error);
+			if (error)
+				return false;
+
+			const int64_t writeTime = GetWriteTime(file.Path);
+			if (writeTime == file.WriteTime && size == file.Size)
+				continue;
+
+			AssetMetadata metadata;
+			ReadSource(file.Path, source);
+			if (writeTime == 0 || !ParseMetadata(source, metadata))
+				return false;
+
+			registry.RemoveMetadata(file.Handle);
+			registry.StoreMetadata(metadata);
+			file.WriteTime = writeTime;
+			file.Size = size;
+			file.Handle = metadata.Handle;
+			refreshed++;
+		}
+		return true;
+	}
+
+	bool AssetScanner::ParseMetadata(const std::string& source, AssetMetadata& metadata)
+	{
+		try
+		{
+			YAML::Node data = YAML::Load(source);
+			auto handle = data["Handle"];
+			auto filePath = data["FilePath"];
+			auto type = data["Type"];
+			if (!handle || !filePath || !type)
+				return false;
+
+			metadata.Handle = AssetHandle(handle.as<std::string>());
+			metadata.FilePath = filePath.as<std::string>();
+			metadata.Type = Utils::AssetTypeFromString(type.as<std::string>());
+			return true;
+		}
+		catch (const YAML::Exception&)
+		{
+			// Runs on worker thread, broken file must not take down scan
+			return false;
+		}
+	}
+
+	int64_t AssetScanner::GetWriteTime(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		const auto time = std::filesystem::last_write_time(path, error);
+		if (error)
+			return 0;
+		return static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	void AssetScanner::scanDirectory(DirectoryResult& directory, const std::filesystem::path& excluded, const AssetRegistry& previousRegistry) const
+	{
+		Stopwatch timer;
+		// Taken before reading, file added during scan changes time and invalidates cache next time
+		directory.WriteTime = GetWriteTime(directory.Path);
+
+		std::error_code error;
+		for (std::filesystem::directory_iterator it(directory.Path, error), end; !error && it != end; it.increment(error))
+		{
+			const std::filesystem::directory_entry& entry = *it;
+			std::error_code entryError;
+			if (entry.is_directory(entryError))
+			{
+				if (entry.path() != excluded)
+					directory.Subdirectories.push_back(entry.path());
+				continue;
+			}
+			if (entry.path().extension() != ".meta")
+				continue;
+
+			MetaFile& file = directory.Files.emplace_back();
+			file.Stamp.Path = entry.path().generic_string();
+			file.Stamp.Size = entry.file_size(entryError);
+			const auto writeTime = entry.last_write_time(entryError);
+			file.Stamp.WriteTime = entryError ? 0 : static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+			const uint32_t previous = m_PreviousFileIndex.Find(std::hash<std::string>{}(file.Stamp.Path), [&](uint32_t index) {
+				return (*m_PreviousFiles)[index].Path == file.Stamp.Path;
+			});
+			if (previous == HashIndex::sc_Invalid || file.Stamp.WriteTime == 0)
+				continue;
+
+			const AssetRegistry::FileStamp& previousStamp = (*m_PreviousFiles)[previous];
+			if (previousStamp.WriteTime != file.Stamp.WriteTime || previousStamp.Size != file.Stamp.Size)
+				continue;
+
+			if (const AssetMetadata* metadata = previousRegistry.GetMetadata(previousStamp.Handle))
+			{
+				file.Metadata = *metadata;
+				file.Stamp.Handle = metadata->Handle;
+				file.Reused = true;
+				file.Valid = true;
+			}
+		}
+		directory.EnumerateTime += timer.Elapsed();
+
+		std::string source;
+		for (MetaFile& file : directory.Files)
+		{
+			if (file.Reused)
+				continue;
+
+			timer.Restart();
+			ReadSource(file.Stamp.Path, source);
+			directory.ReadTime += timer.Elapsed();
+
+			timer.Restart();
+			file.Valid = ParseMetadata(source, file.Metadata);
+			if (file.Valid)
+				file.Stamp.Handle = file.Metadata.Handle;
+			directory.ParseTime += timer.Elapsed();
+		}
+	}
+
+	void AssetScanner::buildPreviousFileIndex(const std::vector<AssetRegistry::FileStamp>& previousFiles)
+	{
+		m_PreviousFiles = &previousFiles;
+		m_PreviousFileIndex.Clear();
+		m_PreviousFileIndex.Reserve(static_cast<uint32_t>(previousFiles.size()));
+		for (uint32_t i = 0; i < previousFiles.size(); ++i)
+			m_PreviousFileIndex.Insert(std::hash<std::string>{}(previousFiles[i].Path), i);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "AssetRegistry.h"
+
+#include <filesystem>
+
+namespace XYZ {
+
+	class ThreadPool;
+
+	// Phase times are summed over all jobs, total is wall time of scan
+	struct AssetScanStatistics
+	{
+		uint32_t Directories = 0;
+		uint32_t MetaFiles = 0;
+		uint32_t Parsed = 0;
+		uint32_t Reused = 0;
+		uint32_t Failed = 0;
+		bool	 CacheHit = false;
+
+		float EnumerateTime = 0.0f;
+		float ReadTime = 0.0f;
+		float ParseTime = 0.0f;
+		float InsertTime = 0.0f;
+		float TotalTime = 0.0f;
+	};
+
+	// Walks directory tree level by level, directories of each level are split between jobs.
+	// Meta files with same time and size as in previous scan are not read, their metadata is copied
+	class XYZ_API AssetScanner
+	{
+	public:
+		static constexpr uint32_t sc_DirectoriesPerJob = 4;
+
+		// Excluded directory and its subdirectories are skipped
+		void Scan(
+			const std::vector<std::filesystem::path>& roots,
+			const std::filesystem::path& excluded,
+			const AssetRegistry& previousRegistry,
+			const std::vector<AssetRegistry::FileStamp>& previousFiles,
+			AssetRegistry& result,
+			ThreadPool* pool = nullptr
+		);
+
+		const std::vector<AssetRegistry::DirectoryStamp>& GetDirectories() const { return m_Directories; }
+		const std::vector<AssetRegistry::FileStamp>&	  GetFiles()	   const { return m_Files; }
+		const AssetScanStatistics&						  GetStatistics()  const { return m_Statistics; }
+
+		// Parses again meta files whose time or size differ from their stamp, stamps are updated.
+		// Fails if any of them is missing or broken, caller should scan instead
+		static bool RefreshChangedFiles(AssetRegistry& registry, std::vector<AssetRegistry::FileStamp>& files, uint32_t& refreshed);
+
+		static bool	   ParseMetadata(const std::string& source, AssetMetadata& metadata);
+		// Zero if time can not be read
+		static int64_t GetWriteTime(const std::filesystem::path& path);
+
+	private:
+		struct MetaFile
+		{
+			AssetRegistry::FileStamp Stamp;
+			AssetMetadata			 Metadata;
+			bool					 Reused = false;
+			bool					 Valid = false;
+		};
+
+		struct DirectoryResult
+		{
+			std::filesystem::path			   Path;
+			int64_t							   WriteTime = 0;
+			std::vector<std::filesystem::path> Subdirectories;
+			std::vector<MetaFile>			   Files;
+
+			float EnumerateTime = 0.0f;
+			float ReadTime = 0.0f;
+			float ParseTime = 0.0f;
+		};
+
+		void scanDirectory(DirectoryResult& directory, const std::filesystem::path& excluded, const AssetRegistry& previousRegistry) const;
+		void buildPreviousFileIndex(const std::vector<AssetRegistry::FileStamp>& previousFiles);
+
+	private:
+		std::vector<AssetRegistry::DirectoryStamp> m_Directories;
+		std::vector<AssetRegistry::FileStamp>	   m_Files;
+		AssetScanStatistics						   m_Statistics;
+
+		// Previous stamps by path, read only during scan
+		const std::vector<AssetRegistry::FileStamp>* m_PreviousFiles = nullptr;
+		HashIndex									 m_PreviousFileIndex;
+	};
+}
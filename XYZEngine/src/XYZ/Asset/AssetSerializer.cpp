@@ -2,6 +2,7 @@
 #include "AssetSerializer.h"
 
 #include "XYZ/Scene/SceneSerializer.h"
+#include "XYZ/Scene/SceneBinarySerializer.h"
 #include "XYZ/Scene/Prefab.h"
 
 #include "XYZ/Renderer/Renderer.h"
@@ -87,13 +88,28 @@ namespace XYZ {
 
 	void SceneAssetSerializer::Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const
 	{
+		// Scene keeps format of existing file, conversion is done from asset browser
+		const std::string filepath = metadata.FilePath.string();
+		if (SceneBinarySerializer::IsBinaryScene(filepath))
+		{
+			SceneBinarySerializer serializer;
+			serializer.Serialize(filepath, asset.As<Scene>());
+			return;
+		}
 		SceneSerializer serializer;
-		serializer.Serialize(metadata.FilePath.string(), asset.As<Scene>());
+		serializer.Serialize(filepath, asset.As<Scene>());
 	}
-	bool SceneAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool SceneAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
+		const std::string filepath = metadata.FilePath.string();
+		if (SceneBinarySerializer::IsBinaryScene(filepath))
+		{
+			SceneBinarySerializer serializer;
+			asset = serializer.Deserialize(filepath);
+			return asset.Raw() != nullptr;
+		}
 		SceneSerializer serializer;
-		asset = serializer.Deserialize(metadata.FilePath.string());
+		asset = serializer.Deserialize(filepath);
 		return true;
 	}
 
@@ -113,12 +129,9 @@ namespace XYZ {
 		fout << out.c_str();
 		fout.flush();
 	}
-	bool ShaderAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool ShaderAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		std::string name = data["Name"].as<std::string>();
 		std::string filePath = data["FilePath"].as<std::string>();
@@ -197,12 +210,9 @@ namespace XYZ {
 		fout << out.c_str();
 		fout.flush();
 	}
-	bool MaterialAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool MaterialAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		AssetHandle shaderHandle = AssetHandle(data["Shader"].as<std::string>());
 		Ref<ShaderAsset> shaderAsset = AssetManager::GetAsset<ShaderAsset>(shaderHandle);
@@ -298,12 +308,9 @@ namespace XYZ {
 		fout << out.c_str();
 		fout.flush();
 	}
-	bool TextureAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool TextureAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		std::string imagePath = data["Image Path"].as<std::string>();
 		uint32_t width = data["Width"].as<uint32_t>();
@@ -374,12 +381,9 @@ namespace XYZ {
 	}
 
 
-	bool MeshSourceAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool MeshSourceAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		auto sourceFilePath = data["SourceFilePath"];
 		if (sourceFilePath)
@@ -444,12 +448,9 @@ namespace XYZ {
 		fout << out.c_str();
 		fout.flush();
 	}
-	bool SkeletonAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool SkeletonAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		auto sourceFilePath = data["SourceFilePath"];
 		asset = Ref<SkeletonAsset>::Create(sourceFilePath.as<std::string>());
@@ -472,12 +473,9 @@ namespace XYZ {
 		fout << out.c_str();
 		fout.flush();
 	}
-	bool AnimationAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool AnimationAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		auto sourceFilePath = data["SourceFilePath"].as<std::string>();
 		auto animationName = data["AnimationName"].as<std::string>();
@@ -507,12 +505,9 @@ namespace XYZ {
 
 
 
-	bool StaticMeshAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool StaticMeshAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		AssetHandle meshSourceHandle(data["MeshSource"].as<std::string>());
 		asset = Ref<StaticMesh>::Create(AssetManager::GetAsset<MeshSource>(meshSourceHandle));
@@ -535,12 +530,9 @@ namespace XYZ {
 		fout.flush();
 	}
 
-	bool AnimatedMeshAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool AnimatedMeshAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		AssetHandle meshSourceHandle(data["MeshSource"].as<std::string>());
 		asset = Ref<AnimatedMesh>::Create(AssetManager::GetAsset<MeshSource>(meshSourceHandle));
@@ -553,12 +545,9 @@ namespace XYZ {
 		SceneSerializer serializer;
 		serializer.Serialize(metadata.FilePath.string(), prefab->m_Scene);
 	}
-	bool PrefabAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool PrefabAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		Ref<Prefab> prefab = Ref<Prefab>::Create();
 
@@ -586,12 +575,9 @@ namespace XYZ {
 		fout << out.c_str();
 		fout.flush();
 	}
-	bool SubTextureSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool SubTextureSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 
 
@@ -627,16 +613,36 @@ namespace XYZ {
 		}
 		out << YAML::EndSeq;
 
+		out << YAML::Key << "Transitions" << YAML::BeginSeq;
+		for (const auto& transition : controller->GetTransitions())
+		{
+			out << YAML::BeginMap;
+			out << YAML::Key << "From" << transition.From;
+			out << YAML::Key << "To" << transition.To;
+			out << YAML::Key << "Duration" << transition.Duration;
+			out << YAML::EndMap;
+		}
+		out << YAML::EndSeq;
+
+		out << YAML::Key << "Layers" << YAML::BeginSeq;
+		for (const auto& layer : controller->GetLayers())
+		{
+			out << YAML::BeginMap;
+			out << YAML::Key << "Name" << layer.Name;
+			out << YAML::Key << "State" << layer.State;
+			out << YAML::Key << "Weight" << layer.Weight;
+			out << YAML::Key << "RootJoint" << layer.RootJoint;
+			out << YAML::EndMap;
+		}
+		out << YAML::EndSeq;
+
 		std::ofstream fout(metadata.FilePath);
 		fout << out.c_str();
 		fout.flush();
 	}
-	bool AnimationControllerAssetSerializer::TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const
+	bool AnimationControllerAssetSerializer::TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const
 	{
-		std::ifstream stream(metadata.FilePath);
-		std::stringstream strStream;
-		strStream << stream.rdbuf();
-		YAML::Node data = YAML::Load(strStream.str());
+		YAML::Node data = YAML::Load(source);
 
 		Ref<AnimationController> controller = Ref<AnimationController>::Create();
 
@@ -656,6 +662,30 @@ namespace XYZ {
 			controller->AddState(stateName, animation);
 		}
 
+		if (auto transitionsData = data["Transitions"])
+		{
+			for (auto transitionData : transitionsData)
+			{
+				controller->SetTransition(
+					transitionData["From"].as<uint32_t>(),
+					transitionData["To"].as<uint32_t>(),
+					transitionData["Duration"].as<float>()
+				);
+			}
+		}
+		if (auto layersData = data["Layers"])
+		{
+			for (auto layerData : layersData)
+			{
+				controller->AddLayer(
+					layerData["Name"].as<std::string>(),
+					layerData["State"].as<uint32_t>(),
+					layerData["Weight"].as<float>(),
+					layerData["RootJoint"].as<std::string>()
+				);
+			}
+		}
+
 		asset = controller;
 		return true;
 	}
@@ -7,7 +7,11 @@ namespace XYZ {
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const = 0;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const = 0;
+		// Source is content of asset file, it is read on I/O thread when streaming
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const = 0;
+
+		// Serializers reading asset file on their own receive empty source
+		virtual bool RequiresSource() const { return true; }
 	};
 
 
@@ -15,7 +19,8 @@ namespace XYZ {
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
+		virtual bool RequiresSource() const override { return false; }
 	};
 
 
@@ -23,14 +28,14 @@ namespace XYZ {
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API MaterialAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 
@@ -38,56 +43,56 @@ namespace XYZ {
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API MeshSourceAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API SkeletonAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API AnimationAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API AnimationControllerAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API StaticMeshAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API AnimatedMeshAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 	class XYZ_API PrefabAssetSerializer : public AssetSerializer
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 
 
@@ -95,6 +100,6 @@ namespace XYZ {
 	{
 	public:
 		virtual void Serialize(const AssetMetadata& metadata, const WeakRef<Asset>& asset) const override;
-		virtual bool TryLoadData(const AssetMetadata& metadata, Ref<Asset>& asset) const override;
+		virtual bool TryLoadData(const AssetMetadata& metadata, const std::string& source, Ref<Asset>& asset) const override;
 	};
 }
\ No newline at end of file
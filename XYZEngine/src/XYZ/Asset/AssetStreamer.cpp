@@ -0,0 +1,289 @@
+#include "stdafx.h"
+#include "AssetStreamer.h"
+#include "AssetManager.h"
+#include "AssetImporter.h"
+
+#include "XYZ/Core/Application.h"
+#include "XYZ/Debug/Profiler.h"
+
+namespace XYZ {
+
+	AssetStreamer::~AssetStreamer()
+	{
+		Stop();
+	}
+
+	void AssetStreamer::Start(uint64_t memoryBudget)
+	{
+		std::unique_lock lock(m_Mutex);
+		if (m_Running)
+			return;
+
+		m_Running = true;
+		m_MemoryBudget = memoryBudget;
+		m_Thread = std::thread(&AssetStreamer::ioThread, this);
+	}
+
+	void AssetStreamer::Stop()
+	{
+		{
+			std::unique_lock lock(m_Mutex);
+			if (!m_Running)
+				return;
+			m_Running = false;
+
+			// Requests already being read or decoded finish on their own
+			for (auto it = m_Requests.begin(); it != m_Requests.end();)
+			{
+				StreamRequest& request = *it->second;
+				if (request.State == RequestState::Queued)
+				{
+					request.State = RequestState::Cancelled;
+					request.Promise.set_value(Ref<Asset>());
+					m_Statistics.QueuedRequests--;
+					m_Statistics.CancelledRequests++;
+					it = m_Requests.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+			m_Queue = {};
+		}
+		m_Condition.notify_all();
+		if (m_Thread.joinable())
+			m_Thread.join();
+
+		// Decode jobs access streamer, they must finish before it is destroyed
+		Application::Get().GetThreadPool().Wait(m_DecodeCounter);
+	}
+
+	std::shared_future<Ref<Asset>> AssetStreamer::Request(const AssetMetadata& metadata, float priority)
+	{
+		std::unique_lock lock(m_Mutex);
+		auto it = m_Requests.find(metadata.Handle);
+		if (it != m_Requests.end())
+		{
+			std::shared_ptr<StreamRequest>& request = it->second;
+			request->RefCount++;
+			m_Statistics.CoalescedRequests++;
+			if (priority > request->Priority && request->State == RequestState::Queued)
+			{
+				request->Priority = priority;
+				pushEntry(request);
+			}
+			return request->Future;
+		}
+
+		auto request = std::make_shared<StreamRequest>();
+		request->Metadata = metadata;
+		request->Priority = priority;
+		request->Future = request->Promise.get_future().share();
+		if (!m_Running)
+		{
+			request->Promise.set_value(Ref<Asset>());
+			return request->Future;
+		}
+
+		m_Requests.emplace(metadata.Handle, request);
+		m_Statistics.QueuedRequests++;
+		pushEntry(request);
+		lock.unlock();
+
+		m_Condition.notify_one();
+		return request->Future;
+	}
+
+	void AssetStreamer::Cancel(const AssetHandle& handle)
+	{
+		std::unique_lock lock(m_Mutex);
+		auto it = m_Requests.find(handle);
+		if (it == m_Requests.end())
+			return;
+
+		StreamRequest& request = *it->second;
+		XYZ_ASSERT(request.RefCount != 0, "Request was cancelled more times than requested");
+		if (--request.RefCount != 0)
+			return;
+
+		// Reading or decoding request is dropped once it reaches decode stage
+		if (request.State == RequestState::Queued)
+		{
+			request.State = RequestState::Cancelled;
+			request.Promise.set_value(Ref<Asset>());
+			m_Statistics.QueuedRequests--;
+			m_Statistics.CancelledRequests++;
+			m_Requests.erase(it);
+		}
+	}
+
+	void AssetStreamer::SetPriority(const AssetHandle& handle, float priority)
+	{
+		std::unique_lock lock(m_Mutex);
+		auto it = m_Requests.find(handle);
+		if (it == m_Requests.end())
+			return;
+
+		std::shared_ptr<StreamRequest>& request = it->second;
+		if (request->State == RequestState::Queued && request->Priority != priority)
+		{
+			request->Priority = priority;
+			pushEntry(request);
+		}
+	}
+
+	void AssetStreamer::SetMemoryBudget(uint64_t bytes)
+	{
+		{
+			std::unique_lock lock(m_Mutex);
+			m_MemoryBudget = bytes;
+		}
+		m_Condition.notify_all();
+	}
+
+	AssetStreamStatistics AssetStreamer::GetStatistics() const
+	{
+		std::unique_lock lock(m_Mutex);
+		AssetStreamStatistics result = m_Statistics;
+		result.MemoryBudget = m_MemoryBudget;
+		return result;
+	}
+
+	float AssetStreamer::CalculatePriority(float distance, bool visible)
+	{
+		const float proximity = 1.0f / (1.0f + std::max(distance, 0.0f));
+		return visible ? 1.0f + proximity : proximity;
+	}
+
+	void AssetStreamer::ioThread()
+	{
+		while (true)
+		{
+			std::shared_ptr<StreamRequest> request;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return !m_Running || canRead(); });
+				if (!m_Running)
+					return;
+
+				request = popRequest();
+				if (!request)
+					continue;
+			}
+
+			XYZ_PROFILE_FUNC("AssetStreamer::ioThread");
+			std::string source;
+			if (!AssetImporter::ReadSource(request->Metadata, source))
+			{
+				{
+					std::unique_lock lock(m_Mutex);
+					request->State = RequestState::Failed;
+					m_Statistics.FailedRequests++;
+					m_Requests.erase(request->Metadata.Handle);
+				}
+				request->Promise.set_value(Ref<Asset>());
+				continue;
+			}
+			{
+				std::unique_lock lock(m_Mutex);
+				// Stop was called while reading, nobody waits for decode anymore
+				if (!m_Running)
+				{
+					m_Requests.erase(request->Metadata.Handle);
+					m_Statistics.CancelledRequests++;
+					lock.unlock();
+					request->Promise.set_value(Ref<Asset>());
+					return;
+				}
+				request->State = RequestState::Decoding;
+				m_Statistics.DecodingRequests++;
+				m_Statistics.BytesInFlight += source.size();
+			}
+
+			// Stop joins this thread before waiting for counter, job is always counted
+			auto& threadPool = Application::Get().GetThreadPool();
+			threadPool.PushJob(m_DecodeCounter, [this, request, source = std::move(source)]() mutable {
+				decode(std::move(request), std::move(source));
+			});
+		}
+	}
+
+	void AssetStreamer::decode(std::shared_ptr<StreamRequest> request, std::string source)
+	{
+		XYZ_PROFILE_FUNC("AssetStreamer::decode");
+		// Request is removed under the same lock as ref count is checked,
+		// so request made again in between is not merged into cancelled one
+		std::unique_lock lock(m_Mutex);
+		const bool cancelled = request->RefCount == 0;
+		Ref<Asset> asset;
+		if (!cancelled)
+		{
+			lock.unlock();
+			if (AssetImporter::TryLoadData(request->Metadata, source, asset))
+				AssetManager::Get().m_LoadedAssets.Set(request->Metadata.Handle, asset.Raw());
+			else
+				asset = nullptr;
+			lock.lock();
+		}
+
+		m_Statistics.DecodingRequests--;
+		m_Statistics.BytesInFlight -= source.size();
+		if (cancelled)
+		{
+			m_Statistics.CancelledRequests++;
+		}
+		else if (!asset.Raw())
+		{
+			request->State = RequestState::Failed;
+			m_Statistics.FailedRequests++;
+		}
+		else
+		{
+			const float latency = request->Timer.Elapsed();
+			m_Statistics.CompletedRequests++;
+			m_TotalLatency += latency;
+			m_Statistics.AverageLatency = m_TotalLatency / m_Statistics.CompletedRequests;
+			m_Statistics.MaxLatency = std::max(m_Statistics.MaxLatency, latency);
+		}
+
+		auto it = m_Requests.find(request->Metadata.Handle);
+		if (it != m_Requests.end() && it->second == request)
+			m_Requests.erase(it);
+		lock.unlock();
+		m_Condition.notify_one();
+		request->Promise.set_value(asset);
+	}
+
+	void AssetStreamer::pushEntry(const std::shared_ptr<StreamRequest>& request)
+	{
+		// Entries with old priority stay in queue and are skipped when popped
+		m_Queue.push({ request->Priority, m_NextOrder++, request });
+	}
+
+	std::shared_ptr<AssetStreamer::StreamRequest> AssetStreamer::popRequest()
+	{
+		while (!m_Queue.empty())
+		{
+			QueueEntry entry = m_Queue.top();
+			m_Queue.pop();
+
+			StreamRequest& request = *entry.Request;
+			if (request.State != RequestState::Queued || request.Priority != entry.Priority)
+				continue;
+
+			request.State = RequestState::Reading;
+			m_Statistics.QueuedRequests--;
+			return entry.Request;
+		}
+		return nullptr;
+	}
+
+	bool AssetStreamer::canRead() const
+	{
+		if (m_Queue.empty())
+			return false;
+		// Single source is always allowed so assets larger than budget can load
+		return m_Statistics.BytesInFlight == 0 || m_Statistics.BytesInFlight < m_MemoryBudget;
+	}
+}
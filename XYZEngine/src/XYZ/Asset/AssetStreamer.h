@@ -0,0 +1,125 @@
+#pragma once
+#include "Asset.h"
+
+#include "XYZ/Core/ThreadPool.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <future>
+#include <queue>
+#include <condition_variable>
+
+namespace XYZ {
+
+	struct AssetStreamStatistics
+	{
+		uint32_t QueuedRequests = 0;
+		uint32_t DecodingRequests = 0;
+		uint64_t BytesInFlight = 0;
+		uint64_t MemoryBudget = 0;
+
+		uint32_t CompletedRequests = 0;
+		uint32_t CancelledRequests = 0;
+		uint32_t FailedRequests = 0; // Source could not be read or decoded
+		uint32_t CoalescedRequests = 0;
+
+		// Time from request to decoded asset in ms
+		float AverageLatency = 0.0f;
+		float MaxLatency = 0.0f;
+	};
+
+	// Same interface as std::future, result is casted to requested type.
+	// Result is null if request was cancelled or asset failed to load
+	template <typename T>
+	class AssetFuture
+	{
+	public:
+		AssetFuture() = default;
+		AssetFuture(std::shared_future<Ref<Asset>> future)
+			: m_Future(std::move(future))
+		{}
+
+		Ref<T> get() const { return m_Future.get().template As<T>(); }
+		void   wait() const { m_Future.wait(); }
+		bool   valid() const { return m_Future.valid(); }
+		bool   IsReady() const { return m_Future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+		// Finished without asset, load failed or request was cancelled
+		bool   IsFailed() const { return IsReady() && !m_Future.get().Raw(); }
+
+	private:
+		std::shared_future<Ref<Asset>> m_Future;
+	};
+
+	// Asset files are read on dedicated I/O thread in priority order and decoded on thread pool.
+	// Read sources are kept until decoded, new reads wait while they exceed memory budget
+	class XYZ_API AssetStreamer
+	{
+	public:
+		AssetStreamer() = default;
+		~AssetStreamer();
+
+		void Start(uint64_t memoryBudget);
+		void Stop();
+
+		// Requests of the same asset are merged and share result, higher priority is read first
+		std::shared_future<Ref<Asset>> Request(const AssetMetadata& metadata, float priority);
+		// Releases one request, asset is not loaded if nobody else requested it
+		void Cancel(const AssetHandle& handle);
+		void SetPriority(const AssetHandle& handle, float priority);
+		void SetMemoryBudget(uint64_t bytes);
+
+		AssetStreamStatistics GetStatistics() const;
+
+		// Visible assets always go before invisible, closer before distant
+		static float CalculatePriority(float distance, bool visible);
+
+	private:
+		enum class RequestState { Queued, Reading, Decoding, Cancelled, Failed };
+
+		struct StreamRequest
+		{
+			AssetMetadata				   Metadata;
+			float						   Priority;
+			uint32_t					   RefCount = 1;
+			RequestState				   State = RequestState::Queued;
+			std::promise<Ref<Asset>>	   Promise;
+			std::shared_future<Ref<Asset>> Future;
+			Stopwatch					   Timer;
+		};
+
+		struct QueueEntry
+		{
+			float						   Priority;
+			uint64_t					   Order;
+			std::shared_ptr<StreamRequest> Request;
+
+			bool operator<(const QueueEntry& other) const
+			{
+				if (Priority != other.Priority)
+					return Priority < other.Priority;
+				return Order > other.Order;
+			}
+		};
+
+		void ioThread();
+		void decode(std::shared_ptr<StreamRequest> request, std::string source);
+
+		void pushEntry(const std::shared_ptr<StreamRequest>& request);
+		std::shared_ptr<StreamRequest> popRequest();
+		bool canRead() const;
+
+	private:
+		std::thread						m_Thread;
+		JobCounter						m_DecodeCounter;
+		mutable std::mutex				m_Mutex;
+		std::condition_variable			m_Condition;
+		bool							m_Running = false;
+
+		std::priority_queue<QueueEntry> m_Queue;
+		std::unordered_map<AssetHandle, std::shared_ptr<StreamRequest>> m_Requests;
+		uint64_t						m_NextOrder = 0;
+
+		uint64_t						m_MemoryBudget = 0;
+		AssetStreamStatistics			m_Statistics;
+		float							m_TotalLatency = 0.0f;
+	};
+}
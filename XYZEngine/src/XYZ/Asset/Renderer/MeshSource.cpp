@@ -303,6 +303,32 @@ namespace XYZ {
 				m_Triangles.push_back({ v1.Position, v2.Position, v3.Position });
 			}
 		}
+
+		std::vector<AABB> triangleBounds;
+		triangleBounds.reserve(m_Triangles.size());
+		for (const auto& triangle : m_Triangles)
+		{
+			triangleBounds.emplace_back(
+				glm::min(glm::min(triangle.V0, triangle.V1), triangle.V2),
+				glm::max(glm::max(triangle.V0, triangle.V1), triangle.V2)
+			);
+		}
+		m_TriangleBVH.Build(triangleBounds);
+	}
+	bool MeshSource::Raycast(const Ray& ray, float& distance) const
+	{
+		bool hit = false;
+		m_TriangleBVH.Raycast(ray, std::numeric_limits<float>::max(), [&](uint32_t index, float& maxDistance) {
+			const Triangle& triangle = m_Triangles[index];
+			float t;
+			if (ray.IntersectsTriangle(triangle.V0, triangle.V1, triangle.V2, t) && t < maxDistance)
+			{
+				maxDistance = t;
+				distance = t;
+				hit = true;
+			}
+		});
+		return hit;
 	}
 	void MeshSource::traverseNodes(aiNode* node, const glm::mat4& parentTransform)
 	{
@@ -5,6 +5,8 @@
 #include "XYZ/Renderer/Buffer.h"
 
 #include "XYZ/Utils/Math/AABB.h"
+#include "XYZ/Utils/Math/BVH.h"
+#include "XYZ/Utils/Math/Ray.h"
 
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
@@ -73,9 +75,13 @@ namespace XYZ {
 		const std::vector<Vertex>&		   GetVertices() const { return m_StaticVertices; }
 		const std::vector<uint32_t>&	   GetIndices() const { return m_Indices; }
 		const std::vector<Triangle>&	   GetTriangles() const { return m_Triangles; }
+		const BVH&						   GetTriangleBVH() const { return m_TriangleBVH; }
+
+		// Finds closest triangle hit by ray in mesh space, distance is in units of ray direction
+		bool Raycast(const Ray& ray, float& distance) const;
 		
-		const std::unordered_map<std::string, uint32_t> GetBoneMapping() const { return m_BoneMapping; }
-		const std::vector<BoneInfo>						GetBoneInfo() const { return m_BoneInfo; }
+		const std::unordered_map<std::string, uint32_t>& GetBoneMapping() const { return m_BoneMapping; }
+		const std::vector<BoneInfo>&						GetBoneInfo() const { return m_BoneInfo; }
 		const std::string& GetSourceFilePath()     const { return m_SourceFilePath; }
 		const glm::mat4&   GetInverseTransform()   const { return m_InverseTransform; }
 		const glm::mat4&   GetSubmeshTransform()   const { return m_SubmeshTransform; }
@@ -107,6 +113,7 @@ namespace XYZ {
 		std::vector<Vertex>			m_StaticVertices;
 		std::vector<uint32_t>		m_Indices;
 		std::vector<Triangle>		m_Triangles;
+		BVH							m_TriangleBVH;
 
 		ozz::unique_ptr<ozz::animation::Skeleton> m_Skeleton;
 		std::unordered_map<std::string, uint32_t> m_BoneMapping;
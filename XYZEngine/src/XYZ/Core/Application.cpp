@@ -224,6 +224,19 @@ namespace XYZ {
 			bool vSync = m_Window->IsVSync();
 			if (ImGui::Checkbox("Vsync", &vSync))
 				m_Window->SetVSync(vSync);
+
+			int framesAhead = static_cast<int>(Renderer::GetFramesAhead());
+			if (ImGui::SliderInt("Frames Ahead", &framesAhead, 1, RendererQueueData::sc_MaxFramesAhead))
+				Renderer::SetFramesAhead(static_cast<uint32_t>(framesAhead));
+
+			const RenderQueueStatistics queueStats = Renderer::GetRenderQueueStatistics();
+			if (ImGui::BeginTable("##RenderQueueTable", 2, ImGuiTableFlags_SizingFixedFit))
+			{
+				UI::TextTableRow("%s", "Render Frame Latency:", "%.3f ms", queueStats.FrameLatency);
+				UI::TextTableRow("%s", "Main Thread Stall:", "%.3f ms", queueStats.StallTime);
+				UI::TextTableRow("%s", "Frames In Flight:", "%u", queueStats.FramesInFlight);
+				ImGui::EndTable();
+			}
 		}
 		ImGui::End();
 	}
@@ -281,7 +294,7 @@ namespace XYZ {
 
 			if (!m_Minimized)
 			{
-				Renderer::BlockRenderThread(); // Sync before new frame				
+				Renderer::WaitForRenderQueue(); // Sync with frame submitted FramesAhead frames ago
 				Renderer::Render();
 
 				m_Window->BeginFrame();
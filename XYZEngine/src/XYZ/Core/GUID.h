@@ -14,6 +14,9 @@ namespace XYZ {
 		GUID();
 		GUID(const std::string& str);
 		GUID(const GUID& other);
+		GUID(uint64_t first, uint64_t second)
+			: m_Data{ first, second }
+		{}
 
 		GUID& operator=(const std::string& str);
 
@@ -53,6 +56,8 @@ namespace XYZ {
 		{
 			return (std::string)*this;
 		}
+		const uint64_t* GetData() const { return m_Data; }
+
 		inline size_t Hash() const
 		{
 			size_t seed = 0;
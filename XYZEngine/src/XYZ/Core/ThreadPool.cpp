@@ -3,12 +3,108 @@
 
 #include "XYZ/Debug/Profiler.h"
 
+#include <deque>
 
 namespace XYZ {
+
+	// Owner pushes and pops from the back, other workers steal from the front.
+	// Injected queue is always popped from the front
+	struct ThreadPool::WorkerQueue
+	{
+		std::mutex		Mutex;
+		std::deque<Job> Jobs;
+	};
+
+	static thread_local ThreadPool* s_CurrentPool = nullptr;
+	static thread_local uint32_t	s_WorkerIndex = 0;
+
+
+	JobCounter::JobCounter(JobCounter* parent)
+		:
+		m_Count(0),
+		m_Parent(parent)
+	{
+	}
+
+	JobCounter::~JobCounter()
+	{
+		XYZ_ASSERT(IsDone(), "Destroying job counter with unfinished jobs");
+	}
+
+	void JobCounter::Increment(uint32_t count)
+	{
+		if (m_Count.fetch_add(count, std::memory_order_acq_rel) == 0 && m_Parent)
+			m_Parent->Increment();
+	}
+
+	void JobCounter::Decrement()
+	{
+		// Counter might be destroyed by waiting thread as soon as it reaches zero
+		JobCounter* parent = m_Parent;
+		if (m_Count.fetch_sub(1, std::memory_order_acq_rel) == 1 && parent)
+			parent->Decrement();
+	}
+
+
+	Job::Job(Job&& other) noexcept
+		:
+		m_Operations(other.m_Operations),
+		m_Counter(other.m_Counter)
+	{
+		if (m_Operations)
+			m_Operations->Move(m_Storage, other.m_Storage);
+		other.m_Operations = nullptr;
+		other.m_Counter = nullptr;
+	}
+
+	Job::~Job()
+	{
+		destroy();
+	}
+
+	Job& Job::operator=(Job&& other) noexcept
+	{
+		if (this != &other)
+		{
+			destroy();
+			m_Operations = other.m_Operations;
+			m_Counter = other.m_Counter;
+			if (m_Operations)
+				m_Operations->Move(m_Storage, other.m_Storage);
+			other.m_Operations = nullptr;
+			other.m_Counter = nullptr;
+		}
+		return *this;
+	}
+
+	void Job::operator()()
+	{
+		m_Operations->Invoke(m_Storage);
+		if (m_Counter)
+		{
+			m_Counter->Decrement();
+			m_Counter = nullptr;
+		}
+	}
+
+	void Job::destroy()
+	{
+		if (m_Operations)
+		{
+			m_Operations->Destroy(m_Storage);
+			m_Operations = nullptr;
+		}
+	}
+
+
 	ThreadPool::ThreadPool()
 		:
 		m_Running(false),
-		m_Waiting(false)
+		m_Waiting(false),
+		m_InjectedQueue(CreateScope<WorkerQueue>()),
+		m_PendingJobs(0),
+		m_ActiveJobs(0),
+		m_SleepingThreads(0)
 	{
 	}
 
@@ -25,11 +121,12 @@ namespace XYZ {
 			m_Running = true;
 			if (numThreads > std::thread::hardware_concurrency())
 				XYZ_CORE_WARN("Creating more threads than the maximum number of threads");
-			{
-				std::unique_lock<std::mutex> lock(m_JobMutex);
-				for (uint32_t i = 0; i < numThreads; ++i)
-					m_Threads.push_back(std::thread(&ThreadPool::worker, this));
-			}
+
+			// Queues must exist before any worker starts stealing
+			for (uint32_t i = 0; i < numThreads; ++i)
+				m_Queues.push_back(CreateScope<WorkerQueue>());
+			for (uint32_t i = 0; i < numThreads; ++i)
+				m_Threads.push_back(std::thread(&ThreadPool::worker, this, i));
 		}
 	}
 
@@ -38,7 +135,10 @@ namespace XYZ {
 		if (m_Running)
 		{
 			WaitForJobs();
-			m_Running = false;
+			{
+				std::scoped_lock lock(m_SleepMutex);
+				m_Running = false;
+			}
 			m_JobAvailableCV.notify_all(); // wake up all threads.
 
 			for (size_t i = 0; i < m_Threads.size(); ++i)
@@ -46,33 +146,146 @@ namespace XYZ {
 				m_Threads[i].join();
 			}
 			m_Threads.clear();
+			m_Queues.clear();
 		}
 	}
 	void ThreadPool::WaitForJobs()
 	{
 		m_Waiting = true;
-		std::unique_lock<std::mutex> lock(m_JobMutex);
-		m_JobDoneCV.wait(lock, [this] { return m_JobQueue.empty(); });
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_JobDoneCV.wait(lock, [this] { return m_PendingJobs == 0 && m_ActiveJobs == 0; });
 		m_Waiting = false;
 	}
-	void ThreadPool::worker()
+
+	void ThreadPool::Wait(const JobCounter& counter)
+	{
+		XYZ_PROFILE_FUNC("ThreadPool::Wait");
+		while (!counter.IsDone())
+		{
+			if (!tryExecuteJob())
+				std::this_thread::yield();
+		}
+	}
+
+	void ThreadPool::push(Job&& job)
+	{
+		if (m_Queues.empty())
+		{
+			// No workers, execute on calling thread
+			job();
+			return;
+		}
+
+		// Workers push to their own queue, jobs from other threads keep their order in injected queue
+		WorkerQueue& queue = s_CurrentPool == this ? *m_Queues[s_WorkerIndex] : *m_InjectedQueue;
+		{
+			// Counted under queue lock, job can not be popped and uncounted before this
+			std::scoped_lock lock(queue.Mutex);
+			queue.Jobs.push_back(std::move(job));
+			m_PendingJobs++;
+		}
+
+		if (m_SleepingThreads != 0)
+		{
+			{ std::scoped_lock lock(m_SleepMutex); }
+			m_JobAvailableCV.notify_one();
+		}
+	}
+
+	bool ThreadPool::tryExecuteJob()
 	{
+		if (m_Queues.empty())
+			return false;
+
 		Job job;
+		if (s_CurrentPool == this)
+		{
+			if (!tryPop(s_WorkerIndex, job) && !tryPopInjected(job) && !trySteal(s_WorkerIndex, job))
+				return false;
+		}
+		else if (!tryPopInjected(job) && !trySteal(static_cast<uint32_t>(m_Queues.size()), job))
+		{
+			return false;
+		}
+
+		m_ActiveJobs++;
+		m_PendingJobs--;
+		job();
+		onJobFinished();
+		return true;
+	}
+
+	bool ThreadPool::tryPop(uint32_t queueIndex, Job& job)
+	{
+		WorkerQueue& queue = *m_Queues[queueIndex];
+		std::scoped_lock lock(queue.Mutex);
+		if (queue.Jobs.empty())
+			return false;
+
+		job = std::move(queue.Jobs.back());
+		queue.Jobs.pop_back();
+		return true;
+	}
+
+	bool ThreadPool::tryPopInjected(Job& job)
+	{
+		std::scoped_lock lock(m_InjectedQueue->Mutex);
+		if (m_InjectedQueue->Jobs.empty())
+			return false;
+
+		job = std::move(m_InjectedQueue->Jobs.front());
+		m_InjectedQueue->Jobs.pop_front();
+		return true;
+	}
+
+	bool ThreadPool::trySteal(uint32_t thiefIndex, Job& job)
+	{
+		const uint32_t numQueues = static_cast<uint32_t>(m_Queues.size());
+		for (uint32_t i = 1; i <= numQueues; ++i)
+		{
+			const uint32_t victimIndex = (thiefIndex + i) % numQueues;
+			if (victimIndex == thiefIndex)
+				continue;
+
+			WorkerQueue& queue = *m_Queues[victimIndex];
+			std::unique_lock lock(queue.Mutex, std::try_to_lock);
+			if (!lock.owns_lock() || queue.Jobs.empty())
+				continue;
+
+			job = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			return true;
+		}
+		return false;
+	}
+
+	void ThreadPool::onJobFinished()
+	{
+		if (--m_ActiveJobs == 0 && m_Waiting && m_PendingJobs == 0)
+		{
+			{ std::scoped_lock lock(m_SleepMutex); }
+			m_JobDoneCV.notify_all();
+		}
+	}
+
+	void ThreadPool::worker(uint32_t index)
+	{
 		XYZ_PROFILE_THREAD("WorkerThread");
+		s_CurrentPool = this;
+		s_WorkerIndex = index;
 
 		while (true)
 		{
-			{
-				std::unique_lock<std::mutex> lock(m_JobMutex);
-				m_JobAvailableCV.wait(lock, [&] { return !m_JobQueue.empty() || !m_Running; });
-				if (!m_Running && m_JobQueue.empty())
-					return;
+			if (tryExecuteJob())
+				continue;
 
-				job = std::move(m_JobQueue.front());
-				m_JobQueue.pop();
-			}
-			job();		
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_SleepingThreads++;
+			m_JobAvailableCV.wait(lock, [&] { return m_PendingJobs != 0 || !m_Running; });
+			m_SleepingThreads--;
+			if (!m_Running && m_PendingJobs == 0)
+				return;
 		}
 	}
-	
-}
\ No newline at end of file
+
+}
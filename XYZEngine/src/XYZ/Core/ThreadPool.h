@@ -1,18 +1,109 @@
 #pragma once
-#include "XYZ/Utils/DataStructures/ThreadQueue.h"
-#include "XYZ/Utils/DataStructures/FreeList.h"
 #include "XYZ/Core/Core.h"
 
 #include <thread>
 #include <future>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <queue>
+#include <cstddef>
 
 namespace XYZ {
 
+	// Counts unfinished jobs, used for fork-join waits without futures.
+	// Child counter keeps its parent pending while it has unfinished jobs
+	class XYZ_API JobCounter
+	{
+	public:
+		JobCounter(JobCounter* parent = nullptr);
+		JobCounter(const JobCounter& other) = delete;
+		~JobCounter();
+
+		JobCounter& operator=(const JobCounter& other) = delete;
+
+		void Increment(uint32_t count = 1);
+		void Decrement();
+
+		bool	 IsDone()   const { return m_Count.load(std::memory_order_acquire) == 0; }
+		uint32_t GetCount() const { return m_Count.load(std::memory_order_acquire); }
+
+	private:
+		std::atomic_uint32_t m_Count;
+		JobCounter*			 m_Parent;
+	};
+
+
+	// Type erased callable with inline storage, small jobs are not heap allocated
+	class XYZ_API Job
+	{
+	public:
+		static constexpr size_t sc_BufferSize = 48;
+
+	public:
+		Job() = default;
+
+		template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Job>>>
+		Job(F&& func, JobCounter* counter = nullptr);
+
+		Job(const Job& other) = delete;
+		Job(Job&& other) noexcept;
+		~Job();
+
+		Job& operator=(const Job& other) = delete;
+		Job& operator=(Job&& other) noexcept;
+
+		// Executes job and decrements counter
+		void operator()();
+
+		bool Valid() const { return m_Operations != nullptr; }
+
+	private:
+		void destroy();
+
+		struct Operations
+		{
+			void(*Invoke)(void* storage);
+			void(*Move)(void* dst, void* src);
+			void(*Destroy)(void* storage);
+		};
+
+		template <typename Functor>
+		struct InlineOperations
+		{
+			static void Invoke(void* storage)			{ (*static_cast<Functor*>(storage))(); }
+			static void Destroy(void* storage)			{ static_cast<Functor*>(storage)->~Functor(); }
+			static void Move(void* dst, void* src)
+			{
+				new (dst)Functor(std::move(*static_cast<Functor*>(src)));
+				Destroy(src);
+			}
+			static constexpr Operations Table{ &Invoke, &Move, &Destroy };
+		};
+
+		template <typename Functor>
+		struct HeapOperations
+		{
+			static Functor*& Get(void* storage)			{ return *static_cast<Functor**>(storage); }
+			static void Invoke(void* storage)			{ (*Get(storage))(); }
+			static void Destroy(void* storage)			{ delete Get(storage); }
+			static void Move(void* dst, void* src)
+			{
+				new (dst)Functor*(Get(src));
+				Get(src) = nullptr;
+			}
+			static constexpr Operations Table{ &Invoke, &Move, &Destroy };
+		};
+
+	private:
+		alignas(std::max_align_t) std::byte m_Storage[sc_BufferSize];
+		const Operations*					m_Operations = nullptr;
+		JobCounter*							m_Counter = nullptr;
+	};
+
+
 	class XYZ_API ThreadPool
 	{
-		using Job = std::function<void()>;
 	public:
 		ThreadPool();
 		ThreadPool(const ThreadPool& other) = delete;
@@ -23,56 +114,113 @@ namespace XYZ {
 
 		void WaitForJobs();
 
+		// Calling thread executes pending jobs until counter is done
+		void Wait(const JobCounter& counter);
+
 		template <typename F, typename... A>
 		void PushJob(F&& task, A&&... args);
-		
+
+		template <typename F, typename... A>
+		void PushJob(JobCounter& counter, F&& task, A&&... args);
+
 		template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
-		std::future<R> SubmitJob(F&& task, A&&... args);	
+		std::future<R> SubmitJob(F&& task, A&&... args);
+
+		uint32_t GetNumThreads() const { return static_cast<uint32_t>(m_Threads.size()); }
 
-	private:	
-		void worker();
+	private:
+		void push(Job&& job);
+		bool tryExecuteJob();
+		bool tryPop(uint32_t queueIndex, Job& job);
+		bool tryPopInjected(Job& job);
+		bool trySteal(uint32_t thiefIndex, Job& job);
+		void onJobFinished();
+
+		void worker(uint32_t index);
+
+		template <typename F, typename... A>
+		static auto bindJob(F&& task, A&&... args);
 
 	private:
+		struct WorkerQueue;
+
 		std::atomic_bool		 m_Running;
 		std::atomic_bool		 m_Waiting;
 		std::vector<std::thread> m_Threads;
 
-		std::mutex				m_JobMutex;
-		std::queue<Job>			m_JobQueue;
+		std::vector<Scope<WorkerQueue>> m_Queues;
+		// Jobs pushed from outside of pool, executed in order of submission
+		Scope<WorkerQueue>		 m_InjectedQueue;
+		std::atomic_uint32_t	 m_PendingJobs;
+		std::atomic_uint32_t	 m_ActiveJobs;
+		std::atomic_uint32_t	 m_SleepingThreads;
+
+		std::mutex				m_SleepMutex;
 		std::condition_variable m_JobAvailableCV;
 		std::condition_variable m_JobDoneCV;
 	};
 
 
-	template<typename F, typename ...A>
-	inline void ThreadPool::PushJob(F&& task, A && ...args)
+	template <typename F, typename>
+	inline Job::Job(F&& func, JobCounter* counter)
+		:
+		m_Counter(counter)
 	{
-		Job taskFunction = std::bind(std::forward<F>(task), std::forward<A>(args)...);
+		using Functor = std::decay_t<F>;
+		if constexpr (sizeof(Functor) <= sc_BufferSize
+				   && alignof(Functor) <= alignof(std::max_align_t)
+				   && std::is_nothrow_move_constructible_v<Functor>)
 		{
-			const std::scoped_lock jobsLock(m_JobMutex);
-			m_JobQueue.push(taskFunction);
+			new (m_Storage)Functor(std::forward<F>(func));
+			m_Operations = &InlineOperations<Functor>::Table;
 		}
-		m_JobAvailableCV.notify_one();
+		else
+		{
+			new (m_Storage)Functor*(new Functor(std::forward<F>(func)));
+			m_Operations = &HeapOperations<Functor>::Table;
+		}
+	}
+
+	template <typename F, typename... A>
+	inline auto ThreadPool::bindJob(F&& task, A&&... args)
+	{
+		if constexpr (sizeof...(A) == 0)
+			return std::forward<F>(task);
+		else
+			return std::bind(std::forward<F>(task), std::forward<A>(args)...);
+	}
+
+	template<typename F, typename ...A>
+	inline void ThreadPool::PushJob(F&& task, A && ...args)
+	{
+		push(Job(bindJob(std::forward<F>(task), std::forward<A>(args)...)));
+	}
+
+	template<typename F, typename ...A>
+	inline void ThreadPool::PushJob(JobCounter& counter, F&& task, A && ...args)
+	{
+		counter.Increment();
+		push(Job(bindJob(std::forward<F>(task), std::forward<A>(args)...), &counter));
 	}
 
 	template<typename F, typename ...A, typename R>
 	inline std::future<R> ThreadPool::SubmitJob(F&& task, A && ...args)
 	{
-		std::function<R()> taskFunction = std::bind(std::forward<F>(task), std::forward<A>(args)...);
 		std::shared_ptr<std::promise<R>> taskPromise = std::make_shared<std::promise<R>>();
-		
-		PushJob([taskFunction, taskPromise] {			
+		std::future<R> future = taskPromise->get_future();
+
+		push(Job([taskFunction = bindJob(std::forward<F>(task), std::forward<A>(args)...), taskPromise]() mutable {
 			if constexpr (std::is_void_v<R>)
 			{
-				std::invoke(task_function);
+				std::invoke(taskFunction);
 				taskPromise->set_value();
 			}
 			else
 			{
 				taskPromise->set_value(std::invoke(taskFunction));
-			}			
-		});
-		return taskPromise->get_future();
+			}
+		}));
+		return future;
 	}
 
-}
\ No newline at end of file
+}
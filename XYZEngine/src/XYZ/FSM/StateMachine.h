@@ -17,8 +17,9 @@ namespace XYZ {
 		void SetState(uint32_t id);
 		void SetAllowTransition(uint32_t fromID, uint32_t toID, bool value);
 	
-		inline bool		CanTransitTo(uint32_t id) const { return m_CurrentState->AllowedTransitions.test(id); }
-		inline uint32_t GetCurrentState()		  const { return m_CurrentState->ID; }
+		inline bool		CanTransitTo(uint32_t id) const { return m_States[m_CurrentState].AllowedTransitions.test(id); }
+		inline bool		IsTransitionAllowed(uint32_t fromID, uint32_t toID) const { return m_States[fromID].AllowedTransitions.test(toID); }
+		inline uint32_t GetCurrentState()		  const { return m_CurrentState; }
 		
 	private:
 		struct State
@@ -27,22 +28,26 @@ namespace XYZ {
 			uint32_t			   ID;
 		};
 	
-		State* m_CurrentState;
-		State  m_States[NumStates];
+		// Index instead of pointer so state machine can be copied
+		uint32_t m_CurrentState;
+		State	 m_States[NumStates];
 	};
 	
 	template<uint32_t NumStates>
 	inline StateMachine<NumStates>::StateMachine(uint32_t defaultId)
+		:
+		m_CurrentState(defaultId)
 	{
-		m_CurrentState = &m_States[defaultId];
+		for (uint32_t i = 0; i < NumStates; ++i)
+			m_States[i].ID = i;
 	}
 	
 	template<uint32_t NumStates>
 	inline bool StateMachine<NumStates>::TransitionTo(uint32_t id)
 	{
-		if (m_CurrentState->AllowedTransitions.test(id))
+		if (m_States[m_CurrentState].AllowedTransitions.test(id))
 		{
-			m_CurrentState = &m_States[id];
+			m_CurrentState = id;
 			return true;
 		}
 		return false;
@@ -51,7 +56,7 @@ namespace XYZ {
 	template<uint32_t NumStates>
 	inline void StateMachine<NumStates>::SetState(uint32_t id)
 	{
-		m_CurrentState = &m_States[id];
+		m_CurrentState = id;
 	}
 	
 	template<uint32_t NumStates>
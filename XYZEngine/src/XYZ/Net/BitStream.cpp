@@ -0,0 +1,95 @@
+#include "stdafx.h"
+#include "BitStream.h"
+
+namespace XYZ {
+
+	void BitWriter::Write(uint32_t value, uint32_t bits)
+	{
+		XYZ_ASSERT(bits <= 32, "Can not write more than 32 bits at once");
+		uint64_t pending = bits < 32 ? (value & ((1ull << bits) - 1)) : value;
+		while (bits != 0)
+		{
+			const uint32_t offset = m_BitsWritten & 7;
+			if (offset == 0)
+				m_Data.push_back(0);
+
+			const uint32_t count = std::min(8 - offset, bits);
+			m_Data.back() |= static_cast<uint8_t>((pending & ((1u << count) - 1)) << offset);
+			pending >>= count;
+			bits -= count;
+			m_BitsWritten += count;
+		}
+	}
+
+	void BitWriter::WriteBytes(const void* data, uint32_t size)
+	{
+		Align();
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		m_Data.insert(m_Data.end(), bytes, bytes + size);
+		m_BitsWritten += size * 8;
+	}
+
+	void BitWriter::Align()
+	{
+		m_BitsWritten = static_cast<uint32_t>(m_Data.size()) * 8;
+	}
+
+	void BitWriter::Clear()
+	{
+		m_Data.clear();
+		m_BitsWritten = 0;
+	}
+
+	BitReader::BitReader(const void* data, uint32_t size)
+		:
+		m_Data(static_cast<const uint8_t*>(data)),
+		m_Size(size)
+	{
+	}
+
+	uint32_t BitReader::Read(uint32_t bits)
+	{
+		XYZ_ASSERT(bits <= 32, "Can not read more than 32 bits at once");
+		if (m_Failed || bits > GetBitsLeft())
+		{
+			m_Failed = true;
+			return 0;
+		}
+		uint64_t value = 0;
+		uint32_t read = 0;
+		while (read != bits)
+		{
+			const uint32_t offset = m_BitsRead & 7;
+			const uint32_t count = std::min(8 - offset, bits - read);
+			const uint64_t chunk = (m_Data[m_BitsRead >> 3] >> offset) & ((1u << count) - 1);
+			value |= chunk << read;
+			read += count;
+			m_BitsRead += count;
+		}
+		return static_cast<uint32_t>(value);
+	}
+
+	void BitReader::ReadBytes(void* data, uint32_t size)
+	{
+		if (const uint8_t* span = ReadSpan(size))
+			memcpy(data, span, size);
+	}
+
+	const uint8_t* BitReader::ReadSpan(uint32_t size)
+	{
+		Align();
+		if (m_Failed || size > GetBitsLeft() / 8)
+		{
+			m_Failed = true;
+			return nullptr;
+		}
+		const uint8_t* span = m_Data + m_BitsRead / 8;
+		m_BitsRead += size * 8;
+		return span;
+	}
+
+	void BitReader::Align()
+	{
+		m_BitsRead = std::min((m_BitsRead + 7) & ~7u, m_Size * 8);
+	}
+}
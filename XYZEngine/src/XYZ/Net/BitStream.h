@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace XYZ {
+
+	// Values are packed LSB first with no padding between them
+	class BitWriter
+	{
+	public:
+		void Write(uint32_t value, uint32_t bits);
+		void WriteBool(bool value) { Write(value ? 1 : 0, 1); }
+		// Starts at next byte boundary
+		void WriteBytes(const void* data, uint32_t size);
+		void Align();
+		void Clear();
+
+		const uint8_t* GetData()		const { return m_Data.data(); }
+		uint32_t	   GetSize()		const { return static_cast<uint32_t>(m_Data.size()); }
+		uint32_t	   GetBitsWritten() const { return m_BitsWritten; }
+
+	private:
+		std::vector<uint8_t> m_Data;
+		uint32_t			 m_BitsWritten = 0;
+	};
+
+	// Reading past end fails and leaves reader in failed state, caller checks result once at the end
+	class BitReader
+	{
+	public:
+		BitReader(const void* data, uint32_t size);
+
+		uint32_t Read(uint32_t bits);
+		bool	 ReadBool() { return Read(1) != 0; }
+		void	 ReadBytes(void* data, uint32_t size);
+		// Starts at next byte boundary, returns pointer into read data or nullptr
+		const uint8_t* ReadSpan(uint32_t size);
+		void	 Align();
+		// Marks data as malformed, used when value read is out of range
+		void	 Fail() { m_Failed = true; }
+
+		bool	 IsValid()		  const { return !m_Failed; }
+		uint32_t GetBitsRead()	  const { return m_BitsRead; }
+		uint32_t GetBitsLeft()	  const { return m_Size * 8 - m_BitsRead; }
+
+	private:
+		const uint8_t* m_Data;
+		uint32_t	   m_Size;
+		uint32_t	   m_BitsRead = 0;
+		bool		   m_Failed = false;
+	};
+
+	namespace Utils {
+		// Number of bits needed to store values in range [0, value]
+		inline uint32_t BitsRequired(uint32_t value)
+		{
+			uint32_t bits = 0;
+			while (value != 0)
+			{
+				bits++;
+				value >>= 1;
+			}
+			return bits;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace XYZ {
+	namespace Net {
+
+		// Bounded ring, any number of threads push, one thread pops. Every cell carries sequence
+		// that tells whether it is free for producer of given position or ready for consumer.
+		// Producers reserve position with compare exchange, consumer does not write shared counter
+		template <typename T>
+		class MPSCQueue
+		{
+		public:
+			// Capacity is rounded up to power of two
+			explicit MPSCQueue(uint32_t capacity)
+			{
+				uint32_t size = 2;
+				while (size < capacity)
+					size <<= 1;
+
+				m_Mask = size - 1;
+				m_Cells = std::make_unique<Cell[]>(size);
+				for (uint32_t i = 0; i < size; ++i)
+					m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+			}
+
+			MPSCQueue(const MPSCQueue<T>&) = delete;
+			MPSCQueue<T>& operator=(const MPSCQueue<T>&) = delete;
+
+			// Returns false if queue is full, value is not moved from then
+			bool TryPush(T&& value)
+			{
+				size_t position = m_Tail.load(std::memory_order_relaxed);
+				while (true)
+				{
+					Cell& cell = m_Cells[position & m_Mask];
+					const size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+					const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+					if (difference == 0)
+					{
+						if (m_Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						{
+							cell.Value = std::move(value);
+							cell.Sequence.store(position + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (difference < 0)
+					{
+						return false;
+					}
+					else
+					{
+						position = m_Tail.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+			// Called only from consumer thread
+			bool TryPop(T& value)
+			{
+				Cell& cell = m_Cells[m_Head & m_Mask];
+				const size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+				if (sequence != m_Head + 1)
+					return false;
+
+				value = std::move(cell.Value);
+				cell.Sequence.store(m_Head + m_Mask + 1, std::memory_order_release);
+				m_Head++;
+				m_PublishedHead.store(m_Head, std::memory_order_relaxed);
+				return true;
+			}
+
+			// Approximate when called while other threads push or pop
+			size_t Size() const
+			{
+				const size_t tail = m_Tail.load(std::memory_order_relaxed);
+				const size_t head = m_PublishedHead.load(std::memory_order_relaxed);
+				return tail > head ? tail - head : 0;
+			}
+
+			bool	 Empty()	const { return Size() == 0; }
+			uint32_t Capacity() const { return static_cast<uint32_t>(m_Mask + 1); }
+
+		private:
+			struct Cell
+			{
+				std::atomic<size_t> Sequence;
+				T					Value;
+			};
+
+			std::unique_ptr<Cell[]> m_Cells;
+			size_t					m_Mask = 0;
+
+			// Producers and consumer write different cache lines
+			alignas(64) std::atomic<size_t> m_Tail = 0;
+			alignas(64) size_t				m_Head = 0;
+			std::atomic<size_t>				m_PublishedHead = 0; // Read by Size from other threads
+		};
+	}
+}
@@ -0,0 +1,270 @@
+#include "stdafx.h"
+#include "MessageBuffer.h"
+
+#include "XYZ/Utils/DataStructures/SlabAllocator.h"
+
+namespace XYZ {
+	namespace Net {
+
+		static SlabAllocator& getAllocator()
+		{
+			static SlabAllocator s_Allocator;
+			return s_Allocator;
+		}
+
+		MessageBuffer::MessageBuffer(const MessageBuffer& other)
+			:
+			m_Storage(other.m_Storage)
+		{
+			if (m_Storage)
+				m_Storage->RefCount.fetch_add(1, std::memory_order_relaxed);
+		}
+		MessageBuffer::MessageBuffer(MessageBuffer&& other) noexcept
+			:
+			m_Storage(other.m_Storage)
+		{
+			other.m_Storage = nullptr;
+		}
+		MessageBuffer::~MessageBuffer()
+		{
+			release();
+		}
+		MessageBuffer& MessageBuffer::operator=(const MessageBuffer& other)
+		{
+			if (m_Storage != other.m_Storage)
+			{
+				release();
+				m_Storage = other.m_Storage;
+				if (m_Storage)
+					m_Storage->RefCount.fetch_add(1, std::memory_order_relaxed);
+			}
+			return *this;
+		}
+		MessageBuffer& MessageBuffer::operator=(MessageBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				release();
+				m_Storage = other.m_Storage;
+				other.m_Storage = nullptr;
+			}
+			return *this;
+		}
+
+		void MessageBuffer::Write(const void* data, uint32_t size)
+		{
+			if (size == 0)
+				return;
+
+			detach();
+			reserveStorage();
+			XYZ_ASSERT(m_Storage->Size + size <= sc_MaxSize, "Message is too big");
+
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			while (size != 0)
+			{
+				Segment* tail = writableTail(size);
+				const uint32_t count = std::min(size, tail->Capacity - tail->Size);
+				memcpy(tail->Data() + tail->Size, bytes, count);
+				tail->Size += count;
+				m_Storage->Size += count;
+				bytes += count;
+				size -= count;
+			}
+		}
+
+		bool MessageBuffer::Read(Cursor& cursor, void* data, uint32_t size) const
+		{
+			if (size == 0)
+				return true;
+			if (cursor.m_Position + size > Size())
+				return false;
+
+			const Segment* segment = cursor.m_Segment;
+			uint32_t offset = cursor.m_Offset;
+			if (cursor.m_StorageID != m_Storage->ID || !segment)
+			{
+				segment = m_Storage->Head;
+				offset = cursor.m_Position;
+				while (offset > segment->Size)
+				{
+					offset -= segment->Size;
+					segment = segment->Next;
+				}
+			}
+
+			uint8_t* bytes = static_cast<uint8_t*>(data);
+			uint32_t left = size;
+			while (left != 0)
+			{
+				if (offset == segment->Size)
+				{
+					segment = segment->Next;
+					offset = 0;
+				}
+				const uint32_t count = std::min(left, segment->Size - offset);
+				memcpy(bytes, segment->Data() + offset, count);
+				offset += count;
+				bytes += count;
+				left -= count;
+			}
+
+			cursor.m_StorageID = m_Storage->ID;
+			cursor.m_Segment = segment;
+			cursor.m_Offset = offset;
+			cursor.m_Position += size;
+			return true;
+		}
+
+		void MessageBuffer::Resize(uint32_t size)
+		{
+			XYZ_ASSERT(size <= sc_MaxSize, "Message is too big");
+			if (size == Size())
+				return;
+			if (size == 0)
+			{
+				Clear();
+				return;
+			}
+
+			detach();
+			reserveStorage();
+			if (size > m_Storage->Size)
+			{
+				uint32_t left = size - m_Storage->Size;
+				while (left != 0)
+				{
+					Segment* tail = writableTail(left);
+					const uint32_t count = std::min(left, tail->Capacity - tail->Size);
+					tail->Size += count;
+					left -= count;
+				}
+			}
+			else
+			{
+				Segment* segment = m_Storage->Head;
+				uint32_t kept = segment->Size;
+				while (kept < size)
+				{
+					segment = segment->Next;
+					kept += segment->Size;
+				}
+				segment->Size -= kept - size;
+
+				Segment* next = segment->Next;
+				segment->Next = nullptr;
+				m_Storage->Tail = segment;
+				while (next)
+				{
+					Segment* freed = next;
+					next = next->Next;
+					freeSegment(freed);
+				}
+				// Cursors may point to released segments
+				m_Storage->ID = nextStorageID();
+			}
+			m_Storage->Size = size;
+		}
+
+		void MessageBuffer::Clear()
+		{
+			release();
+		}
+
+		void MessageBuffer::GetBuffers(std::vector<asio::const_buffer>& buffers) const
+		{
+			for (const Segment* segment = m_Storage ? m_Storage->Head : nullptr; segment; segment = segment->Next)
+				buffers.push_back(asio::buffer(segment->Data(), segment->Size));
+		}
+
+		void MessageBuffer::GetBuffers(std::vector<asio::mutable_buffer>& buffers)
+		{
+			detach();
+			for (Segment* segment = m_Storage ? m_Storage->Head : nullptr; segment; segment = segment->Next)
+				buffers.push_back(asio::buffer(segment->Data(), segment->Size));
+		}
+
+		void MessageBuffer::detach()
+		{
+			if (IsUnique())
+				return;
+
+			// Only place where bytes are copied, happens if shared message is modified
+			MessageBuffer copy;
+			for (const Segment* segment = m_Storage->Head; segment; segment = segment->Next)
+				copy.Write(segment->Data(), segment->Size);
+			*this = std::move(copy);
+		}
+
+		void MessageBuffer::release()
+		{
+			if (!m_Storage)
+				return;
+
+			if (m_Storage->RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				Segment* segment = m_Storage->Head;
+				while (segment)
+				{
+					Segment* next = segment->Next;
+					freeSegment(segment);
+					segment = next;
+				}
+				m_Storage->~Storage();
+				getAllocator().Deallocate(m_Storage);
+			}
+			m_Storage = nullptr;
+		}
+
+		void MessageBuffer::reserveStorage()
+		{
+			if (!m_Storage)
+				m_Storage = createStorage();
+		}
+
+		MessageBuffer::Segment* MessageBuffer::writableTail(uint32_t required)
+		{
+			Segment* tail = m_Storage->Tail;
+			if (tail && tail->Size < tail->Capacity)
+				return tail;
+
+			Segment* segment = allocateSegment(required, tail ? tail->Capacity : 0);
+			if (tail)
+				tail->Next = segment;
+			else
+				m_Storage->Head = segment;
+			m_Storage->Tail = segment;
+			return segment;
+		}
+
+		MessageBuffer::Storage* MessageBuffer::createStorage()
+		{
+			Storage* storage = static_cast<Storage*>(getAllocator().Allocate(sizeof(Storage)));
+			new(storage) Storage{ { 1 }, 0, nextStorageID(), nullptr, nullptr };
+			return storage;
+		}
+
+		uint64_t MessageBuffer::nextStorageID()
+		{
+			static std::atomic<uint64_t> s_NextID = 1;
+			return s_NextID.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		MessageBuffer::Segment* MessageBuffer::allocateSegment(uint32_t required, uint32_t previousCapacity)
+		{
+			// Small messages take one small block, big ones grow to full segments in few steps
+			const uint32_t requested = std::max(required, previousCapacity * 2) + sizeof(Segment);
+			const uint32_t size = SlabAllocator::GetClassSize(SlabAllocator::GetSizeClass(std::clamp(requested, sc_MinSegmentSize, sc_SegmentSize)));
+			Segment* segment = static_cast<Segment*>(getAllocator().Allocate(size));
+			segment->Next = nullptr;
+			segment->Size = 0;
+			segment->Capacity = size - sizeof(Segment);
+			return segment;
+		}
+
+		void MessageBuffer::freeSegment(Segment* segment)
+		{
+			getAllocator().Deallocate(segment);
+		}
+	}
+}
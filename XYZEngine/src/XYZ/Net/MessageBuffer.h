@@ -0,0 +1,120 @@
+#pragma once
+#include "Core.h"
+
+#include <atomic>
+#include <vector>
+
+namespace XYZ {
+	namespace Net {
+
+		// Non owning buffer sequence, asio copies sequence into every operation and copy of vector would allocate
+		template <typename Buffer>
+		class BufferSequenceView
+		{
+		public:
+			using value_type = Buffer;
+			using const_iterator = const Buffer*;
+
+			BufferSequenceView(const std::vector<Buffer>& buffers)
+				: m_Begin(buffers.data()), m_End(buffers.data() + buffers.size())
+			{}
+
+			const_iterator begin() const { return m_Begin; }
+			const_iterator end()   const { return m_End; }
+
+		private:
+			const Buffer* m_Begin;
+			const Buffer* m_End;
+		};
+
+		// Reference counted chain of segments taken from shared slab allocator, segment sizes are size classes
+		// of allocator and double up to sc_SegmentSize. Copies share segments, write to shared buffer detaches it first.
+		// Segments are passed to asio as buffer sequence, bytes are never copied into contiguous memory
+		class MessageBuffer
+		{
+		public:
+			static constexpr uint32_t sc_MinSegmentSize = 64;
+			static constexpr uint32_t sc_SegmentSize = 4096;
+			static constexpr uint32_t sc_MaxSize = 64 * 1024 * 1024;
+
+		private:
+			struct Segment;
+			struct Storage;
+
+		public:
+			// Forward read position, stays valid when buffer it reads is detached
+			class Cursor
+			{
+			public:
+				uint32_t GetPosition() const { return m_Position; }
+
+			private:
+				uint64_t	   m_StorageID = 0; // Storage memory can be reused, id is not
+				const Segment* m_Segment = nullptr;
+				uint32_t	   m_Offset = 0;
+				uint32_t	   m_Position = 0;
+
+				friend class MessageBuffer;
+			};
+
+			MessageBuffer() = default;
+			MessageBuffer(const MessageBuffer& other);
+			MessageBuffer(MessageBuffer&& other) noexcept;
+			~MessageBuffer();
+
+			MessageBuffer& operator=(const MessageBuffer& other);
+			MessageBuffer& operator=(MessageBuffer&& other) noexcept;
+
+			void Write(const void* data, uint32_t size);
+			// Returns false and leaves cursor unchanged if there is not enough data left
+			bool Read(Cursor& cursor, void* data, uint32_t size) const;
+
+			// Grows or shrinks buffer without initializing new bytes, used as target of socket read
+			void Resize(uint32_t size);
+			void Clear();
+
+			// Appends one buffer per segment
+			void GetBuffers(std::vector<asio::const_buffer>& buffers) const;
+			void GetBuffers(std::vector<asio::mutable_buffer>& buffers);
+
+			uint32_t Size()		const { return m_Storage ? m_Storage->Size : 0; }
+			bool	 IsUnique() const { return !m_Storage || m_Storage->RefCount.load(std::memory_order_acquire) == 1; }
+
+		private:
+			// Data follows header
+			struct Segment
+			{
+				Segment* Next;
+				uint32_t Size;
+				uint32_t Capacity;
+
+				uint8_t*	   Data()		{ return reinterpret_cast<uint8_t*>(this + 1); }
+				const uint8_t* Data() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+			};
+
+			struct Storage
+			{
+				std::atomic<uint32_t> RefCount;
+				uint32_t			  Size;
+				uint64_t			  ID;
+				Segment*			  Head;
+				Segment*			  Tail;
+			};
+
+			void detach();
+			void release();
+			void reserveStorage();
+			// Tail with free space, new segment is sized for required bytes
+			Segment* writableTail(uint32_t required);
+
+			static Storage* createStorage();
+			static uint64_t nextStorageID();
+
+			static Segment* allocateSegment(uint32_t required, uint32_t previousCapacity);
+			static void		freeSegment(Segment* segment);
+
+		private:
+			Storage* m_Storage = nullptr;
+		};
+	}
+}
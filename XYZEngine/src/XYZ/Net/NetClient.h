@@ -58,6 +58,12 @@ namespace XYZ {
 					m_Connection->Send(msg);
 			}
 
+			void Send(Message<T>&& msg)
+			{
+				if (IsConnected())
+					m_Connection->Send(std::move(msg));
+			}
+
 			bool IsConnected() const
 			{
 				if (m_Connection)
@@ -1,11 +1,52 @@
 #pragma once
 
 #include "Queue.h"
+#include "MPSCQueue.h"
 #include "NetMessage.h"
 
+#include <optional>
+
 namespace XYZ {
 	namespace Net {
 
+		template <typename T>
+		class Connection;
+
+		// Inbound ring of one server worker. Connection that finds ring full parks itself and stops
+		// reading socket, so TCP slows sender down. Consumer resumes parked connections once ring is half empty
+		template <typename T>
+		class InboundQueue
+		{
+		public:
+			explicit InboundQueue(uint32_t capacity)
+				: m_Ring(capacity)
+			{}
+
+			bool TryPush(OwnedMessage<T>&& msg) { return m_Ring.TryPush(std::move(msg)); }
+			// Called only from consumer thread
+			bool TryPop(OwnedMessage<T>& msg)	{ return m_Ring.TryPop(msg); }
+
+			void Park(std::shared_ptr<Connection<T>> connection)
+			{
+				std::scoped_lock lock(m_ParkedMutex);
+				m_Parked.push_back(std::move(connection));
+				m_HasParked.store(true, std::memory_order_release);
+			}
+
+			// Called only from consumer thread, connection parked after last check is resumed on next call
+			void ResumeParked();
+
+			size_t Size() const { return m_Ring.Size(); }
+
+		private:
+			MPSCQueue<OwnedMessage<T>> m_Ring;
+
+			std::mutex									m_ParkedMutex;
+			std::vector<std::shared_ptr<Connection<T>>> m_Parked;
+			std::vector<std::shared_ptr<Connection<T>>> m_Resumed; // Consumer scratch
+			std::atomic<bool>							m_HasParked = false;
+		};
+
 		template <typename T>
 		class Connection : public std::enable_shared_from_this<Connection<T>>
 		{
@@ -17,25 +58,44 @@ namespace XYZ {
 			};
 
 			Connection(Owner owner, asio::io_context& asioContext, asio::ip::tcp::socket socket, Queue<OwnedMessage<T>>& inMessages)
-				: m_Owner(owner), m_AsioContext(asioContext), m_Socket(std::move(socket)), m_MessagesIn(inMessages)
+				:
+				m_Owner(owner),
+				m_AsioContext(asioContext),
+				m_Socket(std::move(socket)),
+				m_MessagesIn(&inMessages)
 			{
 
 			}
 
+			// Strand is needed only if context runs on more threads
+			Connection(Owner owner, asio::io_context& asioContext, asio::ip::tcp::socket socket, InboundQueue<T>& inRing, bool useStrand)
+				:
+				m_Owner(owner),
+				m_AsioContext(asioContext),
+				m_Socket(std::move(socket)),
+				m_InRing(&inRing)
+			{
+				if (useStrand)
+					m_Strand.emplace(asio::make_strand(asioContext));
+			}
+
 			virtual ~Connection()
 			{
 
 			}
 
+			// Body segments are shared with caller, message bytes are not copied
 			void Send(const Message<T>& msg)
 			{
-				asio::post(m_AsioContext, [this, msg] {
+				post([this, msg = msg]() mutable {
+					pushOutgoingMessage(std::move(msg));
+				});
+			}
 
-					// If queue is not empty it is not writing message , it has no task so start new task ( writeHeader )
-					const bool writingMessage = !m_MessagesOut.Empty();
-					m_MessagesOut.PushBack(msg);
-					if (!writingMessage)
-						writeHeader();
+			void Send(Message<T>&& msg)
+			{
+				post([this, msg = std::move(msg)]() mutable {
+					pushOutgoingMessage(std::move(msg));
 				});
 			}
 
@@ -43,14 +103,15 @@ namespace XYZ {
 			{
 				if (m_Owner == Owner::Client)
 				{
-					asio::async_connect(m_Socket, endpoints,
-						[this](std::error_code ec, asio::ip::tcp::endpoint endpoint) {
+					startOperation([this, &endpoints](auto handler) {
+						asio::async_connect(m_Socket, endpoints, std::move(handler));
+					}, [this](std::error_code ec, asio::ip::tcp::endpoint endpoint) {
 
-							if (!ec)
-							{
-								readHeader();
-							}
-						});
+						if (!ec)
+						{
+							readHeader();
+						}
+					});
 				}
 			}
 
@@ -61,7 +122,7 @@ namespace XYZ {
 					if (m_Socket.is_open())
 					{
 						m_ID = id;
-						readHeader();
+						post([this]() { readHeader(); });
 					}
 				}
 			}
@@ -69,7 +130,7 @@ namespace XYZ {
 			void Disconnect()
 			{
 				if (IsConnected())
-					asio::post(m_AsioContext, [this]() { m_Socket.close(); });
+					post([this]() { m_Socket.close(); });
 			}
 
 			bool IsConnected() const
@@ -85,14 +146,20 @@ namespace XYZ {
 
 			void readHeader()
 			{			
-				asio::async_read(m_Socket, asio::buffer(&m_TemporaryMessage.Header, sizeof(MessageHeader<T>)),
-					[this](std::error_code ec, std::size_t length) {
+				startOperation([this](auto handler) {
+					asio::async_read(m_Socket, asio::buffer(&m_TemporaryMessage.Header, sizeof(MessageHeader<T>)), std::move(handler));
+				}, [this](std::error_code ec, std::size_t length) {
 					
  						if (!ec)
 						{
-							if (m_TemporaryMessage.Header.Size > 0)
+							if (m_TemporaryMessage.Header.Size > MessageBuffer::sc_MaxSize)
 							{
-								m_TemporaryMessage.Body.resize(m_TemporaryMessage.Header.Size);
+								XYZ_CORE_ERROR("[", m_ID, "]", " Message is too big");
+								m_Socket.close();
+							}
+							else if (m_TemporaryMessage.Header.Size > 0)
+							{
+								m_TemporaryMessage.Body.Resize(m_TemporaryMessage.Header.Size);
 								readBody();
 							}
 							else
@@ -108,9 +175,13 @@ namespace XYZ {
 					});
 			}
 			void readBody()
-			{			
-				asio::async_read(m_Socket, asio::buffer(m_TemporaryMessage.Body.data(), m_TemporaryMessage.Header.Size),
-					[this](std::error_code ec, std::size_t length) {
+			{
+				// Socket scatters body directly into pooled segments
+				m_ReadBuffers.clear();
+				m_TemporaryMessage.Body.GetBuffers(m_ReadBuffers);
+				startOperation([this](auto handler) {
+					asio::async_read(m_Socket, BufferSequenceView<asio::mutable_buffer>(m_ReadBuffers), std::move(handler));
+				}, [this](std::error_code ec, std::size_t length) {
 					
 						if (!ec)
 						{
@@ -125,44 +196,35 @@ namespace XYZ {
 					});
 			}
 
-			void writeHeader()
+			void pushOutgoingMessage(Message<T>&& msg)
 			{
-				asio::async_write(m_Socket, asio::buffer(&m_MessagesOut.Front().Header, sizeof(MessageHeader<T>)),
-					[this](std::error_code ec, std::size_t length) {
-						if (!ec)
-						{
-							if (m_MessagesOut.Front().Body.size() > 0)
-							{
-								writeBody();
-							}
-							else
-							{
-								m_MessagesOut.PopFront();
-								if (!m_MessagesOut.Empty())
-									writeHeader();
-							}
-						}
-						else
-						{
-							XYZ_CORE_ERROR("[", m_ID, "]", " Write header failed");
-							m_Socket.close();
-						}
-					});
+				// If queue is not empty it is writing message, otherwise start new write
+				const bool writingMessage = !m_MessagesOut.empty();
+				m_MessagesOut.push_back(std::move(msg));
+				if (!writingMessage)
+					writeMessage();
 			}
 
-			void writeBody()
+			void writeMessage()
 			{
-				asio::async_write(m_Socket, asio::buffer(m_MessagesOut.Front().Body.data(), m_MessagesOut.Front().Body.size()),
-					[this](std::error_code ec, std::size_t length) {
+				// Header and body segments are gathered into one write
+				const Message<T>& msg = m_MessagesOut.front();
+				m_WriteBuffers.clear();
+				m_WriteBuffers.push_back(asio::buffer(&msg.Header, sizeof(MessageHeader<T>)));
+				msg.Body.GetBuffers(m_WriteBuffers);
+
+				startOperation([this](auto handler) {
+					asio::async_write(m_Socket, BufferSequenceView<asio::const_buffer>(m_WriteBuffers), std::move(handler));
+				}, [this](std::error_code ec, std::size_t length) {
 						if (!ec)
 						{
-							m_MessagesOut.PopFront();
-							if (!m_MessagesOut.Empty())
-								writeHeader();
+							m_MessagesOut.pop_front();
+							if (!m_MessagesOut.empty())
+								writeMessage();
 						}
 						else
 						{
-							XYZ_CORE_ERROR("[", m_ID, "]", " Write body failed");
+							XYZ_CORE_ERROR("[", m_ID, "]", " Write message failed");
 							m_Socket.close();
 						}
 					});
@@ -170,27 +232,91 @@ namespace XYZ {
 
 			void addToIncomingMessageQueue()
 			{
+				std::shared_ptr<Connection<T>> remote = nullptr;
 				if (m_Owner == Owner::Server)
-					m_MessagesIn.PushBack({ this->shared_from_this(), m_TemporaryMessage });
+					remote = this->shared_from_this();
+
+				if (m_InRing)
+				{
+					OwnedMessage<T> owned{ remote, std::move(m_TemporaryMessage) };
+					if (!m_InRing->TryPush(std::move(owned)))
+					{
+						// Next header is not read until message is queued
+						m_TemporaryMessage = std::move(owned.Message);
+						m_InRing->Park(std::move(remote));
+						return;
+					}
+				}
 				else
-					m_MessagesIn.PushBack({ nullptr, m_TemporaryMessage });	
+				{
+					m_MessagesIn->PushBack({ std::move(remote), std::move(m_TemporaryMessage) });
+				}
 
+				m_TemporaryMessage = Message<T>();
 				readHeader();
 			}
 
+			template <typename Handler>
+			void post(Handler&& handler)
+			{
+				if (m_Strand)
+					asio::post(*m_Strand, std::forward<Handler>(handler));
+				else
+					asio::post(m_AsioContext, std::forward<Handler>(handler));
+			}
+
+			// Initiate starts asynchronous operation with handler it receives
+			template <typename Initiate, typename Handler>
+			void startOperation(Initiate&& initiate, Handler&& handler)
+			{
+				if (m_Strand)
+					initiate(asio::bind_executor(*m_Strand, std::forward<Handler>(handler)));
+				else
+					initiate(std::forward<Handler>(handler));
+			}
+
 		private:
 			Owner m_Owner;
 
 			Message<T> m_TemporaryMessage;
 			asio::io_context& m_AsioContext;
+			// Handlers of one connection never run concurrently when context runs on more threads
+			std::optional<asio::strand<asio::io_context::executor_type>> m_Strand;
 
 			asio::ip::tcp::socket m_Socket;
 			
-			Queue<OwnedMessage<T>>& m_MessagesIn;
+			// One of them is set
+			Queue<OwnedMessage<T>>* m_MessagesIn = nullptr;
+			InboundQueue<T>*		m_InRing = nullptr;
 
-			Queue<Message<T>> m_MessagesOut;
+			// Accessed only from context thread or strand
+			std::deque<Message<T>>			 m_MessagesOut;
+			std::vector<asio::const_buffer>	 m_WriteBuffers;
+			std::vector<asio::mutable_buffer> m_ReadBuffers;
 
 			uint32_t m_ID = 0;
+
+			friend class InboundQueue<T>;
 		};
+
+		template <typename T>
+		void InboundQueue<T>::ResumeParked()
+		{
+			if (!m_HasParked.load(std::memory_order_acquire) || m_Ring.Size() > m_Ring.Capacity() / 2)
+				return;
+			{
+				std::scoped_lock lock(m_ParkedMutex);
+				m_Resumed.swap(m_Parked);
+				m_HasParked.store(false, std::memory_order_relaxed);
+			}
+			for (auto& connection : m_Resumed)
+			{
+				connection->post([connection]() {
+					if (connection->IsConnected())
+						connection->addToIncomingMessageQueue();
+				});
+			}
+			m_Resumed.clear();
+		}
 	}
 }
\ No newline at end of file
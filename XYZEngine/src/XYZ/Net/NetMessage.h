@@ -1,5 +1,6 @@
 #pragma once
 #include "Core.h"
+#include "MessageBuffer.h"
 
 namespace XYZ {
 	namespace Net {
@@ -14,15 +15,36 @@ namespace XYZ {
 		template <typename T>
 		struct Message
 		{
-			MessageHeader<T>     Header;
-			std::vector<uint8_t> Body;
-			
+			MessageHeader<T>	  Header;
+			MessageBuffer		  Body;
+			MessageBuffer::Cursor ReadCursor; // Position of operator >>
+			bool				  ReadFailed = false; // Set by read past end, following reads fail too
+
 
 			size_t Size() const
 			{
-				return Body.size();
+				return Body.Size();
+			}
+
+			void Write(const void* data, uint32_t size)
+			{
+				Body.Write(data, size);
+				Header.Size = Body.Size();
+			}
+
+			// Failed read zeroes data, malformed message from remote must not leave garbage in it
+			bool Read(void* data, uint32_t size)
+			{
+				if (!ReadFailed && Body.Read(ReadCursor, data, size))
+					return true;
+
+				ReadFailed = true;
+				memset(data, 0, size);
+				return false;
 			}
 
+			bool IsValid() const { return !ReadFailed; }
+
 			friend std::ostream& operator << (std::ostream& os, const Message<T>& msg)
 			{
 				os << "ID: " << int(msg.Header.ID) << " Size: " << msg.Header.Size;
@@ -34,34 +56,18 @@ namespace XYZ {
 			{
 				static_assert(std::is_standard_layout<DataType>::value, "Data is not trivial");
 
-				size_t oldSize = msg.Body.size();
-
-				msg.Body.resize(msg.Body.size() + sizeof(DataType));
-
-				std::memcpy(msg.Body.data() + oldSize, &data, sizeof(DataType));
-				
-				msg.Header.Size = (uint32_t)msg.Size();
-
+				msg.Write(&data, sizeof(DataType));
 				return msg;
 			}
-			// Pulls any POD-like data form the message buffer
+			// Pulls POD-like data from the message in the order it was pushed.
+			// Reading past end is not an error of local code, caller checks IsValid after chain of reads
 			template<typename DataType>
 			friend Message<T>& operator >> (Message<T>& msg, DataType& data)
 			{
-				// Check that the type of the data being pushed is trivially copyable
-				static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be pulled from vector");
-
-				// Cache the location towards the end of the vector where the pulled data starts
-				size_t i = msg.Body.size() - sizeof(DataType);
-
-				// Physically copy the data from the vector into the user variable
-				std::memcpy(&data, msg.Body.data() + i, sizeof(DataType));
-
-				// Shrink the vector to remove read bytes, and reset end position
-				msg.Body.resize(i);
+				// Check that the type of the data being pulled is trivially copyable
+				static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be pulled from message");
 
-				// Recalculate the message size
-				msg.Header.Size = msg.Size();
+				msg.Read(&data, sizeof(DataType));
 
 				// Return the target message so it can be "chained"
 				return msg;
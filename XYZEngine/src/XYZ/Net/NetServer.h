@@ -5,14 +5,29 @@
 namespace XYZ {
 	namespace Net {
 
+		struct ServerConfiguration
+		{
+			uint32_t IOThreads = 1;
+			// Each worker has own inbound ring, messages of one connection always go to same worker
+			uint32_t Workers = 1;
+			// Per worker, connection stops reading when its ring is full until consumer catches up
+			uint32_t InboundCapacity = 4096;
+		};
+
 		template <typename T>
 		class Server
 		{
 		public:
-			Server(uint16_t port)
-				: m_AsioAcceptor(m_AsioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port))
+			Server(uint16_t port, const ServerConfiguration& config = ServerConfiguration())
+				:
+				m_Config(config),
+				m_AsioContext(static_cast<int>(std::max(config.IOThreads, 1u))),
+				m_AsioAcceptor(m_AsioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port))
 			{
-				asio::ip::udp::endpoint()
+				m_Config.IOThreads = std::max(m_Config.IOThreads, 1u);
+				m_Config.Workers = std::max(m_Config.Workers, 1u);
+				for (uint32_t i = 0; i < m_Config.Workers; ++i)
+					m_MessagesIn.push_back(std::make_unique<InboundQueue<T>>(m_Config.InboundCapacity));
 			}
 
 			virtual ~Server()
@@ -25,7 +40,8 @@ namespace XYZ {
 				try
 				{
 					WaitForClientConnection();
-					m_ContextThread = std::thread([this]() { m_AsioContext.run();  });
+					for (uint32_t i = 0; i < m_Config.IOThreads; ++i)
+						m_ContextThreads.emplace_back([this]() { m_AsioContext.run(); });
 				}
 				catch (std::exception& e)
 				{
@@ -40,8 +56,12 @@ namespace XYZ {
 			{
 				m_AsioContext.stop();
 
-				if (m_ContextThread.joinable())
-					m_ContextThread.join();
+				for (std::thread& thread : m_ContextThreads)
+				{
+					if (thread.joinable())
+						thread.join();
+				}
+				m_ContextThreads.clear();
 
 				XYZ_CORE_INFO("Server Stopped");
 			}
@@ -52,25 +72,27 @@ namespace XYZ {
 					if (!ec)
 					{
 						XYZ_CORE_INFO("Server New Connection: ", socket.remote_endpoint());
-						std::shared_ptr<Connection<T>> newConn =
-							std::make_shared<Connection<T>>(Connection<T>::Owner::Server,
-								m_AsioContext, std::move(socket), m_MessagesIn);
-
-						m_Connections.push_back(std::move(newConn));
-						uint32_t id = 0;
-						if (!m_FreeClientIDs.empty())
-						{
-							id = m_FreeClientIDs.back();
-							m_FreeClientIDs.pop_back();
-						}
-						else
+						std::shared_ptr<Connection<T>> newConn;
 						{
-							id = m_NextClientID++;
+							std::scoped_lock lock(m_ConnectionsMutex);
+							uint32_t id = 0;
+							if (!m_FreeClientIDs.empty())
+							{
+								id = m_FreeClientIDs.back();
+								m_FreeClientIDs.pop_back();
+							}
+							else
+							{
+								id = m_NextClientID++;
+							}
+
+							newConn = std::make_shared<Connection<T>>(Connection<T>::Owner::Server,
+								m_AsioContext, std::move(socket), *m_MessagesIn[id % m_MessagesIn.size()], m_Config.IOThreads > 1);
+							m_Connections.push_back(newConn);
+							newConn->ConnectToClient(id);
 						}
-
-						m_Connections.back()->ConnectToClient(id);
-						XYZ_CORE_INFO("[", m_Connections.back()->GetID(), "] Connection Approved");
-						onClientConnect(m_Connections.back());
+						XYZ_CORE_INFO("[", newConn->GetID(), "] Connection Approved");
+						onClientConnect(newConn);
 					}
 					WaitForClientConnection();
 				});
@@ -85,10 +107,10 @@ namespace XYZ {
 				else
 				{
 					onClientDisconnect(client);
+					std::scoped_lock lock(m_ConnectionsMutex);
 					if (client)
 						m_FreeClientIDs.push_back(client->GetID());
 
-					client.reset();
 					m_Connections.erase(
 						std::remove(m_Connections.begin(), m_Connections.end(), client), m_Connections.end()
 					);
@@ -97,44 +119,64 @@ namespace XYZ {
 
 			void MessageAllClients(const Message<T>& msg, std::shared_ptr<Connection<T>> ignoredClient = nullptr)
 			{
-				bool invalidClientExists = false;
-				for (auto& client : m_Connections)
+				// Callbacks are called without lock, they may message clients
+				std::vector<std::shared_ptr<Connection<T>>> disconnected;
 				{
-					if (client && client->IsConnected())
+					std::scoped_lock lock(m_ConnectionsMutex);
+					for (auto& client : m_Connections)
 					{
-						if (client != ignoredClient)
-							client->Send(msg);
+						if (client && client->IsConnected())
+						{
+							if (client != ignoredClient)
+								client->Send(msg);
+						}
+						else
+						{
+							if (client)
+								m_FreeClientIDs.push_back(client->GetID());
+
+							disconnected.push_back(std::move(client));
+						}
 					}
-					else
+					if (!disconnected.empty())
 					{
-						onClientDisconnect(client);
-						if (client)
-							m_FreeClientIDs.push_back(client->GetID());
-
-						client.reset();
-						invalidClientExists = true;
+						m_Connections.erase(
+							std::remove(m_Connections.begin(), m_Connections.end(), nullptr), m_Connections.end()
+						);
 					}
 				}
-				if (invalidClientExists)
-				{
-					m_Connections.erase(
-						std::remove(m_Connections.begin(), m_Connections.end(), nullptr), m_Connections.end()
-					);
-				}
+				for (auto& client : disconnected)
+					onClientDisconnect(client);
 			}
 
+			// Consumes inbound messages of all workers, must not run concurrently with UpdateWorker
 			void Update(size_t maxMessages = -1)
 			{
 				size_t messageCount = 0;
-				while (messageCount < maxMessages && !m_MessagesIn.Empty())
+				for (uint32_t worker = 0; worker < m_MessagesIn.size() && messageCount < maxMessages; ++worker)
+					messageCount += UpdateWorker(worker, maxMessages - messageCount);
+			}
+
+			// One thread per worker, onMessage is then called concurrently for connections of different workers
+			size_t UpdateWorker(uint32_t worker, size_t maxMessages = -1)
+			{
+				InboundQueue<T>& ring = *m_MessagesIn[worker];
+				size_t messageCount = 0;
+				while (messageCount < maxMessages)
 				{
-					m_MessagesIn.Wait();
-					auto msg = std::move(m_MessagesIn.PopFront());
+					OwnedMessage<T> msg;
+					if (!ring.TryPop(msg))
+						break;
 					onMessage(msg.Remote, msg.Message);
 					messageCount++;
 				}
+				ring.ResumeParked();
+				return messageCount;
 			}
 
+			uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_MessagesIn.size()); }
+			size_t   GetInboundSize(uint32_t worker) const { return m_MessagesIn[worker]->Size(); }
+
 		protected:
 
 			virtual void onClientConnect(std::shared_ptr<Connection<T>> client)
@@ -150,13 +192,19 @@ namespace XYZ {
 			}
 
 		protected:
-			Queue<OwnedMessage<T>> m_MessagesIn;
-			std::deque<std::shared_ptr<Connection<T>>> m_Connections;
+			ServerConfiguration m_Config;
 
+			// Destroyed last, connections and queued messages hold strands of context
 			asio::io_context m_AsioContext;
 			asio::ip::tcp::acceptor m_AsioAcceptor;
 
-			std::thread m_ContextThread;
+			std::vector<std::unique_ptr<InboundQueue<T>>> m_MessagesIn;
+
+			// Accept handler runs on io thread, messaging functions on caller thread
+			std::mutex m_ConnectionsMutex;
+			std::deque<std::shared_ptr<Connection<T>>> m_Connections;
+
+			std::vector<std::thread> m_ContextThreads;
 
 			uint32_t m_NextClientID = 0;
 
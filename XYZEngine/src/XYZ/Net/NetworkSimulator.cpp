@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "NetworkSimulator.h"
+
+namespace XYZ {
+
+	NetworkSimulator::NetworkSimulator(const NetworkSimulatorConfiguration& config, uint32_t seed)
+		:
+		m_Config(config),
+		m_Random(seed)
+	{
+	}
+
+	void NetworkSimulator::Send(uint32_t destination, const void* data, size_t size, double time)
+	{
+		if (random() < m_Config.PacketLoss)
+		{
+			m_PacketsDropped++;
+			return;
+		}
+		push(destination, data, size, time);
+		if (random() < m_Config.Duplicates)
+			push(destination, data, size, time);
+	}
+
+	void NetworkSimulator::push(uint32_t destination, const void* data, size_t size, double time)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		Packet packet;
+		packet.DeliveryTime = time + m_Config.Latency + m_Config.Jitter * random();
+		packet.Destination = destination;
+		packet.Data.assign(bytes, bytes + size);
+
+		auto it = std::upper_bound(m_Packets.begin(), m_Packets.end(), packet.DeliveryTime, [](double deliveryTime, const Packet& other) {
+			return deliveryTime < other.DeliveryTime;
+		});
+		m_Packets.insert(it, std::move(packet));
+	}
+
+	float NetworkSimulator::random()
+	{
+		return std::uniform_real_distribution<float>(0.0f, 1.0f)(m_Random);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace XYZ {
+
+	struct NetworkSimulatorConfiguration
+	{
+		float Latency = 0.0f;	  // One way, seconds
+		float Jitter = 0.0f;	  // Added delay is uniform in [0, Jitter], packets can be reordered
+		float PacketLoss = 0.0f;  // 0 - 1
+		float Duplicates = 0.0f;  // Chance packet is delivered twice
+	};
+
+	// Delays, drops, duplicates and reorders packets. Sits between UDPSession and socket,
+	// or replaces socket completely to run both sides in one process over in-memory loopback
+	class NetworkSimulator
+	{
+	public:
+		NetworkSimulator(const NetworkSimulatorConfiguration& config = {}, uint32_t seed = 0);
+
+		void Send(uint32_t destination, const void* data, size_t size, double time);
+
+		// Calls func(destination, data, size) for every packet due at time, in delivery order
+		template <typename Func>
+		void Receive(double time, Func&& func);
+
+		void SetConfiguration(const NetworkSimulatorConfiguration& config) { m_Config = config; }
+		const NetworkSimulatorConfiguration& GetConfiguration() const { return m_Config; }
+
+		uint64_t GetPacketsDropped() const { return m_PacketsDropped; }
+
+	private:
+		struct Packet
+		{
+			double				 DeliveryTime;
+			uint32_t			 Destination;
+			std::vector<uint8_t> Data;
+		};
+
+		void  push(uint32_t destination, const void* data, size_t size, double time);
+		float random();
+
+	private:
+		NetworkSimulatorConfiguration m_Config;
+		std::mt19937				  m_Random;
+		std::vector<Packet>			  m_Packets;   // Kept sorted by delivery time
+		std::vector<Packet>			  m_Delivered; // Swapped out during callbacks, callback may send
+		uint64_t					  m_PacketsDropped = 0;
+	};
+
+	template <typename Func>
+	void NetworkSimulator::Receive(double time, Func&& func)
+	{
+		size_t count = 0;
+		while (count < m_Packets.size() && m_Packets[count].DeliveryTime <= time)
+			count++;
+		if (count == 0)
+			return;
+
+		m_Delivered.clear();
+		std::move(m_Packets.begin(), m_Packets.begin() + count, std::back_inserter(m_Delivered));
+		m_Packets.erase(m_Packets.begin(), m_Packets.begin() + count);
+		for (const Packet& packet : m_Delivered)
+			func(packet.Destination, packet.Data.data(), packet.Data.size());
+	}
+}
@@ -35,6 +35,13 @@ namespace XYZ {
 				m_Blocking.notify_one();
 			}
 
+			void PushBack(T&& elem)
+			{
+				std::scoped_lock lock(m_MutQueue);
+				m_Queue.emplace_back(std::move(elem));
+				m_Blocking.notify_one();
+			}
+
 			void PushFront(const T& elem)
 			{
 				std::scoped_lock lock(m_MutQueue);
@@ -0,0 +1,551 @@
+#include "stdafx.h"
+#include "Replication.h"
+
+#include "XYZ/Debug/Profiler.h"
+#include "XYZ/Scene/Components.h"
+
+#include <glm/gtc/constants.hpp>
+
+namespace XYZ {
+
+	static constexpr uint32_t sc_LengthBits = 6;	   // Bit count prefix of variable length values
+	static constexpr uint32_t sc_BaselineDeltaBits = 8;
+
+	static void writeVarying(BitWriter& writer, uint32_t value)
+	{
+		const uint32_t bits = Utils::BitsRequired(value);
+		writer.Write(bits, sc_LengthBits);
+		writer.Write(value, bits);
+	}
+
+	static uint32_t readVarying(BitReader& reader)
+	{
+		const uint32_t bits = reader.Read(sc_LengthBits);
+		if (bits > 32)
+		{
+			reader.Fail();
+			return 0;
+		}
+		return reader.Read(bits);
+	}
+
+	// Small changes are written as zigzag encoded difference, big ones as full value
+	static void writeField(BitWriter& writer, uint32_t value, uint32_t baseline, uint32_t bits)
+	{
+		const int64_t  difference = static_cast<int64_t>(value) - static_cast<int64_t>(baseline);
+		const uint64_t zigzag = difference >= 0 ? static_cast<uint64_t>(difference) * 2 : static_cast<uint64_t>(-difference) * 2 - 1;
+		const uint32_t prefixBits = Utils::BitsRequired(bits);
+		const uint32_t needed = zigzag > UINT32_MAX ? 33 : Utils::BitsRequired(static_cast<uint32_t>(zigzag));
+		if (needed < bits)
+		{
+			writer.Write(needed, prefixBits);
+			writer.Write(static_cast<uint32_t>(zigzag), needed);
+		}
+		else
+		{
+			writer.Write(bits, prefixBits);
+			writer.Write(value, bits);
+		}
+	}
+
+	static uint32_t readField(BitReader& reader, uint32_t baseline, uint32_t bits)
+	{
+		const uint32_t needed = reader.Read(Utils::BitsRequired(bits));
+		if (needed >= bits)
+			return reader.Read(bits);
+
+		const uint64_t zigzag = reader.Read(needed);
+		const int64_t difference = (zigzag & 1) ? -static_cast<int64_t>((zigzag + 1) / 2) : static_cast<int64_t>(zigzag / 2);
+		return static_cast<uint32_t>(static_cast<int64_t>(baseline) + difference);
+	}
+
+	uint32_t QuantizedFloat::Quantize(float value) const
+	{
+		const double maxValue = static_cast<double>((1ull << Bits) - 1);
+		const double normalized = (std::clamp(value, Min, Max) - Min) / (Max - Min);
+		return static_cast<uint32_t>(std::round(normalized * maxValue));
+	}
+
+	float QuantizedFloat::Dequantize(uint32_t value) const
+	{
+		const double maxValue = static_cast<double>((1ull << Bits) - 1);
+		return static_cast<float>(Min + (value / maxValue) * (Max - Min));
+	}
+
+	void ReplicationRegistry::RegisterTransform(float positionRange, uint32_t positionBits, uint32_t rotationBits, float scaleRange, uint32_t scaleBits)
+	{
+		const QuantizedFloat position{ -positionRange, positionRange, positionBits };
+		const QuantizedFloat rotation{ -glm::pi<float>(), glm::pi<float>(), rotationBits };
+		const QuantizedFloat scale{ -scaleRange, scaleRange, scaleBits };
+		Register<TransformComponent>(
+			{ positionBits, positionBits, positionBits, rotationBits, rotationBits, rotationBits, scaleBits, scaleBits, scaleBits },
+			[=](const TransformComponent& transform, uint32_t* fields) {
+				for (int i = 0; i < 3; ++i)
+				{
+					fields[i] = position.Quantize(transform->Translation[i]);
+					fields[3 + i] = rotation.Quantize(std::remainder(transform->Rotation[i], glm::two_pi<float>()));
+					fields[6 + i] = scale.Quantize(transform->Scale[i]);
+				}
+			},
+			[=](TransformComponent& transform, const uint32_t* fields) {
+				TransformComponent::Transform& data = transform.GetTransform();
+				for (int i = 0; i < 3; ++i)
+				{
+					data.Translation[i] = position.Dequantize(fields[i]);
+					data.Rotation[i] = rotation.Dequantize(fields[3 + i]);
+					data.Scale[i] = scale.Dequantize(fields[6 + i]);
+				}
+			}
+		);
+	}
+
+	void ReplicationSnapshot::Clear()
+	{
+		Valid = false;
+		Entities.clear();
+		Masks.clear();
+		Fields.clear();
+	}
+
+	ReplicationServer::ReplicationServer(const ReplicationRegistry& registry)
+		:
+		m_Registry(registry)
+	{
+	}
+
+	NetEntityID ReplicationServer::Replicate(entt::entity entity)
+	{
+		auto [it, inserted] = m_EntityIDs.try_emplace(entity, m_NextID);
+		if (inserted)
+		{
+			m_Entities.emplace_back(m_NextID, entity);
+			m_NextID++;
+		}
+		return it->second;
+	}
+
+	void ReplicationServer::Unreplicate(entt::entity entity)
+	{
+		auto it = m_EntityIDs.find(entity);
+		if (it == m_EntityIDs.end())
+			return;
+
+		auto position = std::lower_bound(m_Entities.begin(), m_Entities.end(), it->second, [](const auto& pair, NetEntityID id) {
+			return pair.first < id;
+		});
+		m_Entities.erase(position);
+		m_EntityIDs.erase(it);
+	}
+
+	void ReplicationServer::CaptureSnapshot(const entt::registry& registry, uint32_t tick)
+	{
+		XYZ_PROFILE_FUNC("ReplicationServer::CaptureSnapshot");
+		XYZ_ASSERT(!m_HasSnapshot || tick > m_LatestTick, "Snapshot ticks must grow");
+		const auto& components = m_Registry.GetComponents();
+		const uint32_t fieldCount = m_Registry.GetFieldCount();
+
+		ReplicationSnapshot& snapshot = m_Snapshots[tick % sc_SnapshotBufferSize];
+		snapshot.Clear();
+		snapshot.Tick = tick;
+		snapshot.Valid = true;
+		snapshot.Entities.reserve(m_Entities.size());
+		snapshot.Masks.reserve(m_Entities.size());
+		snapshot.Fields.reserve(m_Entities.size() * fieldCount);
+		for (const auto& [id, entity] : m_Entities)
+		{
+			if (!registry.valid(entity))
+				continue;
+
+			const size_t offset = snapshot.Fields.size();
+			snapshot.Fields.resize(offset + fieldCount, 0);
+			uint16_t mask = 0;
+			for (uint32_t i = 0; i < components.size(); ++i)
+			{
+				if (components[i].Capture(registry, entity, &snapshot.Fields[offset + components[i].FirstField]))
+					mask |= 1 << i;
+			}
+			snapshot.Entities.push_back(id);
+			snapshot.Masks.push_back(mask);
+		}
+		m_LatestTick = tick;
+		m_HasSnapshot = true;
+	}
+
+	uint32_t ReplicationServer::AddClient()
+	{
+		for (uint32_t i = 0; i < m_Clients.size(); ++i)
+		{
+			if (!m_Clients[i].Connected)
+			{
+				m_Clients[i] = Client();
+				m_Clients[i].Connected = true;
+				return i;
+			}
+		}
+		m_Clients.emplace_back().Connected = true;
+		return static_cast<uint32_t>(m_Clients.size() - 1);
+	}
+
+	void ReplicationServer::RemoveClient(uint32_t client)
+	{
+		m_Clients[client].Connected = false;
+	}
+
+	void ReplicationServer::WriteSnapshot(uint32_t client, BitWriter& writer)
+	{
+		XYZ_PROFILE_FUNC("ReplicationServer::WriteSnapshot");
+		XYZ_ASSERT(m_HasSnapshot, "No snapshot was captured");
+		Client& state = m_Clients[client];
+		const auto& components = m_Registry.GetComponents();
+		const uint32_t componentCount = static_cast<uint32_t>(components.size());
+		const uint32_t fieldCount = m_Registry.GetFieldCount();
+		const uint32_t startBits = writer.GetBitsWritten();
+
+		const ReplicationSnapshot& current = m_Snapshots[m_LatestTick % sc_SnapshotBufferSize];
+		const ReplicationSnapshot* baseline = state.HasBaseline ? findSnapshot(state.BaselineTick) : nullptr;
+
+		// Entities that changed since baseline and entities baseline has but current does not
+		m_Changed.clear();
+		m_Removed.clear();
+		size_t b = 0;
+		const size_t baselineCount = baseline ? baseline->Entities.size() : 0;
+		for (uint32_t i = 0; i < current.Entities.size(); ++i)
+		{
+			const NetEntityID id = current.Entities[i];
+			while (b < baselineCount && baseline->Entities[b] < id)
+				m_Removed.push_back(baseline->Entities[b++]);
+
+			if (b < baselineCount && baseline->Entities[b] == id)
+			{
+				const bool same = current.Masks[i] == baseline->Masks[b]
+					&& std::equal(&current.Fields[i * fieldCount], &current.Fields[i * fieldCount] + fieldCount, &baseline->Fields[b * fieldCount]);
+				b++;
+				if (same)
+					continue;
+			}
+			m_Changed.push_back(i);
+		}
+		while (b < baselineCount)
+			m_Removed.push_back(baseline->Entities[b++]);
+
+		writer.Write(current.Tick, 32);
+		writer.WriteBool(baseline != nullptr);
+		if (baseline)
+			writer.Write(current.Tick - baseline->Tick, sc_BaselineDeltaBits);
+
+		writeVarying(writer, static_cast<uint32_t>(m_Removed.size()));
+		NetEntityID previous = 0;
+		for (const NetEntityID id : m_Removed)
+		{
+			writeVarying(writer, id - previous);
+			previous = id;
+		}
+
+		writeVarying(writer, static_cast<uint32_t>(m_Changed.size()));
+		previous = 0;
+		b = 0;
+		for (const uint32_t i : m_Changed)
+		{
+			const NetEntityID id = current.Entities[i];
+			writeVarying(writer, id - previous);
+			previous = id;
+
+			while (b < baselineCount && baseline->Entities[b] < id)
+				b++;
+			const bool isNew = !(b < baselineCount && baseline->Entities[b] == id);
+			const uint16_t mask = current.Masks[i];
+			const uint16_t baselineMask = isNew ? 0 : baseline->Masks[b];
+			const uint32_t* fields = &current.Fields[i * fieldCount];
+			const uint32_t* baselineFields = isNew ? nullptr : &baseline->Fields[b * fieldCount];
+
+			writer.WriteBool(isNew);
+			if (!isNew)
+				writer.WriteBool(mask != baselineMask);
+			if (isNew || mask != baselineMask)
+				writer.Write(mask, componentCount);
+
+			for (uint32_t c = 0; c < componentCount; ++c)
+			{
+				if (!(mask & (1 << c)))
+					continue;
+
+				const auto& type = components[c];
+				const uint32_t first = type.FirstField;
+				const uint32_t count = static_cast<uint32_t>(type.FieldBits.size());
+				if (!(baselineMask & (1 << c)))
+				{
+					for (uint32_t f = 0; f < count; ++f)
+						writer.Write(fields[first + f], type.FieldBits[f]);
+					continue;
+				}
+
+				const bool changed = !std::equal(fields + first, fields + first + count, baselineFields + first);
+				writer.WriteBool(changed);
+				if (!changed)
+					continue;
+				for (uint32_t f = 0; f < count; ++f)
+				{
+					const bool fieldChanged = fields[first + f] != baselineFields[first + f];
+					writer.WriteBool(fieldChanged);
+					if (fieldChanged)
+						writeField(writer, fields[first + f], baselineFields[first + f], type.FieldBits[f]);
+				}
+			}
+		}
+
+		state.WrittenTick = current.Tick;
+		ReplicationStatistics& stats = state.Statistics;
+		stats.Tick = current.Tick;
+		stats.BaselineTick = baseline ? baseline->Tick : current.Tick;
+		stats.Entities = static_cast<uint32_t>(current.Entities.size());
+		stats.ChangedEntities = static_cast<uint32_t>(m_Changed.size() + m_Removed.size());
+		stats.Bytes = (writer.GetBitsWritten() - startBits + 7) / 8;
+		stats.BytesPerEntity = stats.Entities != 0 ? static_cast<float>(stats.Bytes) / stats.Entities : 0.0f;
+	}
+
+	void ReplicationServer::OnSnapshotSent(uint32_t client, uint16_t messageID)
+	{
+		Client& state = m_Clients[client];
+		state.Sent[messageID % sc_SnapshotBufferSize] = { messageID, state.WrittenTick, true };
+	}
+
+	void ReplicationServer::OnSnapshotAcked(uint32_t client, uint16_t messageID)
+	{
+		Client& state = m_Clients[client];
+		const SentSnapshot& sent = state.Sent[messageID % sc_SnapshotBufferSize];
+		if (!sent.Valid || sent.MessageID != messageID)
+			return;
+
+		if (!state.HasBaseline || sent.Tick > state.BaselineTick)
+		{
+			state.HasBaseline = true;
+			state.BaselineTick = sent.Tick;
+		}
+	}
+
+	const ReplicationSnapshot* ReplicationServer::findSnapshot(uint32_t tick) const
+	{
+		const ReplicationSnapshot& snapshot = m_Snapshots[tick % sc_SnapshotBufferSize];
+		if (snapshot.Valid && snapshot.Tick == tick)
+			return &snapshot;
+		return nullptr;
+	}
+
+	ReplicationClient::ReplicationClient(const ReplicationRegistry& registry)
+		:
+		m_Registry(registry)
+	{
+	}
+
+	bool ReplicationClient::ReadSnapshot(BitReader& reader, entt::registry& registry)
+	{
+		XYZ_PROFILE_FUNC("ReplicationClient::ReadSnapshot");
+		const uint32_t tick = reader.Read(32);
+		const ReplicationSnapshot* baseline = nullptr;
+		if (reader.ReadBool())
+		{
+			const uint32_t baselineTick = tick - reader.Read(sc_BaselineDeltaBits);
+			const ReplicationSnapshot& snapshot = m_Snapshots[baselineTick % sc_SnapshotBufferSize];
+			if (!snapshot.Valid || snapshot.Tick != baselineTick)
+				return false;
+			baseline = &snapshot;
+		}
+		if (!reader.IsValid())
+			return false;
+
+		ReplicationSnapshot& stored = m_Snapshots[tick % sc_SnapshotBufferSize];
+		if (stored.Valid && stored.Tick == tick)
+			return true;
+
+		// Older snapshot is still decoded and buffered, server may use it as baseline
+		if (!decode(reader, baseline, m_Decoded))
+			return false;
+		m_Decoded.Tick = tick;
+		m_Decoded.Valid = true;
+		std::swap(stored, m_Decoded);
+
+		if (!m_Applied.Valid || tick > m_Applied.Tick)
+			apply(registry, stored);
+		return true;
+	}
+
+	entt::entity ReplicationClient::GetEntity(NetEntityID id) const
+	{
+		auto it = m_Entities.find(id);
+		if (it != m_Entities.end())
+			return it->second;
+		return entt::null;
+	}
+
+	bool ReplicationClient::decode(BitReader& reader, const ReplicationSnapshot* baseline, ReplicationSnapshot& result)
+	{
+		const auto& components = m_Registry.GetComponents();
+		const uint32_t componentCount = static_cast<uint32_t>(components.size());
+		const uint32_t fieldCount = m_Registry.GetFieldCount();
+		const size_t baselineCount = baseline ? baseline->Entities.size() : 0;
+		result.Clear();
+
+		// Every id takes at least length prefix, bigger count is malformed
+		const uint32_t removedCount = readVarying(reader);
+		if (removedCount > reader.GetBitsLeft() / sc_LengthBits)
+			return false;
+
+		std::vector<NetEntityID>& removed = m_Removed;
+		removed.resize(removedCount);
+		NetEntityID previous = 0;
+		for (NetEntityID& id : removed)
+		{
+			id = previous + readVarying(reader);
+			previous = id;
+		}
+
+		size_t b = 0;
+		size_t r = 0;
+		// Unchanged entities of baseline up to id are carried over
+		auto copyBaseline = [&](NetEntityID limit) {
+			for (; b < baselineCount && baseline->Entities[b] < limit; ++b)
+			{
+				const NetEntityID id = baseline->Entities[b];
+				while (r < removed.size() && removed[r] < id)
+					r++;
+				if (r < removed.size() && removed[r] == id)
+					continue;
+
+				result.Entities.push_back(id);
+				result.Masks.push_back(baseline->Masks[b]);
+				result.Fields.insert(result.Fields.end(), &baseline->Fields[b * fieldCount], &baseline->Fields[b * fieldCount] + fieldCount);
+			}
+		};
+
+		const uint32_t changedCount = readVarying(reader);
+		if (changedCount > reader.GetBitsLeft() / sc_LengthBits)
+			return false;
+
+		previous = 0;
+		for (uint32_t i = 0; i < changedCount && reader.IsValid(); ++i)
+		{
+			const NetEntityID id = previous + readVarying(reader);
+			if (i != 0 && id <= previous)
+				return false;
+			previous = id;
+			copyBaseline(id);
+
+			const bool isNew = reader.ReadBool();
+			const bool inBaseline = b < baselineCount && baseline->Entities[b] == id;
+			if (isNew == inBaseline)
+				return false;
+
+			const uint16_t baselineMask = isNew ? 0 : baseline->Masks[b];
+			const uint32_t* baselineFields = isNew ? nullptr : &baseline->Fields[b * fieldCount];
+			if (inBaseline)
+				b++;
+
+			const bool maskChanged = isNew || reader.ReadBool();
+			const uint32_t mask = maskChanged ? reader.Read(componentCount) : baselineMask;
+
+			const size_t offset = result.Fields.size();
+			result.Fields.resize(offset + fieldCount, 0);
+			uint32_t* fields = &result.Fields[offset];
+			for (uint32_t c = 0; c < componentCount; ++c)
+			{
+				if (!(mask & (1 << c)))
+					continue;
+
+				const auto& type = components[c];
+				const uint32_t first = type.FirstField;
+				const uint32_t count = static_cast<uint32_t>(type.FieldBits.size());
+				if (!(baselineMask & (1 << c)))
+				{
+					for (uint32_t f = 0; f < count; ++f)
+						fields[first + f] = reader.Read(type.FieldBits[f]);
+					continue;
+				}
+
+				std::copy(baselineFields + first, baselineFields + first + count, fields + first);
+				if (!reader.ReadBool())
+					continue;
+				for (uint32_t f = 0; f < count; ++f)
+				{
+					if (reader.ReadBool())
+						fields[first + f] = readField(reader, baselineFields[first + f], type.FieldBits[f]);
+				}
+			}
+			result.Entities.push_back(id);
+			result.Masks.push_back(static_cast<uint16_t>(mask));
+		}
+		// Id UINT32_MAX is never assigned
+		copyBaseline(UINT32_MAX);
+		return reader.IsValid();
+	}
+
+	void ReplicationClient::apply(entt::registry& registry, const ReplicationSnapshot& snapshot)
+	{
+		XYZ_PROFILE_FUNC("ReplicationClient::apply");
+		const auto& components = m_Registry.GetComponents();
+		const uint32_t fieldCount = m_Registry.GetFieldCount();
+		const size_t appliedCount = m_Applied.Valid ? m_Applied.Entities.size() : 0;
+
+		auto destroy = [&](NetEntityID id) {
+			auto it = m_Entities.find(id);
+			if (it == m_Entities.end())
+				return;
+			if (m_OnDestroy)
+				m_OnDestroy(registry, id, it->second);
+			else if (registry.valid(it->second))
+				registry.destroy(it->second);
+			m_Entities.erase(it);
+		};
+
+		size_t a = 0;
+		for (size_t i = 0; i < snapshot.Entities.size(); ++i)
+		{
+			const NetEntityID id = snapshot.Entities[i];
+			for (; a < appliedCount && m_Applied.Entities[a] < id; ++a)
+				destroy(m_Applied.Entities[a]);
+
+			const uint32_t* fields = &snapshot.Fields[i * fieldCount];
+			const uint16_t mask = snapshot.Masks[i];
+			uint16_t appliedMask = 0;
+			const uint32_t* appliedFields = nullptr;
+			entt::entity entity = entt::null;
+			if (a < appliedCount && m_Applied.Entities[a] == id)
+			{
+				appliedMask = m_Applied.Masks[a];
+				appliedFields = &m_Applied.Fields[a * fieldCount];
+				entity = GetEntity(id);
+				a++;
+			}
+			if (entity == entt::null)
+			{
+				entity = m_OnSpawn ? m_OnSpawn(registry, id) : registry.create();
+				m_Entities[id] = entity;
+				appliedMask = 0;
+			}
+
+			for (uint32_t c = 0; c < components.size(); ++c)
+			{
+				const auto& type = components[c];
+				const uint16_t bit = 1 << c;
+				if (mask & bit)
+				{
+					const uint32_t* first = fields + type.FirstField;
+					const bool same = (appliedMask & bit) && std::equal(first, first + type.FieldBits.size(), appliedFields + type.FirstField);
+					if (!same)
+						type.Apply(registry, entity, first);
+				}
+				else if (appliedMask & bit)
+				{
+					type.Remove(registry, entity);
+				}
+			}
+		}
+		for (; a < appliedCount; ++a)
+			destroy(m_Applied.Entities[a]);
+
+		m_Applied.Tick = snapshot.Tick;
+		m_Applied.Valid = true;
+		m_Applied.Entities = snapshot.Entities;
+		m_Applied.Masks = snapshot.Masks;
+		m_Applied.Fields = snapshot.Fields;
+	}
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+#include "BitStream.h"
+
+#include <entt/entt.hpp>
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace XYZ {
+
+	using NetEntityID = uint32_t;
+
+	struct QuantizedFloat
+	{
+		float	 Min;
+		float	 Max;
+		uint32_t Bits;
+
+		uint32_t Quantize(float value) const;
+		float	 Dequantize(uint32_t value) const;
+	};
+
+	// Component state is captured as fixed number of quantized integer fields, deltas are computed per field
+	class XYZ_API ReplicationRegistry
+	{
+	public:
+		static constexpr uint32_t sc_MaxComponents = 16;
+
+		using CaptureFunc = std::function<bool(const entt::registry& registry, entt::entity entity, uint32_t* fields)>;
+		using ApplyFunc	  = std::function<void(entt::registry& registry, entt::entity entity, const uint32_t* fields)>;
+		using RemoveFunc  = std::function<void(entt::registry& registry, entt::entity entity)>;
+
+		struct ComponentType
+		{
+			std::vector<uint32_t> FieldBits;
+			uint32_t			  FirstField;
+			CaptureFunc			  Capture;
+			ApplyFunc			  Apply;
+			RemoveFunc			  Remove;
+		};
+
+		// Order of registration must be same on server and client
+		template <typename T>
+		void Register(std::vector<uint32_t> fieldBits, std::function<void(const T&, uint32_t*)> quantize, std::function<void(T&, const uint32_t*)> apply);
+
+		// Rotation is wrapped to [-pi, pi], world transform is not replicated
+		void RegisterTransform(float positionRange = 4096.0f, uint32_t positionBits = 20, uint32_t rotationBits = 14, float scaleRange = 64.0f, uint32_t scaleBits = 14);
+
+		const std::vector<ComponentType>& GetComponents() const { return m_Components; }
+		uint32_t						  GetFieldCount() const { return m_FieldCount; }
+
+	private:
+		std::vector<ComponentType> m_Components;
+		uint32_t				   m_FieldCount = 0;
+	};
+
+	struct ReplicationStatistics
+	{
+		uint32_t Tick = 0;
+		uint32_t BaselineTick = 0;	 // Same as Tick if snapshot was sent without baseline
+		uint32_t Entities = 0;
+		uint32_t ChangedEntities = 0; // Includes removed
+		uint32_t Bytes = 0;
+		float	 BytesPerEntity = 0.0f;
+	};
+
+	// Entities are stored sorted by network id, snapshots are compared by merging
+	struct ReplicationSnapshot
+	{
+		uint32_t				 Tick = 0;
+		bool					 Valid = false;
+		std::vector<NetEntityID> Entities;
+		std::vector<uint16_t>	 Masks;	 // Components entity has
+		std::vector<uint32_t>	 Fields; // Field count of registry per entity, zero for missing components
+
+		void Clear();
+	};
+
+	// Sends state of replicated entities to every client as delta against last snapshot
+	// client acknowledged. Snapshot is written to BitWriter and sent as unreliable message,
+	// id of message is passed back to OnSnapshotSent and on ack to OnSnapshotAcked
+	class XYZ_API ReplicationServer
+	{
+	public:
+		static constexpr uint32_t sc_SnapshotBufferSize = 64;
+
+		ReplicationServer(const ReplicationRegistry& registry);
+
+		NetEntityID Replicate(entt::entity entity);
+		void		Unreplicate(entt::entity entity);
+
+		void CaptureSnapshot(const entt::registry& registry, uint32_t tick);
+
+		uint32_t AddClient();
+		void	 RemoveClient(uint32_t client);
+
+		// Latest captured snapshot, full state if client has no baseline that is still buffered
+		void WriteSnapshot(uint32_t client, BitWriter& writer);
+		void OnSnapshotSent(uint32_t client, uint16_t messageID);
+		void OnSnapshotAcked(uint32_t client, uint16_t messageID);
+
+		// Of last snapshot written for client
+		const ReplicationStatistics& GetStatistics(uint32_t client) const { return m_Clients[client].Statistics; }
+
+	private:
+		struct SentSnapshot
+		{
+			uint16_t MessageID = 0;
+			uint32_t Tick = 0;
+			bool	 Valid = false;
+		};
+
+		struct Client
+		{
+			bool									   Connected = false;
+			bool									   HasBaseline = false;
+			uint32_t								   BaselineTick = 0;
+			uint32_t								   WrittenTick = 0;
+			std::array<SentSnapshot, sc_SnapshotBufferSize> Sent;
+			ReplicationStatistics					   Statistics;
+		};
+
+		const ReplicationSnapshot* findSnapshot(uint32_t tick) const;
+
+	private:
+		const ReplicationRegistry& m_Registry;
+
+		std::vector<std::pair<NetEntityID, entt::entity>> m_Entities; // Sorted, ids only grow
+		std::unordered_map<entt::entity, NetEntityID>	  m_EntityIDs;
+		NetEntityID										  m_NextID = 1;
+
+		std::array<ReplicationSnapshot, sc_SnapshotBufferSize> m_Snapshots;
+		uint32_t										  m_LatestTick = 0;
+		bool											  m_HasSnapshot = false;
+
+		std::vector<Client>		 m_Clients;
+		std::vector<uint32_t>	 m_Changed; // Scratch of WriteSnapshot
+		std::vector<NetEntityID> m_Removed;
+	};
+
+	// Decodes snapshots and applies newest one to registry. Entities are created and destroyed
+	// through handlers so game can attach rest of components, default handlers use registry directly
+	class XYZ_API ReplicationClient
+	{
+	public:
+		static constexpr uint32_t sc_SnapshotBufferSize = ReplicationServer::sc_SnapshotBufferSize;
+
+		using SpawnFunc	  = std::function<entt::entity(entt::registry& registry, NetEntityID id)>;
+		using DestroyFunc = std::function<void(entt::registry& registry, NetEntityID id, entt::entity entity)>;
+
+		ReplicationClient(const ReplicationRegistry& registry);
+
+		// Returns false if snapshot is malformed or its baseline is not buffered
+		bool ReadSnapshot(BitReader& reader, entt::registry& registry);
+
+		void SetSpawnHandler(const SpawnFunc& func)		{ m_OnSpawn = func; }
+		void SetDestroyHandler(const DestroyFunc& func) { m_OnDestroy = func; }
+
+		entt::entity GetEntity(NetEntityID id) const;
+		uint32_t	 GetAppliedTick() const { return m_Applied.Tick; }
+
+	private:
+		bool decode(BitReader& reader, const ReplicationSnapshot* baseline, ReplicationSnapshot& result);
+		void apply(entt::registry& registry, const ReplicationSnapshot& snapshot);
+
+	private:
+		const ReplicationRegistry& m_Registry;
+
+		std::array<ReplicationSnapshot, sc_SnapshotBufferSize> m_Snapshots;
+		ReplicationSnapshot								  m_Decoded;
+		ReplicationSnapshot								  m_Applied;
+		std::unordered_map<NetEntityID, entt::entity>	  m_Entities;
+		std::vector<NetEntityID>						  m_Removed; // Scratch of decode
+
+		SpawnFunc	m_OnSpawn;
+		DestroyFunc m_OnDestroy;
+	};
+
+	template <typename T>
+	void ReplicationRegistry::Register(std::vector<uint32_t> fieldBits, std::function<void(const T&, uint32_t*)> quantize, std::function<void(T&, const uint32_t*)> apply)
+	{
+		XYZ_ASSERT(m_Components.size() < sc_MaxComponents, "Too many replicated components");
+		ComponentType& type = m_Components.emplace_back();
+		type.FirstField = m_FieldCount;
+		m_FieldCount += static_cast<uint32_t>(fieldBits.size());
+		type.FieldBits = std::move(fieldBits);
+		type.Capture = [quantize](const entt::registry& registry, entt::entity entity, uint32_t* fields) {
+			const T* component = registry.try_get<T>(entity);
+			if (!component)
+				return false;
+			quantize(*component, fields);
+			return true;
+		};
+		type.Apply = [apply](entt::registry& registry, entt::entity entity, const uint32_t* fields) {
+			apply(registry.get_or_emplace<T>(entity), fields);
+		};
+		type.Remove = [](entt::registry& registry, entt::entity entity) {
+			registry.remove<T>(entity);
+		};
+	}
+}
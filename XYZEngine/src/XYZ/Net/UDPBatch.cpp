@@ -0,0 +1,80 @@
+#include "stdafx.h"
+#include "UDPBatch.h"
+
+namespace XYZ {
+
+	UDPBatch::UDPBatch(uint32_t batchSize, size_t datagramSize)
+		:
+		m_BatchSize(std::clamp(batchSize, 1u, sc_MaxBatchSize)),
+		m_DatagramSize(datagramSize)
+	{
+	}
+
+	void UDPBatch::Queue(const asio::ip::udp::endpoint& endpoint, const void* data, size_t size)
+	{
+		XYZ_ASSERT(size <= m_DatagramSize, "Datagram is too big");
+		auto [it, inserted] = m_EndpointIndex.try_emplace(endpoint, static_cast<uint32_t>(m_Endpoints.size()));
+		// Queue of endpoint was already passed by partial flush, datagram continues in new queue at tail
+		if (!inserted && it->second < m_FlushEndpoint)
+		{
+			it->second = static_cast<uint32_t>(m_Endpoints.size());
+			inserted = true;
+		}
+		if (inserted)
+			m_Endpoints.push_back({ endpoint, {} });
+
+		const uint32_t offset = static_cast<uint32_t>(m_SendArena.size());
+		const std::byte* bytes = static_cast<const std::byte*>(data);
+		m_SendArena.insert(m_SendArena.end(), bytes, bytes + size);
+		m_Endpoints[it->second].Datagrams.push_back({ offset, static_cast<uint32_t>(size) });
+		m_QueuedCount++;
+	}
+
+	void UDPBatch::advance(size_t count)
+	{
+		m_QueuedCount -= count;
+		while (count != 0)
+		{
+			const EndpointQueue& queue = m_Endpoints[m_FlushEndpoint];
+			const size_t left = queue.Datagrams.size() - m_FlushDatagram;
+			if (count < left)
+			{
+				m_FlushDatagram += static_cast<uint32_t>(count);
+				return;
+			}
+			count -= left;
+			m_FlushEndpoint++;
+			m_FlushDatagram = 0;
+		}
+		if (m_QueuedCount == 0)
+			clearQueue();
+	}
+
+	size_t UDPBatch::EndpointHash::operator()(const asio::ip::udp::endpoint& endpoint) const noexcept
+	{
+		// Hashed by value, raw socket address may differ in unused fields for equal endpoints
+		const asio::ip::address address = endpoint.address();
+		size_t hash = 0;
+		if (address.is_v4())
+		{
+			hash = std::hash<uint32_t>{}(address.to_v4().to_uint());
+		}
+		else
+		{
+			const auto bytes = address.to_v6().to_bytes();
+			hash = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+		}
+		return hash ^ (std::hash<uint16_t>{}(endpoint.port()) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+	}
+
+	void UDPBatch::clearQueue()
+	{
+		// Arena keeps its capacity, steady traffic does not grow it again
+		m_SendArena.clear();
+		m_Endpoints.clear();
+		m_EndpointIndex.clear();
+		m_QueuedCount = 0;
+		m_FlushEndpoint = 0;
+		m_FlushDatagram = 0;
+	}
+}
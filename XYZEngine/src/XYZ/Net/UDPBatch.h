@@ -0,0 +1,87 @@
+#pragma once
+#include "Core.h"
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+
+namespace XYZ {
+
+	// Batched datagram I/O on asio socket. Linux receives and sends whole batch in one system call
+	// with recvmmsg/sendmmsg, other platforms do one non blocking call per datagram
+	class UDPBatch
+	{
+	public:
+		static constexpr uint32_t sc_MaxBatchSize = 64;
+		static constexpr uint32_t sc_DefaultBatchSize = 32;
+
+		struct Datagram
+		{
+			asio::ip::udp::endpoint Endpoint;
+			const std::byte*		Data = nullptr;
+			size_t					Size = 0;
+			bool					Truncated = false;
+		};
+
+		struct Statistics
+		{
+			uint64_t PacketsReceived = 0;
+			uint64_t PacketsSent = 0;
+			uint64_t ReceiveCalls = 0;
+			uint64_t SendCalls = 0;
+		};
+
+		UDPBatch(uint32_t batchSize = sc_DefaultBatchSize, size_t datagramSize = 65536);
+
+		// Does not block, would_block is reported if nothing is ready. Datagrams are valid until next call
+		uint32_t		Receive(asio::ip::udp::socket& socket, std::error_code& ec);
+		const Datagram& GetDatagram(uint32_t index) const { return m_Received[index]; }
+
+		// Datagrams for same endpoint are stored together and sent in order they were queued
+		void   Queue(const asio::ip::udp::endpoint& endpoint, const void* data, size_t size);
+		// Does not block, on would_block rest of queue is kept for next call. Datagram that failed otherwise is dropped
+		size_t Flush(asio::ip::udp::socket& socket, std::error_code& ec);
+
+		bool			  HasQueued()	  const { return m_QueuedCount != 0; }
+		uint32_t		  GetBatchSize()  const { return m_BatchSize; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+
+	private:
+		struct Span
+		{
+			uint32_t Offset;
+			uint32_t Size;
+		};
+
+		struct EndpointHash
+		{
+			size_t operator()(const asio::ip::udp::endpoint& endpoint) const noexcept;
+		};
+
+		struct EndpointQueue
+		{
+			asio::ip::udp::endpoint Endpoint;
+			std::vector<Span>		Datagrams;
+		};
+
+		void advance(size_t count);
+		void clearQueue();
+
+	private:
+		uint32_t m_BatchSize;
+		size_t	 m_DatagramSize;
+
+		// Allocated on first receive, sending only socket does not pay for it
+		std::vector<std::byte>					   m_ReceiveRing;
+		std::array<Datagram, sc_MaxBatchSize>	   m_Received;
+
+		std::vector<std::byte>					   m_SendArena;
+		std::vector<EndpointQueue>				   m_Endpoints;
+		std::unordered_map<asio::ip::udp::endpoint, uint32_t, EndpointHash> m_EndpointIndex;
+		size_t									   m_QueuedCount = 0;
+		uint32_t								   m_FlushEndpoint = 0; // Position of first unsent datagram
+		uint32_t								   m_FlushDatagram = 0;
+
+		Statistics								   m_Statistics;
+	};
+}
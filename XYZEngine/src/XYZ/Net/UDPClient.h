@@ -2,6 +2,7 @@
 #include "Core.h"
 
 #include "XYZ/Utils/DataStructures/ThreadQueue.h"
+#include "UDPBatch.h"
 
 namespace XYZ {
 
@@ -18,6 +19,14 @@ namespace XYZ {
 		void Send(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size);
 		bool SendAsync(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size);
 
+		// Batched path, received datagrams are passed to onReceived until socket is closed.
+		// Queued datagrams are sent on Flush, onSent is not called for them
+		void ReceiveBatchAsync();
+		void QueueSend(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size);
+		void Flush();
+
+		const UDPBatch::Statistics& GetBatchStatistics() const { return m_Batch.GetStatistics(); }
+
 		const asio::ip::udp::endpoint& GetEndpoint() const { return m_Endpoint; }
 	protected:
 		virtual void onConnected() {}
@@ -32,6 +41,9 @@ namespace XYZ {
 		size_t receive(asio::ip::udp::endpoint& endpoint, void* buffer, size_t size);
 
 		void tryReceive();
+		void waitReceiveBatch();
+		void receiveBatch();
+		void flushQueued();
 
 	private:
 		std::vector<std::byte>	 m_ReceiveBuffer;
@@ -42,9 +54,14 @@ namespace XYZ {
 		asio::ip::udp::endpoint  m_ReceiveEndpoint;
 		asio::ip::udp::socket	 m_Socket;
 
+		UDPBatch				 m_Batch;
+		std::mutex				 m_BatchMutex; // Guards send queue of batch
+
 		
 		bool m_Connected;
 		bool m_AsyncReceiving;
 		bool m_AsyncSending;
+		bool m_BatchReceiving = false;
+		bool m_WaitingWrite = false;
 	};
 }
\ No newline at end of file
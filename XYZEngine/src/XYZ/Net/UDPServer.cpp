@@ -7,6 +7,7 @@ namespace XYZ {
 		:
 		m_Context(asioContext),
 		m_Socket(m_Context),
+		m_Batch(UDPBatch::sc_DefaultBatchSize, recBufferSize),
 		m_Port(port),
 		m_Running(false),
 		m_AsyncReceiving(false),
@@ -86,6 +87,88 @@ namespace XYZ {
 		return true;
 	}
 
+	void UDPServer::ReceiveBatchAsync()
+	{
+		if (m_BatchReceiving)
+			return;
+
+		m_BatchReceiving = true;
+		waitReceiveBatch();
+	}
+
+	void UDPServer::QueueSend(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size)
+	{
+		std::scoped_lock lock(m_BatchMutex);
+		m_Batch.Queue(endpoint, buffer, size);
+	}
+
+	void UDPServer::Flush()
+	{
+		std::scoped_lock lock(m_BatchMutex);
+		flushQueued();
+	}
+
+	void UDPServer::waitReceiveBatch()
+	{
+		m_Socket.async_wait(asio::ip::udp::socket::wait_read, [self = shared_from_this()](std::error_code ec) {
+			if (ec)
+			{
+				self->m_BatchReceiving = false;
+				self->onError(ec);
+				return;
+			}
+			self->receiveBatch();
+			self->waitReceiveBatch();
+		});
+	}
+
+	void UDPServer::receiveBatch()
+	{
+		// Socket is drained before waiting again, full batch means more data may be ready
+		uint32_t count = 0;
+		do
+		{
+			std::error_code ec;
+			count = m_Batch.Receive(m_Socket, ec);
+			if (ec && ec != asio::error::would_block)
+				onError(ec);
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const UDPBatch::Datagram& datagram = m_Batch.GetDatagram(i);
+				onReceived(datagram.Endpoint, datagram.Data, datagram.Size);
+				if (datagram.Truncated)
+					onError(asio::error::no_buffer_space);
+			}
+		} while (count == m_Batch.GetBatchSize());
+	}
+
+	void UDPServer::flushQueued()
+	{
+		std::error_code ec;
+		m_Batch.Flush(m_Socket, ec);
+		if (ec == asio::error::would_block)
+		{
+			// Send buffer is full, rest is sent when socket becomes writable
+			if (!m_WaitingWrite)
+			{
+				m_WaitingWrite = true;
+				m_Socket.async_wait(asio::ip::udp::socket::wait_write, [self = shared_from_this()](std::error_code waitError) {
+					std::scoped_lock lock(self->m_BatchMutex);
+					self->m_WaitingWrite = false;
+					if (waitError)
+						self->onError(waitError);
+					else
+						self->flushQueued();
+				});
+			}
+		}
+		else if (ec)
+		{
+			onError(ec);
+		}
+	}
+
 
 	size_t UDPServer::receive(asio::ip::udp::endpoint& endpoint, void* buffer, size_t size)
 	{		
@@ -2,6 +2,7 @@
 #include "Core.h"
 
 #include "UDPClient.h"
+#include "UDPBatch.h"
 
 
 namespace XYZ {
@@ -25,6 +26,14 @@ namespace XYZ {
 		void Send(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size);
 		bool SendAsync(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size);
 
+		// Batched path, received datagrams are passed to onReceived until socket is closed.
+		// Queued datagrams are sent on Flush, onSent is not called for them
+		void ReceiveBatchAsync();
+		void QueueSend(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size);
+		void Flush();
+
+		const UDPBatch::Statistics& GetBatchStatistics() const { return m_Batch.GetStatistics(); }
+
 	protected:
 		virtual void onStarted() {};
 
@@ -40,6 +49,9 @@ namespace XYZ {
 		size_t receive(asio::ip::udp::endpoint& endpoint, void* buffer, size_t size);
 
 		void tryReceive();
+		void waitReceiveBatch();
+		void receiveBatch();
+		void flushQueued();
 
 	private:
 		std::vector<std::byte>	m_ReceiveBuffer;
@@ -49,9 +61,14 @@ namespace XYZ {
 		asio::ip::udp::socket   m_Socket;
 		asio::ip::udp::endpoint m_ReceiveEndpoint;
 
+		UDPBatch				m_Batch;
+		std::mutex				m_BatchMutex; // Guards send queue of batch
+
 		uint16_t m_Port;
 		bool	 m_Running;
 		bool	 m_AsyncReceiving;
 		bool	 m_AsyncSending;
+		bool	 m_BatchReceiving = false;
+		bool	 m_WaitingWrite = false;
 	};
 }
\ No newline at end of file
@@ -1,7 +1,436 @@
 #include "stdafx.h"
 #include "UDPSession.h"
 
+#include "XYZ/Debug/Profiler.h"
 
 namespace XYZ {
 
-}
\ No newline at end of file
+	static constexpr uint32_t sc_SizeBits = 6;	   // Bit count of message size
+	static constexpr uint32_t sc_FragmentBits = 10; // Fragment index and count - 1
+	static constexpr uint32_t sc_MaxDatagramSize = 65507;
+
+	UDPSession::UDPSession(SendFunc sendFunc, uint32_t maxPacketSize)
+		:
+		m_SendFunc(std::move(sendFunc)),
+		m_MaxPacketSize(maxPacketSize)
+	{
+		static_assert(1 << sc_FragmentBits == sc_MaxFragments);
+		XYZ_ASSERT(m_MaxPacketSize <= sc_MaxDatagramSize, "Packet does not fit into datagram");
+		XYZ_ASSERT(m_MaxPacketSize > sc_HeaderSize + messageSize(1, true), "Packet size must be bigger than headers");
+		// Biggest fragment that fits into empty packet with its header
+		m_FragmentSize = m_MaxPacketSize - sc_HeaderSize - messageSize(0, true);
+		while (sc_HeaderSize + messageSize(m_FragmentSize, true) > m_MaxPacketSize)
+			m_FragmentSize--;
+
+		m_ReceivedSequences.fill(UINT32_MAX);
+	}
+
+	void UDPSession::SendReliable(const void* data, uint32_t size)
+	{
+		XYZ_ASSERT(size <= GetMaxMessageSize(), "Message is too big");
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		const uint32_t fragmentCount = std::max(1u, (size + m_FragmentSize - 1) / m_FragmentSize);
+		for (uint32_t i = 0; i < fragmentCount; ++i)
+		{
+			const uint32_t offset = i * m_FragmentSize;
+			ReliableMessage& message = m_ReliableBacklog.emplace_back();
+			message.FragmentIndex = static_cast<uint16_t>(i);
+			message.FragmentCount = static_cast<uint16_t>(fragmentCount);
+			message.Data.assign(bytes + offset, bytes + std::min(size, offset + m_FragmentSize));
+		}
+		fillReliableWindow();
+	}
+
+	uint16_t UDPSession::SendUnreliable(const void* data, uint32_t size)
+	{
+		XYZ_ASSERT(size <= GetMaxMessageSize(), "Message is too big");
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		const uint32_t offset = static_cast<uint32_t>(m_UnreliableData.size());
+		m_UnreliableData.insert(m_UnreliableData.end(), bytes, bytes + size);
+		m_UnreliableMessages.push_back({ m_NextUnreliableID, offset, size });
+		return m_NextUnreliableID++;
+	}
+
+	uint32_t UDPSession::Update(double time)
+	{
+		XYZ_PROFILE_FUNC("UDPSession::Update");
+		const double resendTime = std::max(m_Statistics.RoundTripTime * 1.5f, sc_MinResendTime);
+		uint32_t packets = 0;
+		beginPacket(time);
+		for (uint16_t id = m_OldestReliableID; id != m_NextReliableID; ++id)
+		{
+			ReliableMessage& message = m_ReliableMessages[id % sc_ReliableWindow];
+			if (!message.Used || (message.LastSent >= 0.0 && time - message.LastSent < resendTime))
+				continue;
+
+			const uint32_t size = static_cast<uint32_t>(message.Data.size());
+			if (!fits(size, message.FragmentCount > 1) && m_MessagesInPacket != 0)
+			{
+				endPacket();
+				packets++;
+				beginPacket(time);
+			}
+			if (message.LastSent >= 0.0)
+				m_Statistics.ReliableResent++;
+
+			message.LastSent = time;
+			writeMessage(UDPChannel::Reliable, id, message.Data.data(), size, message.FragmentIndex, message.FragmentCount);
+			m_CurrentPacket->ReliableIDs.push_back(id);
+		}
+		for (const UnreliableMessage& message : m_UnreliableMessages)
+		{
+			const uint32_t fragmentCount = std::max(1u, (message.Size + m_FragmentSize - 1) / m_FragmentSize);
+			if (fragmentCount > 1)
+				m_SentFragments[message.ID % sc_FragmentBufferSize] = { message.ID, fragmentCount };
+
+			for (uint32_t i = 0; i < fragmentCount; ++i)
+			{
+				const uint32_t offset = i * m_FragmentSize;
+				const uint32_t size = std::min(message.Size - offset, m_FragmentSize);
+				if (!fits(size, fragmentCount > 1) && m_MessagesInPacket != 0)
+				{
+					endPacket();
+					packets++;
+					beginPacket(time);
+				}
+				writeMessage(UDPChannel::Unreliable, message.ID, &m_UnreliableData[message.Offset + offset], size, i, fragmentCount);
+				if (fragmentCount > 1)
+					m_CurrentPacket->FragmentIDs.push_back(message.ID);
+				else
+					m_CurrentPacket->UnreliableIDs.push_back(message.ID);
+			}
+		}
+		endPacket();
+		packets++;
+
+		m_UnreliableData.clear();
+		m_UnreliableMessages.clear();
+		return packets;
+	}
+
+	bool UDPSession::Receive(const void* data, size_t size, double time)
+	{
+		XYZ_PROFILE_FUNC("UDPSession::Receive");
+		if (size < sc_HeaderSize || size > UINT32_MAX)
+			return false;
+
+		BitReader reader(data, static_cast<uint32_t>(size));
+		const uint16_t sequence = static_cast<uint16_t>(reader.Read(16));
+		const uint16_t ack = static_cast<uint16_t>(reader.Read(16));
+		const uint32_t ackBits = reader.Read(32);
+
+		if (m_HasReceived && !sequenceGreater(sequence, m_RemoteSequence)
+			&& static_cast<uint16_t>(m_RemoteSequence - sequence) >= sc_SequenceBufferSize)
+			return false;
+		if (isReceived(sequence))
+			return false;
+
+		// Whole packet is parsed before anything is applied, malformed packet does not change state
+		m_ParsedMessages.clear();
+		while (reader.GetBitsLeft() != 0)
+		{
+			ReceivedMessage& message = m_ParsedMessages.emplace_back();
+			message.Channel = reader.ReadBool() ? UDPChannel::Reliable : UDPChannel::Unreliable;
+			message.ID = static_cast<uint16_t>(reader.Read(16));
+			message.FragmentIndex = 0;
+			message.FragmentCount = 1;
+			if (reader.ReadBool())
+			{
+				message.FragmentIndex = static_cast<uint16_t>(reader.Read(sc_FragmentBits));
+				message.FragmentCount = static_cast<uint16_t>(reader.Read(sc_FragmentBits) + 1);
+				if (message.FragmentIndex >= message.FragmentCount || message.FragmentCount == 1)
+					reader.Fail();
+			}
+			const uint32_t sizeBits = reader.Read(sc_SizeBits);
+			if (sizeBits > 32)
+			{
+				reader.Fail();
+				return false;
+			}
+			message.Size = reader.Read(sizeBits);
+			message.Data = reader.ReadSpan(message.Size);
+			if (!reader.IsValid())
+				return false;
+		}
+
+		m_Statistics.PacketsReceived++;
+		m_Statistics.BytesReceived += size;
+		if (!m_HasReceived || sequenceGreater(sequence, m_RemoteSequence))
+		{
+			if (m_HasReceived)
+			{
+				const uint16_t gap = sequence - m_RemoteSequence;
+				if (gap >= sc_SequenceBufferSize)
+					m_ReceivedSequences.fill(UINT32_MAX);
+				else
+				{
+					for (uint16_t skipped = m_RemoteSequence + 1; skipped != sequence; ++skipped)
+						m_ReceivedSequences[skipped % sc_SequenceBufferSize] = UINT32_MAX;
+				}
+			}
+			m_RemoteSequence = sequence;
+			m_HasReceived = true;
+		}
+		m_ReceivedSequences[sequence % sc_SequenceBufferSize] = sequence;
+
+		processAcks(ack, ackBits, time);
+		for (const ReceivedMessage& message : m_ParsedMessages)
+		{
+			if (message.Channel == UDPChannel::Reliable)
+				receiveReliable(message);
+			else if (message.FragmentCount > 1)
+				receiveFragment(message);
+			else if (m_OnMessage)
+				m_OnMessage(UDPChannel::Unreliable, message.Data, message.Size);
+		}
+
+		while (true)
+		{
+			ReliableMessage& message = m_ReceivedMessages[m_ReceiveReliableID % sc_ReliableWindow];
+			if (!message.Used)
+				break;
+			deliverReliable(message);
+			message.Used = false;
+			m_ReceiveReliableID++;
+		}
+		return true;
+	}
+
+	void UDPSession::beginPacket(double time)
+	{
+		SentPacket& packet = m_SentPackets[m_Sequence % sc_SequenceBufferSize];
+		packet.Sequence = m_Sequence;
+		packet.Acked = false;
+		packet.Time = time;
+		packet.ReliableIDs.clear();
+		packet.UnreliableIDs.clear();
+		packet.FragmentIDs.clear();
+
+		m_CurrentPacket = &packet;
+		m_MessagesInPacket = 0;
+		m_Writer.Clear();
+		m_Writer.Write(m_Sequence, 16);
+		m_Writer.Write(m_RemoteSequence, 16);
+		m_Writer.Write(getAckBits(), 32);
+	}
+
+	void UDPSession::endPacket()
+	{
+		m_SendFunc(m_Writer.GetData(), m_Writer.GetSize());
+		m_Statistics.PacketsSent++;
+		m_Statistics.BytesSent += m_Writer.GetSize();
+		m_CurrentPacket = nullptr;
+		m_Sequence++;
+	}
+
+	bool UDPSession::fits(uint32_t size, bool fragment) const
+	{
+		return m_Writer.GetSize() + messageSize(size, fragment) <= m_MaxPacketSize;
+	}
+
+	void UDPSession::writeMessage(UDPChannel channel, uint16_t id, const void* data, uint32_t size, uint32_t fragmentIndex, uint32_t fragmentCount)
+	{
+		const uint32_t sizeBits = Utils::BitsRequired(size);
+		m_Writer.WriteBool(channel == UDPChannel::Reliable);
+		m_Writer.Write(id, 16);
+		m_Writer.WriteBool(fragmentCount > 1);
+		if (fragmentCount > 1)
+		{
+			m_Writer.Write(fragmentIndex, sc_FragmentBits);
+			m_Writer.Write(fragmentCount - 1, sc_FragmentBits);
+		}
+		m_Writer.Write(sizeBits, sc_SizeBits);
+		m_Writer.Write(size, sizeBits);
+		m_Writer.WriteBytes(data, size);
+		m_MessagesInPacket++;
+	}
+
+	void UDPSession::processAcks(uint16_t ack, uint32_t ackBits, double time)
+	{
+		for (uint32_t i = 0; i < 32; ++i)
+		{
+			if (ackBits & (1u << i))
+				processAck(static_cast<uint16_t>(ack - i), time);
+		}
+		while (m_OldestReliableID != m_NextReliableID && !m_ReliableMessages[m_OldestReliableID % sc_ReliableWindow].Used)
+			m_OldestReliableID++;
+		fillReliableWindow();
+
+		if (ackBits != 0 && (!m_HasAck || sequenceGreater(ack, m_LatestAck)))
+		{
+			m_HasAck = true;
+			m_LatestAck = ack;
+			updateLoss(ack);
+		}
+	}
+
+	void UDPSession::processAck(uint16_t sequence, double time)
+	{
+		SentPacket& packet = m_SentPackets[sequence % sc_SequenceBufferSize];
+		if (packet.Sequence != sequence || packet.Acked)
+			return;
+
+		packet.Acked = true;
+		m_Statistics.PacketsAcked++;
+		const float rtt = static_cast<float>(time - packet.Time);
+		if (m_Statistics.PacketsAcked == 1)
+			m_Statistics.RoundTripTime = rtt;
+		else
+			m_Statistics.RoundTripTime += (rtt - m_Statistics.RoundTripTime) * 0.1f;
+
+		const uint16_t inFlight = m_NextReliableID - m_OldestReliableID;
+		for (const uint16_t id : packet.ReliableIDs)
+		{
+			// Message can be acked by earlier copy and its slot taken by newer message
+			if (static_cast<uint16_t>(id - m_OldestReliableID) >= inFlight)
+				continue;
+			ReliableMessage& message = m_ReliableMessages[id % sc_ReliableWindow];
+			message.Used = false;
+			message.Data.clear();
+		}
+		if (m_OnAck)
+		{
+			for (const uint16_t id : packet.UnreliableIDs)
+				m_OnAck(id);
+		}
+		// Slot can be taken by newer message, its fragments are then not counted
+		for (const uint16_t id : packet.FragmentIDs)
+		{
+			SentFragments& fragments = m_SentFragments[id % sc_FragmentBufferSize];
+			if (fragments.ID != id || fragments.Remaining == 0)
+				continue;
+			if (--fragments.Remaining == 0 && m_OnAck)
+				m_OnAck(id);
+		}
+	}
+
+	void UDPSession::updateLoss(uint16_t ack)
+	{
+		// Packets older than ack window can not be acked anymore
+		const uint16_t windowStart = ack - 31;
+		while (sequenceGreater(windowStart, m_LossCheckSequence))
+		{
+			const SentPacket& packet = m_SentPackets[m_LossCheckSequence % sc_SequenceBufferSize];
+			if (packet.Sequence == m_LossCheckSequence)
+			{
+				const bool lost = !packet.Acked;
+				m_Statistics.PacketsLost += lost ? 1 : 0;
+				m_Statistics.PacketLoss += ((lost ? 1.0f : 0.0f) - m_Statistics.PacketLoss) * 0.1f;
+			}
+			m_LossCheckSequence++;
+		}
+	}
+
+	void UDPSession::receiveReliable(const ReceivedMessage& received)
+	{
+		// Already delivered or outside of window
+		if (static_cast<uint16_t>(received.ID - m_ReceiveReliableID) >= sc_ReliableWindow)
+			return;
+
+		ReliableMessage& message = m_ReceivedMessages[received.ID % sc_ReliableWindow];
+		if (message.Used)
+			return;
+		message.Used = true;
+		message.FragmentIndex = received.FragmentIndex;
+		message.FragmentCount = received.FragmentCount;
+		message.Data.assign(received.Data, received.Data + received.Size);
+	}
+
+	void UDPSession::receiveFragment(const ReceivedMessage& received)
+	{
+		// Newer message takes slot of incomplete one, fragments of older message are dropped
+		FragmentAssembly& assembly = m_Assemblies[received.ID % sc_ReassemblyBufferSize];
+		if (!assembly.Used || assembly.ID != received.ID || assembly.Fragments.size() != received.FragmentCount)
+		{
+			assembly.Used = true;
+			assembly.ID = received.ID;
+			assembly.Received = 0;
+			assembly.Fragments.clear();
+			assembly.Fragments.resize(received.FragmentCount);
+		}
+		std::vector<uint8_t>& fragment = assembly.Fragments[received.FragmentIndex];
+		if (received.Size == 0 || !fragment.empty())
+			return;
+
+		fragment.assign(received.Data, received.Data + received.Size);
+		if (++assembly.Received != received.FragmentCount)
+			return;
+
+		m_AssembledMessage.clear();
+		for (const std::vector<uint8_t>& part : assembly.Fragments)
+			m_AssembledMessage.insert(m_AssembledMessage.end(), part.begin(), part.end());
+		assembly.Used = false;
+		assembly.Fragments.clear();
+		if (m_OnMessage)
+			m_OnMessage(UDPChannel::Unreliable, m_AssembledMessage.data(), static_cast<uint32_t>(m_AssembledMessage.size()));
+	}
+
+	void UDPSession::deliverReliable(const ReliableMessage& message)
+	{
+		if (message.FragmentCount == 1)
+		{
+			if (m_OnMessage)
+				m_OnMessage(UDPChannel::Reliable, message.Data.data(), static_cast<uint32_t>(message.Data.size()));
+			return;
+		}
+		// Fragments arrive in order, fragment out of sequence can come only from malformed stream
+		if (message.FragmentIndex != m_ReliableFragments)
+		{
+			m_ReliableAssembly.clear();
+			m_ReliableFragments = 0;
+			if (message.FragmentIndex != 0)
+				return;
+		}
+		m_ReliableAssembly.insert(m_ReliableAssembly.end(), message.Data.begin(), message.Data.end());
+		if (++m_ReliableFragments != message.FragmentCount)
+			return;
+
+		if (m_OnMessage)
+			m_OnMessage(UDPChannel::Reliable, m_ReliableAssembly.data(), static_cast<uint32_t>(m_ReliableAssembly.size()));
+		m_ReliableAssembly.clear();
+		m_ReliableFragments = 0;
+	}
+
+	void UDPSession::fillReliableWindow()
+	{
+		while (!m_ReliableBacklog.empty() && static_cast<uint16_t>(m_NextReliableID - m_OldestReliableID) < sc_ReliableWindow)
+		{
+			ReliableMessage& message = m_ReliableMessages[m_NextReliableID % sc_ReliableWindow];
+			message = std::move(m_ReliableBacklog.front());
+			message.Used = true;
+			message.LastSent = -1.0;
+			m_ReliableBacklog.pop_front();
+			m_NextReliableID++;
+		}
+	}
+
+	bool UDPSession::isReceived(uint16_t sequence) const
+	{
+		return m_ReceivedSequences[sequence % sc_SequenceBufferSize] == sequence;
+	}
+
+	uint32_t UDPSession::getAckBits() const
+	{
+		if (!m_HasReceived)
+			return 0;
+
+		uint32_t bits = 0;
+		for (uint32_t i = 0; i < 32; ++i)
+		{
+			if (isReceived(static_cast<uint16_t>(m_RemoteSequence - i)))
+				bits |= 1u << i;
+		}
+		return bits;
+	}
+
+	uint32_t UDPSession::messageSize(uint32_t size, bool fragment)
+	{
+		const uint32_t headerBits = 1 + 16 + 1 + (fragment ? 2 * sc_FragmentBits : 0) + sc_SizeBits + Utils::BitsRequired(size);
+		return (headerBits + 7) / 8 + size;
+	}
+
+	bool UDPSession::sequenceGreater(uint16_t a, uint16_t b)
+	{
+		return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+	}
+}
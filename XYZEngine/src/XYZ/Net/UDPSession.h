@@ -1,6 +1,186 @@
 #pragma once
+#include "BitStream.h"
 
+#include <array>
+#include <deque>
+#include <functional>
+#include <vector>
 
 namespace XYZ {
 
-}
\ No newline at end of file
+	enum class UDPChannel : uint8_t
+	{
+		Unreliable,
+		Reliable  // Resent until acked, delivered once and in order
+	};
+
+	struct UDPSessionStatistics
+	{
+		uint64_t PacketsSent = 0;
+		uint64_t PacketsReceived = 0;
+		uint64_t PacketsAcked = 0;
+		uint64_t PacketsLost = 0;	   // Fell out of ack window without being acked
+		uint64_t BytesSent = 0;
+		uint64_t BytesReceived = 0;
+		uint64_t ReliableResent = 0;
+		float	 RoundTripTime = 0.0f; // Smoothed, seconds
+		float	 PacketLoss = 0.0f;	   // Smoothed, 0 - 1
+	};
+
+	// One side of connection over unreliable transport. Every packet carries sequence and acks
+	// of last 32 packets received from remote side, so packet is acked even if some replies are lost.
+	// Message that does not fit into empty packet is split into fragments sent in separate packets.
+	// Session does not own socket, packets are passed to send function, e.g. UDPServer::QueueSend
+	class UDPSession
+	{
+	public:
+		static constexpr uint32_t sc_HeaderSize = 8;
+		static constexpr uint32_t sc_MaxPacketSize = 1200;	 // Stays under common MTU
+		static constexpr uint32_t sc_SequenceBufferSize = 1024;
+		static constexpr uint32_t sc_ReliableWindow = 256;	 // Unacked reliable messages in flight
+		static constexpr float	  sc_MinResendTime = 0.05f;
+		static constexpr uint32_t sc_MaxFragments = 1024;
+		static constexpr uint32_t sc_FragmentBufferSize = 64;  // Fragmented unreliable messages waiting for acks
+		static constexpr uint32_t sc_ReassemblyBufferSize = 8; // Fragmented unreliable messages received at once
+
+		using SendFunc = std::function<void(const void* data, size_t size)>;
+		using MessageFunc = std::function<void(UDPChannel channel, const uint8_t* data, uint32_t size)>;
+		// Called with id returned from SendUnreliable once packets carrying message are acked
+		using AckFunc = std::function<void(uint16_t messageID)>;
+
+		UDPSession(SendFunc sendFunc, uint32_t maxPacketSize = sc_MaxPacketSize);
+
+		// Size is limited by GetMaxMessageSize
+		void	 SendReliable(const void* data, uint32_t size);
+		// Fragmented message is delivered and acked only if all its fragments arrive
+		uint16_t SendUnreliable(const void* data, uint32_t size);
+
+		// Packs queued messages and due resends, one packet is sent even if there is nothing to carry acks.
+		// Returns number of packets sent
+		uint32_t Update(double time);
+		// Returns false for malformed, stale or duplicate packet
+		bool	 Receive(const void* data, size_t size, double time);
+
+		void SetMessageHandler(const MessageFunc& func) { m_OnMessage = func; }
+		void SetAckHandler(const AckFunc& func)			{ m_OnAck = func; }
+
+		const UDPSessionStatistics& GetStatistics()		 const { return m_Statistics; }
+		uint32_t					GetMaxMessageSize() const { return m_FragmentSize * sc_MaxFragments; }
+
+	private:
+		struct SentPacket
+		{
+			uint32_t			  Sequence = UINT32_MAX; // Slot is empty if it does not match
+			bool				  Acked = false;
+			double				  Time = 0.0;
+			std::vector<uint16_t> ReliableIDs;
+			std::vector<uint16_t> UnreliableIDs;
+			std::vector<uint16_t> FragmentIDs; // Unreliable messages with fragment in packet
+		};
+
+		// Fragments of reliable message are consecutive reliable messages
+		struct ReliableMessage
+		{
+			bool				 Used = false;
+			double				 LastSent = -1.0;
+			uint16_t			 FragmentIndex = 0;
+			uint16_t			 FragmentCount = 1;
+			std::vector<uint8_t> Data;
+		};
+
+		struct UnreliableMessage
+		{
+			uint16_t ID;
+			uint32_t Offset;
+			uint32_t Size;
+		};
+
+		struct SentFragments
+		{
+			uint16_t ID = 0;
+			uint32_t Remaining = 0; // Fragments not acked yet
+		};
+
+		// Points into received packet
+		struct ReceivedMessage
+		{
+			UDPChannel	   Channel;
+			uint16_t	   ID;
+			uint16_t	   FragmentIndex;
+			uint16_t	   FragmentCount;
+			const uint8_t* Data;
+			uint32_t	   Size;
+		};
+
+		struct FragmentAssembly
+		{
+			bool							  Used = false;
+			uint16_t						  ID = 0;
+			uint32_t						  Received = 0;
+			std::vector<std::vector<uint8_t>> Fragments; // Empty until received
+		};
+
+		void	 beginPacket(double time);
+		void	 endPacket();
+		bool	 fits(uint32_t size, bool fragment) const;
+		void	 writeMessage(UDPChannel channel, uint16_t id, const void* data, uint32_t size, uint32_t fragmentIndex = 0, uint32_t fragmentCount = 1);
+
+		void	 processAcks(uint16_t ack, uint32_t ackBits, double time);
+		void	 processAck(uint16_t sequence, double time);
+		void	 updateLoss(uint16_t ack);
+		void	 receiveReliable(const ReceivedMessage& received);
+		void	 receiveFragment(const ReceivedMessage& received);
+		void	 deliverReliable(const ReliableMessage& message);
+		void	 fillReliableWindow();
+
+		bool	 isReceived(uint16_t sequence) const;
+		uint32_t getAckBits() const;
+
+		static uint32_t messageSize(uint32_t size, bool fragment);
+		static bool		sequenceGreater(uint16_t a, uint16_t b);
+
+	private:
+		SendFunc	m_SendFunc;
+		MessageFunc m_OnMessage;
+		AckFunc		m_OnAck;
+		uint32_t	m_MaxPacketSize;
+		uint32_t	m_FragmentSize;
+
+		BitWriter	m_Writer;
+		SentPacket* m_CurrentPacket = nullptr;
+		uint32_t	m_MessagesInPacket = 0;
+
+		// Send side
+		uint16_t								  m_Sequence = 0;
+		std::array<SentPacket, sc_SequenceBufferSize> m_SentPackets;
+		uint16_t								  m_LossCheckSequence = 0;
+		bool									  m_HasAck = false;
+		uint16_t								  m_LatestAck = 0;
+
+		std::array<ReliableMessage, sc_ReliableWindow> m_ReliableMessages;
+		uint16_t								  m_NextReliableID = 0;
+		uint16_t								  m_OldestReliableID = 0;
+		std::deque<ReliableMessage>				  m_ReliableBacklog; // Waits for space in window
+
+		std::vector<uint8_t>					  m_UnreliableData;
+		std::vector<UnreliableMessage>			  m_UnreliableMessages;
+		uint16_t								  m_NextUnreliableID = 0;
+		std::array<SentFragments, sc_FragmentBufferSize> m_SentFragments;
+
+		// Receive side
+		bool									  m_HasReceived = false;
+		uint16_t								  m_RemoteSequence = 0;
+		std::array<uint32_t, sc_SequenceBufferSize> m_ReceivedSequences;
+
+		uint16_t								  m_ReceiveReliableID = 0;
+		std::array<ReliableMessage, sc_ReliableWindow> m_ReceivedMessages;
+		std::vector<ReceivedMessage>			  m_ParsedMessages;
+
+		std::array<FragmentAssembly, sc_ReassemblyBufferSize> m_Assemblies;
+		std::vector<uint8_t>					  m_AssembledMessage; // Scratch of receiveFragment
+		std::vector<uint8_t>					  m_ReliableAssembly;
+		uint32_t								  m_ReliableFragments = 0; // Received fragments of reliable message in assembly
+
+		UDPSessionStatistics					  m_Statistics;
+	};
+}
@@ -50,8 +50,7 @@ namespace XYZ {
 		m_EmittedParticles += EmitRate * ts;
 
 		const uint32_t newParticles = (uint32_t)m_EmittedParticles + burstEmit();
-		const uint32_t startId = data.GetAliveParticles();
-		const uint32_t endId = std::min(startId + newParticles, data.GetMaxParticles());
+		const uint32_t count = std::min(newParticles, data.GetMaxParticles() - data.GetAliveParticles());
 		if (newParticles)
 			m_EmittedParticles = 0.0f;
 
@@ -59,26 +58,18 @@ namespace XYZ {
 
 		if (Shape == EmitShape::Box)
 		{
-			for (uint32_t i = startId; i < endId; ++i)
-			{
-				generate(data, i);
-				generateBox(data, i);
-			}
+			for (uint32_t i = 0; i < count; ++i)
+				generateBox(data, generate(data));
 		}
 		else if (Shape == EmitShape::Circle)
 		{
-			for (uint32_t i = startId; i < endId; ++i)
-			{
-				generate(data, i);
-				generateCircle(data, i);
-			}
+			for (uint32_t i = 0; i < count; ++i)
+				generateCircle(data, generate(data));
 		}
 		else
 		{
-			for (uint32_t i = startId; i < endId; ++i)
-			{
-				generate(data, i);
-			}
+			for (uint32_t i = 0; i < count; ++i)
+				generate(data);
 		}
 		m_PassedTime += ts;
 	}
@@ -86,16 +77,21 @@ namespace XYZ {
 	void ParticleEmitter::Kill(ParticlePool& data)
 	{
 		XYZ_PROFILE_FUNC("ParticleEmitter::Kill");
-		uint32_t aliveParticles = data.GetAliveParticles();
-		for (uint32_t i = 0; i < aliveParticles; ++i)
+		const float* lifeRemaining = data.GetStream(ParticlePool::LifeRemaining);
+		uint32_t i = 0;
+		while (i < data.GetAliveParticles())
 		{
-			if (data.Particles[i].LifeRemaining <= 0.0f)
+			if (lifeRemaining[i] <= 0.0f)
 			{
-				aliveParticles--;
+				// Last alive particle is moved to i, test it again
 				data.Kill(i);
 				if (m_AliveLights != 0)
 					m_AliveLights--;
 			}
+			else
+			{
+				i++;
+			}
 		}
 	}
 
@@ -122,23 +118,24 @@ namespace XYZ {
 		}
 		return count;
 	}
-	void ParticleEmitter::generate(ParticlePool& data, uint32_t id) const
+	uint32_t ParticleEmitter::generate(ParticlePool& data) const
 	{
-		data.Wake(id);
-		data.Particles[id].Color = Color;
-		data.Particles[id].TexOffset = glm::vec2(0.0f, 0.0f);
-		data.Particles[id].Size = Size;
-		data.Particles[id].Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
-		data.Particles[id].LifeRemaining = LifeTime;
-		data.Particles[id].Velocity = glm::linearRand(MinVelocity, MaxVelocity);
-		data.Particles[id].Position = glm::vec3(0.0f);
-		data.Particles[id].LightColor = LightColor;
-		data.Particles[id].LightIntensity = LightIntensity;
-		data.Particles[id].LightRadius = LightRadius;
+		const uint32_t id = data.Wake();
+		data.SetVec4(ParticlePool::ColorR, id, Color);
+		data.SetVec2(ParticlePool::TexOffsetX, id, glm::vec2(0.0f, 0.0f));
+		data.SetVec3(ParticlePool::SizeX, id, Size);
+		data.SetRotation(id, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		data.GetStream(ParticlePool::LifeRemaining)[id] = LifeTime;
+		data.SetVec3(ParticlePool::VelocityX, id, glm::linearRand(MinVelocity, MaxVelocity));
+		data.SetVec3(ParticlePool::PositionX, id, glm::vec3(0.0f));
+		data.SetVec3(ParticlePool::LightColorR, id, LightColor);
+		data.GetStream(ParticlePool::LightIntensity)[id] = LightIntensity;
+		data.GetStream(ParticlePool::LightRadius)[id] = LightRadius;
+		return id;
 	}
 	void ParticleEmitter::generateBox(ParticlePool& data, uint32_t id) const
 	{
-		data.Particles[id].Position = glm::linearRand(BoxMin, BoxMax);
+		data.SetVec3(ParticlePool::PositionX, id, glm::linearRand(BoxMin, BoxMax));
 	}
 	void ParticleEmitter::generateCircle(ParticlePool& data, uint32_t id) const
 	{
@@ -152,6 +149,6 @@ namespace XYZ {
 			Radius * cos(theta),
 			Radius * sin(theta)
 		);
-		data.Particles[id].Position = glm::vec3(point.x, point.y, 0.0f);
+		data.SetVec3(ParticlePool::PositionX, id, glm::vec3(point.x, point.y, 0.0f));
 	}
 }
\ No newline at end of file
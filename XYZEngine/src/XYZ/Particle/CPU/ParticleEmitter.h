@@ -57,7 +57,7 @@ namespace XYZ {
 	private:
 		uint32_t burstEmit();
 
-		void	 generate(ParticlePool& data, uint32_t id) const;
+		uint32_t generate(ParticlePool& data) const;
 		void	 generateBox(ParticlePool& data, uint32_t id) const;
 		void	 generateCircle(ParticlePool& data, uint32_t id) const;
 
@@ -0,0 +1,165 @@
+#include "stdafx.h"
+#include "ParticleKernels.h"
+
+#include "XYZ/Debug/Profiler.h"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/constants.hpp>
+
+#if defined(_M_X64) || defined(__SSE2__)
+	#define XYZ_PARTICLE_SSE
+	#include <emmintrin.h>
+#endif
+
+namespace XYZ {
+	namespace ParticleKernels {
+
+		static uint32_t RoundUpToGroup(uint32_t count)
+		{
+			return (count + 3) & ~3u;
+		}
+
+#ifdef XYZ_PARTICLE_SSE
+		// Polynomial approximation, error is below 4e-6 after reduction to [-pi/2, pi/2]
+		static __m128 Sin(__m128 x)
+		{
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			const __m128 pi		  = _mm_set1_ps(glm::pi<float>());
+			const __m128 halfPi   = _mm_set1_ps(glm::half_pi<float>());
+			const __m128 twoPi    = _mm_set1_ps(glm::two_pi<float>());
+
+			const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_div_ps(x, twoPi)));
+			x = _mm_sub_ps(x, _mm_mul_ps(turns, twoPi));
+
+			const __m128 sign = _mm_and_ps(x, signMask);
+			const __m128 folded = _mm_sub_ps(_mm_or_ps(pi, sign), x);
+			const __m128 foldMask = _mm_cmpgt_ps(_mm_andnot_ps(signMask, x), halfPi);
+			x = _mm_or_ps(_mm_and_ps(foldMask, folded), _mm_andnot_ps(foldMask, x));
+
+			const __m128 x2 = _mm_mul_ps(x, x);
+			__m128 result = _mm_set1_ps(1.0f / 362880.0f);
+			result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-1.0f / 5040.0f));
+			result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(1.0f / 120.0f));
+			result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-1.0f / 6.0f));
+			result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(1.0f));
+			return _mm_mul_ps(result, x);
+		}
+
+		static __m128 Cos(__m128 x)
+		{
+			return Sin(_mm_add_ps(x, _mm_set1_ps(glm::half_pi<float>())));
+		}
+
+		static __m128 LifeRatio(const float* lifeRemaining, uint32_t i, __m128 invLifeTime)
+		{
+			return _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_load_ps(&lifeRemaining[i]), invLifeTime));
+		}
+#endif
+
+		void Integrate(ParticlePool& pool, uint32_t count, float timestep)
+		{
+			XYZ_PROFILE_FUNC("ParticleKernels::Integrate");
+			float* position[3] = { pool.GetStream(ParticlePool::PositionX), pool.GetStream(ParticlePool::PositionY), pool.GetStream(ParticlePool::PositionZ) };
+			const float* velocity[3] = { pool.GetStream(ParticlePool::VelocityX), pool.GetStream(ParticlePool::VelocityY), pool.GetStream(ParticlePool::VelocityZ) };
+			float* lifeRemaining = pool.GetStream(ParticlePool::LifeRemaining);
+
+			count = RoundUpToGroup(count);
+#ifdef XYZ_PARTICLE_SSE
+			const __m128 ts = _mm_set1_ps(timestep);
+			for (uint32_t i = 0; i < count; i += 4)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+				{
+					const __m128 result = _mm_add_ps(_mm_load_ps(&position[axis][i]), _mm_mul_ps(_mm_load_ps(&velocity[axis][i]), ts));
+					_mm_store_ps(&position[axis][i], result);
+				}
+				_mm_store_ps(&lifeRemaining[i], _mm_sub_ps(_mm_load_ps(&lifeRemaining[i]), ts));
+			}
+#else
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+					position[axis][i] += velocity[axis][i] * timestep;
+				lifeRemaining[i] -= timestep;
+			}
+#endif
+		}
+
+		void LerpOverLife(const float* lifeRemaining, float lifeTime, const LerpChannel* channels, uint32_t channelCount, uint32_t count)
+		{
+			XYZ_PROFILE_FUNC("ParticleKernels::LerpOverLife");
+			const float invLifeTime = 1.0f / lifeTime;
+			count = RoundUpToGroup(count);
+#ifdef XYZ_PARTICLE_SSE
+			const __m128 invLifeTimeSIMD = _mm_set1_ps(invLifeTime);
+			for (uint32_t i = 0; i < count; i += 4)
+			{
+				const __m128 ratio = LifeRatio(lifeRemaining, i, invLifeTimeSIMD);
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const LerpChannel& channel = channels[c];
+					const __m128 result = _mm_add_ps(_mm_set1_ps(channel.Start), _mm_mul_ps(_mm_set1_ps(channel.End - channel.Start), ratio));
+					_mm_store_ps(&channel.Stream[i], result);
+				}
+			}
+#else
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const float ratio = 1.0f - lifeRemaining[i] * invLifeTime;
+				for (uint32_t c = 0; c < channelCount; ++c)
+					channels[c].Stream[i] = channels[c].Start + (channels[c].End - channels[c].Start) * ratio;
+			}
+#endif
+		}
+
+		void RotationOverLife(ParticlePool& pool, const glm::vec3& endRadians, float lifeTime, uint32_t count)
+		{
+			XYZ_PROFILE_FUNC("ParticleKernels::RotationOverLife");
+			const float* lifeRemaining = pool.GetStream(ParticlePool::LifeRemaining);
+			float* rotationX = pool.GetStream(ParticlePool::RotationX);
+			float* rotationY = pool.GetStream(ParticlePool::RotationY);
+			float* rotationZ = pool.GetStream(ParticlePool::RotationZ);
+			float* rotationW = pool.GetStream(ParticlePool::RotationW);
+
+			const float invLifeTime = 1.0f / lifeTime;
+			count = RoundUpToGroup(count);
+#ifdef XYZ_PARTICLE_SSE
+			// Same composition as glm::quat(eulerAngles) with half angles
+			const __m128 invLifeTimeSIMD = _mm_set1_ps(invLifeTime);
+			const __m128 halfX = _mm_set1_ps(endRadians.x * 0.5f);
+			const __m128 halfY = _mm_set1_ps(endRadians.y * 0.5f);
+			const __m128 halfZ = _mm_set1_ps(endRadians.z * 0.5f);
+			for (uint32_t i = 0; i < count; i += 4)
+			{
+				const __m128 ratio = LifeRatio(lifeRemaining, i, invLifeTimeSIMD);
+				const __m128 ax = _mm_mul_ps(halfX, ratio);
+				const __m128 ay = _mm_mul_ps(halfY, ratio);
+				const __m128 az = _mm_mul_ps(halfZ, ratio);
+
+				const __m128 cx = Cos(ax), cy = Cos(ay), cz = Cos(az);
+				const __m128 sx = Sin(ax), sy = Sin(ay), sz = Sin(az);
+
+				const __m128 cycz = _mm_mul_ps(cy, cz);
+				const __m128 sysz = _mm_mul_ps(sy, sz);
+				const __m128 sycz = _mm_mul_ps(sy, cz);
+				const __m128 cysz = _mm_mul_ps(cy, sz);
+
+				_mm_store_ps(&rotationW[i], _mm_add_ps(_mm_mul_ps(cx, cycz), _mm_mul_ps(sx, sysz)));
+				_mm_store_ps(&rotationX[i], _mm_sub_ps(_mm_mul_ps(sx, cycz), _mm_mul_ps(cx, sysz)));
+				_mm_store_ps(&rotationY[i], _mm_add_ps(_mm_mul_ps(cx, sycz), _mm_mul_ps(sx, cysz)));
+				_mm_store_ps(&rotationZ[i], _mm_sub_ps(_mm_mul_ps(cx, cysz), _mm_mul_ps(sx, sycz)));
+			}
+#else
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const float ratio = 1.0f - lifeRemaining[i] * invLifeTime;
+				const glm::quat rotation(endRadians * ratio);
+				rotationX[i] = rotation.x;
+				rotationY[i] = rotation.y;
+				rotationZ[i] = rotation.z;
+				rotationW[i] = rotation.w;
+			}
+#endif
+		}
+	}
+}
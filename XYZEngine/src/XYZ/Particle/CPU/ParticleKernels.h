@@ -0,0 +1,27 @@
+#pragma once
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+namespace XYZ {
+	namespace ParticleKernels {
+
+		struct LerpChannel
+		{
+			float* Stream;
+			float  Start;
+			float  End;
+		};
+
+		// Kernels process particles in groups of four, count is rounded up,
+		// pool streams are padded so the trailing group stays inside stride
+
+		XYZ_API void Integrate(ParticlePool& pool, uint32_t count, float timestep);
+
+		// Interpolates channels by life ratio, (lifeTime - lifeRemaining) / lifeTime
+		XYZ_API void LerpOverLife(const float* lifeRemaining, float lifeTime, const LerpChannel* channels, uint32_t channelCount, uint32_t count);
+
+		// Writes rotation created from euler angles scaled by life ratio
+		XYZ_API void RotationOverLife(ParticlePool& pool, const glm::vec3& endRadians, float lifeTime, uint32_t count);
+	}
+}
@@ -7,26 +7,23 @@ namespace XYZ {
 
 	ParticlePool::ParticlePool(const uint32_t maxParticles)
 		:
+		m_Data(nullptr),
+		m_Stride(0),
 		m_MaxParticles(maxParticles),
 		m_AliveParticles(0)
 	{
 		if (maxParticles)
-		{
 			generateParticles(maxParticles);
-		}
-		else
-		{
-			Particles	= nullptr;
-		}
 	}
 	ParticlePool::ParticlePool(ParticlePool&& other) noexcept
 	{
-		Particles = other.Particles;
-	
+		m_Data = other.m_Data;
+		m_Stride = other.m_Stride;
 		m_MaxParticles = other.m_MaxParticles;
 		m_AliveParticles = other.m_AliveParticles;
 
-		other.Particles = nullptr;
+		other.m_Data = nullptr;
+		other.m_Stride = 0;
 		other.m_MaxParticles = 0;
 		other.m_AliveParticles = 0;
 	}
@@ -37,6 +34,8 @@ namespace XYZ {
 
 	ParticlePool::ParticlePool(const ParticlePool& other)
 		:
+		m_Data(nullptr),
+		m_Stride(0),
 		m_MaxParticles(other.m_MaxParticles),
 		m_AliveParticles(other.m_AliveParticles)
 	{
@@ -45,39 +44,34 @@ namespace XYZ {
 			generateParticles(m_MaxParticles);
 			copyData(other);
 		}
-		else
-		{
-			Particles = nullptr;
-		}
 	}
-	
+
 	ParticlePool& ParticlePool::operator=(const ParticlePool& other)
 	{
+		if (this == &other)
+			return *this;
+
+		deleteParticles();
 		m_MaxParticles = other.m_MaxParticles;
 		m_AliveParticles = other.m_AliveParticles;
-		
-		deleteParticles();
 		if (m_MaxParticles)
 		{
 			generateParticles(m_MaxParticles);
 			copyData(other);
 		}
-		else
-		{
-			Particles = nullptr;
-		}	
 		return *this;
 	}
 
 	ParticlePool& ParticlePool::operator=(ParticlePool&& other) noexcept
 	{
 		deleteParticles();
-		Particles = other.Particles;
-
+		m_Data = other.m_Data;
+		m_Stride = other.m_Stride;
 		m_MaxParticles = other.m_MaxParticles;
 		m_AliveParticles = other.m_AliveParticles;
 
-		other.Particles = nullptr;
+		other.m_Data = nullptr;
+		other.m_Stride = 0;
 		other.m_MaxParticles = 0;
 		other.m_AliveParticles = 0;
 		return *this;
@@ -86,46 +80,103 @@ namespace XYZ {
 	{
 		deleteParticles();
 		m_MaxParticles = maxParticles;
-		generateParticles(maxParticles);
 		m_AliveParticles = 0;
+		if (maxParticles)
+			generateParticles(maxParticles);
 	}
 
-	void ParticlePool::Wake(uint32_t id)
+	uint32_t ParticlePool::Wake()
 	{
 		XYZ_ASSERT(m_AliveParticles < m_MaxParticles, "");
-		Particles[id].Alive = true;
-		m_AliveParticles++;
+		return m_AliveParticles++;
 	}
 	void ParticlePool::Kill(uint32_t id)
 	{
-		swapData(id, m_AliveParticles - 1);
-		Particles[m_AliveParticles - 1].Alive = false;
+		XYZ_ASSERT(id < m_AliveParticles, "");
+		const uint32_t last = m_AliveParticles - 1;
+		if (id != last)
+		{
+			for (uint32_t attribute = 0; attribute < NumAttributes; ++attribute)
+			{
+				float* stream = m_Data + attribute * m_Stride;
+				stream[id] = stream[last];
+			}
+		}
 		m_AliveParticles--;
 	}
-	void ParticlePool::generateParticles(uint32_t particleCount)
+	void ParticlePool::KillAll()
 	{
-		Particles = new Particle[particleCount];
-		for (size_t i = 0; i < particleCount; ++i)
-			Particles[i].Alive = false;
+		m_AliveParticles = 0;
 	}
-	void ParticlePool::swapData(uint32_t a, uint32_t b)
+
+	glm::vec2 ParticlePool::GetVec2(Attribute first, uint32_t id) const
+	{
+		const float* stream = GetStream(first);
+		return { stream[id], stream[id + m_Stride] };
+	}
+	glm::vec3 ParticlePool::GetVec3(Attribute first, uint32_t id) const
+	{
+		const float* stream = GetStream(first);
+		return { stream[id], stream[id + m_Stride], stream[id + 2 * m_Stride] };
+	}
+	glm::vec4 ParticlePool::GetVec4(Attribute first, uint32_t id) const
+	{
+		const float* stream = GetStream(first);
+		return { stream[id], stream[id + m_Stride], stream[id + 2 * m_Stride], stream[id + 3 * m_Stride] };
+	}
+	glm::quat ParticlePool::GetRotation(uint32_t id) const
+	{
+		const glm::vec4 value = GetVec4(RotationX, id);
+		return glm::quat(value.w, value.x, value.y, value.z);
+	}
+	void ParticlePool::SetVec2(Attribute first, uint32_t id, const glm::vec2& value)
 	{
-		Particles[a]	= Particles[b];
+		float* stream = GetStream(first);
+		stream[id] = value.x;
+		stream[id + m_Stride] = value.y;
+	}
+	void ParticlePool::SetVec3(Attribute first, uint32_t id, const glm::vec3& value)
+	{
+		float* stream = GetStream(first);
+		stream[id] = value.x;
+		stream[id + m_Stride] = value.y;
+		stream[id + 2 * m_Stride] = value.z;
+	}
+	void ParticlePool::SetVec4(Attribute first, uint32_t id, const glm::vec4& value)
+	{
+		float* stream = GetStream(first);
+		stream[id] = value.x;
+		stream[id + m_Stride] = value.y;
+		stream[id + 2 * m_Stride] = value.z;
+		stream[id + 3 * m_Stride] = value.w;
+	}
+	void ParticlePool::SetRotation(uint32_t id, const glm::quat& value)
+	{
+		SetVec4(RotationX, id, glm::vec4(value.x, value.y, value.z, value.w));
 	}
 
-	template <typename T>
-	static void copy(T* dest, T* source, uint32_t count)
+	void ParticlePool::generateParticles(uint32_t particleCount)
 	{
-		memcpy(dest, source, count * sizeof(T));
+		// Every stream starts aligned and can be processed in whole SIMD registers
+		constexpr uint32_t floatsPerAlignment = sc_StreamAlignment / sizeof(float);
+		m_Stride = (particleCount + floatsPerAlignment - 1) / floatsPerAlignment * floatsPerAlignment;
+
+		const size_t size = static_cast<size_t>(m_Stride) * NumAttributes * sizeof(float);
+		m_Data = static_cast<float*>(::operator new[](size, std::align_val_t{ sc_StreamAlignment }));
+		memset(m_Data, 0, size);
 	}
 
 	void ParticlePool::copyData(const ParticlePool& source)
 	{
-		copy(Particles,   source.Particles,	m_MaxParticles);	
+		XYZ_ASSERT(m_Stride == source.m_Stride, "");
+		memcpy(m_Data, source.m_Data, static_cast<size_t>(m_Stride) * NumAttributes * sizeof(float));
 	}
 
 	void ParticlePool::deleteParticles()
 	{
-		delete[]Particles;
+		if (m_Data)
+			::operator delete[](m_Data, std::align_val_t{ sc_StreamAlignment });
+		m_Data = nullptr;
+		m_Stride = 0;
 	}
 }
\ No newline at end of file
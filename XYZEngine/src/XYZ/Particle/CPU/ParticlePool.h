@@ -8,7 +8,8 @@
 
 namespace XYZ {
 
-    
+    // Particle attributes are stored as separate float streams,
+    // alive particles are always compacted at the beginning of streams
 	class XYZ_API ParticlePool
 	{
 	public:
@@ -21,39 +22,55 @@ namespace XYZ {
         ParticlePool& operator =(ParticlePool&& other) noexcept;
 
         void SetMaxParticles(uint32_t maxParticles);
-        void Wake(uint32_t id);
+        // Returns id of woken particle
+        uint32_t Wake();
+        // Moves last alive particle to id
         void Kill(uint32_t id);
+        void KillAll();
 
-        // Default particle data
-        struct Particle
+        // Vector attributes occupy consecutive streams
+        enum Attribute
         {
-            glm::vec3 Position;
-            glm::vec3 Velocity;
-            
-            glm::vec4 Color;
-            glm::vec2 TexOffset;
-            glm::vec3 Size;
-            glm::quat Rotation;
-
-            glm::vec3 LightColor;
-            float     LightRadius;
-            float     LightIntensity;
-
-            float     LifeRemaining;
-            bool      Alive;
+            PositionX, PositionY, PositionZ,
+            VelocityX, VelocityY, VelocityZ,
+            ColorR, ColorG, ColorB, ColorA,
+            TexOffsetX, TexOffsetY,
+            SizeX, SizeY, SizeZ,
+            RotationX, RotationY, RotationZ, RotationW,
+            LightColorR, LightColorG, LightColorB,
+            LightRadius,
+            LightIntensity,
+            LifeRemaining,
+            NumAttributes
         };
 
-        Particle* Particles;
+        float*       GetStream(Attribute attribute)       { return m_Data + attribute * m_Stride; }
+        const float* GetStream(Attribute attribute) const { return m_Data + attribute * m_Stride; }
+
+        glm::vec2 GetVec2(Attribute first, uint32_t id) const;
+        glm::vec3 GetVec3(Attribute first, uint32_t id) const;
+        glm::vec4 GetVec4(Attribute first, uint32_t id) const;
+        glm::quat GetRotation(uint32_t id) const;
+
+        void SetVec2(Attribute first, uint32_t id, const glm::vec2& value);
+        void SetVec3(Attribute first, uint32_t id, const glm::vec3& value);
+        void SetVec4(Attribute first, uint32_t id, const glm::vec4& value);
+        void SetRotation(uint32_t id, const glm::quat& value);
 
         uint32_t GetMaxParticles() const { return m_MaxParticles; }
         uint32_t GetAliveParticles() const { return m_AliveParticles; }
+        // Streams are padded, SIMD kernels may process up to stride particles
+        uint32_t GetStride() const { return m_Stride; }
+
+        static constexpr uint32_t sc_StreamAlignment = 32;
     private:
         void generateParticles(uint32_t particleCount);
         void deleteParticles();
-        void swapData(uint32_t a, uint32_t b);
         void copyData(const ParticlePool& source);
 
     private:
+        float*   m_Data;
+        uint32_t m_Stride;
         uint32_t m_MaxParticles;
         uint32_t m_AliveParticles;
     };
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "ParticleSystem.h"
+#include "ParticleKernels.h"
 #include "XYZ/Renderer/SceneRenderer.h"
 
 #include "XYZ/Scene/Components.h"
@@ -157,8 +158,7 @@ namespace XYZ {
 	void ParticleSystem::Reset()
 	{
 		std::unique_lock lock(m_JobsMutex);
-		for (uint32_t i = 0; i < m_Pool.GetAliveParticles(); ++i)
-			m_Pool.Kill(i);
+		m_Pool.KillAll();
 	}
 
 	void ParticleSystem::SetMaxParticles(uint32_t maxParticles)
@@ -185,7 +185,7 @@ namespace XYZ {
 		if (m_MaxParticles == 0)
 			return;
 
-		if (m_JobsCount != 0) // If we did not finish previous jobs, skip one update frame
+		if (!m_JobCounter.IsDone()) // If we did not finish previous jobs, skip one update frame
 			return;
 
 		pushMainJob(ts);
@@ -210,9 +210,8 @@ namespace XYZ {
 
 	void ParticleSystem::pushMainJob(Timestep ts)
 	{
-		m_JobsCount++;
 		Ref<ParticleSystem> instance = this;
-		Application::Get().GetThreadPool().PushJob([instance, ts]() mutable {
+		Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance, ts]() mutable {
 
 			XYZ_PROFILE_FUNC("ParticleSystem::pushMainJob");
 			std::unique_lock lock(instance->m_JobsMutex);
@@ -221,124 +220,76 @@ namespace XYZ {
 			instance->Emitter.Kill(instance->m_Pool);
 			instance->Emitter.Emit(ts, instance->m_Pool);
 
-			const uint32_t aliveParticles = instance->m_Pool.GetAliveParticles();
-			for (uint32_t i = 0; i < aliveParticles; ++i)
-			{
-				instance->m_Pool.Particles[i].Position += instance->m_Pool.Particles[i].Velocity * ts.GetSeconds();
-				instance->m_Pool.Particles[i].LifeRemaining -= ts.GetSeconds();
-			}
-			instance->m_JobsCount--;
+			ParticleKernels::Integrate(instance->m_Pool, instance->m_Pool.GetAliveParticles(), ts.GetSeconds());
 		});
 	}
 
 	void ParticleSystem::pushRotationJob()
 	{
-		m_JobsCount++;
 		Ref<ParticleSystem> instance = this;
-		Application::Get().GetThreadPool().PushJob([instance]() mutable {
+		Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance]() mutable {
 
 			XYZ_PROFILE_FUNC("ParticleSystem::pushRotationJob");
 			std::shared_lock lock(instance->m_JobsMutex);
 
-			auto particles = instance->m_Pool.Particles;
-			const uint32_t aliveParticles = instance->m_Pool.GetAliveParticles();
-
-			for (uint32_t i = 0; i < aliveParticles; ++i)
-			{
-				instance->updateRotation(particles[i]);
-			}
-			instance->m_JobsCount--;
+			instance->updateRotation(instance->m_Pool.GetAliveParticles());
 		});
 	}
 
 	void ParticleSystem::pushAnimationJob()
 	{
-		m_JobsCount++;
 		Ref<ParticleSystem> instance = this;
-		Application::Get().GetThreadPool().PushJob([instance]() mutable {
+		Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance]() mutable {
 
 			XYZ_PROFILE_FUNC("ParticleSystem::pushAnimationJob");
 			std::shared_lock lock(instance->m_JobsMutex);
 
-			auto particles = instance->m_Pool.Particles;
-			const uint32_t aliveParticles = instance->m_Pool.GetAliveParticles();
-
-			const uint32_t stageCount = instance->AnimationTiles.x * instance->AnimationTiles.y;
-			for (uint32_t i = 0; i < aliveParticles; ++i)
-			{
-				instance->updateAnimation(particles[i], stageCount);
-			}
-			instance->m_JobsCount--;
+			instance->updateAnimation(instance->m_Pool.GetAliveParticles());
 		});
 	}
 
 	void ParticleSystem::pushColorOverLifeJob()
 	{
-		m_JobsCount++;
 		Ref<ParticleSystem> instance = this;
-		Application::Get().GetThreadPool().PushJob([instance]() mutable {
+		Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance]() mutable {
 
 			XYZ_PROFILE_FUNC("ParticleSystem::pushColorOverLifeJob");
 			std::shared_lock lock(instance->m_JobsMutex);
 
-			auto particles = instance->m_Pool.Particles;
-			const uint32_t aliveParticles = instance->m_Pool.GetAliveParticles();
-
-			for (uint32_t i = 0; i < aliveParticles; ++i)
-			{
-				instance->updateColorOverLife(particles[i]);
-			}
-			instance->m_JobsCount--;
+			instance->updateColorOverLife(instance->m_Pool.GetAliveParticles());
 		});
 	}
 
 	void ParticleSystem::pushSizeOverLifeJob()
 	{
-		m_JobsCount++;
 		Ref<ParticleSystem> instance = this;
-		Application::Get().GetThreadPool().PushJob([instance]() mutable {
+		Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance]() mutable {
 
 			XYZ_PROFILE_FUNC("ParticleSystem::pushSizeOverLifeJob");
 			std::shared_lock lock(instance->m_JobsMutex);
 
-			auto particles = instance->m_Pool.Particles;
-			const uint32_t aliveParticles = instance->m_Pool.GetAliveParticles();
-
-			for (uint32_t i = 0; i < aliveParticles; ++i)
-			{
-				instance->updateSizeOverLife(particles[i]);
-			}
-			instance->m_JobsCount--;
+			instance->updateSizeOverLife(instance->m_Pool.GetAliveParticles());
 		});
 	}
 
 	void ParticleSystem::pushLightOverLifeJob()
 	{
-		m_JobsCount++;
 		Ref<ParticleSystem> instance = this;
-		Application::Get().GetThreadPool().PushJob([instance]() mutable {
+		Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance]() mutable {
 
 			XYZ_PROFILE_FUNC("ParticleSystem::pushLightOverLifeJob");
 			std::shared_lock lock(instance->m_JobsMutex);
 
-			auto particles = instance->m_Pool.Particles;
 			const uint32_t aliveParticles = instance->m_Pool.GetAliveParticles();
-
 			const uint32_t aliveLights = std::min(aliveParticles, instance->Emitter.MaxLights);
-
-			for (uint32_t i = 0; i < aliveLights; ++i)
-			{
-				instance->updateLightOverLife(particles[i]);
-			}
-			instance->m_JobsCount--;
+			instance->updateLightOverLife(aliveLights);
 		});
 	}
 
 	void ParticleSystem::pushBuildLightsDataJob(const glm::mat4& transform)
 	{
-		m_JobsCount++;
 		Ref<ParticleSystem> instance = this;
-		Application::Get().GetThreadPool().PushJob([instance,tr = transform]() mutable {
+		Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance,tr = transform]() mutable {
 
 			XYZ_PROFILE_FUNC("ParticleSystem::pushBuildLightsDataJob");
 			std::shared_lock lock(instance->m_JobsMutex);
@@ -350,22 +301,21 @@ namespace XYZ {
 			instance->m_RenderData.LightData.resize(maxLights);
 			for (uint32_t i = 0; i < maxLights; ++i)
 			{
-				const auto& particle = instance->m_Pool.Particles[i];
+				const auto& pool = instance->m_Pool;
 
 				const glm::mat4 particleTransform =
-					glm::translate(particle.Position)
-				  * glm::toMat4(particle.Rotation)
-				  * glm::scale(particle.Size);
+					glm::translate(pool.GetVec3(ParticlePool::PositionX, i))
+				  * glm::toMat4(pool.GetRotation(i))
+				  * glm::scale(pool.GetVec3(ParticlePool::SizeX, i));
 
 				const glm::mat4 worldParticleTransform = tr * particleTransform;
 
 				auto& light = instance->m_RenderData.LightData[i];
-				light.Color = particle.LightColor;
+				light.Color = pool.GetVec3(ParticlePool::LightColorR, i);
 				light.Position = Math::TransformToTranslation(worldParticleTransform);
-				light.Radius = particle.LightRadius;
-				light.Intensity = particle.LightIntensity;
+				light.Radius = pool.GetStream(ParticlePool::LightRadius)[i];
+				light.Intensity = pool.GetStream(ParticlePool::LightIntensity)[i];
 			}
-			instance->m_JobsCount--;
 		});
 	}
 
@@ -377,8 +327,7 @@ namespace XYZ {
 		const uint32_t numJobs = aliveParticles / sc_PerJobCount;
 		for (uint32_t jobIndex = 0; jobIndex < numJobs + 1; ++jobIndex)
 		{
-			m_JobsCount++;
-			Application::Get().GetThreadPool().PushJob([instance, jobIndex, tr = transform]() mutable {
+			Application::Get().GetThreadPool().PushJob(m_JobCounter, [instance, jobIndex, tr = transform]() mutable {
 
 				XYZ_PROFILE_FUNC("ParticleSystem::pushBuildRenderDataJob");
 				std::shared_lock lock(instance->m_JobsMutex);
@@ -390,51 +339,70 @@ namespace XYZ {
 
 				instance->buildRenderData(tr, startId, endId);
 				instance->m_RenderData.ParticleCount = aliveParticles;
-
-				instance->m_JobsCount--;
 			});
 		}
 	}
 
 
 
-	void ParticleSystem::updateAnimation(ParticlePool::Particle& particle, uint32_t stageCount) const
+	void ParticleSystem::updateAnimation(uint32_t aliveParticles)
 	{
-		const float ratio = CalcRatio(AnimationCycleLength, particle.LifeRemaining);
-		const float stageProgress = ratio * stageCount;
+		// Integer tile math, kept scalar
+		const float* lifeRemaining = m_Pool.GetStream(ParticlePool::LifeRemaining);
+		float* texOffsetX = m_Pool.GetStream(ParticlePool::TexOffsetX);
+		float* texOffsetY = m_Pool.GetStream(ParticlePool::TexOffsetY);
 
-		const uint32_t index = (uint32_t)floor(stageProgress);
-		const float column = index % AnimationTiles.x;
-		const float row = index / AnimationTiles.y;
+		const uint32_t stageCount = AnimationTiles.x * AnimationTiles.y;
+		for (uint32_t i = 0; i < aliveParticles; ++i)
+		{
+			const float ratio = CalcRatio(AnimationCycleLength, lifeRemaining[i]);
+			const float stageProgress = ratio * stageCount;
 
-		particle.TexOffset = glm::vec2(column / (float)AnimationTiles.x, row / (float)AnimationTiles.y);
+			const uint32_t index = (uint32_t)floor(stageProgress);
+			const float column = index % AnimationTiles.x;
+			const float row = index / AnimationTiles.y;
+
+			texOffsetX[i] = column / (float)AnimationTiles.x;
+			texOffsetY[i] = row / (float)AnimationTiles.y;
+		}
 	}
 
-	void ParticleSystem::updateRotation(ParticlePool::Particle& particle) const
+	void ParticleSystem::updateRotation(uint32_t aliveParticles)
 	{
-		const glm::vec3 radians = glm::radians(EndRotation);
-		const float ratio = CalcRatio(Emitter.LifeTime, particle.LifeRemaining);
-		particle.Rotation = glm::quat(radians * ratio);
+		ParticleKernels::RotationOverLife(m_Pool, glm::radians(EndRotation), Emitter.LifeTime, aliveParticles);
 	}
 
-	void ParticleSystem::updateColorOverLife(ParticlePool::Particle& particle) const
+	void ParticleSystem::updateColorOverLife(uint32_t aliveParticles)
 	{
-		const float ratio = CalcRatio(Emitter.LifeTime, particle.LifeRemaining);
-		particle.Color = glm::lerp(Emitter.Color, EndColor, ratio);
+		const ParticleKernels::LerpChannel channels[] = {
+			{ m_Pool.GetStream(ParticlePool::ColorR), Emitter.Color.r, EndColor.r },
+			{ m_Pool.GetStream(ParticlePool::ColorG), Emitter.Color.g, EndColor.g },
+			{ m_Pool.GetStream(ParticlePool::ColorB), Emitter.Color.b, EndColor.b },
+			{ m_Pool.GetStream(ParticlePool::ColorA), Emitter.Color.a, EndColor.a }
+		};
+		ParticleKernels::LerpOverLife(m_Pool.GetStream(ParticlePool::LifeRemaining), Emitter.LifeTime, channels, 4, aliveParticles);
 	}
 
-	void ParticleSystem::updateSizeOverLife(ParticlePool::Particle& particle) const
+	void ParticleSystem::updateSizeOverLife(uint32_t aliveParticles)
 	{
-		const float ratio = CalcRatio(Emitter.LifeTime, particle.LifeRemaining);
-		particle.Size = glm::lerp(Emitter.Size, EndSize, ratio);
+		const ParticleKernels::LerpChannel channels[] = {
+			{ m_Pool.GetStream(ParticlePool::SizeX), Emitter.Size.x, EndSize.x },
+			{ m_Pool.GetStream(ParticlePool::SizeY), Emitter.Size.y, EndSize.y },
+			{ m_Pool.GetStream(ParticlePool::SizeZ), Emitter.Size.z, EndSize.z }
+		};
+		ParticleKernels::LerpOverLife(m_Pool.GetStream(ParticlePool::LifeRemaining), Emitter.LifeTime, channels, 3, aliveParticles);
 	}
 
-	void ParticleSystem::updateLightOverLife(ParticlePool::Particle& particle) const
+	void ParticleSystem::updateLightOverLife(uint32_t aliveLights)
 	{
-		const float ratio = CalcRatio(Emitter.LifeTime, particle.LifeRemaining);
-		particle.LightColor = glm::lerp(Emitter.LightColor, LightEndColor, ratio);
-		particle.LightIntensity = glm::lerp(Emitter.LightIntensity, LightEndIntensity, ratio);
-		particle.LightRadius = glm::lerp(Emitter.LightRadius, LightEndRadius, ratio);
+		const ParticleKernels::LerpChannel channels[] = {
+			{ m_Pool.GetStream(ParticlePool::LightColorR),	  Emitter.LightColor.r,   LightEndColor.r },
+			{ m_Pool.GetStream(ParticlePool::LightColorG),	  Emitter.LightColor.g,   LightEndColor.g },
+			{ m_Pool.GetStream(ParticlePool::LightColorB),	  Emitter.LightColor.b,   LightEndColor.b },
+			{ m_Pool.GetStream(ParticlePool::LightIntensity), Emitter.LightIntensity, LightEndIntensity },
+			{ m_Pool.GetStream(ParticlePool::LightRadius),	  Emitter.LightRadius,	  LightEndRadius }
+		};
+		ParticleKernels::LerpOverLife(m_Pool.GetStream(ParticlePool::LifeRemaining), Emitter.LifeTime, channels, 5, aliveLights);
 	}
 
 	void ParticleSystem::buildRenderData(const glm::mat4& transform, uint32_t startId, uint32_t endId)
@@ -442,20 +410,18 @@ namespace XYZ {
 		XYZ_PROFILE_FUNC("ParticleSystem::buildRenderData");
 		for (uint32_t i = startId; i < endId; ++i)
 		{
-			const auto& particle = m_Pool.Particles[i];
-
 			const glm::mat4 particleTransform =
-				glm::translate(particle.Position)
-				* glm::toMat4(particle.Rotation)
-				* glm::scale(particle.Size);
+				glm::translate(m_Pool.GetVec3(ParticlePool::PositionX, i))
+				* glm::toMat4(m_Pool.GetRotation(i))
+				* glm::scale(m_Pool.GetVec3(ParticlePool::SizeX, i));
 			
 			
 			const glm::mat4 worldParticleTransform = transform * particleTransform;
 
 
-			m_RenderData.ParticleData[i].Color = particle.Color;
+			m_RenderData.ParticleData[i].Color = m_Pool.GetVec4(ParticlePool::ColorR, i);
 			Mat4ToTransformData(m_RenderData.ParticleData[i].Transform, worldParticleTransform);
-			m_RenderData.ParticleData[i].TexOffset = particle.TexOffset;
+			m_RenderData.ParticleData[i].TexOffset = m_Pool.GetVec2(ParticlePool::TexOffsetX, i);
 		}
 	}
 
@@ -3,6 +3,7 @@
 
 #include "XYZ/Core/Timestep.h"
 #include "XYZ/Core/Ref/Ref.h"
+#include "XYZ/Core/ThreadPool.h"
 
 #include "ParticlePool.h"
 #include "ParticleUpdater.h"
@@ -110,11 +111,11 @@ namespace XYZ {
 		void pushBuildLightsDataJob(const glm::mat4& transform);
 		void pushBuildRenderDataJobs(const glm::mat4& transform);
 
-		void updateAnimation(ParticlePool::Particle& particle, uint32_t stageCount) const;
-		void updateRotation(ParticlePool::Particle& particle) const;
-		void updateColorOverLife(ParticlePool::Particle& particle) const;
-		void updateSizeOverLife(ParticlePool::Particle& particle) const;
-		void updateLightOverLife(ParticlePool::Particle& particle) const;
+		void updateAnimation(uint32_t aliveParticles);
+		void updateRotation(uint32_t aliveParticles);
+		void updateColorOverLife(uint32_t aliveParticles);
+		void updateSizeOverLife(uint32_t aliveParticles);
+		void updateLightOverLife(uint32_t aliveLights);
 
 		void buildRenderData(const glm::mat4& transform, uint32_t startId, uint32_t endId);
 
@@ -124,7 +125,7 @@ namespace XYZ {
 		uint32_t			m_MaxParticles;
 		std::shared_mutex	m_JobsMutex;
 
-		std::atomic_uint8_t m_JobsCount = 0;
+		JobCounter			m_JobCounter;
 		Timestep			m_Timestep;
 
 		static constexpr uint32_t sc_PerJobCount = 500;
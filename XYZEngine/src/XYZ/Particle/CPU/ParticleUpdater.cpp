@@ -34,7 +34,7 @@ namespace XYZ {
 			
 			for (uint32_t i = 0; i < aliveParticles && i < MaxLights; ++i)
 			{
-				Lights.push_back(data.Particles[i].Position);
+				Lights.push_back(data.GetVec3(ParticlePool::PositionX, i));
 			}
 		}
 	}
@@ -59,17 +59,18 @@ namespace XYZ {
 			float columnSize	= 1.0f / Tiles.x;
 			float rowSize		= 1.0f / Tiles.y;
 
+			const float* lifeRemaining = data.GetStream(ParticlePool::LifeRemaining);
 			const uint32_t aliveParticles = data.GetAliveParticles();
 			for (uint32_t i = 0; i < aliveParticles; ++i)
 			{
-				const float ratio			= CalcRatio(CycleLength, data.Particles[i].LifeRemaining);
+				const float ratio			= CalcRatio(CycleLength, lifeRemaining[i]);
 				const float stageProgress = ratio * stageCount;
 
 				const uint32_t index  = (uint32_t)floor(stageProgress);
 				const float column	= index % Tiles.x;
 				const float row		= index / Tiles.y;
 				
-				data.Particles[i].TexOffset = glm::vec2(column / Tiles.x, row / Tiles.y);
+				data.SetVec2(ParticlePool::TexOffsetX, i, glm::vec2(column / Tiles.x, row / Tiles.y));
 			}
 		}
 	}
@@ -84,12 +85,13 @@ namespace XYZ {
 	{
 		if (Enabled)
 		{
+			const float* lifeRemaining = data.GetStream(ParticlePool::LifeRemaining);
 			const uint32_t aliveParticles = data.GetAliveParticles();
 			const glm::vec3 radians = glm::radians(EulerAngles);
 			for (uint32_t i = 0; i < aliveParticles; ++i)
 			{
-				const float ratio = CalcRatio(CycleLength, data.Particles[i].LifeRemaining);
-				data.Particles[i].Rotation = glm::quat(radians * ratio);
+				const float ratio = CalcRatio(CycleLength, lifeRemaining[i]);
+				data.SetRotation(i, glm::quat(radians * ratio));
 			}
 		}
 	}
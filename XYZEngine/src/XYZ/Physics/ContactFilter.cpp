@@ -0,0 +1,22 @@
+#include "stdafx.h"
+#include "ContactFilter.h"
+
+namespace XYZ {
+	bool ContactFilter::ShouldCollide(b2Fixture* fixtureA, b2Fixture* fixtureB)
+	{
+		const b2Filter& filterA = fixtureA->GetFilterData();
+		const b2Filter& filterB = fixtureB->GetFilterData();
+		// Same group overrides layers, same as default Box2D filter
+		if (filterA.groupIndex == filterB.groupIndex && filterA.groupIndex != 0)
+			return filterA.groupIndex > 0;
+
+		const uintptr_t layerA = fixtureA->GetUserData().pointer;
+		const uintptr_t layerB = fixtureB->GetUserData().pointer;
+		if (layerA >= sc_NumLayers || layerB >= sc_NumLayers)
+			return false;
+
+		// Both layers must accept each other
+		return (m_Masks[layerA] & filterB.categoryBits) != 0
+			&& (m_Masks[layerB] & filterA.categoryBits) != 0;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <box2d/box2d.h>
+
+#include <array>
+
+namespace XYZ {
+
+	// Layer index of fixture is stored in its user data, category bits hold bit of the layer.
+	// Masks are looked up per layer, changing layer mask does not require touching fixtures
+	class XYZ_API ContactFilter : public b2ContactFilter
+	{
+	public:
+		static constexpr uint32_t sc_NumLayers = 16;
+
+		virtual bool ShouldCollide(b2Fixture* fixtureA, b2Fixture* fixtureB) override;
+
+		void	 SetMask(uint32_t layer, uint16_t mask) { m_Masks.at(layer) = mask; }
+		uint16_t GetMask(uint32_t layer) const			{ return m_Masks.at(layer); }
+
+	private:
+		std::array<uint16_t, sc_NumLayers> m_Masks{};
+	};
+}
@@ -1,15 +1,14 @@
 #include "stdafx.h"
 #include "ContactListener.h"
-#include "XYZ/Scene/SceneEntity.h"
 
 namespace XYZ {
 	void ContactListener::BeginContact(b2Contact* contact)
 	{
-		SceneEntity* A = reinterpret_cast<SceneEntity*>(contact->GetFixtureA()->GetBody()->GetUserData().pointer);
-		SceneEntity* B = reinterpret_cast<SceneEntity*>(contact->GetFixtureB()->GetBody()->GetUserData().pointer);
+		pushEvent(contact, ContactEventType::Begin);
 	}
 	void ContactListener::EndContact(b2Contact* contact)
 	{
+		pushEvent(contact, ContactEventType::End);
 	}
 	void ContactListener::PreSolve(b2Contact* contact, const b2Manifold* oldManifold)
 	{
@@ -21,4 +20,12 @@ namespace XYZ {
 		B2_NOT_USED(contact);
 		B2_NOT_USED(impulse);
 	}
-}
\ No newline at end of file
+	void ContactListener::pushEvent(b2Contact* contact, ContactEventType type)
+	{
+		m_Events.push_back({
+			contact->GetFixtureA()->GetBody()->GetUserData().pointer,
+			contact->GetFixtureB()->GetBody()->GetUserData().pointer,
+			type
+		});
+	}
+}
@@ -1,7 +1,21 @@
 #pragma once
 #include <box2d/box2d.h>
 
+#include <vector>
+
 namespace XYZ {
+
+	enum class ContactEventType : uint32_t { Begin, End };
+
+	// User data of bodies, resolved to entities after step
+	struct ContactEvent
+	{
+		uintptr_t		 UserDataA;
+		uintptr_t		 UserDataB;
+		ContactEventType Type;
+	};
+
+	// Callbacks run inside step, events are only recorded and dispatched after step finishes
 	class XYZ_API ContactListener : public b2ContactListener
 	{
 	public:
@@ -9,5 +23,15 @@ namespace XYZ {
 		virtual void EndContact(b2Contact* contact) override;
 		virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override;
 		virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override;
+
+		void Clear() { m_Events.clear(); }
+
+		const std::vector<ContactEvent>& GetEvents() const { return m_Events; }
+
+	private:
+		void pushEvent(b2Contact* contact, ContactEventType type);
+
+	private:
+		std::vector<ContactEvent> m_Events;
 	};
-}
\ No newline at end of file
+}
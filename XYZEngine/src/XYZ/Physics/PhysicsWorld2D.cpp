@@ -17,19 +17,85 @@ namespace XYZ {
 
 		m_Layers[ParticleLayer].m_CollisionMask.set(DefaultLayer, true);
 		m_Layers[ParticleLayer].m_CollisionMask.set(ParticleLayer, false);
+
+		for (uint32_t i = 0; i < sc_NumDefaultLayers; ++i)
+			m_ContactFilter.SetMask(i, static_cast<uint16_t>(m_Layers[i].m_CollisionMask.to_ulong()));
+		m_World.SetContactFilter(&m_ContactFilter);
+	}
+	PhysicsWorld2D::~PhysicsWorld2D()
+	{
+		{
+			std::unique_lock lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return !m_StepRequested; });
+			m_Running = false;
+		}
+		m_Condition.notify_all();
+		if (m_Thread.joinable())
+			m_Thread.join();
 	}
 	void PhysicsWorld2D::Step(Timestep ts)
 	{
-		XYZ_PROFILE_FUNC("PhysicsWorld2D::Step");
-
-		const int32_t velocityIterations = 6;
-		const int32_t positionIterations = 2;
-		m_World.Step(ts.GetSeconds(), velocityIterations, positionIterations);
+		Wait();
+		simulate(ts.GetSeconds());
+	}
+	void PhysicsWorld2D::StepAsync(Timestep ts)
+	{
+		{
+			std::unique_lock lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return !m_StepRequested; });
+			if (!m_Running)
+			{
+				m_Running = true;
+				m_Thread = std::thread(&PhysicsWorld2D::physicsThread, this);
+			}
+			m_PendingTime = ts.GetSeconds();
+			m_StepRequested = true;
+		}
+		m_Condition.notify_all();
+	}
+	void PhysicsWorld2D::Wait()
+	{
+		XYZ_PROFILE_FUNC("PhysicsWorld2D::Wait");
+		std::unique_lock lock(m_Mutex);
+		m_Condition.wait(lock, [this]() { return !m_StepRequested; });
+	}
+	void PhysicsWorld2D::Reset()
+	{
+		Wait();
+		m_Accumulator = 0.0f;
+		m_LastStepCount = 0;
+		m_BodyStates.clear();
+	}
+	void PhysicsWorld2D::SetSettings(const Settings& settings)
+	{
+		XYZ_ASSERT(settings.FixedTimestep > 0.0f && settings.MaxSubsteps > 0, "Invalid physics settings");
+		Wait();
+		m_Settings = settings;
 	}
 	void PhysicsWorld2D::SetLayer(const std::string& name, uint32_t index, const CollisionMask& mask)
 	{
 		XYZ_ASSERT(index >= sc_NumDefaultLayers, "Attempting to change default collision layer");
+		Wait();
 		m_Layers.at(index) = { name, index, mask };
+		m_ContactFilter.SetMask(index, static_cast<uint16_t>(mask.to_ulong()));
+		// Setting filter data flags contacts of fixture so they are filtered again
+		for (b2Body* body = m_World.GetBodyList(); body; body = body->GetNext())
+		{
+			for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+			{
+				if (fixture->GetUserData().pointer != index)
+					continue;
+				b2Filter filter = fixture->GetFilterData();
+				filter.maskBits = static_cast<uint16_t>(mask.to_ulong());
+				fixture->SetFilterData(filter);
+			}
+		}
+	}
+	void PhysicsWorld2D::ApplyLayer(b2FixtureDef& fixture, uint32_t index) const
+	{
+		fixture.filter.categoryBits = static_cast<uint16_t>(BIT(index));
+		fixture.filter.maskBits = m_ContactFilter.GetMask(index);
+		fixture.userData.pointer = static_cast<uintptr_t>(index);
 	}
 	const PhysicsWorld2D::Layer& PhysicsWorld2D::GetLayer(std::string_view name) const
 	{
@@ -48,6 +114,71 @@ namespace XYZ {
 	
 	b2World& PhysicsWorld2D::GetWorld()
 	{
+		Wait();
 		return m_World;
 	}
+
+	void PhysicsWorld2D::simulate(float frameTime)
+	{
+		XYZ_PROFILE_FUNC("PhysicsWorld2D::simulate");
+		const float fixedTimestep = m_Settings.FixedTimestep;
+		m_Accumulator += frameTime;
+
+		uint32_t stepCount = 0;
+		while (m_Accumulator >= fixedTimestep && stepCount < m_Settings.MaxSubsteps)
+		{
+			m_Accumulator -= fixedTimestep;
+			stepCount++;
+
+			// Previous state is needed only for last step of frame
+			const bool lastStep = m_Accumulator < fixedTimestep || stepCount == m_Settings.MaxSubsteps;
+			if (lastStep)
+			{
+				m_BodyStates.clear();
+				for (const b2Body* body = m_World.GetBodyList(); body; body = body->GetNext())
+				{
+					if (body->GetType() == b2_staticBody || !body->IsAwake())
+						continue;
+					m_BodyStates.push_back({ body, body->GetUserData().pointer, body->GetPosition(), body->GetAngle(), body->GetPosition(), body->GetAngle() });
+				}
+			}
+			m_World.Step(fixedTimestep, m_Settings.VelocityIterations, m_Settings.PositionIterations);
+		}
+		// Simulation can not keep up, slow down instead of accumulating more work
+		if (stepCount == m_Settings.MaxSubsteps)
+			m_Accumulator = std::min(m_Accumulator, fixedTimestep);
+
+		m_LastStepCount = stepCount;
+		if (stepCount == 0)
+			return;
+
+		// Bodies are not destroyed during step, pointers captured before last step are valid
+		for (BodyState& state : m_BodyStates)
+		{
+			state.Position = state.Body->GetPosition();
+			state.Angle = state.Body->GetAngle();
+		}
+	}
+
+	void PhysicsWorld2D::physicsThread()
+	{
+		while (true)
+		{
+			float frameTime = 0.0f;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return !m_Running || m_StepRequested; });
+				if (!m_Running)
+					return;
+				frameTime = m_PendingTime;
+			}
+
+			simulate(frameTime);
+			{
+				std::unique_lock lock(m_Mutex);
+				m_StepRequested = false;
+			}
+			m_Condition.notify_all();
+		}
+	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include "ContactFilter.h"
 #include "XYZ/Utils/DataStructures/ThreadPass.h"
 #include "XYZ/Core/Timestep.h"
 
@@ -7,6 +8,9 @@
 #include <glm/glm.hpp>
 
 #include <bitset>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace XYZ {
 
@@ -17,6 +21,7 @@ namespace XYZ {
 		static constexpr uint32_t sc_NumDefaultLayers = 2;
 
 		using CollisionMask = std::bitset<sc_NumCollisionLayers>;
+		static_assert(sc_NumCollisionLayers == ContactFilter::sc_NumLayers, "Contact filter must cover all layers");
 
 		enum DefaultLayers { DefaultLayer, ParticleLayer, Num };
 
@@ -26,22 +31,77 @@ namespace XYZ {
 			uint32_t	  m_ID;
 			CollisionMask m_CollisionMask;
 		};
+
+		struct Settings
+		{
+			float	 FixedTimestep = 1.0f / 60.0f;
+			uint32_t MaxSubsteps = 4; // Time left after max substeps is dropped
+			int32_t	 VelocityIterations = 6;
+			int32_t	 PositionIterations = 2;
+		};
+
+		// Awake body before and after last fixed step, render transform is interpolated between them
+		struct BodyState
+		{
+			const b2Body* Body;
+			uintptr_t	  UserData;
+			b2Vec2	  PreviousPosition;
+			float	  PreviousAngle;
+			b2Vec2	  Position;
+			float	  Angle;
+		};
 	public:
 
 		PhysicsWorld2D(const glm::vec2& gravity);
+		~PhysicsWorld2D();
 
+		// Advances simulation in fixed steps on calling thread
 		void Step(Timestep ts);
+		// Advances simulation on physics thread, world must not be touched until Wait returns
+		void StepAsync(Timestep ts);
+		void Wait();
+		// Drops accumulated time and body states, called when bodies are destroyed
+		void Reset();
 
+		void SetSettings(const Settings& settings);
+		const Settings& GetSettings() const { return m_Settings; }
+
+		// Fraction of fixed step accumulated but not simulated yet
+		float	 GetInterpolationAlpha() const { return m_Accumulator / m_Settings.FixedTimestep; }
+		uint32_t GetLastStepCount()		 const { return m_LastStepCount; }
+		const std::vector<BodyState>& GetBodyStates() const { return m_BodyStates; }
+
+		// Contacts of existing fixtures are filtered again with new mask
 		void SetLayer(const std::string& name, uint32_t index, const CollisionMask& mask = {});
-		
+		// Assigns fixture to layer, fixture collides only with layers accepted by both masks
+		void ApplyLayer(b2FixtureDef& fixture, uint32_t index) const;
+
 		const Layer& GetLayer(std::string_view name) const;
 		const Layer& GetLayer(uint32_t index) const;
 
 		const std::array<Layer, sc_NumCollisionLayers>& GetLayers() const { return m_Layers; }
 
+		// Waits for running step before returning world
 		b2World& GetWorld();
+	private:
+		void simulate(float frameTime);
+		void physicsThread();
+
 	private:		
 		b2World									 m_World;		
 		std::array<Layer, sc_NumCollisionLayers> m_Layers;
+		ContactFilter							 m_ContactFilter;
+
+		Settings			   m_Settings;
+		float				   m_Accumulator = 0.0f;
+		uint32_t			   m_LastStepCount = 0;
+		std::vector<BodyState> m_BodyStates;
+
+		std::thread				m_Thread;
+		std::mutex				m_Mutex;
+		std::condition_variable m_Condition;
+		float					m_PendingTime = 0.0f;
+		bool					m_StepRequested = false;
+		bool					m_Running = false;
 	};
 }
\ No newline at end of file
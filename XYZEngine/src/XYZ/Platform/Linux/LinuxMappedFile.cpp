@@ -0,0 +1,57 @@
+#include "stdafx.h"
+#include "XYZ/Utils/MappedFile.h"
+
+#ifdef XYZ_PLATFORM_LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace XYZ {
+
+	MappedFile::MappedFile(const std::string& filepath)
+	{
+		Open(filepath);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& filepath)
+	{
+		Close();
+		const int file = open(filepath.c_str(), O_RDONLY);
+		if (file == -1)
+			return false;
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		// Mapping keeps its own reference to the file
+		close(file);
+		if (data == MAP_FAILED)
+			return false;
+
+		madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+		m_Data = static_cast<const uint8_t*>(data);
+		m_Size = static_cast<size_t>(info.st_size);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data)
+			munmap(const_cast<uint8_t*>(m_Data), m_Size);
+
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+}
+#endif
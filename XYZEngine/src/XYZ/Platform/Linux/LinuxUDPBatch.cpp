@@ -0,0 +1,106 @@
+#include "stdafx.h"
+#include "XYZ/Net/UDPBatch.h"
+
+#ifdef XYZ_PLATFORM_LINUX
+#include <sys/socket.h>
+#include <errno.h>
+
+namespace XYZ {
+
+	static std::error_code lastSocketError()
+	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return asio::error::would_block;
+		return std::error_code(errno, std::system_category());
+	}
+
+	uint32_t UDPBatch::Receive(asio::ip::udp::socket& socket, std::error_code& ec)
+	{
+		ec.clear();
+		if (m_ReceiveRing.empty())
+			m_ReceiveRing.resize(m_BatchSize * m_DatagramSize);
+
+		std::array<mmsghdr, sc_MaxBatchSize> headers;
+		std::array<iovec, sc_MaxBatchSize>	 vectors;
+		for (uint32_t i = 0; i < m_BatchSize; ++i)
+		{
+			vectors[i] = { m_ReceiveRing.data() + i * m_DatagramSize, m_DatagramSize };
+			headers[i] = {};
+			headers[i].msg_hdr.msg_name = m_Received[i].Endpoint.data();
+			headers[i].msg_hdr.msg_namelen = static_cast<socklen_t>(m_Received[i].Endpoint.capacity());
+			headers[i].msg_hdr.msg_iov = &vectors[i];
+			headers[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		const int result = recvmmsg(socket.native_handle(), headers.data(), m_BatchSize, MSG_DONTWAIT, nullptr);
+		m_Statistics.ReceiveCalls++;
+		if (result < 0)
+		{
+			ec = lastSocketError();
+			return 0;
+		}
+
+		for (int i = 0; i < result; ++i)
+		{
+			Datagram& datagram = m_Received[i];
+			datagram.Endpoint.resize(headers[i].msg_hdr.msg_namelen);
+			datagram.Data = m_ReceiveRing.data() + i * m_DatagramSize;
+			datagram.Size = headers[i].msg_len;
+			datagram.Truncated = (headers[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+		}
+		m_Statistics.PacketsReceived += result;
+		return static_cast<uint32_t>(result);
+	}
+
+	size_t UDPBatch::Flush(asio::ip::udp::socket& socket, std::error_code& ec)
+	{
+		ec.clear();
+		std::array<mmsghdr, sc_MaxBatchSize> headers;
+		std::array<iovec, sc_MaxBatchSize>	 vectors;
+
+		size_t sent = 0;
+		while (m_QueuedCount != 0)
+		{
+			// Batch may span several endpoints, each header points to shared endpoint address
+			uint32_t count = 0;
+			uint32_t endpoint = m_FlushEndpoint;
+			uint32_t datagram = m_FlushDatagram;
+			while (count < m_BatchSize && endpoint < m_Endpoints.size())
+			{
+				EndpointQueue& queue = m_Endpoints[endpoint];
+				if (datagram == queue.Datagrams.size())
+				{
+					endpoint++;
+					datagram = 0;
+					continue;
+				}
+				const Span& span = queue.Datagrams[datagram++];
+				vectors[count] = { m_SendArena.data() + span.Offset, span.Size };
+				headers[count] = {};
+				headers[count].msg_hdr.msg_name = queue.Endpoint.data();
+				headers[count].msg_hdr.msg_namelen = static_cast<socklen_t>(queue.Endpoint.size());
+				headers[count].msg_hdr.msg_iov = &vectors[count];
+				headers[count].msg_hdr.msg_iovlen = 1;
+				count++;
+			}
+			if (count == 0)
+				break;
+
+			const int result = sendmmsg(socket.native_handle(), headers.data(), count, MSG_DONTWAIT);
+			m_Statistics.SendCalls++;
+			if (result < 0)
+			{
+				ec = lastSocketError();
+				// Error belongs to first datagram of batch, it would fail again
+				if (ec != asio::error::would_block)
+					advance(1);
+				return sent;
+			}
+			advance(result);
+			sent += result;
+			m_Statistics.PacketsSent += result;
+		}
+		return sent;
+	}
+}
+#endif
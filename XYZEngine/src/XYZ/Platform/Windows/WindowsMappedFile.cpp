@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "XYZ/Utils/MappedFile.h"
+
+#ifdef XYZ_PLATFORM_WINDOWS
+#include <Windows.h>
+
+namespace XYZ {
+
+	MappedFile::MappedFile(const std::string& filepath)
+	{
+		Open(filepath);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& filepath)
+	{
+		Close();
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_Data = static_cast<const uint8_t*>(data);
+		m_Size = static_cast<size_t>(size.QuadPart);
+		m_FileHandle = file;
+		m_MappingHandle = mapping;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_MappingHandle)
+			CloseHandle(m_MappingHandle);
+		if (m_FileHandle)
+			CloseHandle(m_FileHandle);
+
+		m_Data = nullptr;
+		m_Size = 0;
+		m_FileHandle = nullptr;
+		m_MappingHandle = nullptr;
+	}
+}
+#endif
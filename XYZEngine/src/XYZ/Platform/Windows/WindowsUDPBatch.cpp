@@ -0,0 +1,68 @@
+#include "stdafx.h"
+#include "XYZ/Net/UDPBatch.h"
+
+#ifdef XYZ_PLATFORM_WINDOWS
+
+namespace XYZ {
+
+	// No batched socket calls, datagrams go one by one through non blocking socket
+	uint32_t UDPBatch::Receive(asio::ip::udp::socket& socket, std::error_code& ec)
+	{
+		ec.clear();
+		if (m_ReceiveRing.empty())
+			m_ReceiveRing.resize(m_BatchSize * m_DatagramSize);
+		if (!socket.non_blocking())
+			socket.non_blocking(true, ec);
+
+		uint32_t count = 0;
+		while (!ec && count < m_BatchSize)
+		{
+			Datagram& datagram = m_Received[count];
+			std::byte* data = m_ReceiveRing.data() + count * m_DatagramSize;
+			const size_t size = socket.receive_from(asio::buffer(data, m_DatagramSize), datagram.Endpoint, 0, ec);
+			m_Statistics.ReceiveCalls++;
+			// Oversized datagram fails with message_size, its truncated part is still delivered
+			datagram.Truncated = ec == asio::error::message_size;
+			if (ec && !datagram.Truncated)
+				break;
+
+			ec.clear();
+			datagram.Data = data;
+			datagram.Size = datagram.Truncated ? m_DatagramSize : size;
+			count++;
+		}
+		// Something was read, end of data is not error
+		if (count != 0 && ec == asio::error::would_block)
+			ec.clear();
+
+		m_Statistics.PacketsReceived += count;
+		return count;
+	}
+
+	size_t UDPBatch::Flush(asio::ip::udp::socket& socket, std::error_code& ec)
+	{
+		ec.clear();
+		if (!socket.non_blocking())
+			socket.non_blocking(true, ec);
+
+		size_t sent = 0;
+		while (!ec && m_QueuedCount != 0)
+		{
+			const EndpointQueue& queue = m_Endpoints[m_FlushEndpoint];
+			const Span& span = queue.Datagrams[m_FlushDatagram];
+			socket.send_to(asio::buffer(m_SendArena.data() + span.Offset, span.Size), queue.Endpoint, 0, ec);
+			m_Statistics.SendCalls++;
+			if (ec == asio::error::would_block)
+				break;
+
+			advance(1);
+			if (!ec)
+			{
+				sent++;
+				m_Statistics.PacketsSent++;
+			}
+		}
+		return sent;
+	}
+}
+#endif
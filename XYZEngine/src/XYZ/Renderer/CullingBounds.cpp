@@ -0,0 +1,144 @@
+#include "stdafx.h"
+#include "CullingBounds.h"
+
+#include "XYZ/Debug/Profiler.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+	#define XYZ_CULLING_SSE
+	#include <xmmintrin.h>
+#endif
+
+namespace XYZ {
+
+	void CullingBounds::Clear()
+	{
+		m_CenterX.clear();
+		m_CenterY.clear();
+		m_CenterZ.clear();
+		m_ExtentX.clear();
+		m_ExtentY.clear();
+		m_ExtentZ.clear();
+	}
+
+	uint32_t CullingBounds::Push(const AABB& localBounds, const glm::mat4& transform)
+	{
+		const glm::vec3 localCenter = (localBounds.Min + localBounds.Max) * 0.5f;
+		const glm::vec3 localExtents = (localBounds.Max - localBounds.Min) * 0.5f;
+
+		// Extents of transformed box are projections of local extents on world axes
+		const glm::vec3 center = glm::vec3(transform * glm::vec4(localCenter, 1.0f));
+		const glm::vec3 extents =
+			  glm::abs(glm::vec3(transform[0])) * localExtents.x
+			+ glm::abs(glm::vec3(transform[1])) * localExtents.y
+			+ glm::abs(glm::vec3(transform[2])) * localExtents.z;
+
+		const uint32_t index = Size();
+		m_CenterX.push_back(center.x);
+		m_CenterY.push_back(center.y);
+		m_CenterZ.push_back(center.z);
+		m_ExtentX.push_back(extents.x);
+		m_ExtentY.push_back(extents.y);
+		m_ExtentZ.push_back(extents.z);
+		return index;
+	}
+
+	uint32_t CullingBounds::PushVisible()
+	{
+		const float extents = std::numeric_limits<float>::max();
+		const uint32_t index = Size();
+		m_CenterX.push_back(0.0f);
+		m_CenterY.push_back(0.0f);
+		m_CenterZ.push_back(0.0f);
+		m_ExtentX.push_back(extents);
+		m_ExtentY.push_back(extents);
+		m_ExtentZ.push_back(extents);
+		return index;
+	}
+
+	uint32_t CullingBounds::Cull(const Frustum& frustum, const glm::vec3& viewPosition, float maxDistance, std::vector<uint8_t>& visibility) const
+	{
+		XYZ_PROFILE_FUNC("CullingBounds::Cull");
+		const uint32_t count = Size();
+		const bool distanceTest = maxDistance > 0.0f;
+		const float maxDistanceSq = maxDistance * maxDistance;
+
+		visibility.resize(count);
+		uint32_t visibleCount = 0;
+		uint32_t i = 0;
+#ifdef XYZ_CULLING_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 viewX = _mm_set1_ps(viewPosition.x);
+		const __m128 viewY = _mm_set1_ps(viewPosition.y);
+		const __m128 viewZ = _mm_set1_ps(viewPosition.z);
+		const __m128 maxDistSq = _mm_set1_ps(maxDistanceSq);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 cx = _mm_loadu_ps(&m_CenterX[i]);
+			const __m128 cy = _mm_loadu_ps(&m_CenterY[i]);
+			const __m128 cz = _mm_loadu_ps(&m_CenterZ[i]);
+			const __m128 ex = _mm_loadu_ps(&m_ExtentX[i]);
+			const __m128 ey = _mm_loadu_ps(&m_ExtentY[i]);
+			const __m128 ez = _mm_loadu_ps(&m_ExtentZ[i]);
+
+			__m128 outside = zero;
+			for (const glm::vec4& plane : frustum.Planes)
+			{
+				const __m128 nx = _mm_set1_ps(plane.x);
+				const __m128 ny = _mm_set1_ps(plane.y);
+				const __m128 nz = _mm_set1_ps(plane.z);
+
+				const __m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(cx, nx), _mm_mul_ps(cy, ny)),
+					_mm_add_ps(_mm_mul_ps(cz, nz), _mm_set1_ps(plane.w))
+				);
+				const __m128 radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(ex, _mm_andnot_ps(signMask, nx)), _mm_mul_ps(ey, _mm_andnot_ps(signMask, ny))),
+					_mm_mul_ps(ez, _mm_andnot_ps(signMask, nz))
+				);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			if (distanceTest)
+			{
+				// Distance from view position to closest point of box
+				const __m128 dx = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(signMask, _mm_sub_ps(cx, viewX)), ex), zero);
+				const __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(signMask, _mm_sub_ps(cy, viewY)), ey), zero);
+				const __m128 dz = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(signMask, _mm_sub_ps(cz, viewZ)), ez), zero);
+				const __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(distSq, maxDistSq));
+			}
+
+			const int outsideMask = _mm_movemask_ps(outside);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				const uint8_t visible = ((outsideMask >> lane) & 1) == 0;
+				visibility[i + lane] = visible;
+				visibleCount += visible;
+			}
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			const glm::vec3 center = { m_CenterX[i], m_CenterY[i], m_CenterZ[i] };
+			const glm::vec3 extents = { m_ExtentX[i], m_ExtentY[i], m_ExtentZ[i] };
+
+			bool visible = true;
+			for (const glm::vec4& plane : frustum.Planes)
+			{
+				const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+				const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+				visible = visible && distance + radius >= 0.0f;
+			}
+			if (distanceTest)
+			{
+				const glm::vec3 delta = glm::max(glm::abs(center - viewPosition) - extents, glm::vec3(0.0f));
+				visible = visible && glm::dot(delta, delta) <= maxDistanceSq;
+			}
+			visibility[i] = visible;
+			visibleCount += visible;
+		}
+		return visibleCount;
+	}
+}
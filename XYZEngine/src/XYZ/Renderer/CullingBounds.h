@@ -0,0 +1,33 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+#include "XYZ/Utils/Math/AABB.h"
+#include "XYZ/Utils/Math/Frustum.h"
+
+#include <glm/glm.hpp>
+
+namespace XYZ {
+
+	// World space bounds of renderables stored as structure of arrays,
+	// culling kernel tests four bounds at once
+	class XYZ_API CullingBounds
+	{
+	public:
+		void Clear();
+
+		// Transforms local bounds to world space, returns index of bounds
+		uint32_t Push(const AABB& localBounds, const glm::mat4& transform);
+
+		// Pushes bounds that always pass culling
+		uint32_t PushVisible();
+
+		// Writes 1 for visible and 0 for culled bounds, returns number of visible bounds.
+		// Distance test is disabled if maxDistance is not positive
+		uint32_t Cull(const Frustum& frustum, const glm::vec3& viewPosition, float maxDistance, std::vector<uint8_t>& visibility) const;
+
+		uint32_t Size() const { return static_cast<uint32_t>(m_CenterX.size()); }
+
+	private:
+		std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+		std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+	};
+}
@@ -1,8 +1,138 @@
 #include "stdafx.h"
 #include "GeometryRenderQueue.h"
 
+#include "XYZ/Debug/Profiler.h"
 
 namespace XYZ {
+
+	static constexpr uint64_t sc_MaterialKeyBits = 24;
+	static constexpr uint64_t sc_MeshKeyBits	 = 23;
+	static constexpr uint64_t sc_DepthKeyBits	 = 16;
+
+	static constexpr uint64_t sc_DepthKeyShift	  = 0;
+	static constexpr uint64_t sc_OverrideKeyShift = sc_DepthKeyShift + sc_DepthKeyBits;
+	static constexpr uint64_t sc_MeshKeyShift	  = sc_OverrideKeyShift + 1;
+	static constexpr uint64_t sc_MaterialKeyShift = sc_MeshKeyShift + sc_MeshKeyBits;
+
+	static uint64_t HandleBits(const AssetHandle& handle, uint64_t bits)
+	{
+		return static_cast<uint64_t>(handle.Hash()) & ((1ull << bits) - 1);
+	}
+
+	static uint64_t DepthBits(float depth)
+	{
+		// Bit pattern of non negative float grows with its value, highest bits are enough for ordering
+		depth = std::max(depth, 0.0f);
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(float));
+		return static_cast<uint64_t>(bits >> (32 - sc_DepthKeyBits));
+	}
+
+	static float ViewDepth(const glm::mat4& viewMatrix, const glm::mat4& transform)
+	{
+		// Only z of view space translation is required
+		return -(viewMatrix[0][2] * transform[3][0] + viewMatrix[1][2] * transform[3][1] + viewMatrix[2][2] * transform[3][2] + viewMatrix[3][2]);
+	}
+
+	static void CopyToBoneStorage(GeometryRenderQueue::BoneTransforms& storage, const std::vector<ozz::math::Float4x4>& boneTransforms, const Ref<AnimatedMesh>& mesh)
+	{
+		if (boneTransforms.empty())
+		{
+			for (auto& bone : storage)
+				bone = ozz::math::Float4x4::identity();
+		}
+		else
+		{
+			const auto& boneInfo = mesh->GetMeshSource()->GetBoneInfo();
+			for (size_t i = 0; i < boneTransforms.size(); ++i)
+			{
+				const uint32_t jointIndex = boneInfo[i].JointIndex;
+				storage[i] = boneInfo[i].InverseTransform * boneTransforms[jointIndex] * boneInfo[i].BoneOffset;
+			}
+		}
+	}
+
+	template <typename Submission>
+	static void BuildSpriteCommands(GeometryRenderQueue::SubmissionList<Submission>& submissions, std::vector<GeometryRenderQueue::SpriteDrawCommand>& commands)
+	{
+		GeometryRenderQueue::SpriteDrawCommand* command = nullptr;
+		for (uint32_t i = 0; i < submissions.Size(); ++i)
+		{
+			Submission& submission = submissions[i];
+			uint32_t textureIndex = GeometryRenderQueue::SpriteDrawCommand::sc_InvalidTextureIndex;
+			// Key is only hash of material, handles must be compared too
+			if (command && command->MaterialAsset->GetHandle() == submission.MaterialAsset->GetHandle())
+				textureIndex = command->SetTexture(submission.Texture);
+
+			if (textureIndex == GeometryRenderQueue::SpriteDrawCommand::sc_InvalidTextureIndex)
+			{
+				command = &commands.emplace_back();
+				command->MaterialAsset = submission.MaterialAsset;
+				command->MaterialInstance = submission.MaterialAsset->GetMaterialInstance();
+				command->First = i;
+				textureIndex = command->SetTexture(submission.Texture);
+			}
+			submission.Data.TextureIndex = textureIndex;
+			command->Count++;
+		}
+	}
+
+	template <typename Command, typename Submission>
+	static void BuildMeshCommands(GeometryRenderQueue::SubmissionList<Submission>& submissions, std::vector<Command>& commands)
+	{
+		Command* command = nullptr;
+		for (uint32_t i = 0; i < submissions.Size(); ++i)
+		{
+			const Submission& submission = submissions[i];
+			const bool isOverride = submission.OverrideMaterial.Raw() != nullptr;
+
+			// Different batches can share key because of hash collision, instances must also precede overrides
+			if (!command
+				|| !(command->Mesh->GetRenderID() == submission.Mesh->GetRenderID())
+				|| !(command->MaterialAsset->GetHandle() == submission.MaterialAsset->GetHandle())
+				|| (!isOverride && command->OverrideCount != 0))
+			{
+				command = &commands.emplace_back();
+				command->Mesh = submission.Mesh;
+				command->MaterialAsset = submission.MaterialAsset;
+				command->OverrideMaterial = submission.MaterialAsset->GetMaterialInstance();
+				command->First = i;
+			}
+
+			if (isOverride)
+			{
+				command->OverrideCount++;
+			}
+			else
+			{
+				command->Count++;
+				command->TransformInstanceCount++;
+			}
+		}
+	}
+
+	static void BuildInstanceMeshCommands(GeometryRenderQueue::SubmissionList<GeometryRenderQueue::InstanceMeshSubmission>& submissions, std::vector<GeometryRenderQueue::InstanceMeshDrawCommand>& commands)
+	{
+		GeometryRenderQueue::InstanceMeshDrawCommand* command = nullptr;
+		for (uint32_t i = 0; i < submissions.Size(); ++i)
+		{
+			const auto& submission = submissions[i];
+			if (!command
+				|| !(command->Mesh->GetRenderID() == submission.Mesh->GetRenderID())
+				|| !(command->MaterialAsset->GetHandle() == submission.MaterialAsset->GetHandle()))
+			{
+				command = &commands.emplace_back();
+				command->Mesh = submission.Mesh;
+				command->MaterialAsset = submission.MaterialAsset;
+				command->OverrideMaterial = submission.MaterialAsset->GetMaterialInstance();
+				command->Transform = glm::mat4(1.0f);
+				command->First = i;
+			}
+			command->InstanceCount += submission.InstanceCount;
+			command->Count++;
+		}
+	}
+
 	uint32_t GeometryRenderQueue::SpriteDrawCommand::SetTexture(const Ref<Texture2D>& texture)
 	{
 		for (uint32_t i = 0; i < TextureCount; i++)
@@ -12,9 +142,155 @@ namespace XYZ {
 				return i;
 			}
 		}
+		if (TextureCount == Textures.size())
+			return sc_InvalidTextureIndex;
+
 		uint32_t result = TextureCount;
 		Textures[result] = texture;
 		TextureCount++;
 		return result;
 	}
-}
\ No newline at end of file
+
+	uint64_t GeometryRenderQueue::CreateSpriteKey(const AssetHandle& material)
+	{
+		return HandleBits(material, sc_MaterialKeyBits) << sc_MaterialKeyShift;
+	}
+
+	uint64_t GeometryRenderQueue::CreateMeshKey(const AssetHandle& material, const AssetHandle& mesh, bool isOverride, float depth)
+	{
+		return HandleBits(material, sc_MaterialKeyBits) << sc_MaterialKeyShift
+			 | HandleBits(mesh, sc_MeshKeyBits) << sc_MeshKeyShift
+			 | static_cast<uint64_t>(isOverride) << sc_OverrideKeyShift
+			 | DepthBits(depth) << sc_DepthKeyShift;
+	}
+
+	GeometryRenderQueue::TransformData GeometryRenderQueue::ToTransformData(const glm::mat4& transform)
+	{
+		TransformData data;
+		data.TransformRow[0] = { transform[0][0], transform[1][0], transform[2][0], transform[3][0] };
+		data.TransformRow[1] = { transform[0][1], transform[1][1], transform[2][1], transform[3][1] };
+		data.TransformRow[2] = { transform[0][2], transform[1][2], transform[2][2], transform[3][2] };
+		return data;
+	}
+
+	void GeometryRenderQueue::SubmitBillboard(const Ref<MaterialAsset>& material, const Ref<SubTexture>& subTexture, const glm::vec4& color, const glm::vec3& position, const glm::vec2& size)
+	{
+		auto& submission = BillboardSubmissions.Push(CreateSpriteKey(material->GetHandle()));
+		submission.MaterialAsset = material;
+		submission.Texture = subTexture->GetTexture();
+		submission.Data = { 0, subTexture->GetTexCoords(), color, position, size };
+	}
+
+	void GeometryRenderQueue::SubmitSprite(const Ref<MaterialAsset>& material, const Ref<SubTexture>& subTexture, const glm::vec4& color, const glm::mat4& transform)
+	{
+		auto& submission = SpriteSubmissions.Push(CreateSpriteKey(material->GetHandle()));
+		submission.MaterialAsset = material;
+		submission.Texture = subTexture->GetTexture();
+		submission.Data = { 0, subTexture->GetTexCoords(), color, transform };
+	}
+
+	void GeometryRenderQueue::SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const Ref<MaterialInstance>& overrideMaterial)
+	{
+		const bool isOverride = overrideMaterial.Raw() != nullptr;
+		const uint64_t key = CreateMeshKey(material->GetHandle(), mesh->GetRenderID(), isOverride, ViewDepth(ViewMatrix, transform));
+
+		auto& submission = MeshSubmissions.Push(key);
+		submission.Mesh = mesh;
+		submission.MaterialAsset = material;
+		submission.OverrideMaterial = overrideMaterial;
+		submission.Transform = transform;
+	}
+
+	void GeometryRenderQueue::SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const void* instanceData, uint32_t instanceCount, uint32_t instanceSize, const Ref<MaterialInstance>& overrideMaterial)
+	{
+		if (overrideMaterial.Raw())
+		{
+			XYZ_ASSERT(false, "Not implemented");
+			return;
+		}
+
+		const uint64_t key = CreateMeshKey(material->GetHandle(), mesh->GetRenderID(), false, 0.0f);
+		const uint32_t offset = static_cast<uint32_t>(InstanceData.size());
+		const uint32_t instanceDataSize = instanceCount * instanceSize;
+		InstanceData.resize(static_cast<size_t>(offset) + instanceDataSize);
+		memcpy(InstanceData.data() + offset, instanceData, instanceDataSize);
+
+		auto& submission = InstanceMeshSubmissions.Push(key);
+		submission.Mesh = mesh;
+		submission.MaterialAsset = material;
+		submission.InstanceDataOffset = offset;
+		submission.InstanceDataSize = instanceDataSize;
+		submission.InstanceCount = instanceCount;
+	}
+
+	void GeometryRenderQueue::SubmitMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& boneTransforms, const Ref<MaterialInstance>& overrideMaterial)
+	{
+		const bool isOverride = overrideMaterial.Raw() != nullptr;
+		const uint64_t key = CreateMeshKey(material->GetHandle(), mesh->GetRenderID(), isOverride, ViewDepth(ViewMatrix, transform));
+
+		auto& submission = AnimatedMeshSubmissions.Push(key);
+		submission.Mesh = mesh;
+		submission.MaterialAsset = material;
+		submission.OverrideMaterial = overrideMaterial;
+		submission.Transform = transform;
+		submission.BoneDataIndex = static_cast<uint32_t>(BoneData.size());
+		CopyToBoneStorage(BoneData.emplace_back(), boneTransforms, mesh);
+	}
+
+	void GeometryRenderQueue::SubmitSkinnedMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& skinningPalette, const Ref<MaterialInstance>& overrideMaterial)
+	{
+		const bool isOverride = overrideMaterial.Raw() != nullptr;
+		const uint64_t key = CreateMeshKey(material->GetHandle(), mesh->GetRenderID(), isOverride, ViewDepth(ViewMatrix, transform));
+
+		auto& submission = AnimatedMeshSubmissions.Push(key);
+		submission.Mesh = mesh;
+		submission.MaterialAsset = material;
+		submission.OverrideMaterial = overrideMaterial;
+		submission.Transform = transform;
+		submission.BoneDataIndex = static_cast<uint32_t>(BoneData.size());
+
+		auto& storage = BoneData.emplace_back();
+		const size_t count = std::min(skinningPalette.size(), storage.size());
+		memcpy(storage.data(), skinningPalette.data(), count * sizeof(ozz::math::Float4x4));
+		for (size_t i = count; i < storage.size(); ++i)
+			storage[i] = ozz::math::Float4x4::identity();
+	}
+
+	void GeometryRenderQueue::Merge(GeometryRenderQueue& other)
+	{
+		XYZ_PROFILE_FUNC("GeometryRenderQueue::Merge");
+		SpriteSubmissions.Append(other.SpriteSubmissions);
+		BillboardSubmissions.Append(other.BillboardSubmissions);
+		MeshSubmissions.Append(other.MeshSubmissions);
+
+		const uint32_t boneDataOffset = static_cast<uint32_t>(BoneData.size());
+		const uint32_t firstAnimated = AnimatedMeshSubmissions.Append(other.AnimatedMeshSubmissions);
+		for (size_t i = firstAnimated; i < AnimatedMeshSubmissions.Submissions.size(); ++i)
+			AnimatedMeshSubmissions.Submissions[i].BoneDataIndex += boneDataOffset;
+		BoneData.insert(BoneData.end(), other.BoneData.begin(), other.BoneData.end());
+		other.BoneData.clear();
+
+		const uint32_t instanceDataOffset = static_cast<uint32_t>(InstanceData.size());
+		const uint32_t firstInstanced = InstanceMeshSubmissions.Append(other.InstanceMeshSubmissions);
+		for (size_t i = firstInstanced; i < InstanceMeshSubmissions.Submissions.size(); ++i)
+			InstanceMeshSubmissions.Submissions[i].InstanceDataOffset += instanceDataOffset;
+		InstanceData.insert(InstanceData.end(), other.InstanceData.begin(), other.InstanceData.end());
+		other.InstanceData.clear();
+	}
+
+	void GeometryRenderQueue::BuildDrawCommands()
+	{
+		XYZ_PROFILE_FUNC("GeometryRenderQueue::BuildDrawCommands");
+		RadixSort(SpriteSubmissions.Keys, m_SortBuffer);
+		RadixSort(BillboardSubmissions.Keys, m_SortBuffer);
+		RadixSort(MeshSubmissions.Keys, m_SortBuffer);
+		RadixSort(AnimatedMeshSubmissions.Keys, m_SortBuffer);
+		RadixSort(InstanceMeshSubmissions.Keys, m_SortBuffer);
+
+		BuildSpriteCommands(SpriteSubmissions, SpriteDrawCommands);
+		BuildSpriteCommands(BillboardSubmissions, BillboardDrawCommands);
+		BuildMeshCommands(MeshSubmissions, MeshDrawCommands);
+		BuildMeshCommands(AnimatedMeshSubmissions, AnimatedMeshDrawCommands);
+		BuildInstanceMeshCommands(InstanceMeshSubmissions, InstanceMeshDrawCommands);
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "RenderPass.h"
 #include "Renderer2D.h"
+#include "SubTexture.h"
 #include "Mesh.h"
 #include "RenderCommandBuffer.h"
 #include "StorageBufferSet.h"
@@ -10,6 +11,8 @@
 
 #include "XYZ/Asset/Renderer/MaterialAsset.h"
 
+#include "XYZ/Utils/RadixSort.h"
+
 #include "XYZ/Scene/Scene.h"
 #include "XYZ/Scene/Components.h"
 #include "XYZ/Scene/Prefab.h"
@@ -17,37 +20,42 @@
 namespace XYZ {
 	struct XYZ_API GeometryRenderQueue
 	{
-		struct SpriteKey
+		// Submissions are appended in linear buffers and sorted by packed key,
+		// draw commands are then built in single sweep over sorted submissions
+		template <typename T>
+		struct SubmissionList
 		{
-			SpriteKey(const AssetHandle& matHandle)
-				: MaterialHandle(matHandle)
-			{}
+			std::vector<T>		 Submissions;
+			std::vector<SortKey> Keys;
 
-			bool operator<(const SpriteKey& other) const
+			T& Push(uint64_t key)
 			{
-				return (MaterialHandle < other.MaterialHandle);
+				Keys.push_back({ key, static_cast<uint32_t>(Submissions.size()) });
+				return Submissions.emplace_back();
+			}
+			void Clear()
+			{
+				Submissions.clear();
+				Keys.clear();
 			}
 
-			AssetHandle MaterialHandle;
-		};
-		struct BatchMeshKey
-		{
-			AssetHandle MeshHandle;
-			AssetHandle MaterialHandle;
-
-			BatchMeshKey(AssetHandle meshHandle, AssetHandle materialHandle)
-				: MeshHandle(meshHandle), MaterialHandle(materialHandle) {}
+			// Access in sorted order
+			T&		operator[](uint32_t index)		  { return Submissions[Keys[index].Index]; }
+			const T& operator[](uint32_t index) const { return Submissions[Keys[index].Index]; }
 
-			bool operator<(const BatchMeshKey& other) const
+			// Moves submissions of other list to the end, returns index of first moved submission
+			uint32_t Append(SubmissionList& other)
 			{
-				if (MeshHandle < other.MeshHandle)
-					return true;
-
-				return (MeshHandle == other.MeshHandle) && (MaterialHandle < other.MaterialHandle);
+				const uint32_t offset = static_cast<uint32_t>(Submissions.size());
+				Submissions.insert(Submissions.end(), std::make_move_iterator(other.Submissions.begin()), std::make_move_iterator(other.Submissions.end()));
+				for (const SortKey& key : other.Keys)
+					Keys.push_back({ key.Key, key.Index + offset });
+				other.Clear();
+				return offset;
 			}
-		};
-
 
+			uint32_t Size() const { return static_cast<uint32_t>(Keys.size()); }
+		};
 
 		struct SpriteDrawData
 		{
@@ -66,19 +74,37 @@ namespace XYZ {
 			glm::vec2 Size;
 		};
 
+		struct SpriteSubmission
+		{
+			Ref<MaterialAsset> MaterialAsset;
+			Ref<Texture2D>	   Texture;
+			SpriteDrawData	   Data; // TextureIndex is assigned when draw commands are built
+		};
+
+		struct BillboardSubmission
+		{
+			Ref<MaterialAsset> MaterialAsset;
+			Ref<Texture2D>	   Texture;
+			BillboardDrawData  Data;
+		};
+
 		struct SpriteDrawCommand
 		{
+			static constexpr uint32_t sc_InvalidTextureIndex = Renderer2D::GetMaxTextures();
+
 			Ref<MaterialAsset>	  MaterialAsset;
 			Ref<MaterialInstance> MaterialInstance;
+			Ref<Material>		  Material; // Holds textures of this batch, assigned by GeometryPass
 
 			std::array<Ref<Texture2D>, Renderer2D::GetMaxTextures()> Textures;
 
 			uint32_t       TextureCount = 0;
 
+			// Returns sc_InvalidTextureIndex if all texture slots are used
 			uint32_t SetTexture(const Ref<Texture2D>& texture);
 
-			std::vector<SpriteDrawData>		SpriteData;
-			std::vector<BillboardDrawData>	BillboardData;
+			uint32_t First = 0; // Range of sorted submissions
+			uint32_t Count = 0;
 		};
 
 		struct TransformData
@@ -87,10 +113,12 @@ namespace XYZ {
 		};
 		using BoneTransforms = std::array<ozz::math::Float4x4, 60>;
 
-		struct MeshDrawCommandOverride
+		struct MeshSubmission
 		{
-			Ref<MaterialInstance>  OverrideMaterial;
-			glm::mat4			   Transform;
+			Ref<Mesh>			  Mesh;
+			Ref<MaterialAsset>	  MaterialAsset;
+			Ref<MaterialInstance> OverrideMaterial;
+			glm::mat4			  Transform;
 		};
 
 		struct MeshDrawCommand
@@ -99,21 +127,23 @@ namespace XYZ {
 			Ref<MaterialAsset>			 MaterialAsset;
 			Ref<MaterialInstance>		 OverrideMaterial;
 			Ref<Pipeline>				 Pipeline;
-			uint32_t					 TransformInstanceCount = 0;
-
-			std::vector<TransformData>	 TransformData;
-			uint32_t					 TransformOffset = 0;
-			uint32_t					 Count = 0;
+			uint32_t				 TransformInstanceCount = 0;
+			uint32_t				 TransformOffset = 0;
 
-			std::vector<MeshDrawCommandOverride> OverrideCommands;
+			// Sorted submissions, instances are followed by overrides
+			uint32_t				 First = 0;
+			uint32_t				 Count = 0;
+			uint32_t				 OverrideCount = 0;
 		};
 
-		struct AnimatedMeshDrawCommandOverride
+		struct AnimatedMeshSubmission
 		{
-			Ref<MaterialInstance>  OverrideMaterial;
-			glm::mat4			   Transform;
-			BoneTransforms		   BoneTransforms;
-			uint32_t			   BoneTransformsIndex = 0;
+			Ref<AnimatedMesh>	  Mesh;
+			Ref<MaterialAsset>	  MaterialAsset;
+			Ref<MaterialInstance> OverrideMaterial;
+			glm::mat4			  Transform;
+			uint32_t			  BoneDataIndex = 0;
+			uint32_t			  BoneTransformsIndex = 0; // Used by overrides
 		};
 
 		struct AnimatedMeshDrawCommand
@@ -122,15 +152,23 @@ namespace XYZ {
 			Ref<MaterialAsset>			 MaterialAsset;
 			Ref<MaterialInstance>		 OverrideMaterial;
 			Ref<Pipeline>				 Pipeline;
-			uint32_t					 TransformInstanceCount = 0;
-
-			std::vector<TransformData>	 TransformData;
-			uint32_t					 TransformOffset = 0;
+			uint32_t				 TransformInstanceCount = 0;
+			uint32_t				 TransformOffset = 0;
+			uint32_t				 BoneTransformsIndex = 0;
+
+			// Sorted submissions, instances are followed by overrides
+			uint32_t				 First = 0;
+			uint32_t				 Count = 0;
+			uint32_t				 OverrideCount = 0;
+		};
 
-			std::vector<BoneTransforms>	 BoneData;
-			uint32_t					 BoneTransformsIndex = 0;
-			uint32_t					 Count = 0;
-			std::vector<AnimatedMeshDrawCommandOverride> OverrideCommands;
+		struct InstanceMeshSubmission
+		{
+			Ref<Mesh>		   Mesh;
+			Ref<MaterialAsset> MaterialAsset;
+			uint32_t		   InstanceDataOffset = 0; // Offset to InstanceData
+			uint32_t		   InstanceDataSize = 0;
+			uint32_t		   InstanceCount = 0;
 		};
 
 		struct InstanceMeshDrawCommand
@@ -141,9 +179,11 @@ namespace XYZ {
 			Ref<Pipeline>				 Pipeline;
 			glm::mat4					 Transform;
 	
-			std::vector<std::byte>		 InstanceData;
-			uint32_t					 InstanceCount = 0;
-			uint32_t					 InstanceOffset = 0;
+			uint32_t				 InstanceCount = 0;
+			uint32_t				 InstanceOffset = 0;
+
+			uint32_t				 First = 0; // Range of sorted submissions
+			uint32_t				 Count = 0;
 		};
 
 		struct IndirectMeshDrawCommandOverride
@@ -186,17 +226,57 @@ namespace XYZ {
 		};
 
 
-		std::map<SpriteKey, SpriteDrawCommand> SpriteDrawCommands;
-		std::map<SpriteKey, SpriteDrawCommand> BillboardDrawCommands;
+		// Key layout from most significant bits: material (pipeline is cached per material), mesh, override flag, view depth
+		static uint64_t CreateSpriteKey(const AssetHandle& material);
+		static uint64_t CreateMeshKey(const AssetHandle& material, const AssetHandle& mesh, bool isOverride, float depth);
+
+		static TransformData ToTransformData(const glm::mat4& transform);
+
+		void SubmitBillboard(const Ref<MaterialAsset>& material, const Ref<SubTexture>& subTexture, const glm::vec4& color, const glm::vec3& position, const glm::vec2& size);
+		void SubmitSprite(const Ref<MaterialAsset>& material, const Ref<SubTexture>& subTexture, const glm::vec4& color, const glm::mat4& transform);
+
+		void SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const Ref<MaterialInstance>& overrideMaterial = nullptr);
+		void SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const void* instanceData, uint32_t instanceCount, uint32_t instanceSize, const Ref<MaterialInstance>& overrideMaterial);
+		void SubmitMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& boneTransforms, const Ref<MaterialInstance>& overrideMaterial = nullptr);
+		// Palette is already final skinning matrix per bone and is copied as it is
+		void SubmitSkinnedMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& skinningPalette, const Ref<MaterialInstance>& overrideMaterial = nullptr);
+
+		// Moves submissions of other queue to this queue, used to join queues filled by worker threads
+		void Merge(GeometryRenderQueue& other);
+
+		// Sorts submissions and builds draw commands
+		void BuildDrawCommands();
+
+		glm::mat4 ViewMatrix = glm::mat4(1.0f); // Used for depth part of mesh keys
+
+		SubmissionList<SpriteSubmission>	   SpriteSubmissions;
+		SubmissionList<BillboardSubmission>	   BillboardSubmissions;
+		SubmissionList<MeshSubmission>		   MeshSubmissions;
+		SubmissionList<AnimatedMeshSubmission> AnimatedMeshSubmissions;
+		SubmissionList<InstanceMeshSubmission> InstanceMeshSubmissions;
+
+		std::vector<BoneTransforms> BoneData;
+		std::vector<std::byte>		InstanceData;
+
+		std::vector<SpriteDrawCommand>			SpriteDrawCommands;
+		std::vector<SpriteDrawCommand>			BillboardDrawCommands;
+		std::vector<MeshDrawCommand>			MeshDrawCommands;
+		std::vector<AnimatedMeshDrawCommand>	AnimatedMeshDrawCommands;
+		std::vector<InstanceMeshDrawCommand>	InstanceMeshDrawCommands;
 
-		std::map<BatchMeshKey, MeshDrawCommand>			MeshDrawCommands;
-		std::map<BatchMeshKey, AnimatedMeshDrawCommand>	AnimatedMeshDrawCommands;
-		std::map<BatchMeshKey, InstanceMeshDrawCommand>	InstanceMeshDrawCommands;
 		std::map<AssetHandle,  IndirectMeshDrawCommand>	IndirectDrawCommands;
 		std::map<AssetHandle,  ComputeCommandBatch>	    ComputeCommands;
 
 		void Clear()
 		{
+			SpriteSubmissions.Clear();
+			BillboardSubmissions.Clear();
+			MeshSubmissions.Clear();
+			AnimatedMeshSubmissions.Clear();
+			InstanceMeshSubmissions.Clear();
+			BoneData.clear();
+			InstanceData.clear();
+
 			SpriteDrawCommands.clear();
 			BillboardDrawCommands.clear();
 			MeshDrawCommands.clear();
@@ -205,5 +285,8 @@ namespace XYZ {
 			IndirectDrawCommands.clear();
 			ComputeCommands.clear();
 		}
+
+	private:
+		std::vector<SortKey> m_SortBuffer;
 	};
 }
\ No newline at end of file
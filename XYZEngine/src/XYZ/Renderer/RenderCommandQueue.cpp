@@ -1,56 +1,198 @@
 #include "stdafx.h"
 #include "RenderCommandQueue.h"
 
-#include <assert.h>
+#include "XYZ/Debug/Profiler.h"
 
 namespace XYZ {
-	RenderCommandQueue::RenderCommandQueue(uint32_t size)
+
+	static constexpr uint32_t sc_CommandAlignment = 16;
+
+	static uint32_t AlignCommandSize(uint32_t size)
+	{
+		return (size + sc_CommandAlignment - 1) & ~(sc_CommandAlignment - 1);
+	}
+
+	struct ThreadSegmentEntry
+	{
+		uint32_t QueueID;
+		void*	 Segment;
+	};
+	// Queue IDs are never reused, entries of destroyed queues are never matched
+	static thread_local std::vector<ThreadSegmentEntry> s_ThreadSegments;
+	static std::atomic<uint32_t> s_NextQueueID = 0;
+
+
+	RenderCommandQueue::RenderCommandQueue(uint32_t blockSize)
 		:
-		m_Size(size)
+		m_ID(s_NextQueueID.fetch_add(1, std::memory_order_relaxed)),
+		m_BlockSize(blockSize)
 	{
-		m_CommandBuffer = new uint8_t[size];
-		m_CommandBufferPtr = m_CommandBuffer;
-		memset(m_CommandBuffer, 0, size);
+		static_assert(sizeof(CommandHeader) % sc_CommandAlignment == 0, "Command header breaks alignment");
 	}
 
 	RenderCommandQueue::~RenderCommandQueue()
 	{
-		delete[] m_CommandBuffer;
+		for (auto& segment : m_Segments)
+		{
+			for (auto& block : segment->Blocks)
+				::operator delete[](block->Data, std::align_val_t{ sc_CommandAlignment });
+		}
 	}
 
 	void* RenderCommandQueue::Allocate(RenderCommandFn fn, uint32_t size)
 	{
-		XYZ_ASSERT(m_CommandBufferPtr - m_CommandBuffer < m_Size - size, "Command queue out of range");
-		*(RenderCommandFn*)m_CommandBufferPtr = fn;
-		m_CommandBufferPtr += sizeof(RenderCommandFn);
+		Segment& segment = getThreadSegment();
+		uint8_t* memory = allocateInSegment(segment, sizeof(CommandHeader) + AlignCommandSize(size));
+
+		// Sequence keeps submission order between threads
+		const uint32_t sequence = m_Sequence.fetch_add(1, std::memory_order_relaxed);
+		new (memory) CommandHeader{ fn, size, sequence };
+		return memory + sizeof(CommandHeader);
+	}
+
+	void RenderCommandQueue::Commit()
+	{
+		Segment& segment = getThreadSegment();
+		// Only recording thread writes the counter, release makes command visible to Execute
+		segment.Committed.store(segment.Committed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		m_CommandCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void RenderCommandQueue::Execute()
+	{
+		XYZ_PROFILE_FUNC("RenderCommandQueue::Execute");
+		uint32_t commandCount = 0;
+		{
+			std::scoped_lock lock(m_SegmentsMutex);
+			m_Cursors.clear();
+			for (auto& segment : m_Segments)
+			{
+				const uint32_t committed = segment->Committed.load(std::memory_order_acquire);
+				if (committed == segment->Executed)
+					continue;
+				m_Cursors.push_back({ segment.get(), committed - segment->Executed });
+				commandCount += committed - segment->Executed;
+			}
+		}
+
+		if (m_Cursors.size() == 1)
+		{
+			SegmentCursor& cursor = m_Cursors[0];
+			while (cursor.Remaining != 0)
+				executeNext(cursor);
+		}
+		else
+		{
+			// Segments are sorted by sequence, take the lowest head each time
+			while (!m_Cursors.empty())
+			{
+				size_t next = 0;
+				for (size_t i = 1; i < m_Cursors.size(); ++i)
+				{
+					// Sequence wraps around, compare distance
+					if (static_cast<int32_t>(peek(m_Cursors[i])->Sequence - peek(m_Cursors[next])->Sequence) < 0)
+						next = i;
+				}
+				executeNext(m_Cursors[next]);
+				if (m_Cursors[next].Remaining == 0)
+				{
+					m_Cursors[next] = m_Cursors.back();
+					m_Cursors.pop_back();
+				}
+			}
+		}
+		m_CommandCount.fetch_sub(commandCount, std::memory_order_relaxed);
+	}
+
+	RenderCommandQueue::Segment& RenderCommandQueue::getThreadSegment()
+	{
+		for (const auto& entry : s_ThreadSegments)
+		{
+			if (entry.QueueID == m_ID)
+				return *static_cast<Segment*>(entry.Segment);
+		}
+		return createThreadSegment();
+	}
 
-		*(uint32_t*)m_CommandBufferPtr = size;
-		m_CommandBufferPtr += sizeof(uint32_t);
+	RenderCommandQueue::Segment& RenderCommandQueue::createThreadSegment()
+	{
+		auto segment = std::make_unique<Segment>();
+		segment->WriteBlock = acquireBlock(*segment, m_BlockSize);
+		segment->ReadBlock = segment->WriteBlock;
 
-		void* memory = m_CommandBufferPtr;
-		m_CommandBufferPtr += size;
+		std::scoped_lock lock(m_SegmentsMutex);
+		s_ThreadSegments.push_back({ m_ID, segment.get() });
+		return *m_Segments.emplace_back(std::move(segment));
+	}
 
-		m_CommandCount++;
+	uint8_t* RenderCommandQueue::allocateInSegment(Segment& segment, uint32_t size)
+	{
+		Block* block = segment.WriteBlock;
+		if (block->Size - segment.WriteOffset < size)
+		{
+			if (block->Size - segment.WriteOffset >= sizeof(CommandHeader))
+				new (block->Data + segment.WriteOffset) CommandHeader{ nullptr, 0, 0 };
+
+			block->Next = acquireBlock(segment, size);
+			block = block->Next;
+			segment.WriteBlock = block;
+			segment.WriteOffset = 0;
+		}
+		uint8_t* memory = block->Data + segment.WriteOffset;
+		segment.WriteOffset += size;
 		return memory;
 	}
 
+	RenderCommandQueue::Block* RenderCommandQueue::acquireBlock(Segment& segment, uint32_t size)
+	{
+		std::scoped_lock lock(segment.BlocksMutex);
+		for (size_t i = 0; i < segment.FreeBlocks.size(); ++i)
+		{
+			Block* block = segment.FreeBlocks[i];
+			if (block->Size >= size)
+			{
+				segment.FreeBlocks[i] = segment.FreeBlocks.back();
+				segment.FreeBlocks.pop_back();
+				block->Next = nullptr;
+				return block;
+			}
+		}
 
-	void RenderCommandQueue::Execute()
+		const uint32_t blockSize = std::max(m_BlockSize, size);
+		uint8_t* data = static_cast<uint8_t*>(::operator new[](blockSize, std::align_val_t{ sc_CommandAlignment }));
+		return segment.Blocks.emplace_back(std::make_unique<Block>(Block{ data, blockSize, nullptr })).get();
+	}
+
+	RenderCommandQueue::CommandHeader* RenderCommandQueue::peek(SegmentCursor& cursor)
 	{
-		//std::scoped_lock<std::mutex> lock(m_Mutex);
-		uint8_t* buffer = m_CommandBuffer;
-		for (uint32_t i = 0; i < m_CommandCount; i++)
+		// Called only with committed command ahead, so block end marker and next block are visible
+		Segment& segment = *cursor.Source;
+		while (true)
 		{
-			const RenderCommandFn function = *(RenderCommandFn*)buffer;
-			buffer += sizeof(RenderCommandFn);
+			Block* block = segment.ReadBlock;
+			if (block->Size - segment.ReadOffset >= sizeof(CommandHeader))
+			{
+				CommandHeader* header = reinterpret_cast<CommandHeader*>(block->Data + segment.ReadOffset);
+				if (header->Function)
+					return header;
+			}
+			segment.ReadBlock = block->Next;
+			segment.ReadOffset = 0;
 
-			const uint32_t size = *(uint32_t*)buffer;
-			buffer += sizeof(uint32_t);
-			function(buffer);
-			buffer += size;
+			std::scoped_lock lock(segment.BlocksMutex);
+			segment.FreeBlocks.push_back(block);
 		}
+	}
+
+	void RenderCommandQueue::executeNext(SegmentCursor& cursor)
+	{
+		CommandHeader* header = peek(cursor);
+		const uint32_t size = header->Size;
+		header->Function(header + 1);
 
-		m_CommandBufferPtr = m_CommandBuffer;
-		m_CommandCount = 0;
+		Segment& segment = *cursor.Source;
+		segment.ReadOffset += sizeof(CommandHeader) + AlignCommandSize(size);
+		segment.Executed++;
+		cursor.Remaining--;
 	}
-}
\ No newline at end of file
+}
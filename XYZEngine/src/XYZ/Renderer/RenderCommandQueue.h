@@ -1,28 +1,94 @@
 #pragma once
 #include <tuple>
 #include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
 
 #include "XYZ/Core/Core.h"
 
 namespace XYZ {
 
+	// Every thread records commands into its own segment without locking,
+	// segments are stitched together in submission order on Execute.
+	// Command is executed only after it is committed, commands committed while
+	// Execute runs are left for the next Execute. Execute runs on one thread at a time
 	class XYZ_API RenderCommandQueue
 	{
 	public:
 		typedef void(*RenderCommandFn)(void*);
 
-		RenderCommandQueue(uint32_t size = 10 * 1024 * 1024);
+		RenderCommandQueue(uint32_t blockSize = 1024 * 1024);
 		~RenderCommandQueue();
 
+		RenderCommandQueue(const RenderCommandQueue&) = delete;
+		RenderCommandQueue& operator=(const RenderCommandQueue&) = delete;
+
 		void* Allocate(RenderCommandFn func, uint32_t size);
+		// Publishes command returned by the last Allocate of calling thread
+		void  Commit();
 
 		void Execute();
 
-		uint32_t GetCommandCount() const { return m_CommandCount; }
+		// Committed commands waiting for execution
+		uint32_t GetCommandCount() const { return m_CommandCount.load(std::memory_order_relaxed); }
+	private:
+		// Header without function marks the end of used part of block
+		struct CommandHeader
+		{
+			RenderCommandFn Function;
+			uint32_t		Size;
+			uint32_t		Sequence;
+		};
+
+		struct Block
+		{
+			uint8_t* Data;
+			uint32_t Size;
+			Block*	 Next; // Written before first command in next block is committed
+		};
+
+		struct Segment
+		{
+			// Owned by recording thread
+			Block*	 WriteBlock = nullptr;
+			uint32_t WriteOffset = 0;
+
+			// Owned by executing thread
+			Block*	 ReadBlock = nullptr;
+			uint32_t ReadOffset = 0;
+			uint32_t Executed = 0;
+
+			std::atomic<uint32_t> Committed = 0;
+
+			// Executed blocks are returned to recording thread
+			std::mutex							BlocksMutex;
+			std::vector<Block*>					FreeBlocks;
+			std::vector<std::unique_ptr<Block>> Blocks;
+		};
+
+		struct SegmentCursor
+		{
+			Segment* Source;
+			uint32_t Remaining;
+		};
+
+		Segment& getThreadSegment();
+		Segment& createThreadSegment();
+		uint8_t* allocateInSegment(Segment& segment, uint32_t size);
+		Block*	 acquireBlock(Segment& segment, uint32_t size);
+
+		static CommandHeader* peek(SegmentCursor& cursor);
+		static void executeNext(SegmentCursor& cursor);
+
 	private:
-		uint8_t* m_CommandBuffer;
-		uint8_t* m_CommandBufferPtr;
-		uint32_t m_CommandCount = 0;
-		uint32_t m_Size;
+		const uint32_t		  m_ID;
+		const uint32_t		  m_BlockSize;
+		std::atomic<uint32_t> m_Sequence = 0;
+		std::atomic<uint32_t> m_CommandCount = 0;
+
+		std::mutex						      m_SegmentsMutex;
+		std::vector<std::unique_ptr<Segment>> m_Segments;
+		std::vector<SegmentCursor>		      m_Cursors;
 	};
-}
\ No newline at end of file
+}
@@ -238,7 +238,7 @@ namespace XYZ {
 
 	void GeometryPass::submitStaticMeshes(GeometryRenderQueue& queue, const Ref<RenderCommandBuffer>& commandBuffer)
 	{
-		for (auto& [key, command] : queue.MeshDrawCommands)
+		for (auto& command : queue.MeshDrawCommands)
 		{
 			Renderer::BindPipeline(
 				commandBuffer,
@@ -261,8 +261,10 @@ namespace XYZ {
 					command.TransformInstanceCount
 				);
 			}
-			for (auto& dcOverride : command.OverrideCommands)
+			const uint32_t overrideEnd = command.First + command.Count + command.OverrideCount;
+			for (uint32_t i = command.First + command.Count; i < overrideEnd; ++i)
 			{
+				const auto& dcOverride = queue.MeshSubmissions[i];
 				Renderer::RenderMesh(
 					commandBuffer,
 					command.Pipeline,
@@ -276,7 +278,7 @@ namespace XYZ {
 	}
 	void GeometryPass::submitAnimatedMeshes(GeometryRenderQueue& queue, const Ref<RenderCommandBuffer>& commandBuffer)
 	{
-		for (auto& [key, command] : queue.AnimatedMeshDrawCommands)
+		for (auto& command : queue.AnimatedMeshDrawCommands)
 		{
 			Renderer::BindPipeline(
 				commandBuffer,
@@ -299,8 +301,10 @@ namespace XYZ {
 					command.TransformInstanceCount
 				);
 			}
-			for (auto& dcOverride : command.OverrideCommands)
+			const uint32_t overrideEnd = command.First + command.Count + command.OverrideCount;
+			for (uint32_t i = command.First + command.Count; i < overrideEnd; ++i)
 			{
+				const auto& dcOverride = queue.AnimatedMeshSubmissions[i];
 				Renderer::RenderMesh(
 					commandBuffer,
 					command.Pipeline,
@@ -317,7 +321,7 @@ namespace XYZ {
 	}
 	void GeometryPass::submitInstancedMeshes(GeometryRenderQueue& queue, const Ref<RenderCommandBuffer>& commandBuffer)
 	{
-		for (auto& [key, command] : queue.InstanceMeshDrawCommands)
+		for (auto& command : queue.InstanceMeshDrawCommands)
 		{
 			Renderer::BindPipeline(
 				commandBuffer,
@@ -346,23 +350,29 @@ namespace XYZ {
 
 		m_Renderer2D->BeginScene(viewMatrix);
 
-		for (auto& [key, command] : queue.SpriteDrawCommands)
+		for (auto& command : queue.SpriteDrawCommands)
 		{
 			Ref<Pipeline> pipeline = m_PipelineCache.PreparePipeline(command.MaterialAsset, m_SceneRenderer->m_GeometryRenderPass);
-			for (const auto& data : command.SpriteData)
+			for (uint32_t i = command.First; i < command.First + command.Count; ++i)
+			{
+				const auto& data = queue.SpriteSubmissions[i].Data;
 				m_Renderer2D->SubmitQuad(data.Transform, data.TexCoords, data.TextureIndex, data.Color);
+			}
 
-			Renderer::BindPipeline(commandBuffer, pipeline, m_SceneRenderer->m_UniformBufferSet, nullptr, command.MaterialAsset->GetMaterial());
+			Renderer::BindPipeline(commandBuffer, pipeline, m_SceneRenderer->m_UniformBufferSet, nullptr, command.Material);
 			m_Renderer2D->FlushQuads(pipeline, command.MaterialInstance, true);
 		}
 
-		for (auto& [key, command] : queue.BillboardDrawCommands)
+		for (auto& command : queue.BillboardDrawCommands)
 		{
 			Ref<Pipeline> pipeline = m_PipelineCache.PreparePipeline(command.MaterialAsset, m_SceneRenderer->m_GeometryRenderPass);
-			for (const auto& data : command.BillboardData)
+			for (uint32_t i = command.First; i < command.First + command.Count; ++i)
+			{
+				const auto& data = queue.BillboardSubmissions[i].Data;
 				m_Renderer2D->SubmitQuadBillboard(data.Position, data.Size, data.TexCoords, data.TextureIndex, data.Color);
+			}
 
-			Renderer::BindPipeline(commandBuffer, pipeline, m_SceneRenderer->m_UniformBufferSet, nullptr, command.MaterialAsset->GetMaterial());
+			Renderer::BindPipeline(commandBuffer, pipeline, m_SceneRenderer->m_UniformBufferSet, nullptr, command.Material);
 			m_Renderer2D->FlushQuads(pipeline, command.MaterialInstance, true);
 		}
 		m_Renderer2D->EndScene();
@@ -378,7 +388,7 @@ namespace XYZ {
 			m_DepthPipeline3DStatic.Material
 		);
 
-		for (auto& [key, command] : queue.MeshDrawCommands)
+		for (auto& command : queue.MeshDrawCommands)
 		{
 			Renderer::RenderMesh(
 				commandBuffer,
@@ -391,8 +401,10 @@ namespace XYZ {
 				command.TransformOffset,
 				command.TransformInstanceCount
 			);
-			for (auto& dcOverride : command.OverrideCommands)
+			const uint32_t overrideEnd = command.First + command.Count + command.OverrideCount;
+			for (uint32_t i = command.First + command.Count; i < overrideEnd; ++i)
 			{
+				const auto& dcOverride = queue.MeshSubmissions[i];
 				Renderer::RenderMesh(
 					commandBuffer,
 					m_DepthPipeline3DStatic.Pipeline,
@@ -413,7 +425,7 @@ namespace XYZ {
 			m_SceneRenderer->m_StorageBufferSet,
 			m_DepthPipeline3DAnimated.Material
 		);
-		for (auto& [key, command] : queue.AnimatedMeshDrawCommands)
+		for (auto& command : queue.AnimatedMeshDrawCommands)
 		{		
 			Renderer::RenderMesh(
 				commandBuffer,
@@ -426,8 +438,10 @@ namespace XYZ {
 				command.TransformOffset,
 				command.TransformInstanceCount
 			);
-			for (auto& dcOverride : command.OverrideCommands)
+			const uint32_t overrideEnd = command.First + command.Count + command.OverrideCount;
+			for (uint32_t i = command.First + command.Count; i < overrideEnd; ++i)
 			{
+				const auto& dcOverride = queue.AnimatedMeshSubmissions[i];
 				Renderer::RenderMesh(
 					commandBuffer,
 					m_DepthPipeline3DAnimated.Pipeline,
@@ -451,7 +465,7 @@ namespace XYZ {
 			nullptr,
 			m_DepthPipelineInstanced.Material
 		);
-		for (auto& [key, command] : queue.InstanceMeshDrawCommands)
+		for (auto& command : queue.InstanceMeshDrawCommands)
 		{
 			Renderer::RenderMesh(
 				commandBuffer,
@@ -480,17 +494,23 @@ namespace XYZ {
 			nullptr, 
 			m_DepthPipeline2D.Material
 		);
-		for (auto& [key, command] : queue.SpriteDrawCommands)
+		for (auto& command : queue.SpriteDrawCommands)
 		{
-			for (const auto& data : command.SpriteData)
+			for (uint32_t i = command.First; i < command.First + command.Count; ++i)
+			{
+				const auto& data = queue.SpriteSubmissions[i].Data;
 				m_Renderer2D->SubmitQuad(data.Transform, data.TexCoords, data.TextureIndex, data.Color);
+			}
 
 			m_Renderer2D->FlushQuads(m_DepthPipeline2D.Pipeline, command.MaterialInstance, false);
 		}
-		for (auto& [key, command] : queue.BillboardDrawCommands)
+		for (auto& command : queue.BillboardDrawCommands)
 		{	
-			for (const auto& data : command.BillboardData)
+			for (uint32_t i = command.First; i < command.First + command.Count; ++i)
+			{
+				const auto& data = queue.BillboardSubmissions[i].Data;
 				m_Renderer2D->SubmitQuadBillboard(data.Position, data.Size, data.TexCoords, data.TextureIndex, data.Color);
+			}
 
 			m_Renderer2D->FlushQuads(m_DepthPipeline2D.Pipeline, command.MaterialInstance, false);
 		}
@@ -499,14 +519,14 @@ namespace XYZ {
 
 	void GeometryPass::prepareStaticDrawCommands(GeometryRenderQueue& queue, size_t& overrideCount, uint32_t& transformsCount)
 	{	
-		for (auto& [key, dc] : queue.MeshDrawCommands)
+		for (auto& dc : queue.MeshDrawCommands)
 		{
 			dc.Pipeline = m_PipelineCache.PreparePipeline(dc.MaterialAsset, m_SceneRenderer->m_GeometryRenderPass);
 			dc.TransformOffset = transformsCount * sizeof(GeometryRenderQueue::TransformData);
-			overrideCount += dc.OverrideCommands.size();
-			for (const auto& transform : dc.TransformData)
+			overrideCount += dc.OverrideCount;
+			for (uint32_t i = dc.First; i < dc.First + dc.Count; ++i)
 			{
-				m_SceneRenderer->m_TransformData[transformsCount] = transform;
+				m_SceneRenderer->m_TransformData[transformsCount] = GeometryRenderQueue::ToTransformData(queue.MeshSubmissions[i].Transform);
 				transformsCount++;
 			}
 		}
@@ -547,26 +567,28 @@ namespace XYZ {
 
 	void GeometryPass::prepareAnimatedDrawCommands(GeometryRenderQueue& queue, size_t& overrideCount, uint32_t& transformsCount, uint32_t& boneTransformCount)
 	{
-		for (auto& [key, dc] : queue.AnimatedMeshDrawCommands)
+		for (auto& dc : queue.AnimatedMeshDrawCommands)
 		{
 			dc.Pipeline = m_PipelineCache.PreparePipeline(dc.MaterialAsset, m_SceneRenderer->m_GeometryRenderPass);
 			dc.TransformOffset = transformsCount * sizeof(SceneRenderer::TransformData);
 			dc.BoneTransformsIndex = boneTransformCount;
-			overrideCount += dc.OverrideCommands.size();
-			for (const auto& transform : dc.TransformData)
+			overrideCount += dc.OverrideCount;
+			for (uint32_t i = dc.First; i < dc.First + dc.Count; ++i)
 			{
-				m_SceneRenderer->m_TransformData[transformsCount] = transform;
+				const auto& submission = queue.AnimatedMeshSubmissions[i];
+				m_SceneRenderer->m_TransformData[transformsCount] = GeometryRenderQueue::ToTransformData(submission.Transform);
 				transformsCount++;
-			}
-			for (const auto& bones : dc.BoneData)
-			{
+
+				const auto& bones = queue.BoneData[submission.BoneDataIndex];
 				const size_t offset = boneTransformCount * bones.size();
 				memcpy(&m_SceneRenderer->m_BoneTransformSSBO.Data[offset], bones.data(), sizeof(GeometryRenderQueue::BoneTransforms));
 				boneTransformCount++;
 			}
-			for (auto& overrideDc : dc.OverrideCommands)
+			const uint32_t overrideEnd = dc.First + dc.Count + dc.OverrideCount;
+			for (uint32_t i = dc.First + dc.Count; i < overrideEnd; ++i)
 			{
-				const auto& bones = overrideDc.BoneTransforms;
+				auto& overrideDc = queue.AnimatedMeshSubmissions[i];
+				const auto& bones = queue.BoneData[overrideDc.BoneDataIndex];
 				const size_t offset = boneTransformCount * bones.size();
 				memcpy(&m_SceneRenderer->m_BoneTransformSSBO.Data[offset], bones.data(), sizeof(GeometryRenderQueue::BoneTransforms));
 				overrideDc.BoneTransformsIndex = boneTransformCount;
@@ -603,31 +625,65 @@ namespace XYZ {
 
 	void GeometryPass::prepareInstancedDrawCommands(GeometryRenderQueue& queue, uint32_t& instanceOffset)
 	{
-		for (auto& [key, dc] : queue.InstanceMeshDrawCommands)
+		for (auto& dc : queue.InstanceMeshDrawCommands)
 		{
 			dc.Pipeline = m_PipelineCache.PreparePipeline(dc.MaterialAsset, m_SceneRenderer->m_GeometryRenderPass);
 			dc.InstanceOffset = instanceOffset;
-			memcpy(&m_SceneRenderer->m_InstanceData.data()[instanceOffset], dc.InstanceData.data(), dc.InstanceData.size());
-			instanceOffset += dc.InstanceData.size();
+			for (uint32_t i = dc.First; i < dc.First + dc.Count; ++i)
+			{
+				const auto& submission = queue.InstanceMeshSubmissions[i];
+				memcpy(&m_SceneRenderer->m_InstanceData.data()[instanceOffset], &queue.InstanceData[submission.InstanceDataOffset], submission.InstanceDataSize);
+				instanceOffset += submission.InstanceDataSize;
+			}
 		}
 	}
 
 	void GeometryPass::prepare2DDrawCommands(GeometryRenderQueue& queue)
 	{
-		for (auto& [key, command] : queue.SpriteDrawCommands)
+		// Sprites and billboards of one material asset share batch numbering, so no two batches share material
+		std::unordered_map<AssetHandle, uint32_t> batchCounts;
+		for (auto& command : queue.SpriteDrawCommands)
+			prepareSpriteDrawCommand(command, batchCounts);
+		for (auto& command : queue.BillboardDrawCommands)
+			prepareSpriteDrawCommand(command, batchCounts);
+	}
+
+	void GeometryPass::prepareSpriteDrawCommand(GeometryRenderQueue::SpriteDrawCommand& command, std::unordered_map<AssetHandle, uint32_t>& batchCounts)
+	{
+		const uint32_t batchIndex = batchCounts[command.MaterialAsset->GetHandle()]++;
+		command.Material = getSpriteBatchMaterial(command.MaterialAsset, batchIndex);
+		for (uint32_t i = 0; i < command.TextureCount; ++i)
+			command.Material->SetImageArray("u_Texture", command.Textures[i]->GetImage(), i);
+		for (uint32_t i = command.TextureCount; i < Renderer2D::GetMaxTextures(); ++i)
+			command.Material->SetImageArray("u_Texture", m_WhiteTexture->GetImage(), i);
+	}
+
+	Ref<Material> GeometryPass::getSpriteBatchMaterial(const Ref<MaterialAsset>& materialAsset, uint32_t batchIndex)
+	{
+		if (batchIndex == 0)
+			return materialAsset->GetMaterial();
+
+		SpriteBatchMaterials& batchMaterials = m_SpriteBatchMaterials[materialAsset->GetHandle()];
+		if (batchMaterials.Shader.Raw() != materialAsset->GetShader().Raw())
 		{
-			for (uint32_t i = 0; i < command.TextureCount; ++i)
-				command.MaterialAsset->GetMaterial()->SetImageArray("u_Texture", command.Textures[i]->GetImage(), i);
-			for (uint32_t i = command.TextureCount; i < Renderer2D::GetMaxTextures(); ++i)
-				command.MaterialAsset->GetMaterial()->SetImageArray("u_Texture", m_WhiteTexture->GetImage(), i);
+			batchMaterials.Shader = materialAsset->GetShader();
+			batchMaterials.Materials.clear();
 		}
-		for (auto& [key, command] : queue.BillboardDrawCommands)
+		while (batchMaterials.Materials.size() < batchIndex)
+			batchMaterials.Materials.push_back(Material::Create(batchMaterials.Shader));
+
+		// Other textures of material asset can change at any time
+		Ref<Material> material = batchMaterials.Materials[batchIndex - 1];
+		for (const auto& texture : materialAsset->GetTextures())
+			material->SetImage(texture.Name, texture.Texture->GetImage());
+		for (const auto& textureArray : materialAsset->GetTextureArrays())
 		{
-			for (uint32_t i = 0; i < command.TextureCount; ++i)
-				command.MaterialAsset->GetMaterial()->SetImageArray("u_Texture", command.Textures[i]->GetImage(), i);
-			for (uint32_t i = command.TextureCount; i < Renderer2D::GetMaxTextures(); ++i)
-				command.MaterialAsset->GetMaterial()->SetImageArray("u_Texture", m_WhiteTexture->GetImage(), i);
+			if (textureArray.Name == "u_Texture")
+				continue;
+			for (uint32_t i = 0; i < textureArray.Textures.size(); ++i)
+				material->SetImageArray(textureArray.Name, textureArray.Textures[i]->GetImage(), i);
 		}
+		return material;
 	}
 
 	void GeometryPass::createDepthResources()
@@ -69,6 +69,9 @@ namespace XYZ {
 		void prepareAnimatedDrawCommands(GeometryRenderQueue& queue, size_t& overrideCount, uint32_t& transformsCount, uint32_t& boneTransformCount);
 		void prepareInstancedDrawCommands(GeometryRenderQueue& queue, uint32_t& instanceOffset);
 		void prepare2DDrawCommands(GeometryRenderQueue& queue);
+		void prepareSpriteDrawCommand(GeometryRenderQueue::SpriteDrawCommand& command, std::unordered_map<AssetHandle, uint32_t>& batchCounts);
+
+		Ref<Material> getSpriteBatchMaterial(const Ref<MaterialAsset>& materialAsset, uint32_t batchIndex);
 
 		void createDepthResources();
 		
@@ -95,6 +98,15 @@ namespace XYZ {
 		DepthPipeline m_DepthPipeline2D;
 		DepthPipeline m_DepthPipelineInstanced;
 
+		// Batches of one material asset are bound with different textures,
+		// first batch uses material of asset and others use these
+		struct SpriteBatchMaterials
+		{
+			Ref<Shader>				   Shader;
+			std::vector<Ref<Material>> Materials;
+		};
+		std::unordered_map<AssetHandle, SpriteBatchMaterials> m_SpriteBatchMaterials;
+
 
 		
 
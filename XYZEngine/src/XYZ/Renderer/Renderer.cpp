@@ -157,7 +157,7 @@ namespace XYZ {
 	
 		s_Data.APIContext = APIContext::Create();
 		s_RendererAPI = CreateRendererAPI();	
-		s_Data.QueueData.Init(s_Data.Configuration.FramesInFlight);	
+		s_Data.QueueData.Init(s_Data.Configuration.FramesInFlight, s_Data.Configuration.FramesAhead);
 	}
 
 	void Renderer::InitAPI(bool initDefaultResources)
@@ -316,6 +316,11 @@ namespace XYZ {
 		s_Data.QueueData.BlockRenderThread();
 	}
 
+	void Renderer::WaitForRenderQueue()
+	{
+		s_Data.QueueData.WaitForRenderQueue();
+	}
+
 	void Renderer::WaitAndRenderAll()
 	{
 		BlockRenderThread();
@@ -346,9 +351,25 @@ namespace XYZ {
 		return s_Data.APIContext->GetCurrentFrame();
 	}
 
+	void Renderer::SetFramesAhead(uint32_t framesAhead)
+	{
+		s_Data.QueueData.SetFramesAhead(framesAhead);
+	}
+
+	uint32_t Renderer::GetFramesAhead()
+	{
+		return s_Data.QueueData.GetFramesAhead();
+	}
+
+	RenderQueueStatistics Renderer::GetRenderQueueStatistics()
+	{
+		return s_Data.QueueData.GetStatistics();
+	}
+
 	void Renderer::Render()
 	{
 		s_Data.Stats.Reset();
+		s_Data.Stats.CommandsCount = s_Data.QueueData.GetRenderCommandQueue().GetCommandCount();
 		s_Data.QueueData.ExecuteRenderQueue();
 	}
 	void Renderer::ExecuteResources()
@@ -381,7 +402,7 @@ namespace XYZ {
 		return s_Data.QueueData.GetResourceQueue(s_Data.APIContext->GetCurrentFrame());
 	}
 
-	ScopedLock<RenderCommandQueue> Renderer::getRenderCommandQueue()
+	RenderCommandQueue& Renderer::getRenderCommandQueue()
 	{
 		return s_Data.QueueData.GetRenderCommandQueue();
 	}
@@ -11,6 +11,7 @@
 
 #include "RendererAPI.h"
 #include "RenderCommandQueue.h"
+#include "RendererQueueData.h"
 #include "RenderPass.h"
 #include "Pipeline.h"
 #include "PipelineCompute.h"
@@ -50,6 +51,7 @@ namespace XYZ {
 	struct RendererConfiguration
 	{
 		uint32_t FramesInFlight = 3;
+		uint32_t FramesAhead = 1; // Frames main thread can record ahead of render thread, 1 - 3
 	};
 
 
@@ -135,6 +137,7 @@ namespace XYZ {
 
 
 		static void BlockRenderThread();
+		static void WaitForRenderQueue();
 		static void WaitAndRenderAll();
 		static void WaitAndRender();
 
@@ -147,9 +150,13 @@ namespace XYZ {
 		static const RendererStats& GetStats();
 		static uint32_t			    GetCurrentFrame();
 
+		static void					 SetFramesAhead(uint32_t framesAhead);
+		static uint32_t				 GetFramesAhead();
+		static RenderQueueStatistics GetRenderQueueStatistics();
+
 	private:
 		static ScopedLock<RenderCommandQueue> getResourceQueue();
-		static ScopedLock<RenderCommandQueue> getRenderCommandQueue();
+		static RenderCommandQueue&			  getRenderCommandQueue();
 		static RendererStats&	   getStats();
 	};
 
@@ -165,10 +172,11 @@ namespace XYZ {
 			(*pFunc)();
 			pFunc->~FuncT(); // Call destructor
 		};
-		ScopedLock<RenderCommandQueue> queue = getRenderCommandQueue();
-		auto storageBuffer = queue->Allocate(renderCmd, sizeof(func));
+		// Queue records into thread local segment, no lock is taken
+		RenderCommandQueue& queue = getRenderCommandQueue();
+		auto storageBuffer = queue.Allocate(renderCmd, sizeof(func));
 		new (storageBuffer) FuncT(std::forward<FuncT>(func));
-		getStats().CommandsCount++;
+		queue.Commit();
 	}
 
 	template<typename FuncT>
@@ -184,6 +192,7 @@ namespace XYZ {
 		ScopedLock<RenderCommandQueue> resourceQueue = getResourceQueue();
 		auto storageBuffer = resourceQueue->Allocate(renderCmd, sizeof(func));
 		new (storageBuffer) FuncT(std::forward<FuncT>(func));
+		resourceQueue->Commit();
 	}
 
 	template <typename FuncT>
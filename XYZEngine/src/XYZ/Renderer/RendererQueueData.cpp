@@ -10,9 +10,11 @@
 
 
 namespace XYZ {
-	void RendererQueueData::Init(uint32_t framesInFlight)
+	void RendererQueueData::Init(uint32_t framesInFlight, uint32_t framesAhead)
 	{
 		m_FramesInFlight = framesInFlight;
+		m_FramesAhead = std::clamp(framesAhead, 1u, sc_MaxFramesAhead);
+		m_RequestedFramesAhead = m_FramesAhead;
 		m_Pool.Start(1);
 		m_ResourceQueues = new ResourceCommandQueue[framesInFlight];
 	}
@@ -23,8 +25,6 @@ namespace XYZ {
 		{
 			ExecuteRenderQueue();
 			BlockRenderThread();
-			ExecuteRenderQueue();
-			BlockRenderThread();
 		};
 		m_Pool.Stop();
 		for (uint32_t i = 0; i < m_FramesInFlight; ++i)
@@ -35,18 +35,24 @@ namespace XYZ {
 
 	void RendererQueueData::ExecuteRenderQueue()
 	{
-		RenderCommandQueue* queue = &m_RenderCommandQueue[m_RenderWriteIndex];
+		const uint32_t writeIndex = m_RenderWriteIndex.load(std::memory_order_relaxed);
+		RenderCommandQueue* queue = &m_RenderCommandQueue[writeIndex];
 		#ifdef RENDER_THREAD_ENABLED
 
-		m_RenderWriteIndex = m_RenderWriteIndex == 0 ? 1 : 0;
-		m_RenderThreadFinished = m_Pool.SubmitJob([this, queue]() -> bool{
-			XYZ_PROFILE_FUNC("RendererQueueData::ExecuteRenderQueue Job");
-			XYZ_SCOPE_PERF("RendererQueueData::ExecuteRenderQueue");
-
-			queue->Execute();
-			Fence::Create(UINT64_MAX);
-			return true;
+		std::promise<void> finished;
+		m_RenderQueueFinished[writeIndex] = finished.get_future();
+		m_Pool.PushJob([this, queue, finished = std::move(finished), submitTime = Clock::now()]() mutable {
+			executeRenderQueue(queue, finished, submitTime);
 		});
+
+		const bool framesAheadChanged = m_FramesAhead != m_RequestedFramesAhead;
+		m_FramesAhead = m_RequestedFramesAhead;
+		const uint32_t nextWriteIndex = (writeIndex + 1) % (m_FramesAhead + 1);
+		// Commands recorded into submitted queue after its execution started stay there for its next turn
+		m_RenderWriteIndex.store(nextWriteIndex, std::memory_order_release);
+		// Ring size changed, next queue was not waited for by WaitForRenderQueue
+		if (framesAheadChanged && m_RenderQueueFinished[nextWriteIndex].valid())
+			m_RenderQueueFinished[nextWriteIndex].wait();
 		#else
 			queue->Execute();
 		#endif //  RENDER_THREAD_ENABLED	
@@ -64,14 +70,37 @@ namespace XYZ {
 		XYZ_PROFILE_FUNC("RendererQueueData::BlockRenderThread");
 		XYZ_SCOPE_PERF("RendererQueueData::BlockRenderThread");
 
-		if (m_RenderThreadFinished.valid())
-			m_RenderThreadFinished.wait();
+		for (auto& finished : m_RenderQueueFinished)
+		{
+			if (finished.valid())
+				finished.wait();
+		}
 		#endif
 	}
 
-	ScopedLock<RenderCommandQueue> RendererQueueData::GetRenderCommandQueue()
+	void RendererQueueData::WaitForRenderQueue()
 	{
-		return ScopedLock<RenderCommandQueue>(&m_RenderCommandQueueMutex, m_RenderCommandQueue[m_RenderWriteIndex]);
+		#ifdef RENDER_THREAD_ENABLED
+		XYZ_PROFILE_FUNC("RendererQueueData::WaitForRenderQueue");
+		XYZ_SCOPE_PERF("RendererQueueData::WaitForRenderQueue");
+
+		// Queue written after next submission was submitted m_FramesAhead frames ago
+		Stopwatch stallTimer;
+		auto& finished = m_RenderQueueFinished[(m_RenderWriteIndex.load(std::memory_order_relaxed) + 1) % (m_FramesAhead + 1)];
+		if (finished.valid())
+			finished.wait();
+		m_StallTime = stallTimer.Elapsed();
+		#endif
+	}
+
+	void RendererQueueData::SetFramesAhead(uint32_t framesAhead)
+	{
+		m_RequestedFramesAhead = std::clamp(framesAhead, 1u, sc_MaxFramesAhead);
+	}
+
+	RenderCommandQueue& RendererQueueData::GetRenderCommandQueue()
+	{
+		return m_RenderCommandQueue[m_RenderWriteIndex.load(std::memory_order_acquire)];
 	}
 
 	ScopedLock<RenderCommandQueue> RendererQueueData::GetResourceQueue(uint32_t index)
@@ -81,6 +110,37 @@ namespace XYZ {
 
 	bool RendererQueueData::RenderCommandQueuesEmpty() const
 	{
-		return m_RenderCommandQueue[0].GetCommandCount() == 0 && m_RenderCommandQueue[1].GetCommandCount() == 0;
+		for (const auto& queue : m_RenderCommandQueue)
+		{
+			if (queue.GetCommandCount() != 0)
+				return false;
+		}
+		return true;
+	}
+
+	RenderQueueStatistics RendererQueueData::GetStatistics() const
+	{
+		RenderQueueStatistics statistics;
+		statistics.FrameLatency = m_FrameLatency.load(std::memory_order_relaxed);
+		statistics.StallTime = m_StallTime;
+		for (const auto& finished : m_RenderQueueFinished)
+		{
+			if (finished.valid() && finished.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				statistics.FramesInFlight++;
+		}
+		return statistics;
+	}
+
+	void RendererQueueData::executeRenderQueue(RenderCommandQueue* queue, std::promise<void>& finished, Clock::time_point submitTime)
+	{
+		XYZ_PROFILE_FUNC("RendererQueueData::ExecuteRenderQueue Job");
+		XYZ_SCOPE_PERF("RendererQueueData::ExecuteRenderQueue");
+
+		queue->Execute();
+		Fence::Create(UINT64_MAX);
+
+		const std::chrono::duration<float, std::milli> latency = Clock::now() - submitTime;
+		m_FrameLatency.store(latency.count(), std::memory_order_relaxed);
+		finished.set_value();
 	}
 }
\ No newline at end of file
@@ -6,31 +6,59 @@
 
 
 #include <shared_mutex>
+#include <chrono>
+#include <array>
+#include <future>
 
 namespace XYZ {
 
+	struct RenderQueueStatistics
+	{
+		float	 FrameLatency = 0.0f; // Milliseconds from queue submission to end of its execution
+		float	 StallTime = 0.0f;	  // Milliseconds main thread waited for render thread last frame
+		uint32_t FramesInFlight = 0;
+	};
 
 	class XYZ_API RendererQueueData
 	{
 	public:
-		void Init(uint32_t framesInFlight);
+		static constexpr uint32_t sc_MaxFramesAhead = 3;
+
+		void Init(uint32_t framesInFlight, uint32_t framesAhead);
 		void Shutdown();
 
 		void ExecuteRenderQueue();
 		void ExecuteResourceQueue(uint32_t index);
 
+		// Waits for all submitted render queues
 		void BlockRenderThread();
+		// Waits only until the queue recorded next frame is free
+		void WaitForRenderQueue();
 
+		// Number of frames main thread can record ahead of render thread, applied on next submission
+		void SetFramesAhead(uint32_t framesAhead);
+		uint32_t GetFramesAhead() const { return m_RequestedFramesAhead; }
 
-		ScopedLock<RenderCommandQueue> GetRenderCommandQueue();
+		RenderCommandQueue&			   GetRenderCommandQueue();
 		ScopedLock<RenderCommandQueue> GetResourceQueue(uint32_t index);
 
 		ThreadPool& GetThreadPool() { return m_Pool; }
 		bool RenderCommandQueuesEmpty() const;
+		RenderQueueStatistics GetStatistics() const;
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		void executeRenderQueue(RenderCommandQueue* queue, std::promise<void>& finished, Clock::time_point submitTime);
+
 	private:
 		uint32_t		   m_FramesInFlight = 0;
-		RenderCommandQueue m_RenderCommandQueue[2];
-		std::shared_mutex  m_RenderCommandQueueMutex;
+		uint32_t		   m_FramesAhead = 1;
+		uint32_t		   m_RequestedFramesAhead = 1;
+
+		// One queue is recorded while up to m_FramesAhead queues wait for execution,
+		// render thread pool has one worker and executes them in submission order
+		std::array<RenderCommandQueue, sc_MaxFramesAhead + 1> m_RenderCommandQueue;
+		std::array<std::future<void>, sc_MaxFramesAhead + 1>  m_RenderQueueFinished;
 
 		struct ResourceCommandQueue
 		{
@@ -40,10 +68,12 @@ namespace XYZ {
 
 		ResourceCommandQueue* m_ResourceQueues;
 
-		ThreadPool		   m_Pool;
-		uint32_t		   m_RenderWriteIndex = 0;
+		ThreadPool			  m_Pool;
+		// Read by worker threads submitting render commands
+		std::atomic<uint32_t> m_RenderWriteIndex = 0;
 
-		std::future<bool>  m_RenderThreadFinished;
+		std::atomic<float> m_FrameLatency = 0.0f;
+		float			   m_StallTime = 0.0f;
 	};
 
-}
\ No newline at end of file
+}
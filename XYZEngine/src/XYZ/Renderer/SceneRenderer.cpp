@@ -7,7 +7,9 @@
 
 
 #include "XYZ/Core/Input.h"
+#include "XYZ/Core/Application.h"
 #include "XYZ/Debug/Profiler.h"
+#include "XYZ/Debug/Timer.h"
 #include "XYZ/ImGui/ImGui.h"
 #include "XYZ/API/Vulkan/VulkanRendererAPI.h"
 #include "XYZ/API/Vulkan/VulkanPipelineCompute.h"
@@ -22,33 +24,6 @@
 
 namespace XYZ {
 
-	static GeometryRenderQueue::TransformData Mat4ToTransformData(const glm::mat4& transform)
-	{
-		GeometryRenderQueue::TransformData data;
-		data.TransformRow[0] = { transform[0][0], transform[1][0], transform[2][0], transform[3][0] };
-		data.TransformRow[1] = { transform[0][1], transform[1][1], transform[2][1], transform[3][1] };
-		data.TransformRow[2] = { transform[0][2], transform[1][2], transform[2][2], transform[3][2] };
-		return data;
-	}
-
-	static void CopyToBoneStorage(GeometryRenderQueue::BoneTransforms& storage, const std::vector<ozz::math::Float4x4>& boneTransforms, const Ref<AnimatedMesh>& mesh)
-	{
-		if (boneTransforms.empty())
-		{
-			for (auto& bone : storage)
-				bone = ozz::math::Float4x4::identity();
-		}
-		else
-		{
-			const auto& boneInfo = mesh->GetMeshSource()->GetBoneInfo();
-			for (size_t i = 0; i < boneTransforms.size(); ++i)
-			{
-				const uint32_t jointIndex = boneInfo[i].JointIndex;
-				storage[i] = boneInfo[i].InverseTransform * boneTransforms[jointIndex] * boneInfo[i].BoneOffset;
-			}
-		}
-	}
-
 	SceneRenderer::SceneRenderer(Ref<Scene> scene, SceneRendererSpecification specification)
 		:
 		m_Specification(specification),
@@ -133,6 +108,8 @@ namespace XYZ {
 		m_CameraDataUB.ViewProjectionMatrix = m_SceneCamera.Camera.GetProjectionMatrix() * m_SceneCamera.ViewMatrix;
 		m_CameraDataUB.ProjectionMatrix = m_SceneCamera.Camera.GetProjectionMatrix();
 		m_CameraDataUB.ViewMatrix = m_SceneCamera.ViewMatrix;
+		m_Queue.ViewMatrix = m_CameraDataUB.ViewMatrix;
+		m_CullingStatistics = {};
 		
 		const auto& lightEnvironment = m_ActiveScene->m_LightEnvironment;
 		m_PointsLights3DSSBO.Count = static_cast<uint32_t>(lightEnvironment.PointLights3D.size());
@@ -145,6 +122,8 @@ namespace XYZ {
 		m_CameraDataUB.ViewProjectionMatrix = viewProjectionMatrix;
 		m_CameraDataUB.ProjectionMatrix = projection;
 		m_CameraDataUB.ViewMatrix = viewMatrix;
+		m_Queue.ViewMatrix = m_CameraDataUB.ViewMatrix;
+		m_CullingStatistics = {};
 
 		const auto& lightEnvironment = m_ActiveScene->m_LightEnvironment;
 		m_PointsLights3DSSBO.Count = static_cast<uint32_t>(lightEnvironment.PointLights3D.size());
@@ -194,105 +173,60 @@ namespace XYZ {
 
 	void SceneRenderer::SubmitBillboard(const Ref<MaterialAsset>& material, const Ref<SubTexture>& subTexture, uint32_t sortLayer, const glm::vec4& color, const glm::vec3& position, const glm::vec2& size)
 	{
-		GeometryRenderQueue::SpriteKey key{ material->GetHandle() };
-
-		auto& command = m_Queue.BillboardDrawCommands[key];
-
-		uint32_t textureIndex = command.SetTexture(subTexture->GetTexture());
-
-		command.MaterialAsset = material;
-		command.MaterialInstance = material->GetMaterialInstance();
-
-		command.BillboardData.push_back({ textureIndex, subTexture->GetTexCoords(), color, position, size });
+		m_Queue.SubmitBillboard(material, subTexture, color, position, size);
 	}
 
 	void SceneRenderer::SubmitSprite(const Ref<MaterialAsset>& material, const Ref<SubTexture>& subTexture, const glm::vec4& color, const glm::mat4& transform)
 	{
-		GeometryRenderQueue::SpriteKey key{ material->GetHandle() };
-		auto& command = m_Queue.SpriteDrawCommands[key];
-		
-		uint32_t textureIndex = command.SetTexture(subTexture->GetTexture());
-		
-		command.MaterialAsset = material;
-		command.MaterialInstance = material->GetMaterialInstance();
-		command.SpriteData.push_back({ textureIndex, subTexture->GetTexCoords(), color, transform });
+		m_Queue.SubmitSprite(material, subTexture, color, transform);
 	}
 
 	void SceneRenderer::SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const Ref<MaterialInstance>& overrideMaterial)
 	{
-		GeometryRenderQueue::BatchMeshKey key{ mesh->GetRenderID(), material->GetHandle() };
-		
-		auto& dc = m_Queue.MeshDrawCommands[key];
-		dc.Mesh = mesh;
-		dc.MaterialAsset = material;
-
-		if (overrideMaterial.Raw())
-		{
-			auto& dcOverride = dc.OverrideCommands.emplace_back();
-			dcOverride.OverrideMaterial = overrideMaterial;
-			dcOverride.Transform = transform;
-		}
-		else
-		{		
-			dc.Count++;
-			dc.OverrideMaterial = material->GetMaterialInstance();
-			dc.TransformInstanceCount++;
-			dc.TransformData.push_back(Mat4ToTransformData(transform));
-		}
+		m_Queue.SubmitMesh(mesh, material, transform, overrideMaterial);
 	}
 
 	void SceneRenderer::SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const void* instanceData, uint32_t instanceCount, uint32_t instanceSize, const Ref<MaterialInstance>& overrideMaterial)
 	{
-		GeometryRenderQueue::BatchMeshKey key{ mesh->GetRenderID(), material->GetHandle() };
+		m_Queue.SubmitMesh(mesh, material, instanceData, instanceCount, instanceSize, overrideMaterial);
+	}
 
-		auto& dc = m_Queue.InstanceMeshDrawCommands[key];
-		dc.Mesh = mesh;
-		dc.MaterialAsset = material;
-		dc.Transform = glm::mat4(1.0f);
+	void SceneRenderer::SubmitMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& boneTransforms, const Ref<MaterialInstance>& overrideMaterial)
+	{
+		m_Queue.SubmitMesh(mesh, material, transform, boneTransforms, overrideMaterial);
+	}
 
-		if (overrideMaterial.Raw())
-		{
-			XYZ_ASSERT(false, "Not implemented");
-		}
-		else
-		{
-			dc.OverrideMaterial = material->GetMaterialInstance();
-			dc.InstanceCount += instanceCount;
-		
-			size_t offset = dc.InstanceData.size();
-			size_t instanceDataSize = static_cast<size_t>(instanceCount) * instanceSize;
-			dc.InstanceData.resize(offset + instanceDataSize);
-			memcpy(dc.InstanceData.data() + offset, instanceData, instanceDataSize);
-		}
+	void SceneRenderer::SubmitSkinnedMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& skinningPalette, const Ref<MaterialInstance>& overrideMaterial)
+	{
+		m_Queue.SubmitSkinnedMesh(mesh, material, transform, skinningPalette, overrideMaterial);
 	}
 
-	void SceneRenderer::SubmitMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& boneTransforms, const Ref<MaterialInstance>& overrideMaterial)
+	void SceneRenderer::SetQueuePartitionCount(uint32_t count)
 	{
-		GeometryRenderQueue::BatchMeshKey key{ mesh->GetHandle(), material->GetHandle() };
+		if (m_QueuePartitions.size() < count)
+			m_QueuePartitions.resize(count);
+		for (auto& partition : m_QueuePartitions)
+			partition.ViewMatrix = m_CameraDataUB.ViewMatrix;
+	}
 
-		auto& dc = m_Queue.AnimatedMeshDrawCommands[key];
-		dc.Mesh = mesh;
-		dc.MaterialAsset = material;
 
-		if (overrideMaterial.Raw())
-		{
-			auto& dcOverride = dc.OverrideCommands.emplace_back();
-			dcOverride.OverrideMaterial = overrideMaterial;
-			dcOverride.Transform = transform;
-			CopyToBoneStorage(dcOverride.BoneTransforms, boneTransforms, mesh);
-		}
-		else
+
+	uint32_t SceneRenderer::CullBounds(const CullingBounds& bounds, std::vector<uint8_t>& visibility)
+	{
+		XYZ_PROFILE_FUNC("SceneRenderer::CullBounds");
+		if (!m_Options.FrustumCulling)
 		{
-			dc.Count++;
-			dc.OverrideMaterial = material->GetMaterialInstance();
-			dc.TransformInstanceCount++;
-			dc.TransformData.push_back(Mat4ToTransformData(transform));
-			auto& boneStorage = dc.BoneData.emplace_back();
-			CopyToBoneStorage(boneStorage, boneTransforms, mesh);
+			visibility.assign(bounds.Size(), 1);
+			return bounds.Size();
 		}
-	}
-
+		const Frustum frustum(m_CameraDataUB.ViewProjectionMatrix);
+		const glm::vec3 viewPosition = glm::vec3(glm::inverse(m_CameraDataUB.ViewMatrix)[3]);
 
+		const uint32_t visibleCount = bounds.Cull(frustum, viewPosition, m_Options.CullDistance, visibility);
+		m_CullingStatistics.TestedCount += bounds.Size();
+		m_CullingStatistics.VisibleCount += visibleCount;
+		return visibleCount;
+	}
 
 	bool SceneRenderer::CreateComputeAllocation(uint32_t size, uint32_t index, StorageBufferAllocation& allocation)
 	{
@@ -414,6 +348,18 @@ namespace XYZ {
 						[&]() { ImGui::Checkbox("##ShowGrid", &m_Options.ShowGrid); }
 					);
 
+					UI::TableRow("FrustumCullingRow",
+						[]() { ImGui::Text("Frustum Culling"); },
+						[&]() { ImGui::Checkbox("##FrustumCulling", &m_Options.FrustumCulling); }
+					);
+					UI::TableRow("CullDistanceRow",
+						[]() { ImGui::Text("Cull Distance"); },
+						[&]()
+						{	UI::ScopedStyleStack style(true, ImGuiStyleVar_ItemSpacing, ImVec2{ 0.0f, 5.0f });
+							UI::FloatControl("##CullDistance", "##CullDistanceDrag", m_Options.CullDistance, 0.0f, 1.0f);
+						}
+					);
+
 					UI::TableRow("GridScaleRow",
 						[]() { ImGui::Text("Grid Scale"); },
 						[&]()
@@ -498,6 +444,9 @@ namespace XYZ {
 
 					UI::TextTableRow("%s", "Transform Instances:", "%u", m_RenderStatistics.TransformInstanceCount);
 					UI::TextTableRow("%s", "Instance Data Size:", "%u", m_RenderStatistics.InstanceDataSize);
+
+					UI::TextTableRow("%s", "Cull Tested Count:", "%u", m_RenderStatistics.CullTestedCount);
+					UI::TextTableRow("%s", "Culled Count:", "%u", m_RenderStatistics.CulledCount);
 					
 					ImGui::EndTable();
 				}
@@ -684,6 +633,12 @@ namespace XYZ {
 	}
 	void SceneRenderer::preRender()
 	{
+		{
+			XYZ_SCOPE_PERF("SceneRenderer::preRender BuildDrawCommands");
+			for (auto& partition : m_QueuePartitions)
+				m_Queue.Merge(partition);
+			m_Queue.BuildDrawCommands();
+		}
 		m_GeometryPassStatistics = m_GeometryPass.PreSubmit(m_Queue);
 		DeferredLightPassStatistics lightPassStats = m_DeferredLightPass.PreSubmit(m_ActiveScene);
 		
@@ -701,6 +656,9 @@ namespace XYZ {
 	
 		m_RenderStatistics.PointLight2DCount = lightPassStats.PointLightCount;
 		m_RenderStatistics.SpotLight2DCount = lightPassStats.SpotLightCount;
+
+		m_RenderStatistics.CullTestedCount = m_CullingStatistics.TestedCount;
+		m_RenderStatistics.CulledCount = m_CullingStatistics.TestedCount - m_CullingStatistics.VisibleCount;
 	}
 
 	void SceneRenderer::renderGrid()
@@ -13,6 +13,7 @@
 #include "SceneRendererBuffers.h"
 #include "PushConstBuffer.h"
 #include "StorageBufferAllocator.h"
+#include "CullingBounds.h"
 
 #include "RenderPasses/GeometryPass.h"
 #include "RenderPasses/DeferredLightPass.h"
@@ -41,6 +42,8 @@ namespace XYZ {
 	{
 		bool ShowGrid = true;
 		bool ShowBoundingBoxes = false;
+		bool FrustumCulling = true;
+		float CullDistance = 0.0f; // Zero disables distance culling
 	};
 
 	struct SceneRendererCamera
@@ -83,7 +86,13 @@ namespace XYZ {
 		void SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const Ref<MaterialInstance>& overrideMaterial = nullptr);
 		void SubmitMesh(const Ref<Mesh>& mesh, const Ref<MaterialAsset>& material, const void* instanceData, uint32_t instanceCount, uint32_t instanceSize, const Ref<MaterialInstance>& overrideMaterial);
 		void SubmitMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& boneTransforms, const Ref<MaterialInstance>& overrideMaterial = nullptr);
+		void SubmitSkinnedMesh(const Ref<AnimatedMesh>& mesh, const Ref<MaterialAsset>& material, const glm::mat4& transform, const std::vector<ozz::math::Float4x4>& skinningPalette, const Ref<MaterialInstance>& overrideMaterial = nullptr);
 		
+		// Partitions are filled by worker threads, each thread must use different partition.
+		// Must be called after BeginScene, partitions are merged in EndScene
+		void				 SetQueuePartitionCount(uint32_t count);
+		GeometryRenderQueue& GetQueuePartition(uint32_t index) { return m_QueuePartitions[index]; }
+
 		// Compute stuff
 		bool CreateComputeAllocation(uint32_t size, uint32_t index, StorageBufferAllocation& allocation);
 
@@ -108,6 +117,9 @@ namespace XYZ {
 			const StorageBufferAllocation& indirectCommandAllocation
 		);
 
+		// Tests bounds against camera frustum, writes 1 for visible bounds
+		uint32_t CullBounds(const CullingBounds& bounds, std::vector<uint8_t>& visibility);
+
 		void OnImGuiRender();
 
 
@@ -177,6 +189,7 @@ namespace XYZ {
 		glm::ivec3				   m_LightCullingWorkGroups;
 
 		GeometryRenderQueue		   m_Queue;								   
+		std::vector<GeometryRenderQueue> m_QueuePartitions;
 		bool				       m_ViewportSizeChanged = false;
 	
 		Ref<ShaderAsset>		   m_CompositeShaderAsset;
@@ -201,8 +214,17 @@ namespace XYZ {
 			
 			uint32_t TransformInstanceCount = 0;
 			uint32_t InstanceDataSize = 0;
+
+			uint32_t CullTestedCount = 0;
+			uint32_t CulledCount = 0;
+		};
+		struct CullingStatistics
+		{
+			uint32_t TestedCount = 0;
+			uint32_t VisibleCount = 0;
 		};
 		RenderStatistics m_RenderStatistics;
+		CullingStatistics m_CullingStatistics;
 		GeometryPassStatistics m_GeometryPassStatistics;
 
 
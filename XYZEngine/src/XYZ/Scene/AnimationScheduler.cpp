@@ -0,0 +1,83 @@
+#include "stdafx.h"
+#include "AnimationScheduler.h"
+
+#include "Components.h"
+
+#include "XYZ/Debug/Profiler.h"
+
+namespace XYZ {
+
+	AnimationScheduler::AnimationScheduler()
+		:
+		m_Lods{ {
+			{ 20.0f,  1, AnimationController::sc_FullDepth },
+			{ 40.0f,  2, AnimationController::sc_FullDepth },
+			{ 80.0f,  4, 6 },
+			{ std::numeric_limits<float>::max(), 8, 3 }
+		} },
+		m_Budget(512)
+	{
+	}
+
+	void AnimationScheduler::Schedule(entt::registry& registry, Timestep ts, const glm::vec3& viewPosition, const std::vector<entt::entity>& culled)
+	{
+		XYZ_PROFILE_FUNC("AnimationScheduler::Schedule");
+		m_Sampled.clear();
+		m_Interpolated.clear();
+		m_Statistics = AnimationStatistics();
+
+		auto animView = registry.view<AnimationComponent, AnimatedMeshComponent, TransformComponent>();
+		for (auto entity : animView)
+		{
+			auto [anim, animMesh, transform] = animView.get(entity);
+			if (!anim.Playing || !anim.Controller.Raw())
+				continue;
+
+			const size_t index = static_cast<size_t>(entt::to_entity(entity));
+			if (index < culled.size() && culled[index] == entity && !animMesh.SkinningPalette.empty())
+			{
+				// Pending time is applied once sampled, character waiting longest is first when it becomes visible
+				const uint32_t lowestRate = m_Lods[sc_LodCount - 1].UpdateRate;
+				anim.PendingTime += ts;
+				anim.FramesSinceSample++;
+				m_Statistics.Culled++;
+				if ((anim.BonesObserved || anim.UpdateBoneEntities) && anim.FramesSinceSample >= lowestRate)
+				{
+					anim.LodLevel = sc_LodCount - 1;
+					m_Sampled.push_back(entity);
+				}
+				continue;
+			}
+
+			const glm::vec3 position = glm::vec3(transform->WorldTransform[3]);
+			const float distance = glm::length(position - viewPosition);
+			uint32_t level = 0;
+			while (level < sc_LodCount - 1 && distance > m_Lods[level].MaxDistance)
+				level++;
+
+			anim.LodLevel = level;
+			anim.PendingTime += ts;
+			anim.FramesSinceSample++;
+			m_Statistics.LodCounts[level]++;
+
+			if (animMesh.SkinningPalette.empty() || anim.FramesSinceSample >= m_Lods[level].UpdateRate)
+				m_Sampled.push_back(entity);
+			else
+				m_Interpolated.push_back(entity);
+		}
+
+		if (m_Sampled.size() > m_Budget)
+		{
+			// Characters waiting longest are sampled first, rest waits for next frame
+			auto& animStorage = registry.storage<AnimationComponent>();
+			std::nth_element(m_Sampled.begin(), m_Sampled.begin() + m_Budget, m_Sampled.end(), [&](entt::entity a, entt::entity b) {
+				return animStorage.get(a).FramesSinceSample > animStorage.get(b).FramesSinceSample;
+			});
+			m_Interpolated.insert(m_Interpolated.end(), m_Sampled.begin() + m_Budget, m_Sampled.end());
+			m_Statistics.Deferred = static_cast<uint32_t>(m_Sampled.size() - m_Budget);
+			m_Sampled.resize(m_Budget);
+		}
+		m_Statistics.Sampled = static_cast<uint32_t>(m_Sampled.size());
+		m_Statistics.Interpolated = static_cast<uint32_t>(m_Interpolated.size());
+	}
+}
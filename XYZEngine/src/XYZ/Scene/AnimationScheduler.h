@@ -0,0 +1,60 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+#include "XYZ/Core/Timestep.h"
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <limits>
+
+namespace XYZ {
+
+	struct AnimationLod
+	{
+		float	 MaxDistance;
+		uint32_t UpdateRate;	// Animation is sampled every UpdateRate frames, palette is interpolated in between
+		uint32_t MaxJointDepth; // Deeper joints keep rest pose relative to parent
+	};
+
+	struct AnimationStatistics
+	{
+		uint32_t Sampled = 0;
+		uint32_t Interpolated = 0;
+		uint32_t Deferred = 0; // Due for sampling but over budget
+		uint32_t Culled = 0;
+		std::array<uint32_t, 4> LodCounts{};
+	};
+
+	// Assigns animation lod by distance from view and decides which characters are sampled this frame.
+	// Characters that are due for sampling are ordered by how long they wait, budget limits sampled count.
+	// Culled characters are not sampled unless their bones are observed, then they use the lowest rate
+	class XYZ_API AnimationScheduler
+	{
+	public:
+		static constexpr uint32_t sc_LodCount = 4;
+		static constexpr uint32_t sc_Unlimited = std::numeric_limits<uint32_t>::max();
+
+		AnimationScheduler();
+
+		// Culled is indexed by entity and holds entities culled in last rendered frame, other entities are visible
+		void Schedule(entt::registry& registry, Timestep ts, const glm::vec3& viewPosition, const std::vector<entt::entity>& culled);
+
+		void SetLod(uint32_t level, const AnimationLod& lod) { m_Lods[level] = lod; }
+		void SetBudget(uint32_t maxSampledPerFrame)			 { m_Budget = maxSampledPerFrame; }
+
+		const AnimationLod&				 GetLod(uint32_t level) const { return m_Lods[level]; }
+		uint32_t						 GetBudget()			const { return m_Budget; }
+		const std::vector<entt::entity>& GetSampled()			const { return m_Sampled; }
+		const std::vector<entt::entity>& GetInterpolated()		const { return m_Interpolated; }
+		const AnimationStatistics&		 GetStatistics()		const { return m_Statistics; }
+
+	private:
+		std::array<AnimationLod, sc_LodCount> m_Lods;
+		uint32_t							  m_Budget;
+
+		std::vector<entt::entity> m_Sampled;
+		std::vector<entt::entity> m_Interpolated;
+		AnimationStatistics		  m_Statistics;
+	};
+}
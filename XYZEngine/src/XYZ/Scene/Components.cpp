@@ -168,11 +168,13 @@ namespace XYZ {
 		childRel.PreviousSibling = lastChild;
 		childRel.Parent = parent;
 		childRel.Depth = parentRel.Depth + 1;
+		reg.patch<Relationship>(child); // Notify listeners about new parent
 	}
 
 	void Relationship::RemoveRelation(entt::entity child, entt::registry& reg)
 	{
 		removeRelation(child, reg);
+		reg.patch<Relationship>(child);
 	}
 	void Relationship::removeRelation(entt::entity child, entt::registry& reg)
 	{
@@ -274,6 +276,8 @@ namespace XYZ {
 		MaterialAsset(other.MaterialAsset),
 		OverrideMaterial(other.OverrideMaterial),
 		BoneTransforms(other.BoneTransforms),
+		SkinningPalette(other.SkinningPalette),
+		SampledPalettes{ other.SampledPalettes[0], other.SampledPalettes[1] },
 		BoneEntities(other.BoneEntities)
 	{
 	}
@@ -324,7 +328,8 @@ namespace XYZ {
 		:
 		Controller(other.Controller),
 		AnimationTime(other.AnimationTime),
-		Playing(other.Playing)
+		Playing(other.Playing),
+		UpdateBoneEntities(other.UpdateBoneEntities)
 	{
 	}
 	PointLightComponent2D::PointLightComponent2D(const glm::vec3& color, float radius, float intensity)
@@ -73,6 +73,15 @@ namespace XYZ {
 		bool	  m_Dirty = true;
 
 		friend class Scene;
+		friend class TransformHierarchy;
+	};
+
+	// Runtime only, rigid bodies interpolated between physics steps are rendered with it.
+	// TransformComponent keeps simulated pose, so scripts and hierarchy see physics state
+	struct XYZ_API RenderTransformComponent
+	{
+		glm::mat4 LocalOffset = glm::mat4(1.0f); // Simulated local transform to interpolated one
+		glm::mat4 WorldTransform = glm::mat4(1.0f);
 	};
 	
 
@@ -145,7 +154,9 @@ namespace XYZ {
 		Ref<MaterialAsset>    MaterialAsset;
 		Ref<MaterialInstance> OverrideMaterial;
 		
-		std::vector<ozz::math::Float4x4> BoneTransforms;
+		std::vector<ozz::math::Float4x4> BoneTransforms; // World transforms of bone entities, used when mesh is not animated
+		std::vector<ozz::math::Float4x4> SkinningPalette; // Written directly by animation, relative to parent of the mesh entity
+		std::vector<ozz::math::Float4x4> SampledPalettes[2]; // Last two sampled palettes, interpolated when animation lod skips frames
 		std::vector<entt::entity>		 BoneEntities;
 	};
 
@@ -158,6 +169,13 @@ namespace XYZ {
 		SamplingContext			  Context; // It is not owned by controller so single controller can update on multiple threads
 		float					  AnimationTime = 0.0f;
 		bool					  Playing = false;
+		bool					  UpdateBoneEntities = false; // Forces bone entity writes, observers in scene are detected automatically
+		bool					  BonesObserved = false;	  // Set by scene if bone entities have attached children, scripts or are selected
+
+		// Runtime state of animation lod
+		uint32_t				  LodLevel = 0;
+		uint32_t				  FramesSinceSample = 0;
+		float					  PendingTime = 0.0f; // Time not yet applied to animation
 	};
 
 	class Prefab;
@@ -284,6 +302,7 @@ namespace XYZ {
 		uint32_t Depth;
 		friend class Scene;
 		friend class SceneSerializer;
+		friend class SceneBinarySerializer;
 	};
 
 	template<typename T>
@@ -327,6 +346,7 @@ namespace XYZ {
 		enum class BodyType { Static, Dynamic, Kinematic };
 
 		BodyType Type;
+		uint32_t Layer = 0; // Index of collision layer in PhysicsWorld2D
 
 		void* RuntimeBody = nullptr;
 	};
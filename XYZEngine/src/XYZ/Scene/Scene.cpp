@@ -33,6 +33,8 @@
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <unordered_set>
+
 
 namespace XYZ {
 
@@ -129,12 +131,32 @@ namespace XYZ {
 
 		m_Registry.on_construct<ScriptComponent>().connect<&Scene::onScriptComponentConstruct>(this);
 		m_Registry.on_destroy<ScriptComponent>().connect<&Scene::onScriptComponentDestruct>(this);
+		connectHierarchySignals();
 	}
 
 	Scene::~Scene()
 	{
+		// Contact listener is destroyed before physics world
+		m_PhysicsWorld.Wait();
 		m_Registry.on_construct<ScriptComponent>().disconnect<&Scene::onScriptComponentConstruct>(this);
 		m_Registry.on_destroy<ScriptComponent>().disconnect<&Scene::onScriptComponentDestruct>(this);
+		m_Registry.on_update<Relationship>().disconnect<&Scene::onRelationshipUpdate>(this);
+		m_Registry.on_destroy<TransformComponent>().disconnect<&Scene::onTransformComponentDestruct>(this);
+		m_Registry.on_construct<AnimatedMeshComponent>().disconnect<&Scene::onBoneObserverChange>(this);
+		m_Registry.on_update<AnimatedMeshComponent>().disconnect<&Scene::onBoneObserverChange>(this);
+		m_Registry.on_construct<MeshComponent>().disconnect<&Scene::onRenderableChange>(this);
+		m_Registry.on_update<MeshComponent>().disconnect<&Scene::onRenderableChange>(this);
+		m_Registry.on_destroy<MeshComponent>().disconnect<&Scene::onRenderableChange>(this);
+		m_Registry.on_construct<AnimatedMeshComponent>().disconnect<&Scene::onRenderableChange>(this);
+		m_Registry.on_update<AnimatedMeshComponent>().disconnect<&Scene::onRenderableChange>(this);
+		m_Registry.on_destroy<AnimatedMeshComponent>().disconnect<&Scene::onRenderableChange>(this);
+		m_Registry.on_construct<SpriteRenderer>().disconnect<&Scene::onRenderableChange>(this);
+		m_Registry.on_destroy<SpriteRenderer>().disconnect<&Scene::onRenderableChange>(this);
+		for (const auto& [handle, streamed] : m_StreamedMeshes)
+		{
+			if (!streamed.Future.IsReady())
+				AssetManager::CancelAssetAsync(handle);
+		}
 	}
 
 	SceneEntity Scene::CreateEntity(const std::string& name, const GUID& guid)
@@ -203,6 +225,9 @@ namespace XYZ {
 
 	void Scene::OnPlay()
 	{
+		// Registry is copied back on stop, meshes assigned while playing would be lost
+		WaitForStreamedMeshes();
+
 		// Find Camera	
 		auto cameraView = m_Registry.view<CameraComponent>();
 		if (!cameraView.empty())
@@ -242,6 +267,8 @@ namespace XYZ {
 	{
 		Utils::CloneRegistry(s_CopyRegistry, m_Registry);
 		s_CopyRegistry = entt::registry();
+		// Registry was replaced, signals are lost and hierarchy must be flattened again
+		connectHierarchySignals();
 		{
 			b2World& physicsWorld = m_PhysicsWorld.GetWorld();
 			auto rigidBodyView = m_Registry.view<RigidBody2DComponent>();
@@ -250,6 +277,10 @@ namespace XYZ {
 				auto& body = rigidBodyView.get<RigidBody2DComponent>(entity);
 				physicsWorld.DestroyBody(static_cast<b2Body*>(body.RuntimeBody));
 			}
+			m_PhysicsWorld.Reset();
+			// Destroyed bodies report end of their contacts, user data is freed below
+			m_ContactListener.Clear();
+			m_ContactEventCount = 0;
 		}
 
 		auto scriptView = m_Registry.view<ScriptComponent>();
@@ -272,13 +303,180 @@ namespace XYZ {
 		m_SelectedEntity = entt::null;
 	}
 
+	// Palette is built straight from model space pose, bone entities are not involved
+	static void UpdateSkinningPalette(std::vector<ozz::math::Float4x4>& palette, const AnimatedMeshComponent& animatedMesh, const SamplingContext& context)
+	{
+		if (!animatedMesh.Mesh.Raw() || !animatedMesh.Mesh->IsValid())
+			return;
+
+		const auto& modelSpaceTransforms = context.GetModelSpaceTransforms();
+		const auto& boneInfo = animatedMesh.Mesh->GetMeshSource()->GetBoneInfo();
+		palette.resize(boneInfo.size());
+		for (size_t i = 0; i < boneInfo.size(); ++i)
+		{
+			const uint32_t jointIndex = boneInfo[i].JointIndex;
+			if (jointIndex < modelSpaceTransforms.size())
+				palette[i] = modelSpaceTransforms[jointIndex] * boneInfo[i].BoneOffset;
+			else
+				palette[i] = ozz::math::Float4x4::identity();
+		}
+	}
+
+	// Skipped frames blend between last two samples, palette lags one sample behind animation
+	static void InterpolateSkinningPalette(const AnimationComponent& animation, AnimatedMeshComponent& animatedMesh, uint32_t updateRate)
+	{
+		const auto& from = animatedMesh.SampledPalettes[0];
+		const auto& to = animatedMesh.SampledPalettes[1];
+		if (to.empty() || from.size() != to.size())
+			return;
+
+		const float ratio = std::min(static_cast<float>(animation.FramesSinceSample + 1) / static_cast<float>(updateRate), 1.0f);
+		const ozz::math::SimdFloat4 alpha = ozz::math::simd_float4::Load1(ratio);
+		animatedMesh.SkinningPalette.resize(to.size());
+		for (size_t i = 0; i < to.size(); ++i)
+		{
+			for (int column = 0; column < 4; ++column)
+				animatedMesh.SkinningPalette[i].cols[column] = ozz::math::Lerp(from[i].cols[column], to[i].cols[column], alpha);
+		}
+	}
+
+	static void UpdateBoneEntities(entt::registry& registry, const AnimatedMeshComponent& animatedMesh, SamplingContext& context)
+	{
+		if (!animatedMesh.Mesh.Raw() || !animatedMesh.Mesh->IsValid())
+			return;
+
+		context.UpdateLocalTransforms();
+		const auto& boneInfo = animatedMesh.Mesh->GetMeshSource()->GetBoneInfo();
+		const size_t count = std::min(animatedMesh.BoneEntities.size(), boneInfo.size());
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t jointIndex = boneInfo[i].JointIndex;
+			if (jointIndex >= context.LocalTranslations.size())
+				continue;
+
+			auto& transform = registry.get<TransformComponent>(animatedMesh.BoneEntities[i]);
+			transform.GetTransform().Translation = context.LocalTranslations[jointIndex];
+			transform.GetTransform().Rotation = glm::eulerAngles(context.LocalRotations[jointIndex]);
+			transform.GetTransform().Scale = context.LocalScales[jointIndex];
+		}
+	}
+
+	// Culled entities are from last rendered frame, entity created since then is visible
+	static bool IsAnimatedMeshVisible(const std::vector<entt::entity>& culled, entt::entity entity)
+	{
+		const size_t index = static_cast<size_t>(entt::to_entity(entity));
+		return index >= culled.size() || culled[index] != entity;
+	}
+
+	// Culled characters only advance animation, palette is built again once they are visible
+	static void SampleAnimation(entt::registry& registry, entt::entity entity, AnimationComponent& animation, AnimatedMeshComponent& animatedMesh, const AnimationLod& lod, bool visible)
+	{
+		const bool firstSample = animatedMesh.SkinningPalette.empty();
+		animation.Controller->Update(animation.AnimationTime, animation.PendingTime, animation.Context, lod.MaxJointDepth);
+		animation.PendingTime = 0.0f;
+		animation.FramesSinceSample = 0;
+
+		if (!visible && !firstSample)
+		{
+			// Interpolation must not continue from palette sampled before culling
+			animatedMesh.SampledPalettes[1].clear();
+		}
+		else if (lod.UpdateRate <= 1)
+		{
+			UpdateSkinningPalette(animatedMesh.SkinningPalette, animatedMesh, animation.Context);
+			animatedMesh.SampledPalettes[1].clear();
+		}
+		else
+		{
+			std::swap(animatedMesh.SampledPalettes[0], animatedMesh.SampledPalettes[1]);
+			UpdateSkinningPalette(animatedMesh.SampledPalettes[1], animatedMesh, animation.Context);
+			if (animatedMesh.SampledPalettes[0].size() != animatedMesh.SampledPalettes[1].size())
+				animatedMesh.SampledPalettes[0] = animatedMesh.SampledPalettes[1];
+
+			// Spread characters created at the same time across frames
+			if (firstSample)
+				animation.FramesSinceSample = static_cast<uint32_t>(entt::to_integral(entity)) % lod.UpdateRate;
+			InterpolateSkinningPalette(animation, animatedMesh, lod.UpdateRate);
+		}
+
+		if (animation.UpdateBoneEntities || animation.BonesObserved)
+			UpdateBoneEntities(registry, animatedMesh, animation.Context);
+	}
+
+	// Skinned vertices are relative to parent of the mesh entity
+	template <typename TransformStorage, typename RelationshipStorage>
+	static entt::entity SkinningSpaceEntity(entt::entity entity, const TransformStorage& transformStorage, const RelationshipStorage& relationshipStorage)
+	{
+		if (relationshipStorage.contains(entity))
+		{
+			const entt::entity parent = relationshipStorage.get(entity).GetParent();
+			if (parent != entt::null && transformStorage.contains(parent))
+				return parent;
+		}
+		return entity;
+	}
+
+	template <typename RenderTransformStorage>
+	static const glm::mat4& RenderTransform(entt::entity entity, const TransformComponent& transform, const RenderTransformStorage& renderTransformStorage)
+	{
+		return renderTransformStorage.contains(entity) ? renderTransformStorage.get(entity).WorldTransform : transform->WorldTransform;
+	}
+
+	void Scene::updateBoneObservers()
+	{
+		if (!m_BoneObserversDirty)
+			return;
+
+		XYZ_PROFILE_FUNC("Scene::updateBoneObservers");
+		m_BoneObserversDirty = false;
+		auto& transformStorage = m_Registry.storage<TransformComponent>();
+		auto& relationshipStorage = m_Registry.storage<Relationship>();
+		auto& scriptStorage = m_Registry.storage<ScriptComponent>();
+
+		std::unordered_set<entt::entity> bones;
+		auto animView = m_Registry.view<AnimationComponent, AnimatedMeshComponent>();
+		for (auto entity : animView)
+		{
+			auto [anim, animMesh] = animView.get(entity);
+			bones.clear();
+			bones.insert(animMesh.BoneEntities.begin(), animMesh.BoneEntities.end());
+
+			// Scripts of character can look up bones, anything parented to bone follows it
+			const entt::entity root = SkinningSpaceEntity(entity, transformStorage, relationshipStorage);
+			bool observed = scriptStorage.contains(entity) || scriptStorage.contains(root);
+			for (auto it = bones.begin(); it != bones.end() && !observed; ++it)
+			{
+				const entt::entity bone = *it;
+				if (bone == m_SelectedEntity || scriptStorage.contains(bone))
+				{
+					observed = true;
+					break;
+				}
+				if (!relationshipStorage.contains(bone))
+					continue;
+
+				entt::entity child = relationshipStorage.get(bone).GetFirstChild();
+				while (child != entt::null && relationshipStorage.contains(child))
+				{
+					if (child != entity && bones.find(child) == bones.end())
+					{
+						observed = true;
+						break;
+					}
+					child = relationshipStorage.get(child).GetNextSibling();
+				}
+			}
+			anim.BonesObserved = observed;
+		}
+	}
+
 	void Scene::OnUpdate(Timestep ts)
 	{
 		XYZ_PROFILE_FUNC("Scene::OnUpdate");
-		m_PhysicsWorld.Step(ts);
-
+		// Waits for step started last frame
 		updateRigidBody2DView();
-		
+		dispatchContactEvents();
+
 		updateParticleView(ts);
 		updateGPUParticleView(ts);
 
@@ -288,7 +486,10 @@ namespace XYZ {
 			updateAnimationView(ts);
 
 		updateScripts(ts);
+		// Scripts are done with bodies, physics steps while hierarchy updates and scene renders
+		m_PhysicsWorld.StepAsync(ts);
 		updateHierarchy();
+		updateRenderTransforms();
 		m_GPUScene.OnUpdate(ts);
 	}
 
@@ -306,54 +507,82 @@ namespace XYZ {
 		renderCamera.ViewMatrix = glm::inverse(cameraTransform->WorldTransform);
 		auto [translation, rotation, scale] = cameraTransform.GetWorldComponents();
 		renderCamera.ViewPosition = translation;
+		m_AnimationViewPosition = translation;
 
 		setupLightEnvironment();
 		sceneRenderer->GetOptions().ShowGrid = false;
 		sceneRenderer->SetViewportSize(m_ViewportWidth, m_ViewportHeight);
 		sceneRenderer->BeginScene(renderCamera);
+		updateStreamedMeshes(*sceneRenderer);
+		cullRenderables(*sceneRenderer);
 
 
-		auto spriteView = m_Registry.view<TransformComponent, SpriteRenderer>();
-		for (auto entity : spriteView)
+		if (m_SubmitRenderAsync)
 		{
-			auto& [transform, spriteRenderer] = spriteView.get<TransformComponent, SpriteRenderer>(entity);
-			sceneRenderer->SubmitSprite(spriteRenderer.Material, spriteRenderer.SubTexture, spriteRenderer.Color, transform->WorldTransform);
+			submitRenderAsync(*sceneRenderer, false);
 		}
-		auto meshView = m_Registry.view<TransformComponent, MeshComponent>();
-		for (auto entity : meshView)
+		else
 		{
-			auto& [transform, meshComponent] = meshView.get<TransformComponent, MeshComponent>(entity);
-			sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, transform->WorldTransform, meshComponent.OverrideMaterial);
-		}
+			auto& renderTransformStorage = m_Registry.storage<RenderTransformComponent>();
+			auto spriteView = m_Registry.view<TransformComponent, SpriteRenderer>();
+			for (auto entity : spriteView)
+			{
+				auto& [transform, spriteRenderer] = spriteView.get<TransformComponent, SpriteRenderer>(entity);
+				sceneRenderer->SubmitSprite(spriteRenderer.Material, spriteRenderer.SubTexture, spriteRenderer.Color, RenderTransform(entity, transform, renderTransformStorage));
+			}
+			auto& meshStorage = m_Registry.storage<MeshComponent>();
+			auto meshView = m_Registry.view<TransformComponent, MeshComponent>();
+			for (auto entity : meshView)
+			{
+				if (!m_MeshVisibility[meshStorage.index(entity)])
+					continue;
+				auto& [transform, meshComponent] = meshView.get<TransformComponent, MeshComponent>(entity);
+				if (!meshComponent.Mesh.Raw()) // Still streaming
+					continue;
+				sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, RenderTransform(entity, transform, renderTransformStorage), meshComponent.OverrideMaterial);
+			}
 
-		auto animMeshView = m_Registry.view<TransformComponent, AnimatedMeshComponent>();
-		for (auto entity : animMeshView)
-		{
-			auto& [transform, meshComponent] = animMeshView.get<TransformComponent, AnimatedMeshComponent>(entity);
-			meshComponent.BoneTransforms.resize(meshComponent.BoneEntities.size());
-			for (size_t i = 0; i < meshComponent.BoneEntities.size(); ++i)
+			auto& animMeshStorage = m_Registry.storage<AnimatedMeshComponent>();
+			auto& animationStorage = m_Registry.storage<AnimationComponent>();
+			auto& transformStorage = m_Registry.storage<TransformComponent>();
+			auto& relationshipStorage = m_Registry.storage<Relationship>();
+			auto animMeshView = m_Registry.view<TransformComponent, AnimatedMeshComponent>();
+			for (auto entity : animMeshView)
 			{
-				const entt::entity boneEntity = meshComponent.BoneEntities[i];
-				meshComponent.BoneTransforms[i] = Utils::Float4x4FromMat4(m_Registry.get<TransformComponent>(boneEntity)->WorldTransform);
+				if (!m_AnimatedMeshVisibility[animMeshStorage.index(entity)])
+					continue;
+				auto& [transform, meshComponent] = animMeshView.get<TransformComponent, AnimatedMeshComponent>(entity);
+				if (animationStorage.contains(entity) && !meshComponent.SkinningPalette.empty())
+				{
+					const entt::entity skinningSpace = SkinningSpaceEntity(entity, transformStorage, relationshipStorage);
+					sceneRenderer->SubmitSkinnedMesh(meshComponent.Mesh, meshComponent.MaterialAsset, transformStorage.get(skinningSpace)->WorldTransform, meshComponent.SkinningPalette, meshComponent.OverrideMaterial);
+					continue;
+				}
+				meshComponent.BoneTransforms.resize(meshComponent.BoneEntities.size());
+				for (size_t i = 0; i < meshComponent.BoneEntities.size(); ++i)
+				{
+					const entt::entity boneEntity = meshComponent.BoneEntities[i];
+					meshComponent.BoneTransforms[i] = Utils::Float4x4FromMat4(m_Registry.get<TransformComponent>(boneEntity)->WorldTransform);
+				}
+				Ref<MeshSource> meshSource = meshComponent.Mesh->GetMeshSource();
+				sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, meshSource->GetSubmeshTransform(), meshComponent.BoneTransforms, meshComponent.OverrideMaterial);
 			}
-			Ref<MeshSource> meshSource = meshComponent.Mesh->GetMeshSource();
-			sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, meshSource->GetSubmeshTransform(), meshComponent.BoneTransforms, meshComponent.OverrideMaterial);
-		}
 
-		auto particleView = m_Registry.view<TransformComponent, ParticleRenderer, ParticleComponent>();
-		for (auto entity : particleView)
-		{
-			auto& [transform, renderer, particleComponent] = particleView.get<TransformComponent, ParticleRenderer, ParticleComponent>(entity);
+			auto particleView = m_Registry.view<TransformComponent, ParticleRenderer, ParticleComponent>();
+			for (auto entity : particleView)
+			{
+				auto& [transform, renderer, particleComponent] = particleView.get<TransformComponent, ParticleRenderer, ParticleComponent>(entity);
 
-			auto& renderData = particleComponent.GetSystem()->GetRenderData();
+				auto& renderData = particleComponent.GetSystem()->GetRenderData();
 		
-			sceneRenderer->SubmitMesh(
-				renderer.Mesh, renderer.MaterialAsset,
-				renderData.ParticleData.data(),
-				renderData.ParticleCount,
-				sizeof(ParticleRenderData),
-				renderer.OverrideMaterial
-			);
+				sceneRenderer->SubmitMesh(
+					renderer.Mesh, renderer.MaterialAsset,
+					renderData.ParticleData.data(),
+					renderData.ParticleCount,
+					sizeof(ParticleRenderData),
+					renderer.OverrideMaterial
+				);
+			}
 		}
 		m_GPUScene.OnRender(this, sceneRenderer);
 		sceneRenderer->EndScene();
@@ -392,69 +621,107 @@ namespace XYZ {
 		return true;
 	}
 
+	// Reloading part of CheckAsset, must run on main thread
+	template <typename T>
+	static void ReloadAsset(Ref<T>& asset)
+	{
+		if (asset.Raw() && !asset->IsFlagSet(AssetFlag::Missing) && asset->IsFlagSet(AssetFlag::Reloaded))
+			asset = AssetManager::GetAsset<T>(asset->GetHandle());
+	}
+
+	// Read only part of CheckAsset, safe to call from jobs
+	template <typename T>
+	static bool IsAssetValid(const Ref<T>& asset)
+	{
+		return asset.Raw() && !asset->IsFlagSet(AssetFlag::Missing);
+	}
+
 	void Scene::OnRenderEditor(Ref<SceneRenderer> sceneRenderer, const glm::mat4& viewProjection, const glm::mat4& view, const glm::mat4& projection)
 	{
 		XYZ_PROFILE_FUNC("Scene::OnRenderEditor");
 		
-		
+		m_AnimationViewPosition = glm::vec3(glm::inverse(view)[3]);
 		setupLightEnvironment();
 		sceneRenderer->BeginScene(viewProjection, view, projection);
+		updateStreamedMeshes(*sceneRenderer);
+		cullRenderables(*sceneRenderer);
 	
-		auto spriteView = m_Registry.view<TransformComponent, SpriteRenderer>();
-		for (auto entity : spriteView)
+		if (m_SubmitRenderAsync)
 		{
-			auto& [transform, spriteRenderer] = spriteView.get<TransformComponent, SpriteRenderer>(entity);
-			
-			if (!CheckAsset(spriteRenderer.Material) || !CheckAsset(spriteRenderer.SubTexture))
-				continue;
-			sceneRenderer->SubmitSprite(spriteRenderer.Material, spriteRenderer.SubTexture, spriteRenderer.Color, transform->WorldTransform);
+			submitRenderAsync(*sceneRenderer, true);
 		}
-		
-		auto meshView = m_Registry.view<TransformComponent, MeshComponent>();
-		for (auto entity : meshView)
+		else
 		{
-			auto& [transform, meshComponent] = meshView.get<TransformComponent, MeshComponent>(entity);
-			if (!CheckAsset(meshComponent.MaterialAsset) || !CheckAsset(meshComponent.Mesh))
-				continue;
-			sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, transform->WorldTransform, meshComponent.OverrideMaterial);
-		}
+			auto spriteView = m_Registry.view<TransformComponent, SpriteRenderer>();
+			for (auto entity : spriteView)
+			{
+				auto& [transform, spriteRenderer] = spriteView.get<TransformComponent, SpriteRenderer>(entity);
+			
+				if (!CheckAsset(spriteRenderer.Material) || !CheckAsset(spriteRenderer.SubTexture))
+					continue;
+				sceneRenderer->SubmitSprite(spriteRenderer.Material, spriteRenderer.SubTexture, spriteRenderer.Color, transform->WorldTransform);
+			}
+		
+			auto& meshStorage = m_Registry.storage<MeshComponent>();
+			auto meshView = m_Registry.view<TransformComponent, MeshComponent>();
+			for (auto entity : meshView)
+			{
+				if (!m_MeshVisibility[meshStorage.index(entity)])
+					continue;
+				auto& [transform, meshComponent] = meshView.get<TransformComponent, MeshComponent>(entity);
+				if (!CheckAsset(meshComponent.MaterialAsset) || !CheckAsset(meshComponent.Mesh))
+					continue;
+				sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, transform->WorldTransform, meshComponent.OverrideMaterial);
+			}
 		
 		
-		auto animMeshView = m_Registry.view<TransformComponent,AnimatedMeshComponent>();
-		for (auto entity : animMeshView)
-		{
-			auto& [transform, meshComponent] = animMeshView.get<TransformComponent,  AnimatedMeshComponent>(entity);
-			if (!CheckAsset(meshComponent.Mesh) || !CheckAsset(meshComponent.MaterialAsset))
-				continue;
-
-			
-			meshComponent.BoneTransforms.resize(meshComponent.BoneEntities.size());
-			for (size_t i = 0; i < meshComponent.BoneEntities.size(); ++i)
+			auto& animMeshStorage = m_Registry.storage<AnimatedMeshComponent>();
+			auto& animationStorage = m_Registry.storage<AnimationComponent>();
+			auto& transformStorage = m_Registry.storage<TransformComponent>();
+			auto& relationshipStorage = m_Registry.storage<Relationship>();
+			auto animMeshView = m_Registry.view<TransformComponent,AnimatedMeshComponent>();
+			for (auto entity : animMeshView)
 			{
-				const entt::entity boneEntity = meshComponent.BoneEntities[i];
-				meshComponent.BoneTransforms[i] = Utils::Float4x4FromMat4(m_Registry.get<TransformComponent>(boneEntity)->WorldTransform);
+				if (!m_AnimatedMeshVisibility[animMeshStorage.index(entity)])
+					continue;
+				auto& [transform, meshComponent] = animMeshView.get<TransformComponent,  AnimatedMeshComponent>(entity);
+				if (!CheckAsset(meshComponent.Mesh) || !CheckAsset(meshComponent.MaterialAsset))
+					continue;
+
+				if (animationStorage.contains(entity) && !meshComponent.SkinningPalette.empty())
+				{
+					const entt::entity skinningSpace = SkinningSpaceEntity(entity, transformStorage, relationshipStorage);
+					sceneRenderer->SubmitSkinnedMesh(meshComponent.Mesh, meshComponent.MaterialAsset, transformStorage.get(skinningSpace)->WorldTransform, meshComponent.SkinningPalette, meshComponent.OverrideMaterial);
+					continue;
+				}
+				meshComponent.BoneTransforms.resize(meshComponent.BoneEntities.size());
+				for (size_t i = 0; i < meshComponent.BoneEntities.size(); ++i)
+				{
+					const entt::entity boneEntity = meshComponent.BoneEntities[i];
+					meshComponent.BoneTransforms[i] = Utils::Float4x4FromMat4(m_Registry.get<TransformComponent>(boneEntity)->WorldTransform);
+				}
+				Ref<MeshSource> meshSource = meshComponent.Mesh->GetMeshSource();
+				sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, meshSource->GetSubmeshTransform(), meshComponent.BoneTransforms, meshComponent.OverrideMaterial);
 			}
-			Ref<MeshSource> meshSource = meshComponent.Mesh->GetMeshSource();
-			sceneRenderer->SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, meshSource->GetSubmeshTransform(), meshComponent.BoneTransforms, meshComponent.OverrideMaterial);
-		}
 
-		{
-			XYZ_PROFILE_FUNC("Scene::OnRenderEditor particleView");
-			auto particleView = m_Registry.view<TransformComponent, ParticleRenderer, ParticleComponent>();
-			for (auto entity : particleView)
 			{
-				auto& [transform, renderer, particleComponent] = particleView.get<TransformComponent, ParticleRenderer, ParticleComponent>(entity);
-				if (!CheckAsset(renderer.Mesh) || !CheckAsset(renderer.MaterialAsset))
-					continue;
+				XYZ_PROFILE_FUNC("Scene::OnRenderEditor particleView");
+				auto particleView = m_Registry.view<TransformComponent, ParticleRenderer, ParticleComponent>();
+				for (auto entity : particleView)
+				{
+					auto& [transform, renderer, particleComponent] = particleView.get<TransformComponent, ParticleRenderer, ParticleComponent>(entity);
+					if (!CheckAsset(renderer.Mesh) || !CheckAsset(renderer.MaterialAsset))
+						continue;
 				
-				const auto& renderData = particleComponent.GetSystem()->GetRenderData();
-				sceneRenderer->SubmitMesh(
-					renderer.Mesh, renderer.MaterialAsset,
-					renderData.ParticleData.data(),
-					renderData.ParticleCount,
-					sizeof(ParticleRenderData),
-					renderer.OverrideMaterial
-				);
+					const auto& renderData = particleComponent.GetSystem()->GetRenderData();
+					sceneRenderer->SubmitMesh(
+						renderer.Mesh, renderer.MaterialAsset,
+						renderData.ParticleData.data(),
+						renderData.ParticleCount,
+						sizeof(ParticleRenderData),
+						renderer.OverrideMaterial
+					);
+				}
 			}
 		}
 		
@@ -469,6 +736,35 @@ namespace XYZ {
 		{
 			ImGui::Checkbox("Update Animation Async", &m_UpdateAnimationAsync);
 			ImGui::Checkbox("Update Hierarchy Async", &m_UpdateHierarchyAsync);
+			ImGui::Checkbox("Submit Render Async", &m_SubmitRenderAsync);
+
+			const AnimationStatistics& animStats = m_AnimationScheduler.GetStatistics();
+			int animBudget = static_cast<int>(std::min(m_AnimationScheduler.GetBudget(), 100000u));
+			if (ImGui::DragInt("Animation Budget", &animBudget, 1.0f, 1, 100000))
+				m_AnimationScheduler.SetBudget(static_cast<uint32_t>(animBudget));
+			ImGui::Text("Animations Sampled: %u Interpolated: %u Deferred: %u Culled: %u", animStats.Sampled, animStats.Interpolated, animStats.Deferred, animStats.Culled);
+			ImGui::Text("Animation Lod: %u %u %u %u", animStats.LodCounts[0], animStats.LodCounts[1], animStats.LodCounts[2], animStats.LodCounts[3]);
+
+			PhysicsWorld2D::Settings physicsSettings = m_PhysicsWorld.GetSettings();
+			bool physicsChanged = false;
+			float stepRate = 1.0f / physicsSettings.FixedTimestep;
+			if (ImGui::DragFloat("Physics Step Rate", &stepRate, 1.0f, 10.0f, 240.0f))
+			{
+				physicsSettings.FixedTimestep = 1.0f / stepRate;
+				physicsChanged = true;
+			}
+			int maxSubsteps = static_cast<int>(physicsSettings.MaxSubsteps);
+			if (ImGui::DragInt("Physics Max Substeps", &maxSubsteps, 1.0f, 1, 16))
+			{
+				physicsSettings.MaxSubsteps = static_cast<uint32_t>(maxSubsteps);
+				physicsChanged = true;
+			}
+			physicsChanged |= ImGui::DragInt("Velocity Iterations", &physicsSettings.VelocityIterations, 1.0f, 1, 32);
+			physicsChanged |= ImGui::DragInt("Position Iterations", &physicsSettings.PositionIterations, 1.0f, 1, 32);
+			if (physicsChanged)
+				m_PhysicsWorld.SetSettings(physicsSettings);
+			ImGui::Text("Physics Steps: %u Awake Bodies: %u", m_PhysicsStepCount, m_AwakeBodyCount);
+			ImGui::Text("Contact Events: %u", m_ContactEventCount);
 		}
 		ImGui::End();
 	}
@@ -479,6 +775,36 @@ namespace XYZ {
 		m_ViewportHeight = height;
 	}
 
+	void Scene::StreamMesh(SceneEntity entity, const AssetHandle& meshHandle)
+	{
+		if (!AssetManager::Exist(meshHandle))
+		{
+			XYZ_CORE_WARN("Scene references missing mesh {0}", meshHandle.ToString());
+			return;
+		}
+		entity.GetComponent<MeshComponent>().Mesh = nullptr;
+		StreamedMesh& streamed = m_StreamedMeshes[meshHandle];
+		if (streamed.Entities.empty())
+			streamed.Future = AssetManager::GetAssetAsync<StaticMesh>(meshHandle, streamed.Priority);
+		streamed.Entities.push_back(entity.ID());
+	}
+
+	void Scene::WaitForStreamedMeshes()
+	{
+		XYZ_PROFILE_FUNC("Scene::WaitForStreamedMeshes");
+		auto& meshStorage = m_Registry.storage<MeshComponent>();
+		for (auto& [handle, streamed] : m_StreamedMeshes)
+		{
+			Ref<StaticMesh> mesh = streamed.Future.get();
+			for (const entt::entity entity : streamed.Entities)
+			{
+				if (meshStorage.contains(entity))
+					meshStorage.get(entity).Mesh = mesh;
+			}
+		}
+		m_StreamedMeshes.clear();
+	}
+
 	SceneEntity Scene::GetEntityByName(const std::string& name)
 	{
 		auto view = m_Registry.view<SceneTagComponent>();
@@ -515,12 +841,54 @@ namespace XYZ {
 	{
 		std::unique_lock lock(m_ScriptMutex);
 		ScriptEngine::CreateScriptEntityInstance({ ent, this });
+		m_BoneObserversDirty = true;
 	}
 
 	void Scene::onScriptComponentDestruct(entt::registry& reg, entt::entity ent)
 	{
 		std::unique_lock lock(m_ScriptMutex);
 		ScriptEngine::DestroyScriptEntityInstance({ ent, this });
+		m_BoneObserversDirty = true;
+	}
+
+	void Scene::onRelationshipUpdate(entt::registry& reg, entt::entity ent)
+	{
+		m_TransformHierarchy.Reparent(reg, ent);
+		m_BoneObserversDirty = true;
+	}
+
+	void Scene::onTransformComponentDestruct(entt::registry& reg, entt::entity ent)
+	{
+		m_TransformHierarchy.Remove(ent);
+	}
+
+	void Scene::onBoneObserverChange(entt::registry& reg, entt::entity ent)
+	{
+		m_BoneObserversDirty = true;
+	}
+
+	void Scene::onRenderableChange(entt::registry& reg, entt::entity ent)
+	{
+		m_SceneBVH.Invalidate();
+	}
+
+	void Scene::connectHierarchySignals()
+	{
+		m_Registry.on_update<Relationship>().connect<&Scene::onRelationshipUpdate>(this);
+		m_Registry.on_destroy<TransformComponent>().connect<&Scene::onTransformComponentDestruct>(this);
+		m_Registry.on_construct<AnimatedMeshComponent>().connect<&Scene::onBoneObserverChange>(this);
+		m_Registry.on_update<AnimatedMeshComponent>().connect<&Scene::onBoneObserverChange>(this);
+		m_Registry.on_construct<MeshComponent>().connect<&Scene::onRenderableChange>(this);
+		m_Registry.on_update<MeshComponent>().connect<&Scene::onRenderableChange>(this);
+		m_Registry.on_destroy<MeshComponent>().connect<&Scene::onRenderableChange>(this);
+		m_Registry.on_construct<AnimatedMeshComponent>().connect<&Scene::onRenderableChange>(this);
+		m_Registry.on_update<AnimatedMeshComponent>().connect<&Scene::onRenderableChange>(this);
+		m_Registry.on_destroy<AnimatedMeshComponent>().connect<&Scene::onRenderableChange>(this);
+		m_Registry.on_construct<SpriteRenderer>().connect<&Scene::onRenderableChange>(this);
+		m_Registry.on_destroy<SpriteRenderer>().connect<&Scene::onRenderableChange>(this);
+		m_TransformHierarchy.Invalidate();
+		m_SceneBVH.Invalidate();
+		m_BoneObserversDirty = true;
 	}
 
 
@@ -542,164 +910,326 @@ namespace XYZ {
 	void Scene::updateHierarchy()
 	{
 		XYZ_PROFILE_FUNC("Scene::updateHierarchy");
-		std::stack<entt::entity> entities;
-		{
-			const Relationship& relation = m_Registry.get<Relationship>(m_SceneEntity);
-			if (m_Registry.valid(relation.FirstChild))
-				entities.push(relation.FirstChild);
-		}
+		if (m_TransformHierarchy.IsInvalid())
+			m_TransformHierarchy.Rebuild(m_Registry, m_SceneEntity);
 
-		while (!entities.empty())
-		{
-			const entt::entity tmp = entities.top();
-			entities.pop();
-		
-			const Relationship& relation = m_Registry.get<Relationship>(tmp);
-			if (m_Registry.valid(relation.NextSibling))
-				entities.push(relation.NextSibling);
-			if (m_Registry.valid(relation.FirstChild))
-				entities.push(relation.FirstChild);
-			
-			TransformComponent& transform = m_Registry.get<TransformComponent>(tmp);		
-			// Every entity except m_SceneEntity must have parent
-			TransformComponent& parentTransform = m_Registry.get<TransformComponent>(relation.Parent);
-			
-			if (parentTransform.m_Dirty || transform.m_Dirty)
-				transform.GetTransform().WorldTransform = parentTransform->WorldTransform * transform.GetLocalTransform();
-		}
-		
-		// We updated all transforms, they are no longer dirty
-		auto& transformStorage = m_Registry.storage<TransformComponent>();
-		for (auto& transformComponent : transformStorage)
-			transformComponent.m_Dirty = false;
+		m_TransformHierarchy.Update(m_Registry, nullptr);
+		m_SceneBVH.Invalidate();
 	}
 
 	void Scene::updateHierarchyAsync()
 	{
 		XYZ_PROFILE_FUNC("Scene::updateHierarchyAsync");
-		auto& threadPool = Application::Get().GetThreadPool();
-		Ref<Scene> instance = this;
+		if (m_TransformHierarchy.IsInvalid())
+			m_TransformHierarchy.Rebuild(m_Registry, m_SceneEntity);
 
-		const Relationship& relation = m_Registry.get<Relationship>(m_SceneEntity);
-		TransformComponent& parentTransform = m_Registry.get<TransformComponent>(m_SceneEntity);
+		m_TransformHierarchy.Update(m_Registry, &Application::Get().GetThreadPool());
+		m_SceneBVH.Invalidate();
+	}
 
-		entt::entity parent = m_SceneEntity;
-		entt::entity child = relation.GetFirstChild();
+	void Scene::updateSceneBVH()
+	{
+		// World transforms change only in hierarchy update, so scene is refit at most once per frame
+		m_SceneBVH.Update(m_Registry);
+	}
 
-		std::vector<std::future<bool>> futures;
-		while (m_Registry.valid(child))
+	void Scene::updateAnimationView(Timestep ts)
+	{
+		XYZ_PROFILE_FUNC("Scene::updateAnimationView");
+		updateBoneObservers();
+		m_AnimationScheduler.Schedule(m_Registry, ts, m_AnimationViewPosition, m_CulledAnimatedMeshes);
+
+		auto& animStorage = m_Registry.storage<AnimationComponent>();
+		auto& animMeshStorage = m_Registry.storage<AnimatedMeshComponent>();
+		for (auto entity : m_AnimationScheduler.GetSampled())
 		{
-			const Relationship& childRelation = m_Registry.get<Relationship>(child);
+			auto& anim = animStorage.get(entity);
+			const bool visible = IsAnimatedMeshVisible(m_CulledAnimatedMeshes, entity);
+			SampleAnimation(m_Registry, entity, anim, animMeshStorage.get(entity), m_AnimationScheduler.GetLod(anim.LodLevel), visible);
+		}
+		for (auto entity : m_AnimationScheduler.GetInterpolated())
+		{
+			if (!IsAnimatedMeshVisible(m_CulledAnimatedMeshes, entity))
+				continue;
+			auto& anim = animStorage.get(entity);
+			InterpolateSkinningPalette(anim, animMeshStorage.get(entity), m_AnimationScheduler.GetLod(anim.LodLevel).UpdateRate);
+		}
+	}
+	
+	void Scene::updateAnimationViewAsync(Timestep ts)
+	{
+		XYZ_PROFILE_FUNC("Scene::updateAnimationViewAsync");
+		updateBoneObservers();
+		m_AnimationScheduler.Schedule(m_Registry, ts, m_AnimationViewPosition, m_CulledAnimatedMeshes);
 
-			TransformComponent& transform = m_Registry.get<TransformComponent>(child);
-			if (parentTransform.m_Dirty || transform.m_Dirty)
-				transform.GetTransform().WorldTransform = parentTransform->WorldTransform * transform.GetLocalTransform();
+		Ref<Scene> instance = this;
+		auto& threadPool = Application::Get().GetThreadPool();
+		auto& animStorage = m_Registry.storage<AnimationComponent>();
+		auto& animMeshStorage = m_Registry.storage<AnimatedMeshComponent>();
+		
+		const auto& sampled = m_AnimationScheduler.GetSampled();
+		std::vector<std::future<bool>> futures;
+		futures.reserve(sampled.size());
+		
+		for (auto entity : sampled)
+		{
+			auto& anim = animStorage.get(entity);
+			const AnimationLod& lod = m_AnimationScheduler.GetLod(anim.LodLevel);
+			const bool visible = IsAnimatedMeshVisible(m_CulledAnimatedMeshes, entity);
+			futures.emplace_back(threadPool.SubmitJob([instance, entity, lod, visible, &animation = anim, &animatedMesh = animMeshStorage.get(entity)]() mutable {
 
-			futures.emplace_back(threadPool.SubmitJob([instance, child]() mutable {
-				instance->updateSubHierarchy(child);
+				SampleAnimation(instance->m_Registry, entity, animation, animatedMesh, lod, visible);
 				return true;
 			}));
-			child = childRelation.GetNextSibling();
 		}
-
+		// Interpolation is cheap compared to sampling, done while jobs run
+		for (auto entity : m_AnimationScheduler.GetInterpolated())
+		{
+			if (!IsAnimatedMeshVisible(m_CulledAnimatedMeshes, entity))
+				continue;
+			auto& anim = animStorage.get(entity);
+			InterpolateSkinningPalette(anim, animMeshStorage.get(entity), m_AnimationScheduler.GetLod(anim.LodLevel).UpdateRate);
+		}
 		for (auto& future : futures)
 			future.wait();
-
-		// We updated all transforms, they are no longer dirty
-		auto& transformStorage = m_Registry.storage<TransformComponent>();
-		for (auto& transformComponent : transformStorage)
-			transformComponent.m_Dirty = false;
 	}
 
-	void Scene::updateSubHierarchy(entt::entity parent)
+	template <typename Storage, typename Func>
+	static void ForEachInPartition(Storage& storage, uint32_t partition, uint32_t partitionCount, Func&& func)
 	{
-		XYZ_PROFILE_FUNC("Scene::updateSubHierarchy");
+		const size_t count = storage.size();
+		const size_t begin = count * partition / partitionCount;
+		const size_t end = count * (partition + 1) / partitionCount;
+		const entt::entity* entities = storage.data();
+		for (size_t i = begin; i < end; ++i)
+			func(entities[i], storage.get(entities[i]));
+	}
 
-		const Relationship& relation = m_Registry.get<Relationship>(parent);
-		TransformComponent& parentTransform = m_Registry.get<TransformComponent>(parent);
+	void Scene::cullRenderables(SceneRenderer& sceneRenderer)
+	{
+		XYZ_PROFILE_FUNC("Scene::cullRenderables");
+		auto& transformStorage = m_Registry.storage<TransformComponent>();
+		auto& relationshipStorage = m_Registry.storage<Relationship>();
+		auto& meshStorage = m_Registry.storage<MeshComponent>();
+		auto& animMeshStorage = m_Registry.storage<AnimatedMeshComponent>();
 
-		std::stack<entt::entity> entities;
+		// Bounds are pushed in storage order, entities without valid mesh are never culled
+		m_CullingBounds.Clear();
+		for (size_t i = 0; i < meshStorage.size(); ++i)
 		{
-			const Relationship& relation = m_Registry.get<Relationship>(parent);
-			if (m_Registry.valid(relation.FirstChild))
-				entities.push(relation.FirstChild);
+			const entt::entity entity = meshStorage.data()[i];
+			const MeshComponent& meshComponent = meshStorage.get(entity);
+			if (!transformStorage.contains(entity) || !meshComponent.Mesh.Raw() || !meshComponent.Mesh->IsValid())
+			{
+				m_CullingBounds.PushVisible();
+				continue;
+			}
+			Ref<MeshSource> meshSource = meshComponent.Mesh->GetMeshSource();
+			m_CullingBounds.Push(meshSource->GetSubmeshBoundingBox(), transformStorage.get(entity)->WorldTransform);
 		}
+		sceneRenderer.CullBounds(m_CullingBounds, m_MeshVisibility);
 
-		while (!entities.empty())
+		m_CullingBounds.Clear();
+		for (size_t i = 0; i < animMeshStorage.size(); ++i)
 		{
-			const entt::entity current = entities.top();
-			entities.pop();
+			const entt::entity entity = animMeshStorage.data()[i];
+			const AnimatedMeshComponent& meshComponent = animMeshStorage.get(entity);
 
-			const Relationship& relation = m_Registry.get<Relationship>(current);
-			if (m_Registry.valid(relation.NextSibling))
-				entities.push(relation.NextSibling);
-			if (m_Registry.valid(relation.FirstChild))
-				entities.push(relation.FirstChild);
-
-			TransformComponent& transform = m_Registry.get<TransformComponent>(current);
-			TransformComponent& parentTransform = m_Registry.get<TransformComponent>(relation.Parent);
+			const entt::entity parent = SkinningSpaceEntity(entity, transformStorage, relationshipStorage);
+			if (!transformStorage.contains(parent) || !meshComponent.Mesh.Raw() || !meshComponent.Mesh->IsValid())
+			{
+				m_CullingBounds.PushVisible();
+				continue;
+			}
+			Ref<MeshSource> meshSource = meshComponent.Mesh->GetMeshSource();
+			m_CullingBounds.Push(meshSource->GetSubmeshBoundingBox(), transformStorage.get(parent)->WorldTransform * meshSource->GetSubmeshTransform());
+		}
+		sceneRenderer.CullBounds(m_CullingBounds, m_AnimatedMeshVisibility);
 
-			if (parentTransform.m_Dirty || transform.m_Dirty)
-				transform.GetTransform().WorldTransform = parentTransform->WorldTransform * transform.GetLocalTransform();
+		std::fill(m_CulledAnimatedMeshes.begin(), m_CulledAnimatedMeshes.end(), entt::entity(entt::null));
+		for (size_t i = 0; i < animMeshStorage.size(); ++i)
+		{
+			if (m_AnimatedMeshVisibility[i])
+				continue;
+			const entt::entity entity = animMeshStorage.data()[i];
+			const size_t index = static_cast<size_t>(entt::to_entity(entity));
+			if (index >= m_CulledAnimatedMeshes.size())
+				m_CulledAnimatedMeshes.resize(index + 1, entt::null);
+			m_CulledAnimatedMeshes[index] = entity;
 		}
 	}
 
-	void Scene::updateAnimationView(Timestep ts)
+	void Scene::updateStreamedMeshes(SceneRenderer& sceneRenderer)
 	{
-		XYZ_PROFILE_FUNC("Scene::updateAnimationView");
-		auto animView = m_Registry.view<AnimationComponent, AnimatedMeshComponent>();
-		for (auto entity : animView)
+		if (m_StreamedMeshes.empty())
+			return;
+
+		XYZ_PROFILE_FUNC("Scene::updateStreamedMeshes");
+		auto& transformStorage = m_Registry.storage<TransformComponent>();
+		auto& meshStorage = m_Registry.storage<MeshComponent>();
+		for (auto it = m_StreamedMeshes.begin(); it != m_StreamedMeshes.end();)
 		{
-			auto [anim, animMesh] = animView.get(entity);
-			anim.Playing = true; // TODO: temporary
-			if (anim.Playing && anim.Controller.Raw())
+			StreamedMesh& streamed = it->second;
+			if (!streamed.Future.IsReady())
 			{
-				anim.Controller->Update(anim.AnimationTime, anim.Context);
-				anim.AnimationTime += ts;
-				for (size_t i = 0; i < animMesh.BoneEntities.size(); ++i)
-				{
-					auto& transform = m_Registry.get<TransformComponent>(animMesh.BoneEntities[i]);
-					transform.GetTransform().Translation = anim.Context.LocalTranslations[i];
-					transform.GetTransform().Rotation = glm::eulerAngles(anim.Context.LocalRotations[i]);
-					transform.GetTransform().Scale = anim.Context.LocalScales[i];
-				}
+				++it;
+				continue;
+			}
+			// Entities of failed mesh keep null mesh and are not rendered
+			if (streamed.Future.IsFailed())
+				XYZ_CORE_WARN("Streamed mesh {0} failed to load", it->first.ToString());
+			Ref<StaticMesh> mesh = streamed.Future.get();
+			for (const entt::entity entity : streamed.Entities)
+			{
+				if (meshStorage.contains(entity))
+					meshStorage.get(entity).Mesh = mesh;
+			}
+			it = m_StreamedMeshes.erase(it);
+		}
+
+		// Mesh bounds are not known yet, unit bounds around entity decide visibility
+		const AABB unitBounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+		m_CullingBounds.Clear();
+		for (const auto& [handle, streamed] : m_StreamedMeshes)
+		{
+			for (const entt::entity entity : streamed.Entities)
+			{
+				if (transformStorage.contains(entity))
+					m_CullingBounds.Push(unitBounds, transformStorage.get(entity)->WorldTransform);
+				else
+					m_CullingBounds.PushVisible();
+			}
+		}
+		sceneRenderer.CullBounds(m_CullingBounds, m_StreamedMeshVisibility);
+
+		// Mesh shared by multiple entities takes priority of the most important one
+		uint32_t index = 0;
+		for (auto& [handle, streamed] : m_StreamedMeshes)
+		{
+			float priority = 0.0f;
+			for (const entt::entity entity : streamed.Entities)
+			{
+				const bool visible = m_StreamedMeshVisibility[index++] != 0;
+				const float distance = transformStorage.contains(entity)
+					? glm::distance(glm::vec3(transformStorage.get(entity)->WorldTransform[3]), m_AnimationViewPosition) : 0.0f;
+				priority = std::max(priority, AssetStreamer::CalculatePriority(distance, visible));
+			}
+			if (priority != streamed.Priority)
+			{
+				streamed.Priority = priority;
+				AssetManager::GetStreamer().SetPriority(handle, priority);
 			}
 		}
 	}
-	
-	void Scene::updateAnimationViewAsync(Timestep ts)
+
+	void Scene::submitRenderAsync(SceneRenderer& sceneRenderer, bool checkAssets)
 	{
-		XYZ_PROFILE_FUNC("Scene::updateAnimationViewAsync");
-		Ref<Scene> instance = this;
+		XYZ_PROFILE_FUNC("Scene::submitRenderAsync");
 		auto& threadPool = Application::Get().GetThreadPool();
-		auto animView = m_Registry.view<AnimationComponent, AnimatedMeshComponent>();
-		
-		std::vector<std::future<bool>> futures;
-		futures.reserve(animView.size_hint());
-		
-		for (auto entity : animView)
+		// Calling thread executes jobs while waiting, it needs partition too
+		const uint32_t partitionCount = threadPool.GetNumThreads() + 1;
+		sceneRenderer.SetQueuePartitionCount(partitionCount);
+
+		// Storages are acquired here, registry must not be modified by jobs
+		auto& transformStorage = m_Registry.storage<TransformComponent>();
+		auto& spriteStorage = m_Registry.storage<SpriteRenderer>();
+		auto& meshStorage = m_Registry.storage<MeshComponent>();
+		auto& animMeshStorage = m_Registry.storage<AnimatedMeshComponent>();
+		auto& animationStorage = m_Registry.storage<AnimationComponent>();
+		auto& relationshipStorage = m_Registry.storage<Relationship>();
+		auto& particleRendererStorage = m_Registry.storage<ParticleRenderer>();
+		auto& particleStorage = m_Registry.storage<ParticleComponent>();
+		auto& renderTransformStorage = m_Registry.storage<RenderTransformComponent>();
+
+		// Reloaded assets are resolved before fan out, jobs only read asset references
+		if (checkAssets)
 		{
-			auto [anim, animMesh] = animView.get(entity);
-			anim.Playing = true; // TODO: temporary
-			if (anim.Playing && anim.Controller.Raw())
+			XYZ_PROFILE_FUNC("Scene::submitRenderAsync ReloadAssets");
+			for (SpriteRenderer& spriteRenderer : spriteStorage)
+			{
+				ReloadAsset(spriteRenderer.Material);
+				ReloadAsset(spriteRenderer.SubTexture);
+			}
+			for (MeshComponent& meshComponent : meshStorage)
 			{
-				futures.emplace_back(threadPool.SubmitJob([instance, ts, &animation = anim, &animatedMesh = animMesh]() mutable {
+				ReloadAsset(meshComponent.MaterialAsset);
+				ReloadAsset(meshComponent.Mesh);
+			}
+			for (AnimatedMeshComponent& meshComponent : animMeshStorage)
+			{
+				ReloadAsset(meshComponent.Mesh);
+				ReloadAsset(meshComponent.MaterialAsset);
+			}
+			for (ParticleRenderer& renderer : particleRendererStorage)
+			{
+				ReloadAsset(renderer.Mesh);
+				ReloadAsset(renderer.MaterialAsset);
+			}
+		}
+
+		JobCounter counter;
+		for (uint32_t partition = 0; partition < partitionCount; ++partition)
+		{
+			threadPool.PushJob(counter, [&, partition]() {
+				XYZ_PROFILE_FUNC("Scene::submitRenderAsync Job");
+				GeometryRenderQueue& queue = sceneRenderer.GetQueuePartition(partition);
+
+				ForEachInPartition(spriteStorage, partition, partitionCount, [&](entt::entity entity, SpriteRenderer& spriteRenderer) {
+					if (!transformStorage.contains(entity))
+						return;
+					if (checkAssets && (!IsAssetValid(spriteRenderer.Material) || !IsAssetValid(spriteRenderer.SubTexture)))
+						return;
+					queue.SubmitSprite(spriteRenderer.Material, spriteRenderer.SubTexture, spriteRenderer.Color, RenderTransform(entity, transformStorage.get(entity), renderTransformStorage));
+				});
+
+				ForEachInPartition(meshStorage, partition, partitionCount, [&](entt::entity entity, MeshComponent& meshComponent) {
+					if (!transformStorage.contains(entity) || !m_MeshVisibility[meshStorage.index(entity)] || !meshComponent.Mesh.Raw())
+						return;
+					if (checkAssets && (!IsAssetValid(meshComponent.MaterialAsset) || !IsAssetValid(meshComponent.Mesh)))
+						return;
+					queue.SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, RenderTransform(entity, transformStorage.get(entity), renderTransformStorage), meshComponent.OverrideMaterial);
+				});
 
-					animation.Controller->Update(animation.AnimationTime, animation.Context);
-					animation.AnimationTime += ts;
-					for (size_t i = 0; i < animatedMesh.BoneEntities.size(); ++i)
+				ForEachInPartition(animMeshStorage, partition, partitionCount, [&](entt::entity entity, AnimatedMeshComponent& meshComponent) {
+					if (!transformStorage.contains(entity) || !m_AnimatedMeshVisibility[animMeshStorage.index(entity)])
+						return;
+					if (checkAssets && (!IsAssetValid(meshComponent.Mesh) || !IsAssetValid(meshComponent.MaterialAsset)))
+						return;
+
+					if (animationStorage.contains(entity) && !meshComponent.SkinningPalette.empty())
 					{
-						auto& transform = instance->m_Registry.get<TransformComponent>(animatedMesh.BoneEntities[i]);
-						transform.GetTransform().Translation = animation.Context.LocalTranslations[i];
-						transform.GetTransform().Rotation = glm::eulerAngles(animation.Context.LocalRotations[i]);
-						transform.GetTransform().Scale = animation.Context.LocalScales[i];
+						const entt::entity skinningSpace = SkinningSpaceEntity(entity, transformStorage, relationshipStorage);
+						queue.SubmitSkinnedMesh(meshComponent.Mesh, meshComponent.MaterialAsset, transformStorage.get(skinningSpace)->WorldTransform, meshComponent.SkinningPalette, meshComponent.OverrideMaterial);
+						return;
 					}
-					return true;
-				}));
-			}
+					meshComponent.BoneTransforms.resize(meshComponent.BoneEntities.size());
+					for (size_t i = 0; i < meshComponent.BoneEntities.size(); ++i)
+					{
+						const entt::entity boneEntity = meshComponent.BoneEntities[i];
+						meshComponent.BoneTransforms[i] = Utils::Float4x4FromMat4(transformStorage.get(boneEntity)->WorldTransform);
+					}
+					Ref<MeshSource> meshSource = meshComponent.Mesh->GetMeshSource();
+					queue.SubmitMesh(meshComponent.Mesh, meshComponent.MaterialAsset, meshSource->GetSubmeshTransform(), meshComponent.BoneTransforms, meshComponent.OverrideMaterial);
+				});
+
+				ForEachInPartition(particleRendererStorage, partition, partitionCount, [&](entt::entity entity, ParticleRenderer& renderer) {
+					if (!transformStorage.contains(entity) || !particleStorage.contains(entity))
+						return;
+					if (checkAssets && (!IsAssetValid(renderer.Mesh) || !IsAssetValid(renderer.MaterialAsset)))
+						return;
+
+					const auto& renderData = particleStorage.get(entity).GetSystem()->GetRenderData();
+					queue.SubmitMesh(
+						renderer.Mesh, renderer.MaterialAsset,
+						renderData.ParticleData.data(),
+						renderData.ParticleCount,
+						sizeof(ParticleRenderData),
+						renderer.OverrideMaterial
+					);
+				});
+			});
 		}
-		for (auto& future : futures)
-			future.wait();
+		threadPool.Wait(counter);
 	}
 
 	void Scene::updateParticleView(Timestep ts)
@@ -729,15 +1259,116 @@ namespace XYZ {
 	void Scene::updateRigidBody2DView()
 	{
 		XYZ_PROFILE_FUNC("Scene::updateRigidBody2DView");
-		auto rigidView = m_Registry.view<TransformComponent, RigidBody2DComponent>();
-		for (const auto entity : rigidView)
+		m_PhysicsWorld.Wait();
+		// Physics thread is idle until next StepAsync, statistics are copied for ImGui
+		m_PhysicsStepCount = m_PhysicsWorld.GetLastStepCount();
+		m_AwakeBodyCount = static_cast<uint32_t>(m_PhysicsWorld.GetBodyStates().size());
+
+		// Only bodies awake during last step are copied, sleeping ones keep their transform
+		auto& transformStorage = m_Registry.storage<TransformComponent>();
+		auto& renderTransformStorage = m_Registry.storage<RenderTransformComponent>();
+		uint32_t updatedCount = 0;
+		const float alpha = m_PhysicsWorld.GetInterpolationAlpha();
+		for (const auto& state : m_PhysicsWorld.GetBodyStates())
+		{
+			const SceneEntity* sceneEntity = reinterpret_cast<const SceneEntity*>(state.UserData);
+			if (!sceneEntity || !transformStorage.contains(sceneEntity->ID()))
+				continue;
+
+			TransformComponent& transformComponent = transformStorage.get(sceneEntity->ID());
+			auto& transform = transformComponent.GetTransform();
+			transform.Translation.x = state.Position.x;
+			transform.Translation.y = state.Position.y;
+			transform.Rotation.z = state.Angle;
+
+			TransformComponent interpolated(transformComponent);
+			interpolated.GetTransform().Translation.x = glm::mix(state.PreviousPosition.x, state.Position.x, alpha);
+			interpolated.GetTransform().Translation.y = glm::mix(state.PreviousPosition.y, state.Position.y, alpha);
+			interpolated.GetTransform().Rotation.z = glm::mix(state.PreviousAngle, state.Angle, alpha);
+
+			auto& renderTransform = m_Registry.emplace_or_replace<RenderTransformComponent>(sceneEntity->ID());
+			renderTransform.LocalOffset = glm::inverse(transformComponent.GetLocalTransform()) * interpolated.GetLocalTransform();
+			updatedCount++;
+		}
+		if (renderTransformStorage.size() == updatedCount)
+			return;
+
+		// Some bodies went to sleep since last step, their render transform is removed
+		std::fill(m_AwakeBodyMask.begin(), m_AwakeBodyMask.end(), 0);
+		for (const auto& state : m_PhysicsWorld.GetBodyStates())
+		{
+			const SceneEntity* sceneEntity = reinterpret_cast<const SceneEntity*>(state.UserData);
+			if (!sceneEntity || !renderTransformStorage.contains(sceneEntity->ID()))
+				continue;
+			const size_t index = static_cast<size_t>(entt::to_entity(sceneEntity->ID()));
+			if (index >= m_AwakeBodyMask.size())
+				m_AwakeBodyMask.resize(index + 1, 0);
+			m_AwakeBodyMask[index] = 1;
+		}
+		std::vector<entt::entity> asleep;
+		const entt::entity* entities = renderTransformStorage.data();
+		for (size_t i = 0; i < renderTransformStorage.size(); ++i)
 		{
-			auto [transform, rigidBody] = rigidView.get<TransformComponent, RigidBody2DComponent>(entity);
-			const b2Body* body = static_cast<b2Body*>(rigidBody.RuntimeBody);
-			transform.GetTransform().Translation.x = body->GetPosition().x;
-			transform.GetTransform().Translation.y = body->GetPosition().y;
-			transform.GetTransform().Rotation.z = body->GetAngle();
+			const entt::entity entity = entities[i];
+			const size_t index = static_cast<size_t>(entt::to_entity(entity));
+			if (index >= m_AwakeBodyMask.size() || !m_AwakeBodyMask[index])
+				asleep.push_back(entity);
 		}
+		m_Registry.remove<RenderTransformComponent>(asleep.begin(), asleep.end());
+	}
+
+	void Scene::updateRenderTransforms()
+	{
+		XYZ_PROFILE_FUNC("Scene::updateRenderTransforms");
+		// Children of bodies follow simulated pose
+		auto view = m_Registry.view<const TransformComponent, RenderTransformComponent>();
+		for (auto entity : view)
+		{
+			auto [transform, renderTransform] = view.get<const TransformComponent, RenderTransformComponent>(entity);
+			renderTransform.WorldTransform = transform->WorldTransform * renderTransform.LocalOffset;
+		}
+	}
+
+	void Scene::dispatchContactEvents()
+	{
+		XYZ_PROFILE_FUNC("Scene::dispatchContactEvents");
+		// Step is finished, events recorded during all substeps are dispatched at once
+		const auto& events = m_ContactListener.GetEvents();
+		m_ContactEventCount = static_cast<uint32_t>(events.size());
+		if (events.empty())
+			return;
+
+		auto& scriptStorage = m_Registry.storage<ScriptComponent>();
+		auto hasScript = [&](entt::entity entity) {
+			return m_Registry.valid(entity) && scriptStorage.contains(entity) && !scriptStorage.get(entity).ModuleName.empty();
+		};
+
+		std::shared_lock lock(m_ScriptMutex);
+		for (const ContactEvent& event : events)
+		{
+			const SceneEntity* entityA = reinterpret_cast<const SceneEntity*>(event.UserDataA);
+			const SceneEntity* entityB = reinterpret_cast<const SceneEntity*>(event.UserDataB);
+			if (!entityA || !entityB)
+				continue;
+
+			const bool scriptA = hasScript(entityA->ID());
+			const bool scriptB = hasScript(entityB->ID());
+			if (event.Type == ContactEventType::Begin)
+			{
+				if (scriptA)
+					ScriptEngine::OnCollisionBegin(*entityA, *entityB);
+				if (scriptB)
+					ScriptEngine::OnCollisionBegin(*entityB, *entityA);
+			}
+			else
+			{
+				if (scriptA)
+					ScriptEngine::OnCollisionEnd(*entityA, *entityB);
+				if (scriptB)
+					ScriptEngine::OnCollisionEnd(*entityB, *entityA);
+			}
+		}
+		m_ContactListener.Clear();
 	}
 
 	void Scene::setupPhysics()
@@ -745,10 +1376,7 @@ namespace XYZ {
 		auto rigidBodyView = m_Registry.view<RigidBody2DComponent>();
 		m_PhysicsEntityBuffer = new SceneEntity[rigidBodyView.size()];
 		b2World& physicsWorld = m_PhysicsWorld.GetWorld();
-		const PhysicsWorld2D::Layer defaultLayer = m_PhysicsWorld.GetLayer(PhysicsWorld2D::DefaultLayer);
 		b2FixtureDef fixture;
-		fixture.filter.categoryBits = defaultLayer.m_CollisionMask.to_ulong();
-		fixture.filter.maskBits = BIT(defaultLayer.m_ID);
 
 		size_t counter = 0;
 		for (auto ent : rigidBodyView)
@@ -770,10 +1398,14 @@ namespace XYZ {
 			
 			bodyDef.position.Set(translation.x, translation.y);
 			bodyDef.angle = transform->Rotation.z;
+			m_PhysicsEntityBuffer[counter] = entity;
 			bodyDef.userData.pointer = reinterpret_cast<uintptr_t>(&m_PhysicsEntityBuffer[counter]);
 			
 			b2Body* body = physicsWorld.CreateBody(&bodyDef);
 			rigidBody.RuntimeBody = body;
+
+			XYZ_ASSERT(rigidBody.Layer < PhysicsWorld2D::sc_NumCollisionLayers, "Invalid collision layer");
+			m_PhysicsWorld.ApplyLayer(fixture, rigidBody.Layer);
 			
 			if (entity.HasComponent<BoxCollider2DComponent>())
 			{
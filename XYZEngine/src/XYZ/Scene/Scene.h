@@ -11,13 +11,18 @@
 
 #include "XYZ/Utils/DataStructures/ThreadPass.h"
 #include "XYZ/Asset/Asset.h"
+#include "XYZ/Asset/AssetStreamer.h"
 #include "XYZ/Asset/Animation/AnimationController.h"
 #include "XYZ/Asset/Renderer/MeshSource.h"
 #include "XYZ/Renderer/Mesh.h"
+#include "XYZ/Renderer/CullingBounds.h"
 #include "XYZ/Particle/GPU/ParticleSystemGPU.h"
 
 #include "SceneCamera.h"
 #include "GPUScene.h"
+#include "TransformHierarchy.h"
+#include "AnimationScheduler.h"
+#include "SceneBVH.h"
 
 #include <entt/entt.hpp>
 
@@ -73,7 +78,7 @@ namespace XYZ {
         void DestroyEntity(SceneEntity entity);
         void SetState(SceneState state) { m_State = state; }
         void SetViewportSize(uint32_t width, uint32_t height);
-        void SetSelectedEntity(entt::entity ent) { m_SelectedEntity = ent; }
+        void SetSelectedEntity(entt::entity ent) { m_SelectedEntity = ent; m_BoneObserversDirty = true; }
 
         void OnPlay();
         void OnStop();
@@ -85,6 +90,10 @@ namespace XYZ {
         
         void OnImGuiRender();
 
+        // Mesh component gets mesh once it is loaded, visible and closer meshes are loaded first
+        void StreamMesh(SceneEntity entity, const AssetHandle& meshHandle);
+        void WaitForStreamedMeshes();
+
         SceneEntity GetEntityByName(const std::string& name);
         SceneEntity GetEntityByGUID(const GUID& guid);
         SceneEntity GetSceneEntity();
@@ -96,6 +105,7 @@ namespace XYZ {
         inline SceneState  GetState() const { return m_State; }
         inline const GUID& GetUUID() const { return m_UUID; }
         inline const std::string& GetName() const { return m_Name; }
+        inline uint32_t    GetContactEventCount() const { return m_ContactEventCount; }
 
 
         virtual AssetType GetAssetType() const override { return AssetType::Scene; }
@@ -106,20 +116,32 @@ namespace XYZ {
     private:
         void onScriptComponentConstruct(entt::registry& reg, entt::entity ent);
         void onScriptComponentDestruct(entt::registry& reg, entt::entity ent);
+        void onRelationshipUpdate(entt::registry& reg, entt::entity ent);
+        void onTransformComponentDestruct(entt::registry& reg, entt::entity ent);
+        void onBoneObserverChange(entt::registry& reg, entt::entity ent);
+        void onRenderableChange(entt::registry& reg, entt::entity ent);
+        void connectHierarchySignals();
   
 
         void updateScripts(Timestep ts);
         void updateHierarchy();      
         void updateHierarchyAsync();
-        void updateSubHierarchy(entt::entity parent);
+        void updateSceneBVH();
 
 
+        void updateBoneObservers();
         void updateAnimationView(Timestep ts);
         void updateAnimationViewAsync(Timestep ts);
 
+        void updateStreamedMeshes(SceneRenderer& sceneRenderer);
+        void cullRenderables(SceneRenderer& sceneRenderer);
+        void submitRenderAsync(SceneRenderer& sceneRenderer, bool checkAssets);
+
         void updateParticleView(Timestep ts);
         void updateGPUParticleView(Timestep ts);
         void updateRigidBody2DView();
+        void updateRenderTransforms();
+        void dispatchContactEvents();
 
        
         void setupPhysics();
@@ -129,8 +151,32 @@ namespace XYZ {
         PhysicsWorld2D      m_PhysicsWorld;
         ContactListener     m_ContactListener;
         SceneEntity*        m_PhysicsEntityBuffer;
+        uint32_t            m_ContactEventCount = 0; // Events dispatched last frame
+        uint32_t            m_PhysicsStepCount = 0;  // Copied after physics thread finished, read by ImGui
+        uint32_t            m_AwakeBodyCount = 0;
+        std::vector<uint8_t> m_AwakeBodyMask;        // Indexed by entity, reused between frames
         LightEnvironment    m_LightEnvironment;
         GPUScene            m_GPUScene;
+        TransformHierarchy  m_TransformHierarchy; // Must outlive registry
+        CullingBounds       m_CullingBounds;
+        AnimationScheduler  m_AnimationScheduler;
+        SceneBVH            m_SceneBVH; // Invalidated by hierarchy update and renderable changes, updated by first query
+        glm::vec3           m_AnimationViewPosition = glm::vec3(0.0f); // Position of last rendered view, used by animation lod
+
+        // Indexed same as mesh component storages
+        std::vector<uint8_t> m_MeshVisibility;
+        std::vector<uint8_t> m_AnimatedMeshVisibility;
+        // Indexed by entity, holds entities culled in last rendered frame. Animation runs before next cull, storage may be reordered by then
+        std::vector<entt::entity> m_CulledAnimatedMeshes;
+
+        struct StreamedMesh
+        {
+            AssetFuture<StaticMesh>   Future;
+            float                     Priority = 0.0f;
+            std::vector<entt::entity> Entities;
+        };
+        std::unordered_map<AssetHandle, StreamedMesh> m_StreamedMeshes;
+        std::vector<uint8_t>                          m_StreamedMeshVisibility;
 
         entt::registry      m_Registry;
         GUID                m_UUID;
@@ -148,14 +194,17 @@ namespace XYZ {
 
         std::shared_mutex m_ScriptMutex;
         
+        bool  m_BoneObserversDirty = true;
         bool  m_UpdateAnimationAsync = false;
         bool  m_UpdateHierarchyAsync = false;
+        bool  m_SubmitRenderAsync = false;
 
 
         friend SceneRenderer;
         friend class SceneIntersection;
         friend class SceneEntity;
         friend class SceneSerializer;
+        friend class SceneBinarySerializer;
         friend class ScriptEngine;
         friend class LuaEntity;
         friend class Editor::SceneHierarchyPanel;
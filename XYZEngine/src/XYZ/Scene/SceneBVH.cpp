@@ -0,0 +1,124 @@
+#include "stdafx.h"
+#include "SceneBVH.h"
+
+#include "Components.h"
+
+#include "XYZ/Debug/Profiler.h"
+
+namespace XYZ {
+
+	void SceneBVH::Update(entt::registry& registry)
+	{
+		if (!m_Dirty)
+			return;
+
+		XYZ_PROFILE_FUNC("SceneBVH::Update");
+		auto& transformStorage = registry.storage<TransformComponent>();
+		auto& relationshipStorage = registry.storage<Relationship>();
+		auto& meshStorage = registry.storage<MeshComponent>();
+		auto& animMeshStorage = registry.storage<AnimatedMeshComponent>();
+		auto& spriteStorage = registry.storage<SpriteRenderer>();
+
+		m_Dirty = false;
+		size_t count = 0;
+
+		// Storages keep their order while entities only move, so entries are matched by position
+		for (auto entity : animMeshStorage)
+		{
+			const AnimatedMeshComponent& animMesh = animMeshStorage.get(entity);
+			if (!transformStorage.contains(entity) || !animMesh.Mesh.Raw() || !animMesh.Mesh->IsValid())
+				continue;
+
+			// Bind pose triangles are in space of parent, same as bounds used by culling
+			entt::entity skinningSpace = entity;
+			if (relationshipStorage.contains(entity))
+			{
+				const entt::entity parent = relationshipStorage.get(entity).GetParent();
+				if (registry.valid(parent) && transformStorage.contains(parent))
+					skinningSpace = parent;
+			}
+			const Ref<MeshSource>& source = animMesh.Mesh->GetMeshSource();
+			const glm::mat4 transform = transformStorage.get(skinningSpace)->WorldTransform * source->GetSubmeshTransform();
+			updateEntry(count++, entity, transform, source.Raw(), source->GetSubmeshBoundingBox());
+		}
+		for (auto entity : meshStorage)
+		{
+			const MeshComponent& mesh = meshStorage.get(entity);
+			if (!transformStorage.contains(entity) || animMeshStorage.contains(entity) || !mesh.Mesh.Raw() || !mesh.Mesh->IsValid())
+				continue;
+
+			const Ref<MeshSource>& source = mesh.Mesh->GetMeshSource();
+			updateEntry(count++, entity, transformStorage.get(entity)->WorldTransform, source.Raw(), source->GetSubmeshBoundingBox());
+		}
+		for (auto entity : spriteStorage)
+		{
+			if (!transformStorage.contains(entity) || animMeshStorage.contains(entity) || meshStorage.contains(entity))
+				continue;
+
+			const AABB quad(glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.5f, 0.5f, 0.0f));
+			updateEntry(count++, entity, transformStorage.get(entity)->WorldTransform, nullptr, quad);
+		}
+
+		while (m_Entries.size() > count)
+		{
+			m_Tree.Remove(m_Proxies.back());
+			m_Entries.pop_back();
+			m_Bounds.pop_back();
+			m_Proxies.pop_back();
+		}
+		// Scene does not use pairs of moved proxies
+		m_Tree.CleanMovedNodes();
+	}
+
+	void SceneBVH::Clear()
+	{
+		for (const int32_t proxy : m_Proxies)
+			m_Tree.Remove(proxy);
+		m_Entries.clear();
+		m_Bounds.clear();
+		m_Proxies.clear();
+		m_Dirty = true;
+	}
+
+	void SceneBVH::updateEntry(size_t index, entt::entity entity, const glm::mat4& transform, const MeshSource* source, const AABB& localBounds)
+	{
+		if (index >= m_Entries.size())
+		{
+			m_Entries.push_back({ entt::null, glm::mat4(0.0f), glm::mat4(0.0f), nullptr });
+			m_Bounds.emplace_back();
+			m_Proxies.push_back(NULL_NODE);
+		}
+
+		Entry& entry = m_Entries[index];
+		const bool replaced = entry.Entity != entity || entry.Source != source;
+		if (!replaced && entry.Transform == transform)
+			return;
+
+		entry.Entity = entity;
+		entry.Source = source;
+		entry.Transform = transform;
+		entry.InverseTransform = glm::inverse(transform);
+
+		// Extents of transformed box are projections of local extents on world axes
+		const glm::vec3 localCenter = (localBounds.Min + localBounds.Max) * 0.5f;
+		const glm::vec3 localExtents = (localBounds.Max - localBounds.Min) * 0.5f;
+		const glm::vec3 center = glm::vec3(transform * glm::vec4(localCenter, 1.0f));
+		const glm::vec3 extents =
+			  glm::abs(glm::vec3(transform[0])) * localExtents.x
+			+ glm::abs(glm::vec3(transform[1])) * localExtents.y
+			+ glm::abs(glm::vec3(transform[2])) * localExtents.z;
+
+		const AABB bounds(center - extents, center + extents);
+		if (m_Proxies[index] == NULL_NODE)
+		{
+			m_Proxies[index] = m_Tree.Insert(static_cast<uint32_t>(index), bounds);
+		}
+		else
+		{
+			// Displacement predicts movement only for the same entity
+			const glm::vec3 previousCenter = (m_Bounds[index].Min + m_Bounds[index].Max) * 0.5f;
+			m_Tree.Move(m_Proxies[index], bounds, replaced ? glm::vec3(0.0f) : center - previousCenter);
+		}
+		m_Bounds[index] = bounds;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+#include "XYZ/Asset/Renderer/MeshSource.h"
+#include "XYZ/Utils/DataStructures/DynamicTree.h"
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+namespace XYZ {
+
+	// Dynamic tree over world bounds of meshes and sprites. Entities are inserted, moved and removed
+	// incrementally, small movement stays inside fattened bounds and does not touch the tree
+	class XYZ_API SceneBVH
+	{
+	public:
+		struct Entry
+		{
+			entt::entity	  Entity;
+			glm::mat4		  Transform;		// Mesh space to world
+			glm::mat4		  InverseTransform;
+			const MeshSource* Source;			// Null for sprites, valid until next update
+		};
+
+		// Does nothing until invalidated, so queries between frames share one update
+		void Update(entt::registry& registry);
+		void Clear();
+		void Invalidate() { m_Dirty = true; }
+
+		// Calls func(entry, worldBounds, maxDistance) for entities in leaves hit by ray
+		template <typename Func>
+		void Raycast(const Ray& ray, float maxDistance, Func&& func) const
+		{
+			m_Tree.RayCast(ray, maxDistance, [&](int32_t proxy, float& distance) {
+				const uint32_t index = m_Tree.GetDataIndex(proxy);
+				func(m_Entries[index], m_Bounds[index], distance);
+			});
+		}
+
+		// Calls func(entry, worldBounds) for entities in leaves overlapping aabb
+		template <typename Func>
+		void Query(const AABB& aabb, Func&& func) const
+		{
+			m_Tree.Query(aabb, [&](int32_t proxy) {
+				const uint32_t index = m_Tree.GetDataIndex(proxy);
+				func(m_Entries[index], m_Bounds[index]);
+				return true;
+			});
+		}
+
+		const std::vector<Entry>& GetEntries() const { return m_Entries; }
+		const DynamicTree&		  GetTree()	   const { return m_Tree; }
+		bool					  IsDirty()	   const { return m_Dirty; }
+
+	private:
+		void updateEntry(size_t index, entt::entity entity, const glm::mat4& transform, const MeshSource* source, const AABB& localBounds);
+
+	private:
+		std::vector<Entry>	 m_Entries;
+		std::vector<AABB>	 m_Bounds;	// Exact world bounds, tree stores fattened ones
+		std::vector<int32_t> m_Proxies;
+		DynamicTree			 m_Tree;
+
+		bool m_Dirty = true;
+	};
+}
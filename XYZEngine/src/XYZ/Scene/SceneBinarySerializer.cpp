@@ -0,0 +1,996 @@
+#include "stdafx.h"
+#include "SceneBinarySerializer.h"
+#include "SceneSerializer.h"
+
+#include "XYZ/Scene/SceneEntity.h"
+#include "XYZ/Asset/AssetManager.h"
+#include "XYZ/Core/Application.h"
+#include "XYZ/Debug/Profiler.h"
+#include "XYZ/Utils/MappedFile.h"
+
+namespace XYZ {
+
+	namespace {
+
+		constexpr char	   sc_Magic[4] = { 'X', 'Y', 'Z', 'B' };
+		constexpr uint32_t sc_NullIndex = UINT32_MAX;
+		constexpr uint64_t sc_SectionAlignment = 16;
+
+		enum class ChunkType : uint32_t
+		{
+			SceneTag,
+			Transform,
+			Relationship,
+			SpriteRenderer,
+			Mesh,
+			AnimatedMesh,
+			Animation,
+			ParticleRenderer,
+			Camera,
+			PointLight2D,
+			SpotLight2D,
+			PointLight3D,
+			RigidBody2D,
+			BoxCollider2D,
+			CircleCollider2D,
+			ChainCollider2D,
+			Yaml
+		};
+		constexpr uint32_t sc_ChunkTypeCount = static_cast<uint32_t>(ChunkType::Yaml) + 1;
+
+		struct BinaryGUID
+		{
+			uint64_t Data[2];
+		};
+
+		struct StringRef
+		{
+			uint32_t Offset;
+			uint32_t Size;
+		};
+
+		// Offset in bytes to chunk payload
+		struct ArrayRef
+		{
+			uint32_t Offset;
+			uint32_t Count;
+		};
+
+		struct FileHeader
+		{
+			char	  Magic[4];
+			uint32_t  Version;
+			uint32_t  EntityCount;
+			uint32_t  ChunkCount;
+			StringRef SceneName;
+			uint32_t  SceneFirstChild;
+			uint32_t  Padding;
+			uint64_t  GUIDTableOffset;
+			uint64_t  StringTableOffset;
+			uint64_t  StringTableSize;
+			uint64_t  ChunkTableOffset;
+		};
+
+		struct ChunkHeader
+		{
+			ChunkType Type;
+			uint32_t  Count;
+			uint32_t  RecordSize;
+			uint32_t  Padding;
+			uint64_t  EntitiesOffset;
+			uint64_t  RecordsOffset;
+			uint64_t  PayloadOffset;
+			uint64_t  PayloadSize;
+		};
+
+		struct TagRecord
+		{
+			StringRef Name;
+		};
+
+		struct TransformRecord
+		{
+			glm::vec3 Translation;
+			glm::vec3 Rotation;
+			glm::vec3 Scale;
+		};
+
+		struct RelationshipRecord
+		{
+			uint32_t Parent;
+			uint32_t FirstChild;
+			uint32_t PreviousSibling;
+			uint32_t NextSibling;
+			uint32_t Depth;
+		};
+
+		struct SpriteRendererRecord
+		{
+			BinaryGUID Material;
+			BinaryGUID SubTexture;
+			glm::vec4  Color;
+			uint32_t   SortLayer;
+			uint32_t   Visible;
+		};
+
+		struct MeshRecord
+		{
+			BinaryGUID Mesh;
+			BinaryGUID Material;
+		};
+
+		struct AnimatedMeshRecord
+		{
+			BinaryGUID Mesh;
+			BinaryGUID Material;
+			ArrayRef   BoneEntities;
+		};
+
+		struct AnimationRecord
+		{
+			BinaryGUID Controller;
+			uint32_t   UpdateBoneEntities;
+			uint32_t   Playing;
+		};
+
+		struct CameraRecord
+		{
+			uint32_t					 ProjectionType;
+			CameraPerspectiveProperties  Perspective;
+			CameraOrthographicProperties Orthographic;
+		};
+
+		struct PointLight2DRecord
+		{
+			glm::vec3 Color;
+			float	  Radius;
+			float	  Intensity;
+		};
+
+		struct SpotLight2DRecord
+		{
+			glm::vec3 Color;
+			float	  Radius;
+			float	  Intensity;
+			float	  InnerAngle;
+			float	  OuterAngle;
+		};
+
+		struct PointLight3DRecord
+		{
+			glm::vec3 Radiance;
+			float	  Intensity;
+			float	  LightSize;
+			float	  MinRadius;
+			float	  Radius;
+			float	  Falloff;
+			uint32_t  CastsShadows;
+			uint32_t  SoftShadows;
+		};
+
+		struct RigidBody2DRecord
+		{
+			uint32_t Type;
+			uint32_t Layer;
+		};
+
+		struct BoxCollider2DRecord
+		{
+			glm::vec2 Size;
+			glm::vec2 Offset;
+			float	  Density;
+			float	  Friction;
+		};
+
+		struct CircleCollider2DRecord
+		{
+			glm::vec2 Offset;
+			float	  Radius;
+			float	  Density;
+			float	  Friction;
+		};
+
+		struct ChainCollider2DRecord
+		{
+			ArrayRef Points;
+			float	 Density;
+			float	 Friction;
+			uint32_t InvertNormals;
+		};
+
+		struct YamlRecord
+		{
+			StringRef Source;
+		};
+
+
+		BinaryGUID ToBinary(const GUID& guid)
+		{
+			return { guid.GetData()[0], guid.GetData()[1] };
+		}
+		GUID FromBinary(const BinaryGUID& guid)
+		{
+			return GUID(guid.Data[0], guid.Data[1]);
+		}
+		// Zero guid stands for missing asset
+		bool IsNull(const BinaryGUID& guid)
+		{
+			return guid.Data[0] == 0 && guid.Data[1] == 0;
+		}
+		template <typename T>
+		BinaryGUID AssetToBinary(const Ref<T>& asset)
+		{
+			if (asset.Raw())
+				return ToBinary(asset->GetHandle());
+			return { 0, 0 };
+		}
+
+		uint64_t AlignSection(uint64_t offset)
+		{
+			return (offset + sc_SectionAlignment - 1) & ~(sc_SectionAlignment - 1);
+		}
+
+
+		class BinaryWriter
+		{
+		public:
+			uint64_t Write(const void* data, size_t size)
+			{
+				const uint64_t offset = m_Buffer.size();
+				const uint8_t* bytes = static_cast<const uint8_t*>(data);
+				m_Buffer.insert(m_Buffer.end(), bytes, bytes + size);
+				return offset;
+			}
+			template <typename T>
+			uint64_t WriteArray(const std::vector<T>& values)
+			{
+				Align();
+				return Write(values.data(), values.size() * sizeof(T));
+			}
+			template <typename T>
+			void Patch(uint64_t offset, const T& value)
+			{
+				memcpy(&m_Buffer[offset], &value, sizeof(T));
+			}
+			void Align()
+			{
+				m_Buffer.resize(AlignSection(m_Buffer.size()), 0);
+			}
+
+			const std::vector<uint8_t>& GetBuffer() const { return m_Buffer; }
+		private:
+			std::vector<uint8_t> m_Buffer;
+		};
+
+
+		class StringTable
+		{
+		public:
+			StringRef Add(const std::string& value)
+			{
+				auto it = m_Lookup.find(value);
+				if (it != m_Lookup.end())
+					return it->second;
+
+				const StringRef ref{ static_cast<uint32_t>(m_Data.size()), static_cast<uint32_t>(value.size()) };
+				m_Data.insert(m_Data.end(), value.begin(), value.end());
+				m_Lookup.emplace(value, ref);
+				return ref;
+			}
+			const std::vector<char>& GetData() const { return m_Data; }
+
+		private:
+			std::vector<char>					       m_Data;
+			std::unordered_map<std::string, StringRef> m_Lookup;
+		};
+
+
+		struct ChunkData
+		{
+			ChunkType			  Type;
+			uint32_t			  RecordSize;
+			std::vector<uint32_t> Entities;
+			std::vector<uint8_t>  Records;
+			std::vector<uint8_t>  Payload;
+
+			template <typename T>
+			ArrayRef AddPayload(const T* data, size_t count)
+			{
+				const ArrayRef ref{ static_cast<uint32_t>(Payload.size()), static_cast<uint32_t>(count) };
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+				Payload.insert(Payload.end(), bytes, bytes + count * sizeof(T));
+				return ref;
+			}
+		};
+
+		using EntityIndexMap = std::unordered_map<entt::entity, uint32_t>;
+
+		uint32_t IndexOf(const EntityIndexMap& indices, entt::entity entity)
+		{
+			auto it = indices.find(entity);
+			if (it != indices.end())
+				return it->second;
+			return sc_NullIndex;
+		}
+
+		template <typename Component, typename Record, typename Func>
+		void BuildChunk(std::vector<ChunkData>& chunks, ChunkType type, const entt::registry& reg, const EntityIndexMap& indices, Func&& func)
+		{
+			ChunkData chunk{ type, static_cast<uint32_t>(sizeof(Record)) };
+			auto view = reg.view<const Component>();
+			for (const entt::entity entity : view)
+			{
+				const uint32_t index = IndexOf(indices, entity);
+				// Scene entity components are created by scene itself
+				if (index == sc_NullIndex || index == 0)
+					continue;
+
+				const Record record = func(view.template get<const Component>(entity), chunk);
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+				chunk.Entities.push_back(index);
+				chunk.Records.insert(chunk.Records.end(), bytes, bytes + sizeof(Record));
+			}
+			if (!chunk.Entities.empty())
+				chunks.push_back(std::move(chunk));
+		}
+
+
+		struct ChunkView
+		{
+			const ChunkHeader* Header;
+			const uint32_t*    Entities;
+			const uint8_t*     Records;
+			const uint8_t*     Payload;
+
+			template <typename T>
+			const T* GetRecords() const
+			{
+				XYZ_ASSERT(Header->RecordSize == sizeof(T), "Chunk record size does not match");
+				return reinterpret_cast<const T*>(Records);
+			}
+			// Returns nullptr if array is out of payload range
+			template <typename T>
+			const T* GetPayload(const ArrayRef& ref) const
+			{
+				if (ref.Offset % alignof(T) != 0
+				 || ref.Offset + static_cast<uint64_t>(ref.Count) * sizeof(T) > Header->PayloadSize)
+					return nullptr;
+				return reinterpret_cast<const T*>(Payload + ref.Offset);
+			}
+		};
+
+		bool InRange(uint64_t offset, uint64_t size, uint64_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+
+		// Zero for unknown chunk types, they are skipped on load
+		uint32_t RecordSizeOf(ChunkType type)
+		{
+			switch (type)
+			{
+			case ChunkType::SceneTag:		  return sizeof(TagRecord);
+			case ChunkType::Transform:		  return sizeof(TransformRecord);
+			case ChunkType::Relationship:	  return sizeof(RelationshipRecord);
+			case ChunkType::SpriteRenderer:	  return sizeof(SpriteRendererRecord);
+			case ChunkType::Mesh:			  return sizeof(MeshRecord);
+			case ChunkType::AnimatedMesh:	  return sizeof(AnimatedMeshRecord);
+			case ChunkType::Animation:		  return sizeof(AnimationRecord);
+			case ChunkType::ParticleRenderer: return sizeof(MeshRecord);
+			case ChunkType::Camera:			  return sizeof(CameraRecord);
+			case ChunkType::PointLight2D:	  return sizeof(PointLight2DRecord);
+			case ChunkType::SpotLight2D:	  return sizeof(SpotLight2DRecord);
+			case ChunkType::PointLight3D:	  return sizeof(PointLight3DRecord);
+			case ChunkType::RigidBody2D:	  return sizeof(RigidBody2DRecord);
+			case ChunkType::BoxCollider2D:	  return sizeof(BoxCollider2DRecord);
+			case ChunkType::CircleCollider2D: return sizeof(CircleCollider2DRecord);
+			case ChunkType::ChainCollider2D:  return sizeof(ChainCollider2DRecord);
+			case ChunkType::Yaml:			  return sizeof(YamlRecord);
+			}
+			return 0;
+		}
+
+		// Seen arrays are shared by all chunks of file, entity can own component only once
+		bool ValidateChunk(const ChunkHeader& chunk, uint32_t entityCount, const uint8_t* data, uint64_t fileSize, std::array<bool, sc_ChunkTypeCount>& seenTypes, std::vector<uint8_t>& seenEntities)
+		{
+			const uint32_t recordSize = RecordSizeOf(chunk.Type);
+			if (recordSize != 0 && chunk.RecordSize != recordSize)
+				return false;
+			if (recordSize != 0)
+			{
+				bool& seen = seenTypes[static_cast<uint32_t>(chunk.Type)];
+				if (seen)
+					return false;
+				seen = true;
+			}
+
+			const uint64_t count = chunk.Count;
+			if (!InRange(chunk.EntitiesOffset, count * sizeof(uint32_t), fileSize)
+			 || !InRange(chunk.RecordsOffset, count * chunk.RecordSize, fileSize)
+			 || !InRange(chunk.PayloadOffset, chunk.PayloadSize, fileSize)
+			 || chunk.EntitiesOffset % alignof(uint32_t) != 0
+			 || chunk.RecordsOffset % alignof(uint64_t) != 0
+			 || chunk.PayloadOffset % alignof(uint32_t) != 0)
+				return false;
+
+			const uint32_t* entities = reinterpret_cast<const uint32_t*>(data + chunk.EntitiesOffset);
+			bool valid = true;
+			uint32_t marked = 0;
+			for (; marked < chunk.Count; ++marked)
+			{
+				if (entities[marked] == 0 || entities[marked] >= entityCount || seenEntities[entities[marked]])
+				{
+					valid = false;
+					break;
+				}
+				seenEntities[entities[marked]] = 1;
+			}
+			// Only marked entries are reset, cost stays proportional to chunk size
+			for (uint32_t i = 0; i < marked; ++i)
+				seenEntities[entities[i]] = 0;
+			return valid;
+		}
+
+		// Inserts all components of chunk with single call, entities can not own component yet
+		template <typename Component, typename Record, typename Func>
+		void InsertChunk(entt::registry& reg, const ChunkView& chunk, const std::vector<entt::entity>& entities, Func&& func)
+		{
+			const uint32_t count = chunk.Header->Count;
+			const Record* records = chunk.GetRecords<Record>();
+
+			std::vector<entt::entity> targets;
+			std::vector<Component> components;
+			targets.reserve(count);
+			components.reserve(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				targets.push_back(entities[chunk.Entities[i]]);
+				func(components.emplace_back(), records[i]);
+			}
+			reg.insert<Component>(targets.begin(), targets.end(), std::make_move_iterator(components.begin()));
+		}
+
+
+		// Every unique asset is requested once, loading runs on thread pool
+		template <typename T>
+		class AssetResolver
+		{
+		public:
+			void Request(const BinaryGUID& handle)
+			{
+				if (!IsNull(handle))
+					m_Assets.emplace(FromBinary(handle), Ref<T>());
+			}
+
+			// Caller waits for counter, map is not modified until then
+			void Load(ThreadPool& threadPool, JobCounter& counter)
+			{
+				for (auto& [handle, asset] : m_Assets)
+				{
+					threadPool.PushJob(counter, [assetHandle = handle, result = &asset]() {
+						if (AssetManager::Exist(assetHandle))
+							*result = AssetManager::GetAsset<T>(assetHandle);
+						else
+							XYZ_CORE_WARN("Scene references missing asset {0}", assetHandle.ToString());
+					});
+				}
+			}
+
+			Ref<T> Get(const BinaryGUID& handle) const
+			{
+				if (IsNull(handle))
+					return Ref<T>();
+				return m_Assets.at(FromBinary(handle));
+			}
+		private:
+			std::unordered_map<AssetHandle, Ref<T>> m_Assets;
+		};
+	}
+
+
+	void SceneBinarySerializer::Serialize(const std::string& filepath, WeakRef<Scene> scene)
+	{
+		XYZ_PROFILE_FUNC("SceneBinarySerializer::Serialize");
+		scene->WaitForStreamedMeshes();
+		const entt::registry& reg = scene->m_Registry;
+		const entt::entity sceneEntity = scene->m_SceneEntity;
+
+		std::vector<entt::entity> entities;
+		entities.reserve(reg.alive());
+		entities.push_back(sceneEntity);
+		reg.each([&](const entt::entity entity) {
+			if (entity != sceneEntity)
+				entities.push_back(entity);
+		});
+
+		EntityIndexMap indices;
+		indices.reserve(entities.size());
+		std::vector<BinaryGUID> guids;
+		guids.reserve(entities.size());
+		for (const entt::entity entity : entities)
+		{
+			indices.emplace(entity, static_cast<uint32_t>(guids.size()));
+			guids.push_back(ToBinary(reg.get<IDComponent>(entity).ID));
+		}
+
+		StringTable strings;
+		std::vector<ChunkData> chunks;
+
+		BuildChunk<SceneTagComponent, TagRecord>(chunks, ChunkType::SceneTag, reg, indices, [&](const SceneTagComponent& tag, ChunkData&) {
+			return TagRecord{ strings.Add(tag.Name) };
+		});
+		BuildChunk<TransformComponent, TransformRecord>(chunks, ChunkType::Transform, reg, indices, [](const TransformComponent& transform, ChunkData&) {
+			return TransformRecord{ transform->Translation, transform->Rotation, transform->Scale };
+		});
+		BuildChunk<Relationship, RelationshipRecord>(chunks, ChunkType::Relationship, reg, indices, [&](const Relationship& relationship, ChunkData&) {
+			return RelationshipRecord{
+				IndexOf(indices, relationship.GetParent()),
+				IndexOf(indices, relationship.GetFirstChild()),
+				IndexOf(indices, relationship.GetPreviousSibling()),
+				IndexOf(indices, relationship.GetNextSibling()),
+				relationship.GetDepth()
+			};
+		});
+		BuildChunk<SpriteRenderer, SpriteRendererRecord>(chunks, ChunkType::SpriteRenderer, reg, indices, [](const SpriteRenderer& sprite, ChunkData&) {
+			return SpriteRendererRecord{
+				AssetToBinary(sprite.Material),
+				AssetToBinary(sprite.SubTexture),
+				sprite.Color,
+				sprite.SortLayer,
+				sprite.Visible
+			};
+		});
+		BuildChunk<MeshComponent, MeshRecord>(chunks, ChunkType::Mesh, reg, indices, [](const MeshComponent& mesh, ChunkData&) {
+			return MeshRecord{ AssetToBinary(mesh.Mesh), AssetToBinary(mesh.MaterialAsset) };
+		});
+		BuildChunk<AnimatedMeshComponent, AnimatedMeshRecord>(chunks, ChunkType::AnimatedMesh, reg, indices, [&](const AnimatedMeshComponent& mesh, ChunkData& chunk) {
+			std::vector<uint32_t> bones;
+			bones.reserve(mesh.BoneEntities.size());
+			for (const entt::entity bone : mesh.BoneEntities)
+				bones.push_back(IndexOf(indices, bone));
+
+			return AnimatedMeshRecord{
+				AssetToBinary(mesh.Mesh),
+				AssetToBinary(mesh.MaterialAsset),
+				chunk.AddPayload(bones.data(), bones.size())
+			};
+		});
+		BuildChunk<AnimationComponent, AnimationRecord>(chunks, ChunkType::Animation, reg, indices, [](const AnimationComponent& animation, ChunkData&) {
+			return AnimationRecord{ AssetToBinary(animation.Controller), animation.UpdateBoneEntities ? 1u : 0u, animation.Playing ? 1u : 0u };
+		});
+		BuildChunk<ParticleRenderer, MeshRecord>(chunks, ChunkType::ParticleRenderer, reg, indices, [](const ParticleRenderer& renderer, ChunkData&) {
+			return MeshRecord{ AssetToBinary(renderer.Mesh), AssetToBinary(renderer.MaterialAsset) };
+		});
+		BuildChunk<CameraComponent, CameraRecord>(chunks, ChunkType::Camera, reg, indices, [](const CameraComponent& camera, ChunkData&) {
+			return CameraRecord{
+				static_cast<uint32_t>(camera.Camera.GetProjectionType()),
+				camera.Camera.GetPerspectiveProperties(),
+				camera.Camera.GetOrthographicProperties()
+			};
+		});
+		BuildChunk<PointLightComponent2D, PointLight2DRecord>(chunks, ChunkType::PointLight2D, reg, indices, [](const PointLightComponent2D& light, ChunkData&) {
+			return PointLight2DRecord{ light.Color, light.Radius, light.Intensity };
+		});
+		BuildChunk<SpotLightComponent2D, SpotLight2DRecord>(chunks, ChunkType::SpotLight2D, reg, indices, [](const SpotLightComponent2D& light, ChunkData&) {
+			return SpotLight2DRecord{ light.Color, light.Radius, light.Intensity, light.InnerAngle, light.OuterAngle };
+		});
+		BuildChunk<PointLightComponent3D, PointLight3DRecord>(chunks, ChunkType::PointLight3D, reg, indices, [](const PointLightComponent3D& light, ChunkData&) {
+			return PointLight3DRecord{
+				light.Radiance,
+				light.Intensity,
+				light.LightSize,
+				light.MinRadius,
+				light.Radius,
+				light.Falloff,
+				light.CastsShadows,
+				light.SoftShadows
+			};
+		});
+		BuildChunk<RigidBody2DComponent, RigidBody2DRecord>(chunks, ChunkType::RigidBody2D, reg, indices, [](const RigidBody2DComponent& body, ChunkData&) {
+			return RigidBody2DRecord{ static_cast<uint32_t>(body.Type), body.Layer };
+		});
+		BuildChunk<BoxCollider2DComponent, BoxCollider2DRecord>(chunks, ChunkType::BoxCollider2D, reg, indices, [](const BoxCollider2DComponent& collider, ChunkData&) {
+			return BoxCollider2DRecord{ collider.Size, collider.Offset, collider.Density, collider.Friction };
+		});
+		BuildChunk<CircleCollider2DComponent, CircleCollider2DRecord>(chunks, ChunkType::CircleCollider2D, reg, indices, [](const CircleCollider2DComponent& collider, ChunkData&) {
+			return CircleCollider2DRecord{ collider.Offset, collider.Radius, collider.Density, collider.Friction };
+		});
+		BuildChunk<ChainCollider2DComponent, ChainCollider2DRecord>(chunks, ChunkType::ChainCollider2D, reg, indices, [](const ChainCollider2DComponent& collider, ChunkData& chunk) {
+			return ChainCollider2DRecord{
+				chunk.AddPayload(collider.Points.data(), collider.Points.size()),
+				collider.Density,
+				collider.Friction,
+				collider.InvertNormals
+			};
+		});
+		{
+			// Script fields and particle systems are not flat, keep them in yaml
+			ChunkData chunk{ ChunkType::Yaml, static_cast<uint32_t>(sizeof(YamlRecord)) };
+			for (uint32_t i = 1; i < entities.size(); ++i)
+			{
+				const std::string source = SceneSerializer::serializeYamlComponents({ entities[i], scene.Raw() });
+				if (source.empty())
+					continue;
+
+				const YamlRecord record{ strings.Add(source) };
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+				chunk.Entities.push_back(i);
+				chunk.Records.insert(chunk.Records.end(), bytes, bytes + sizeof(YamlRecord));
+			}
+			if (!chunk.Entities.empty())
+				chunks.push_back(std::move(chunk));
+		}
+
+		FileHeader header{};
+		memcpy(header.Magic, sc_Magic, sizeof(sc_Magic));
+		header.Version = sc_Version;
+		header.EntityCount = static_cast<uint32_t>(entities.size());
+		header.ChunkCount = static_cast<uint32_t>(chunks.size());
+		header.SceneName = strings.Add(scene->m_Name);
+		header.SceneFirstChild = IndexOf(indices, reg.get<Relationship>(sceneEntity).GetFirstChild());
+
+		BinaryWriter writer;
+		writer.Write(&header, sizeof(FileHeader));
+		header.GUIDTableOffset = writer.WriteArray(guids);
+		header.StringTableOffset = writer.WriteArray(strings.GetData());
+		header.StringTableSize = strings.GetData().size();
+
+		std::vector<ChunkHeader> chunkHeaders(chunks.size());
+		header.ChunkTableOffset = writer.WriteArray(chunkHeaders);
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			const ChunkData& chunk = chunks[i];
+			ChunkHeader& chunkHeader = chunkHeaders[i];
+			chunkHeader.Type = chunk.Type;
+			chunkHeader.Count = static_cast<uint32_t>(chunk.Entities.size());
+			chunkHeader.RecordSize = chunk.RecordSize;
+			chunkHeader.EntitiesOffset = writer.WriteArray(chunk.Entities);
+			chunkHeader.RecordsOffset = writer.WriteArray(chunk.Records);
+			chunkHeader.PayloadOffset = writer.WriteArray(chunk.Payload);
+			chunkHeader.PayloadSize = chunk.Payload.size();
+		}
+		for (size_t i = 0; i < chunkHeaders.size(); ++i)
+			writer.Patch(header.ChunkTableOffset + i * sizeof(ChunkHeader), chunkHeaders[i]);
+		writer.Patch(0, header);
+
+		const auto& buffer = writer.GetBuffer();
+		std::ofstream fout(filepath, std::ios::binary);
+		fout.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+		fout.flush();
+	}
+
+	Ref<Scene> SceneBinarySerializer::Deserialize(const std::string& filepath)
+	{
+		XYZ_PROFILE_FUNC("SceneBinarySerializer::Deserialize");
+		MappedFile file(filepath);
+		if (!file.IsOpen() || file.GetSize() < sizeof(FileHeader))
+		{
+			XYZ_CORE_ERROR("Failed to map binary scene '{0}'", filepath);
+			return Ref<Scene>();
+		}
+		const uint8_t* data = file.GetData();
+		const uint64_t fileSize = file.GetSize();
+
+		FileHeader header;
+		memcpy(&header, data, sizeof(FileHeader));
+		if (memcmp(header.Magic, sc_Magic, sizeof(sc_Magic)) != 0 || header.Version != sc_Version)
+		{
+			XYZ_CORE_ERROR("Binary scene '{0}' has unsupported version {1}", filepath, header.Version);
+			return Ref<Scene>();
+		}
+		if (header.EntityCount == 0
+		 || !InRange(header.GUIDTableOffset, static_cast<uint64_t>(header.EntityCount) * sizeof(BinaryGUID), fileSize)
+		 || !InRange(header.StringTableOffset, header.StringTableSize, fileSize)
+		 || !InRange(header.ChunkTableOffset, static_cast<uint64_t>(header.ChunkCount) * sizeof(ChunkHeader), fileSize))
+		{
+			XYZ_CORE_ERROR("Binary scene '{0}' is corrupted", filepath);
+			return Ref<Scene>();
+		}
+
+		const BinaryGUID* guids = reinterpret_cast<const BinaryGUID*>(data + header.GUIDTableOffset);
+		const char* strings = reinterpret_cast<const char*>(data + header.StringTableOffset);
+		const ChunkHeader* chunkHeaders = reinterpret_cast<const ChunkHeader*>(data + header.ChunkTableOffset);
+		// Out of range references mark file as corrupted, scene is discarded after chunks are inserted
+		bool corrupted = false;
+		auto getString = [&](const StringRef& ref) {
+			if (static_cast<uint64_t>(ref.Offset) + ref.Size > header.StringTableSize)
+			{
+				corrupted = true;
+				return std::string();
+			}
+			return std::string(strings + ref.Offset, ref.Size);
+		};
+		const std::string sceneName = getString(header.SceneName);
+		if (corrupted)
+		{
+			XYZ_CORE_ERROR("Binary scene '{0}' has corrupted name", filepath);
+			return Ref<Scene>();
+		}
+
+		std::vector<ChunkView> chunks;
+		chunks.reserve(header.ChunkCount);
+		std::array<bool, sc_ChunkTypeCount> seenTypes{};
+		std::vector<uint8_t> seenEntities(header.EntityCount, 0);
+		for (uint32_t i = 0; i < header.ChunkCount; ++i)
+		{
+			const ChunkHeader& chunk = chunkHeaders[i];
+			if (!ValidateChunk(chunk, header.EntityCount, data, fileSize, seenTypes, seenEntities))
+			{
+				XYZ_CORE_ERROR("Binary scene '{0}' has corrupted chunk {1}", filepath, i);
+				return Ref<Scene>();
+			}
+			chunks.push_back({
+				&chunk,
+				reinterpret_cast<const uint32_t*>(data + chunk.EntitiesOffset),
+				data + chunk.RecordsOffset,
+				data + chunk.PayloadOffset
+			});
+		}
+
+		// Request every referenced asset before components are created so they load in parallel, static meshes are streamed
+		AssetResolver<MaterialAsset>	   materials;
+		AssetResolver<SubTexture>		   subTextures;
+		AssetResolver<AnimatedMesh>		   animatedMeshes;
+		AssetResolver<Mesh>				   particleMeshes;
+		AssetResolver<AnimationController> controllers;
+		for (const ChunkView& chunk : chunks)
+		{
+			for (uint32_t i = 0; i < chunk.Header->Count; ++i)
+			{
+				switch (chunk.Header->Type)
+				{
+				case ChunkType::SpriteRenderer:
+					materials.Request(chunk.GetRecords<SpriteRendererRecord>()[i].Material);
+					subTextures.Request(chunk.GetRecords<SpriteRendererRecord>()[i].SubTexture);
+					break;
+				case ChunkType::Mesh:
+					materials.Request(chunk.GetRecords<MeshRecord>()[i].Material);
+					break;
+				case ChunkType::AnimatedMesh:
+					animatedMeshes.Request(chunk.GetRecords<AnimatedMeshRecord>()[i].Mesh);
+					materials.Request(chunk.GetRecords<AnimatedMeshRecord>()[i].Material);
+					break;
+				case ChunkType::ParticleRenderer:
+					particleMeshes.Request(chunk.GetRecords<MeshRecord>()[i].Mesh);
+					materials.Request(chunk.GetRecords<MeshRecord>()[i].Material);
+					break;
+				case ChunkType::Animation:
+					controllers.Request(chunk.GetRecords<AnimationRecord>()[i].Controller);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+		{
+			// Waiting executes other jobs, so scene can be loaded from worker thread too
+			auto& threadPool = Application::Get().GetThreadPool();
+			JobCounter counter;
+			materials.Load(threadPool, counter);
+			subTextures.Load(threadPool, counter);
+			animatedMeshes.Load(threadPool, counter);
+			particleMeshes.Load(threadPool, counter);
+			controllers.Load(threadPool, counter);
+			threadPool.Wait(counter);
+		}
+
+		Ref<Scene> scene = Ref<Scene>::Create(sceneName, FromBinary(guids[0]));
+		entt::registry& reg = scene->m_Registry;
+
+		std::vector<entt::entity> entities(header.EntityCount);
+		entities[0] = scene->m_SceneEntity;
+		reg.create(entities.begin() + 1, entities.end());
+		{
+			std::vector<IDComponent> ids;
+			ids.reserve(header.EntityCount - 1);
+			for (uint32_t i = 1; i < header.EntityCount; ++i)
+				ids.emplace_back(FromBinary(guids[i]));
+			reg.insert<IDComponent>(entities.begin() + 1, entities.end(), std::make_move_iterator(ids.begin()));
+		}
+		auto toEntity = [&](uint32_t index) {
+			return index < entities.size() ? entities[index] : entt::null;
+		};
+		reg.get<Relationship>(scene->m_SceneEntity).FirstChild = toEntity(header.SceneFirstChild);
+
+		std::vector<const ChunkView*> yamlChunks;
+		for (const ChunkView& chunk : chunks)
+		{
+			switch (chunk.Header->Type)
+			{
+			case ChunkType::SceneTag:
+				InsertChunk<SceneTagComponent, TagRecord>(reg, chunk, entities, [&](SceneTagComponent& tag, const TagRecord& record) {
+					tag.Name = getString(record.Name);
+				});
+				break;
+			case ChunkType::Transform:
+				InsertChunk<TransformComponent, TransformRecord>(reg, chunk, entities, [](TransformComponent& transform, const TransformRecord& record) {
+					transform.GetTransform().Translation = record.Translation;
+					transform.GetTransform().Rotation = record.Rotation;
+					transform.GetTransform().Scale = record.Scale;
+				});
+				break;
+			case ChunkType::Relationship:
+				InsertChunk<Relationship, RelationshipRecord>(reg, chunk, entities, [&](Relationship& relationship, const RelationshipRecord& record) {
+					relationship.Parent = toEntity(record.Parent);
+					relationship.FirstChild = toEntity(record.FirstChild);
+					relationship.PreviousSibling = toEntity(record.PreviousSibling);
+					relationship.NextSibling = toEntity(record.NextSibling);
+					relationship.Depth = record.Depth;
+				});
+				break;
+			case ChunkType::SpriteRenderer:
+				InsertChunk<SpriteRenderer, SpriteRendererRecord>(reg, chunk, entities, [&](SpriteRenderer& sprite, const SpriteRendererRecord& record) {
+					sprite.Material = materials.Get(record.Material);
+					sprite.SubTexture = subTextures.Get(record.SubTexture);
+					sprite.Color = record.Color;
+					sprite.SortLayer = record.SortLayer;
+					sprite.Visible = record.Visible != 0;
+				});
+				break;
+			case ChunkType::Mesh:
+				InsertChunk<MeshComponent, MeshRecord>(reg, chunk, entities, [&](MeshComponent& mesh, const MeshRecord& record) {
+					mesh.MaterialAsset = materials.Get(record.Material);
+				});
+				// Scene does not wait for meshes, they are assigned when streamed in
+				for (uint32_t i = 0; i < chunk.Header->Count; ++i)
+				{
+					const MeshRecord& record = chunk.GetRecords<MeshRecord>()[i];
+					if (!IsNull(record.Mesh))
+						scene->StreamMesh(SceneEntity(entities[chunk.Entities[i]], scene.Raw()), FromBinary(record.Mesh));
+				}
+				break;
+			case ChunkType::AnimatedMesh:
+				InsertChunk<AnimatedMeshComponent, AnimatedMeshRecord>(reg, chunk, entities, [&](AnimatedMeshComponent& mesh, const AnimatedMeshRecord& record) {
+					mesh.Mesh = animatedMeshes.Get(record.Mesh);
+					mesh.MaterialAsset = materials.Get(record.Material);
+					const uint32_t* bones = chunk.GetPayload<uint32_t>(record.BoneEntities);
+					if (!bones)
+					{
+						corrupted = true;
+						return;
+					}
+					mesh.BoneEntities.reserve(record.BoneEntities.Count);
+					for (uint32_t i = 0; i < record.BoneEntities.Count; ++i)
+						mesh.BoneEntities.push_back(toEntity(bones[i]));
+				});
+				break;
+			case ChunkType::Animation:
+				InsertChunk<AnimationComponent, AnimationRecord>(reg, chunk, entities, [&](AnimationComponent& animation, const AnimationRecord& record) {
+					animation.Controller = controllers.Get(record.Controller);
+					animation.UpdateBoneEntities = record.UpdateBoneEntities != 0;
+					animation.Playing = record.Playing != 0;
+				});
+				break;
+			case ChunkType::ParticleRenderer:
+				InsertChunk<ParticleRenderer, MeshRecord>(reg, chunk, entities, [&](ParticleRenderer& renderer, const MeshRecord& record) {
+					renderer.Mesh = particleMeshes.Get(record.Mesh);
+					renderer.MaterialAsset = materials.Get(record.Material);
+				});
+				break;
+			case ChunkType::Camera:
+				InsertChunk<CameraComponent, CameraRecord>(reg, chunk, entities, [&](CameraComponent& camera, const CameraRecord& record) {
+					if (record.ProjectionType > static_cast<uint32_t>(CameraProjectionType::Perspective))
+					{
+						corrupted = true;
+						return;
+					}
+					camera.Camera.SetProjectionType(static_cast<CameraProjectionType>(record.ProjectionType));
+					camera.Camera.SetPerspective(record.Perspective);
+					camera.Camera.SetOrthographic(record.Orthographic);
+				});
+				break;
+			case ChunkType::PointLight2D:
+				InsertChunk<PointLightComponent2D, PointLight2DRecord>(reg, chunk, entities, [](PointLightComponent2D& light, const PointLight2DRecord& record) {
+					light.Color = record.Color;
+					light.Radius = record.Radius;
+					light.Intensity = record.Intensity;
+				});
+				break;
+			case ChunkType::SpotLight2D:
+				InsertChunk<SpotLightComponent2D, SpotLight2DRecord>(reg, chunk, entities, [](SpotLightComponent2D& light, const SpotLight2DRecord& record) {
+					light.Color = record.Color;
+					light.Radius = record.Radius;
+					light.Intensity = record.Intensity;
+					light.InnerAngle = record.InnerAngle;
+					light.OuterAngle = record.OuterAngle;
+				});
+				break;
+			case ChunkType::PointLight3D:
+				InsertChunk<PointLightComponent3D, PointLight3DRecord>(reg, chunk, entities, [](PointLightComponent3D& light, const PointLight3DRecord& record) {
+					light.Radiance = record.Radiance;
+					light.Intensity = record.Intensity;
+					light.LightSize = record.LightSize;
+					light.MinRadius = record.MinRadius;
+					light.Radius = record.Radius;
+					light.Falloff = record.Falloff;
+					light.CastsShadows = record.CastsShadows != 0;
+					light.SoftShadows = record.SoftShadows != 0;
+				});
+				break;
+			case ChunkType::RigidBody2D:
+				InsertChunk<RigidBody2DComponent, RigidBody2DRecord>(reg, chunk, entities, [&](RigidBody2DComponent& body, const RigidBody2DRecord& record) {
+					if (record.Type > static_cast<uint32_t>(RigidBody2DComponent::BodyType::Kinematic))
+					{
+						corrupted = true;
+						return;
+					}
+					body.Type = static_cast<RigidBody2DComponent::BodyType>(record.Type);
+					body.Layer = record.Layer;
+				});
+				break;
+			case ChunkType::BoxCollider2D:
+				InsertChunk<BoxCollider2DComponent, BoxCollider2DRecord>(reg, chunk, entities, [](BoxCollider2DComponent& collider, const BoxCollider2DRecord& record) {
+					collider.Size = record.Size;
+					collider.Offset = record.Offset;
+					collider.Density = record.Density;
+					collider.Friction = record.Friction;
+				});
+				break;
+			case ChunkType::CircleCollider2D:
+				InsertChunk<CircleCollider2DComponent, CircleCollider2DRecord>(reg, chunk, entities, [](CircleCollider2DComponent& collider, const CircleCollider2DRecord& record) {
+					collider.Offset = record.Offset;
+					collider.Radius = record.Radius;
+					collider.Density = record.Density;
+					collider.Friction = record.Friction;
+				});
+				break;
+			case ChunkType::ChainCollider2D:
+				InsertChunk<ChainCollider2DComponent, ChainCollider2DRecord>(reg, chunk, entities, [&](ChainCollider2DComponent& collider, const ChainCollider2DRecord& record) {
+					const glm::vec2* points = chunk.GetPayload<glm::vec2>(record.Points);
+					if (!points)
+					{
+						corrupted = true;
+						return;
+					}
+					collider.Points.assign(points, points + record.Points.Count);
+					collider.Density = record.Density;
+					collider.Friction = record.Friction;
+					collider.InvertNormals = record.InvertNormals != 0;
+				});
+				break;
+			case ChunkType::Yaml:
+				yamlChunks.push_back(&chunk);
+				break;
+			default:
+				XYZ_CORE_WARN("Binary scene '{0}' has unknown chunk type {1}", filepath, ToUnderlying(chunk.Header->Type));
+				break;
+			}
+		}
+
+		if (corrupted)
+		{
+			XYZ_CORE_ERROR("Binary scene '{0}' references data out of range", filepath);
+			return Ref<Scene>();
+		}
+
+		// Scripts can access other components of entity, create them last
+		for (const ChunkView* chunk : yamlChunks)
+		{
+			const YamlRecord* records = chunk->GetRecords<YamlRecord>();
+			for (uint32_t i = 0; i < chunk->Header->Count; ++i)
+			{
+				const std::string source = getString(records[i].Source);
+				if (corrupted)
+				{
+					XYZ_CORE_ERROR("Binary scene '{0}' references data out of range", filepath);
+					return Ref<Scene>();
+				}
+				SceneEntity entity(entities[chunk->Entities[i]], scene.Raw());
+				SceneSerializer::deserializeYamlComponents(source, entity);
+			}
+		}
+
+		// Relationships were inserted directly, flatten hierarchy again
+		scene->m_TransformHierarchy.Invalidate();
+		return scene;
+	}
+
+	bool SceneBinarySerializer::IsBinaryScene(const std::string& filepath)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		char magic[sizeof(sc_Magic)] = {};
+		if (!stream.read(magic, sizeof(magic)))
+			return false;
+		return memcmp(magic, sc_Magic, sizeof(sc_Magic)) == 0;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "Scene.h"
+
+namespace XYZ {
+
+	// Components are stored in typed chunks of flat records, file is memory mapped on load
+	// and every chunk is inserted into registry at once. Entities are referenced by index
+	// to guid table, index 0 is always scene entity. Strings are stored in shared string table
+	class XYZ_API SceneBinarySerializer
+	{
+	public:
+		static constexpr uint32_t sc_Version = 4;
+
+		void	   Serialize(const std::string& filepath, WeakRef<Scene> scene);
+		Ref<Scene> Deserialize(const std::string& filepath);
+
+		static bool IsBinaryScene(const std::string& filepath);
+	};
+}
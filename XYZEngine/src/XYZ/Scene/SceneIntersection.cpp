@@ -1,83 +1,41 @@
 #include "stdafx.h"
 #include "SceneIntersection.h"
-#include "SceneEntityUtils.h"
 
-#include "Components.h"
+#include "XYZ/Debug/Profiler.h"
 
 namespace XYZ {
 	namespace Utils {
 		
-		static bool RayEntityCollision(const SceneEntity& entity, const Ray& ray, float& distance)
+		static bool RayEntityCollision(const SceneBVH::Entry& entry, const AABB& bounds, const Ray& ray, float& distance)
 		{
-			AABB aabb = SceneEntityAABB(entity);
-			if (ray.IntersectsAABB(aabb, distance))
-			{
-				if (entity.HasComponent<AnimatedMeshComponent>())
-				{
-					auto& meshComponent = entity.GetComponent<AnimatedMeshComponent>();
-					auto& transformComponent = entity.GetComponent<TransformComponent>();
-
-					Ray transformedRay = {
-						glm::inverse(transformComponent->WorldTransform) * glm::vec4(ray.Origin, 1.0f),
-						glm::inverse(glm::mat3(transformComponent->WorldTransform)) * ray.Direction
-					};
+			if (!ray.IntersectsAABB(bounds, distance))
+				return false;
 
-					if (meshComponent.Mesh->IsValid())
-					{
-						auto& meshSource = meshComponent.Mesh->GetMeshSource();
-						for (const auto& tr : meshSource->GetTriangles())
-						{
-							if (transformedRay.IntersectsTriangle(tr.V0, tr.V1, tr.V2, distance))
-							{
-								return true;
-							}
-						}
-					}
-				}
-				else if (entity.HasComponent<MeshComponent>())
-				{
-					auto& meshComponent = entity.GetComponent<MeshComponent>();
-					auto& transformComponent = entity.GetComponent<TransformComponent>();
+			// Sprites are tested only against bounds
+			if (!entry.Source)
+				return true;
 
-					Ray transformedRay = {
-						glm::inverse(transformComponent->WorldTransform) * glm::vec4(ray.Origin, 1.0f),
-						glm::inverse(glm::mat3(transformComponent->WorldTransform)) * ray.Direction
-					};
-
-					if (meshComponent.Mesh->IsValid())
-					{
-						auto& meshSource = meshComponent.Mesh->GetMeshSource();
-						for (const auto& tr : meshSource->GetTriangles())
-						{
-							if (transformedRay.IntersectsTriangle(tr.V0, tr.V1, tr.V2, distance))
-							{
-								return true;
-							}
-						}
-					}
-				}
-				else if (entity.HasComponent<SpriteRenderer>())
-				{
-					return true;
-				}
-			}
-			return false;
+			// Inverse transform is cached by SceneBVH, parametric distance is same in mesh and world space
+			const Ray meshRay = {
+				glm::vec3(entry.InverseTransform * glm::vec4(ray.Origin, 1.0f)),
+				glm::mat3(entry.InverseTransform) * ray.Direction
+			};
+			return entry.Source->Raycast(meshRay, distance);
 		}
 	}
 
 
     std::deque<SceneIntersection::HitData> SceneIntersection::Intersect(const Ray& ray, Ref<Scene> scene)
     {
+		XYZ_PROFILE_FUNC("SceneIntersection::Intersect");
         std::deque<HitData> result;
 
-		// TODO: octree
-		scene->GetRegistry().each([&](const entt::entity entityID) {
-			SceneEntity entity(entityID, scene.Raw());
+		scene->updateSceneBVH();
+		scene->m_SceneBVH.Raycast(ray, std::numeric_limits<float>::max(), [&](const SceneBVH::Entry& entry, const AABB& bounds, float& maxDistance) {
 			float distance = 0.0f;
-
-			if (Utils::RayEntityCollision(entity, ray, distance))
+			if (Utils::RayEntityCollision(entry, bounds, ray, distance))
 			{
-				result.push_back({ entity, distance });
+				result.push_back({ SceneEntity(entry.Entity, scene.Raw()), distance });
 			}
 		});
 
@@ -87,4 +45,35 @@ namespace XYZ {
 
         return result;
     }
-}
\ No newline at end of file
+
+	bool SceneIntersection::Raycast(const Ray& ray, Ref<Scene> scene, HitData& hit)
+	{
+		XYZ_PROFILE_FUNC("SceneIntersection::Raycast");
+		bool result = false;
+
+		scene->updateSceneBVH();
+		scene->m_SceneBVH.Raycast(ray, std::numeric_limits<float>::max(), [&](const SceneBVH::Entry& entry, const AABB& bounds, float& maxDistance) {
+			float distance = 0.0f;
+			if (Utils::RayEntityCollision(entry, bounds, ray, distance) && distance < maxDistance)
+			{
+				maxDistance = distance;
+				hit = { SceneEntity(entry.Entity, scene.Raw()), distance };
+				result = true;
+			}
+		});
+		return result;
+	}
+
+	std::vector<SceneEntity> SceneIntersection::Overlap(const AABB& aabb, Ref<Scene> scene)
+	{
+		XYZ_PROFILE_FUNC("SceneIntersection::Overlap");
+		std::vector<SceneEntity> result;
+
+		scene->updateSceneBVH();
+		scene->m_SceneBVH.Query(aabb, [&](const SceneBVH::Entry& entry, const AABB& bounds) {
+			if (glm::all(glm::lessThanEqual(bounds.Min, aabb.Max)) && glm::all(glm::greaterThanEqual(bounds.Max, aabb.Min)))
+				result.emplace_back(entry.Entity, scene.Raw());
+		});
+		return result;
+	}
+}
@@ -17,6 +17,11 @@ namespace XYZ {
 			float		Distance;
 		};
 
+		// All entities hit by ray, sorted by distance
 		static std::deque<HitData> Intersect(const Ray& ray, Ref<Scene> scene);
+		// Closest entity hit by ray
+		static bool Raycast(const Ray& ray, Ref<Scene> scene, HitData& hit);
+		// Entities whose world bounds overlap aabb
+		static std::vector<SceneEntity> Overlap(const AABB& aabb, Ref<Scene> scene);
 	};
-}
\ No newline at end of file
+}
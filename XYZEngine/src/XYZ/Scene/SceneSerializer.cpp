@@ -147,6 +147,7 @@ namespace XYZ {
 		out << YAML::BeginMap;
 
 		out << YAML::Key << "Type" << YAML::Value << ToUnderlying(val.Type);
+		out << YAML::Key << "Layer" << YAML::Value << val.Layer;
 		out << YAML::EndMap; // RigidBody2D
 	}
 
@@ -363,6 +364,8 @@ namespace XYZ {
 		{
 			out << YAML::Key << "Controller" << "";
 		}
+		out << YAML::Key << "Playing" << val.Playing;
+		out << YAML::Key << "UpdateBoneEntities" << val.UpdateBoneEntities;
 		out << YAML::EndMap;
 	}
 
@@ -636,6 +639,8 @@ namespace XYZ {
 			component.Type = RigidBody2DComponent::BodyType::Kinematic;
 			break;
 		}
+		if (auto layer = data["Layer"])
+			component.Layer = layer.as<uint32_t>();
 	}
 
 	template <>
@@ -672,6 +677,12 @@ namespace XYZ {
 			AssetHandle handle(controllerData);
 			component.Controller = AssetManager::TryGetAsset<AnimationController>(handle);
 		}
+		// Scenes saved before playing state was stored always played
+		component.Playing = true;
+		if (auto playing = data["Playing"])
+			component.Playing = playing.as<bool>();
+		if (auto updateBoneEntities = data["UpdateBoneEntities"])
+			component.UpdateBoneEntities = updateBoneEntities.as<bool>();
 	}
 
 	void SceneSerializer::deserializeEntity(YAML::Node& data,  WeakRef<Scene> scene)
@@ -803,6 +814,7 @@ namespace XYZ {
 
 	void SceneSerializer::Serialize(const std::string& filepath, WeakRef<Scene> scene)
 	{
+		scene->WaitForStreamedMeshes();
 		YAML::Emitter out;
 		
 		SceneEntity sceneEntity = scene->GetSceneEntity();
@@ -886,6 +898,8 @@ namespace XYZ {
 					setupAnimatedMeshComponent(animatedMeshComponent, setupEntity);
 			}
 		}
+		// Relationships were overwritten directly, flatten hierarchy again
+		scene->m_TransformHierarchy.Invalidate();
 		return scene;
 	}
 
@@ -942,4 +956,35 @@ namespace XYZ {
 			component.BoneEntities.push_back(bone);
 		}
 	}
+
+	std::string SceneSerializer::serializeYamlComponents(SceneEntity entity)
+	{
+		const bool hasScript = entity.HasComponent<ScriptComponent>();
+		const bool hasParticle = entity.HasComponent<ParticleComponent>();
+		if (!hasScript && !hasParticle)
+			return std::string();
+
+		YAML::Emitter out;
+		out << YAML::BeginMap;
+		if (hasScript)
+			serialize<ScriptComponent>(out, entity.GetComponent<ScriptComponent>(), entity);
+		if (hasParticle)
+			serialize<ParticleComponent>(out, entity.GetComponent<ParticleComponent>(), entity);
+		out << YAML::EndMap;
+		return out.c_str();
+	}
+	void SceneSerializer::deserializeYamlComponents(const std::string& source, SceneEntity entity)
+	{
+		YAML::Node data = YAML::Load(source);
+		auto scriptComponent = data["ScriptComponent"];
+		if (scriptComponent)
+		{
+			deserialize<ScriptComponent>(scriptComponent, entity.EmplaceComponent<ScriptComponent>(), entity);
+		}
+		auto particleComponent = data["ParticleComponent"];
+		if (particleComponent)
+		{
+			deserialize<ParticleComponent>(particleComponent, entity.EmplaceComponent<ParticleComponent>(), entity);
+		}
+	}
 }
\ No newline at end of file
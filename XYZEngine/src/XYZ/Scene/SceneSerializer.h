@@ -51,5 +51,10 @@ namespace XYZ {
 		static void setupRelationship(YAML::Node& data, SceneEntity entity);
 		static void setupAnimatedMeshComponent(YAML::Node& data, SceneEntity entity);
 
+		// Components without flat layout, binary scenes store them as yaml
+		static std::string serializeYamlComponents(SceneEntity entity);
+		static void		   deserializeYamlComponents(const std::string& source, SceneEntity entity);
+
+		friend class SceneBinarySerializer;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "stdafx.h"
+#include "TransformHierarchy.h"
+
+#include "Components.h"
+
+#include "XYZ/Core/ThreadPool.h"
+#include "XYZ/Debug/Profiler.h"
+
+namespace XYZ {
+
+	void TransformHierarchy::Level::Clear()
+	{
+		Entities.clear();
+		Parents.clear();
+		Transforms.clear();
+		LocalTransforms.clear();
+		WorldTransforms.clear();
+		Changed.clear();
+		Removed = 0;
+	}
+
+	void TransformHierarchy::Rebuild(entt::registry& reg, entt::entity root)
+	{
+		XYZ_PROFILE_FUNC("TransformHierarchy::Rebuild");
+		for (auto& level : m_Levels)
+			level.Clear();
+		std::fill(m_Locations.begin(), m_Locations.end(), Location{});
+		m_NodeCount = 0;
+
+		pushNode(reg, root, 0, sc_InvalidIndex);
+
+		// Breadth first, every level is complete before we start with the next one
+		for (uint32_t levelIndex = 0; levelIndex < m_Levels.size(); ++levelIndex)
+		{
+			for (uint32_t i = 0; i < m_Levels[levelIndex].Size(); ++i)
+			{
+				const Relationship& relation = reg.get<Relationship>(m_Levels[levelIndex].Entities[i]);
+				entt::entity child = relation.GetFirstChild();
+				while (reg.valid(child))
+				{
+					pushNode(reg, child, levelIndex + 1, i);
+					child = reg.get<Relationship>(child).GetNextSibling();
+				}
+			}
+		}
+		while (!m_Levels.empty() && m_Levels.back().Size() == 0)
+			m_Levels.pop_back();
+
+		m_Invalid = false;
+		m_RefreshTransforms = false;
+	}
+
+	void TransformHierarchy::Reparent(entt::registry& reg, entt::entity entity)
+	{
+		if (m_Invalid) // Whole tree is going to be rebuilt anyway
+			return;
+
+		XYZ_PROFILE_FUNC("TransformHierarchy::Reparent");
+		removeSubtree(reg, entity);
+
+		const Relationship& relation = reg.get<Relationship>(entity);
+		const Location parent = findLocation(relation.GetParent());
+		// Detached entities are not part of the hierarchy
+		if (parent.Level != sc_InvalidIndex)
+			insertSubtree(reg, entity, parent);
+	}
+
+	void TransformHierarchy::Remove(entt::entity entity)
+	{
+		if (m_Invalid)
+			return;
+
+		removeNode(findLocation(entity));
+		// Component storage moves last component to the removed slot
+		m_RefreshTransforms = true;
+	}
+
+	void TransformHierarchy::Update(entt::registry& reg, ThreadPool* pool)
+	{
+		XYZ_PROFILE_FUNC("TransformHierarchy::Update");
+		XYZ_ASSERT(!m_Invalid, "Transform hierarchy must be rebuilt before update");
+		if (m_Levels.empty())
+			return;
+
+		if (m_RefreshTransforms)
+			refreshTransforms(reg);
+		compact();
+
+		// Root has no parent, its world transform is used as it is
+		Level& rootLevel = m_Levels[0];
+		TransformComponent& root = *rootLevel.Transforms[0];
+		rootLevel.WorldTransforms[0] = root.m_Transform.WorldTransform;
+		rootLevel.Changed[0] = root.m_Dirty;
+		root.m_Dirty = false;
+
+		for (uint32_t levelIndex = 1; levelIndex < m_Levels.size(); ++levelIndex)
+		{
+			const uint32_t count = m_Levels[levelIndex].Size();
+			if (pool && count > sc_PerJobCount)
+			{
+				JobCounter counter;
+				for (uint32_t start = 0; start < count; start += sc_PerJobCount)
+				{
+					const uint32_t end = std::min(start + sc_PerJobCount, count);
+					pool->PushJob(counter, [this, levelIndex, start, end]() {
+						XYZ_PROFILE_FUNC("TransformHierarchy::Update Job");
+						updateRange(levelIndex, start, end);
+					});
+				}
+				pool->Wait(counter);
+			}
+			else
+			{
+				updateRange(levelIndex, 0, count);
+			}
+		}
+	}
+
+	void TransformHierarchy::insertSubtree(entt::registry& reg, entt::entity entity, const Location& parent)
+	{
+		struct PendingNode
+		{
+			entt::entity Entity;
+			Location	 Parent;
+		};
+		std::vector<PendingNode> pending;
+		pending.push_back({ entity, parent });
+		while (!pending.empty())
+		{
+			const PendingNode node = pending.back();
+			pending.pop_back();
+
+			const uint32_t level = node.Parent.Level + 1;
+			const uint32_t index = pushNode(reg, node.Entity, level, node.Parent.Index);
+
+			entt::entity child = reg.get<Relationship>(node.Entity).GetFirstChild();
+			while (reg.valid(child))
+			{
+				pending.push_back({ child, { level, index } });
+				child = reg.get<Relationship>(child).GetNextSibling();
+			}
+		}
+	}
+
+	uint32_t TransformHierarchy::pushNode(entt::registry& reg, entt::entity entity, uint32_t level, uint32_t parentIndex)
+	{
+		if (level >= m_Levels.size())
+			m_Levels.resize(level + 1);
+
+		Level& target = m_Levels[level];
+		TransformComponent& transform = reg.get<TransformComponent>(entity);
+		// World transform must be recalculated under new parent
+		transform.m_Dirty = true;
+
+		const uint32_t index = target.Size();
+		target.Entities.push_back(entity);
+		target.Parents.push_back(parentIndex);
+		target.Transforms.push_back(&transform);
+		target.LocalTransforms.push_back(glm::mat4(1.0f));
+		target.WorldTransforms.push_back(transform.m_Transform.WorldTransform);
+		target.Changed.push_back(0);
+
+		getLocation(entity) = { level, index };
+		m_NodeCount++;
+		return index;
+	}
+
+	void TransformHierarchy::removeSubtree(entt::registry& reg, entt::entity entity)
+	{
+		std::vector<entt::entity> pending;
+		pending.push_back(entity);
+		while (!pending.empty())
+		{
+			const entt::entity current = pending.back();
+			pending.pop_back();
+
+			removeNode(findLocation(current));
+
+			entt::entity child = reg.get<Relationship>(current).GetFirstChild();
+			while (reg.valid(child))
+			{
+				pending.push_back(child);
+				child = reg.get<Relationship>(child).GetNextSibling();
+			}
+		}
+	}
+
+	void TransformHierarchy::removeNode(const Location& location)
+	{
+		if (location.Level == sc_InvalidIndex)
+			return;
+
+		Level& level = m_Levels[location.Level];
+		getLocation(level.Entities[location.Index]) = Location{};
+
+		level.Entities[location.Index] = entt::null;
+		level.Transforms[location.Index] = nullptr;
+		level.Changed[location.Index] = 0;
+		level.Removed++;
+		m_NodeCount--;
+	}
+
+	void TransformHierarchy::updateRange(uint32_t levelIndex, uint32_t start, uint32_t end)
+	{
+		const Level& parentLevel = m_Levels[levelIndex - 1];
+		Level& level = m_Levels[levelIndex];
+
+		for (uint32_t i = start; i < end; ++i)
+		{
+			TransformComponent* transform = level.Transforms[i];
+			if (!transform) // Removed node
+				continue;
+
+			const uint32_t parent = level.Parents[i];
+			if (transform->m_Dirty)
+				level.LocalTransforms[i] = transform->GetLocalTransform();
+
+			// Clean node with unchanged parent keeps its world transform, whole clean subtree is skipped this way
+			if (transform->m_Dirty || parentLevel.Changed[parent])
+			{
+				level.WorldTransforms[i] = parentLevel.WorldTransforms[parent] * level.LocalTransforms[i];
+				transform->m_Transform.WorldTransform = level.WorldTransforms[i];
+				transform->m_Dirty = false;
+				level.Changed[i] = 1;
+			}
+			else
+			{
+				level.Changed[i] = 0;
+			}
+		}
+	}
+
+	void TransformHierarchy::compact()
+	{
+		std::vector<uint32_t>* parentRemap = &m_Remap[0];
+		std::vector<uint32_t>* remap = &m_Remap[1];
+		bool parentCompacted = false;
+
+		for (uint32_t levelIndex = 0; levelIndex < m_Levels.size(); ++levelIndex)
+		{
+			Level& level = m_Levels[levelIndex];
+			if (parentCompacted)
+			{
+				for (uint32_t i = 0; i < level.Size(); ++i)
+				{
+					if (level.Entities[i] == entt::null)
+						continue;
+
+					const uint32_t newParent = (*parentRemap)[level.Parents[i]];
+					if (newParent == sc_InvalidIndex) // Parent was removed, node is orphaned
+						removeNode({ levelIndex, i });
+					else
+						level.Parents[i] = newParent;
+				}
+			}
+
+			const bool compacted = level.Removed != 0 && level.Removed * 4 >= level.Size();
+			if (compacted)
+			{
+				remap->assign(level.Size(), sc_InvalidIndex);
+				uint32_t write = 0;
+				for (uint32_t read = 0; read < level.Size(); ++read)
+				{
+					if (level.Entities[read] == entt::null)
+						continue;
+
+					(*remap)[read] = write;
+					if (write != read)
+					{
+						level.Entities[write]		 = level.Entities[read];
+						level.Parents[write]		 = level.Parents[read];
+						level.Transforms[write]		 = level.Transforms[read];
+						level.LocalTransforms[write] = level.LocalTransforms[read];
+						level.WorldTransforms[write] = level.WorldTransforms[read];
+						level.Changed[write]		 = level.Changed[read];
+						getLocation(level.Entities[write]).Index = write;
+					}
+					write++;
+				}
+				level.Entities.resize(write);
+				level.Parents.resize(write);
+				level.Transforms.resize(write);
+				level.LocalTransforms.resize(write);
+				level.WorldTransforms.resize(write);
+				level.Changed.resize(write);
+				level.Removed = 0;
+			}
+			std::swap(parentRemap, remap);
+			parentCompacted = compacted;
+		}
+	}
+
+	void TransformHierarchy::refreshTransforms(entt::registry& reg)
+	{
+		XYZ_PROFILE_FUNC("TransformHierarchy::refreshTransforms");
+		for (auto& level : m_Levels)
+		{
+			for (uint32_t i = 0; i < level.Size(); ++i)
+			{
+				if (level.Entities[i] != entt::null)
+					level.Transforms[i] = &reg.get<TransformComponent>(level.Entities[i]);
+			}
+		}
+		m_RefreshTransforms = false;
+	}
+
+	TransformHierarchy::Location& TransformHierarchy::getLocation(entt::entity entity)
+	{
+		const size_t index = static_cast<size_t>(entt::to_entity(entity));
+		if (index >= m_Locations.size())
+			m_Locations.resize(index + 1);
+		return m_Locations[index];
+	}
+
+	TransformHierarchy::Location TransformHierarchy::findLocation(entt::entity entity) const
+	{
+		if (entity == entt::null)
+			return Location{};
+
+		const size_t index = static_cast<size_t>(entt::to_entity(entity));
+		if (index >= m_Locations.size())
+			return Location{};
+
+		// Entity identifier might be recycled, make sure that location belongs to this version
+		const Location& location = m_Locations[index];
+		if (location.Level == sc_InvalidIndex || m_Levels[location.Level].Entities[location.Index] != entity)
+			return Location{};
+
+		return location;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <limits>
+
+namespace XYZ {
+
+	class ThreadPool;
+	class TransformComponent;
+
+	// Flattened, depth sorted transform hierarchy.
+	// Every level stores parent indices and local / world matrices contiguously,
+	// levels are updated one after another, nodes inside level can be updated in parallel
+	class XYZ_API TransformHierarchy
+	{
+	public:
+		TransformHierarchy() = default;
+		TransformHierarchy(const TransformHierarchy& other) = delete;
+
+		TransformHierarchy& operator=(const TransformHierarchy& other) = delete;
+
+		// Flattens whole tree starting at root, used after bulk changes of relationships
+		void Rebuild(entt::registry& reg, entt::entity root);
+
+		// Removes subtree of entity and inserts it again under its current parent
+		void Reparent(entt::registry& reg, entt::entity entity);
+
+		// Removes single node, children are expected to be removed too
+		void Remove(entt::entity entity);
+
+		// Updates world transforms and clears dirty flags, pool can be nullptr
+		void Update(entt::registry& reg, ThreadPool* pool);
+
+		void Invalidate() { m_Invalid = true; }
+
+		bool	 IsInvalid()	 const { return m_Invalid; }
+		uint32_t GetNodeCount()  const { return m_NodeCount; }
+		uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_Levels.size()); }
+
+	private:
+		static constexpr uint32_t sc_InvalidIndex = std::numeric_limits<uint32_t>::max();
+		static constexpr uint32_t sc_PerJobCount = 2048;
+
+		struct Location
+		{
+			uint32_t Level = sc_InvalidIndex;
+			uint32_t Index = sc_InvalidIndex;
+		};
+
+		struct Level
+		{
+			std::vector<entt::entity>		 Entities;
+			std::vector<uint32_t>			 Parents; // Index to previous level
+			std::vector<TransformComponent*> Transforms;
+			std::vector<glm::mat4>			 LocalTransforms;
+			std::vector<glm::mat4>			 WorldTransforms;
+			std::vector<uint8_t>			 Changed;
+			uint32_t						 Removed = 0;
+
+			uint32_t Size() const { return static_cast<uint32_t>(Entities.size()); }
+			void	 Clear();
+		};
+
+		void	 insertSubtree(entt::registry& reg, entt::entity entity, const Location& parent);
+		uint32_t pushNode(entt::registry& reg, entt::entity entity, uint32_t level, uint32_t parentIndex);
+		void	 removeSubtree(entt::registry& reg, entt::entity entity);
+		void	 removeNode(const Location& location);
+
+		void updateRange(uint32_t level, uint32_t start, uint32_t end);
+		void compact();
+		void refreshTransforms(entt::registry& reg);
+
+		Location& getLocation(entt::entity entity);
+		Location  findLocation(entt::entity entity) const;
+
+	private:
+		std::vector<Level>	  m_Levels;
+		std::vector<Location> m_Locations; // Indexed by entity
+		std::vector<uint32_t> m_Remap[2];
+
+		uint32_t m_NodeCount = 0;
+		bool	 m_Invalid = true;
+		bool	 m_RefreshTransforms = false;
+	};
+}
@@ -37,7 +37,7 @@ namespace XYZ {
 	MonoImage* s_CoreAssemblyImage = nullptr;
 
 
-	static MonoMethod* GetMethod(MonoImage* image, const std::string& methodDesc);
+	static MonoMethod* GetMethod(MonoImage* image, const std::string& methodDesc, bool required = true);
 
 	struct EntityScriptClass
 	{
@@ -50,6 +50,8 @@ namespace XYZ {
 		MonoMethod* OnCreateMethod = nullptr;
 		MonoMethod* OnDestroyMethod = nullptr;
 		MonoMethod* OnUpdateMethod = nullptr;
+		MonoMethod* OnCollisionBeginMethod = nullptr;
+		MonoMethod* OnCollisionEndMethod = nullptr;
 
 		void InitClassMethods(MonoImage* image)
 		{
@@ -57,6 +59,9 @@ namespace XYZ {
 			OnCreateMethod = GetMethod(image, FullName + ":OnCreate()");
 			OnDestroyMethod = GetMethod(image, FullName + ":OnDestroy()");
 			OnUpdateMethod = GetMethod(image, FullName + ":OnUpdate(single)");
+			// Collision callbacks are optional
+			OnCollisionBeginMethod = GetMethod(image, FullName + ":OnCollisionBegin(uint)", false);
+			OnCollisionEndMethod = GetMethod(image, FullName + ":OnCollisionEnd(uint)", false);
 		}
 	};
 
@@ -174,14 +179,14 @@ namespace XYZ {
 		return handle;
 	}
 
-	static MonoMethod* GetMethod(MonoImage* image, const std::string& methodDesc)
+	static MonoMethod* GetMethod(MonoImage* image, const std::string& methodDesc, bool required)
 	{
 		MonoMethodDesc* desc = mono_method_desc_new(methodDesc.c_str(), NULL);
 		if (!desc)
 			XYZ_CORE_ERROR("mono_method_desc_new failed");
 
 		MonoMethod* method = mono_method_desc_search_in_image(desc, image);
-		if (!method)
+		if (!method && required)
 			XYZ_CORE_ERROR("mono_method_desc_search_in_image failed");
 
 		return method;
@@ -401,6 +406,26 @@ namespace XYZ {
 			CallMethod(instance.GetInstance(), instance.ScriptClass->OnUpdateMethod, args);
 		}
 	}
+	void ScriptEngine::OnCollisionBegin(const SceneEntity& entity, const SceneEntity& other)
+	{
+		ScriptEntityInstance& instance = s_ScriptEntityInstances.GetData(entity);
+		if (instance.ScriptClass->OnCollisionBeginMethod)
+		{
+			uint32_t otherID = static_cast<uint32_t>(other.m_ID);
+			void* args[] = { &otherID };
+			CallMethod(instance.GetInstance(), instance.ScriptClass->OnCollisionBeginMethod, args);
+		}
+	}
+	void ScriptEngine::OnCollisionEnd(const SceneEntity& entity, const SceneEntity& other)
+	{
+		ScriptEntityInstance& instance = s_ScriptEntityInstances.GetData(entity);
+		if (instance.ScriptClass->OnCollisionEndMethod)
+		{
+			uint32_t otherID = static_cast<uint32_t>(other.m_ID);
+			void* args[] = { &otherID };
+			CallMethod(instance.GetInstance(), instance.ScriptClass->OnCollisionEndMethod, args);
+		}
+	}
 
 	MonoObject* ScriptEngine::Construct(const std::string& fullName, bool callConstructor, void** parameters)
 	{
@@ -48,6 +48,8 @@ namespace XYZ {
 		static void OnCreateEntity(const SceneEntity& entity);
 		static void OnDestroyEntity(const SceneEntity& entity);
 		static void OnUpdateEntity(const SceneEntity& entity, Timestep ts);
+		static void OnCollisionBegin(const SceneEntity& entity, const SceneEntity& other);
+		static void OnCollisionEnd(const SceneEntity& entity, const SceneEntity& other);
 		static MonoObject* Construct(const std::string& fullName, bool callConstructor = true, void** parameters = nullptr);
 		static MonoClass* GetCoreClass(const std::string& fullName);
 
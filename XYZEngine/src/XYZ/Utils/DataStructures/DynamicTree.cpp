@@ -2,6 +2,8 @@
 #include "DynamicTree.h"
 
 #include "XYZ/Renderer/Renderer2D.h"
+#include "XYZ/Core/ThreadPool.h"
+#include "XYZ/Debug/Profiler.h"
 
 
 
@@ -10,100 +12,154 @@
 
 
 namespace XYZ {
-	bool DynamicTree::RayCast(const Ray& ray, uint32_t& result)
+	bool DynamicTree::RayCast(const Ray& ray, uint32_t& result) const
 	{
-		std::stack<int32_t> stack;
-		stack.push(m_RootIndex);
-		while (!stack.empty())
-		{
-			const int32_t index = stack.top();
-			stack.pop();
+		bool hit = false;
+		RayCast(ray, std::numeric_limits<float>::max(), [&](int32_t index, float& maxDistance) {
 			float distance = 0.0f;
-			if (!ray.IntersectsAABB(m_Nodes[index].Box, distance))
-			{
-				continue;
-			}
-			if (m_Nodes[index].IsLeaf())
-			{
-				const uint32_t objectIndex = m_Nodes[index].DataIndex;
-				if (ray.IntersectsAABB(m_Nodes[index].Box, distance))
-				{
-					result = objectIndex;
-					return true;
-				}
-			}
-			else
+			if (ray.IntersectsAABB(m_Nodes[index].Box, distance) && distance < maxDistance)
 			{
-				stack.push(m_Nodes[index].FirstChild);
-				stack.push(m_Nodes[index].SecondChild);
+				maxDistance = distance;
+				result = m_Nodes[index].DataIndex;
+				hit = true;
 			}
-		}
-		return false;
-	}
-	void DynamicTree::Query(const CollisionCallback& callback,const AABB& aabb)
-	{
-		std::stack<int32_t> stack;
-		stack.push(m_RootIndex);
-		while (!stack.empty())
-		{
-			const int32_t index = stack.top();
-			stack.pop();
-			if (index == NULL_NODE)
-				continue;
-
-			const Node& node = m_Nodes[index];
-			if (node.Box.Intersect(aabb))
-			{
-				if (node.IsLeaf())
-				{
-					const bool proceed = callback(index);
-					if (proceed)
-						return;
-				}
-				else
-				{
-					stack.push(node.FirstChild);
-					stack.push(node.SecondChild);
-				}
-			}
-		}
+		});
+		return hit;
 	}
 	int32_t DynamicTree::Insert(uint32_t objectIndex, const AABB& box)
 	{
-		const int32_t leaf = m_Nodes.Insert({ box , objectIndex });
-		
-		if (m_MovedNodes.size() < m_Nodes.Range())
-			m_MovedNodes.resize(m_Nodes.Range());
+		const glm::vec3 margin(sc_AABBMargin);
+		const int32_t leaf = m_Nodes.Insert({ AABB(box.Min - margin, box.Max + margin), objectIndex });
 		insertLeaf(leaf);
+		markMoved(leaf);
 		return leaf;
 	}
-	void DynamicTree::Move(int32_t index, const glm::vec2& displacement)
+	bool DynamicTree::Move(int32_t index, const AABB& box, const glm::vec3& displacement)
+	{
+		XYZ_ASSERT(m_Nodes[index].IsLeaf(), "Only leaves can be moved");
+		const glm::vec3 margin(sc_AABBMargin);
+		AABB fatAABB(box.Min - margin, box.Max + margin);
+
+		// Predict movement so proxy does not need reinsert next frame
+		const glm::vec3 predicted = sc_DisplacementMultiplier * displacement;
+		fatAABB.Min += glm::min(predicted, glm::vec3(0.0f));
+		fatAABB.Max += glm::max(predicted, glm::vec3(0.0f));
+
+		const AABB& treeAABB = m_Nodes[index].Box;
+		if (treeAABB.Contains(box))
+		{
+			// Huge fattened box from fast movement in past would produce many false pairs
+			const AABB hugeAABB(fatAABB.Min - 4.0f * margin, fatAABB.Max + 4.0f * margin);
+			if (hugeAABB.Contains(treeAABB))
+				return false;
+		}
+
+		removeLeaf(index);
+		m_Nodes[index].Box = fatAABB;
+		insertLeaf(index);
+		markMoved(index);
+		return true;
+	}
+	void DynamicTree::Move(int32_t index, const glm::vec3& displacement)
 	{
 		removeLeaf(index);
 
-		m_Nodes[index].Box.Min.x += displacement.x;
-		m_Nodes[index].Box.Min.y += displacement.y;
-		m_Nodes[index].Box.Max.x += displacement.x;
-		m_Nodes[index].Box.Max.y += displacement.y;
+		m_Nodes[index].Box.Min += displacement;
+		m_Nodes[index].Box.Max += displacement;
 
-		m_MovedNodes[index] = true;
 		insertLeaf(index);
+		markMoved(index);
+	}
+	void DynamicTree::Move(int32_t index, const glm::vec2& displacement)
+	{
+		Move(index, glm::vec3(displacement, 0.0f));
 	}
 	void DynamicTree::Remove(int32_t index)
 	{		
+		if (m_Nodes[index].Moved)
+			m_MovedNodes.erase(std::find(m_MovedNodes.begin(), m_MovedNodes.end(), index));
+
 		removeLeaf(index);
 		m_Nodes.Erase(index);
 	}
 
+	void DynamicTree::FindPairs(std::vector<ProxyPair>& pairs, ThreadPool* pool) const
+	{
+		XYZ_PROFILE_FUNC("DynamicTree::FindPairs");
+		pairs.clear();
+		const size_t count = m_MovedNodes.size();
+		if (pool && count > sc_PerJobCount)
+		{
+			const size_t jobCount = (count + sc_PerJobCount - 1) / sc_PerJobCount;
+			std::vector<std::vector<ProxyPair>> jobPairs(jobCount);
+			JobCounter counter;
+			for (size_t job = 0; job < jobCount; ++job)
+			{
+				const size_t begin = job * sc_PerJobCount;
+				const size_t end = std::min(begin + sc_PerJobCount, count);
+				pool->PushJob(counter, [this, begin, end, &result = jobPairs[job]]() {
+					XYZ_PROFILE_FUNC("DynamicTree::FindPairs Job");
+					findPairs(begin, end, result);
+				});
+			}
+			pool->Wait(counter);
+			for (const auto& result : jobPairs)
+				pairs.insert(pairs.end(), result.begin(), result.end());
+		}
+		else
+		{
+			findPairs(0, count, pairs);
+		}
+	}
+
+	void DynamicTree::QueryBatch(const std::vector<AABB>& boxes, std::vector<ProxyPair>& result, ThreadPool* pool) const
+	{
+		XYZ_PROFILE_FUNC("DynamicTree::QueryBatch");
+		result.clear();
+		auto queryRange = [this, &boxes](size_t begin, size_t end, std::vector<ProxyPair>& output) {
+			for (size_t i = begin; i < end; ++i)
+			{
+				Query(boxes[i], [&](int32_t proxy) {
+					output.push_back({ static_cast<int32_t>(i), proxy });
+					return true;
+				});
+			}
+		};
+
+		const size_t count = boxes.size();
+		if (pool && count > sc_PerJobCount)
+		{
+			const size_t jobCount = (count + sc_PerJobCount - 1) / sc_PerJobCount;
+			std::vector<std::vector<ProxyPair>> jobResults(jobCount);
+			JobCounter counter;
+			for (size_t job = 0; job < jobCount; ++job)
+			{
+				const size_t begin = job * sc_PerJobCount;
+				const size_t end = std::min(begin + sc_PerJobCount, count);
+				pool->PushJob(counter, [&queryRange, begin, end, &output = jobResults[job]]() {
+					XYZ_PROFILE_FUNC("DynamicTree::QueryBatch Job");
+					queryRange(begin, end, output);
+				});
+			}
+			pool->Wait(counter);
+			for (const auto& output : jobResults)
+				result.insert(result.end(), output.begin(), output.end());
+		}
+		else
+		{
+			queryRange(0, count, result);
+		}
+	}
+
 	void DynamicTree::SubmitToRenderer(Ref<Renderer2D> renderer2D)
 	{
-		std::stack<int32_t> stack;
+		std::vector<int32_t> stack;
 		if (m_RootIndex != NULL_NODE)
-			stack.push(m_RootIndex);
+			stack.push_back(m_RootIndex);
 		while (!stack.empty())
 		{
-			const int32_t index = stack.top();
-			stack.pop();
+			const int32_t index = stack.back();
+			stack.pop_back();
 
 			const AABB box = m_Nodes[index].Box;
 
@@ -118,91 +174,57 @@ namespace XYZ {
 			}
 			else
 			{
-				stack.push(m_Nodes[index].FirstChild);
-				stack.push(m_Nodes[index].SecondChild);
+				stack.push_back(m_Nodes[index].FirstChild);
+				stack.push_back(m_Nodes[index].SecondChild);
 			}
 		}
 	}
 
 	void DynamicTree::CleanMovedNodes()
 	{
-		for (auto& node : m_MovedNodes)
-			node = false;
+		for (const int32_t index : m_MovedNodes)
+			m_Nodes[index].Moved = false;
+		m_MovedNodes.clear();
 	}
 
-	void DynamicTree::insertLeaf(int32_t leaf)
+	void DynamicTree::markMoved(int32_t index)
 	{
-		if (m_RootIndex == NULL_NODE)
+		if (!m_Nodes[index].Moved)
 		{
-			m_RootIndex = leaf;
-			return;
+			m_Nodes[index].Moved = true;
+			m_MovedNodes.push_back(index);
 		}
+	}
 
-		AABB leafAABB = m_Nodes[leaf].Box;
-		int32_t index = m_RootIndex;
-		while (!m_Nodes[index].IsLeaf())
+	void DynamicTree::findPairs(size_t begin, size_t end, std::vector<ProxyPair>& pairs) const
+	{
+		for (size_t i = begin; i < end; ++i)
 		{
-			int32_t firstChild = m_Nodes[index].FirstChild;
-			int32_t secondChild = m_Nodes[index].SecondChild;
-
-			float area = m_Nodes[index].Box.GetPerimeter();
-
-			AABB combinedAABB = AABB::Union(m_Nodes[index].Box, leafAABB);
-			float combinedArea = combinedAABB.GetPerimeter();
-
-			// Cost of creating a new parent for this node and the new leaf
-			float cost = 2.0f * combinedArea;
-
-			// Minimum cost of pushing the leaf further down the tree
-			float inheritanceCost = 2.0f * (combinedArea - area);
-
-			// Cost of descending into child1
-			float cost1;
-			if (m_Nodes[firstChild].IsLeaf())
-			{
-				AABB aabb = AABB::Union(leafAABB, m_Nodes[firstChild].Box);
-				cost1 = aabb.GetPerimeter() + inheritanceCost;
-			}
-			else
-			{
-				AABB aabb = AABB::Union(leafAABB, m_Nodes[firstChild].Box);
-				float oldArea = m_Nodes[firstChild].Box.GetPerimeter();
-				float newArea = aabb.GetPerimeter();
-				cost1 = (newArea - oldArea) + inheritanceCost;
-			}
+			const int32_t queryIndex = m_MovedNodes[i];
+			Query(m_Nodes[queryIndex].Box, [&](int32_t index) {
+				if (index == queryIndex)
+					return true;
 
-			// Cost of descending into child2
-			float cost2;
-			if (m_Nodes[secondChild].IsLeaf())
-			{
-				AABB aabb = AABB::Union(leafAABB, m_Nodes[secondChild].Box);
-				cost2 = aabb.GetPerimeter() + inheritanceCost;
-			}
-			else
-			{
-				AABB aabb = AABB::Union(leafAABB, m_Nodes[secondChild].Box);
-				float oldArea = m_Nodes[secondChild].Box.GetPerimeter();
-				float newArea = aabb.GetPerimeter();
-				cost2 = newArea - oldArea + inheritanceCost;
-			}
+				// Pair of two moved proxies is reported only by one of them
+				if (m_Nodes[index].Moved && index > queryIndex)
+					return true;
 
-			// Descend according to the minimum cost.
-			if (cost < cost1 && cost < cost2)
-			{
-				break;
-			}
+				pairs.push_back({ std::min(index, queryIndex), std::max(index, queryIndex) });
+				return true;
+			});
+		}
+	}
 
-			// Descend
-			if (cost1 < cost2)
-			{
-				index = firstChild;
-			}
-			else
-			{
-				index = secondChild;
-			}
+	void DynamicTree::insertLeaf(int32_t leaf)
+	{
+		if (m_RootIndex == NULL_NODE)
+		{
+			m_RootIndex = leaf;
+			return;
 		}
-		int32_t sibling = index;
+
+		const AABB leafAABB = m_Nodes[leaf].Box;
+		const int32_t sibling = findBestSibling(leafAABB);
 
 		// Create a new parent.
 		int32_t oldParent = m_Nodes[sibling].ParentIndex;
@@ -237,21 +259,90 @@ namespace XYZ {
 		}
 
 		// Walk back up the tree fixing heights and AABBs
-		index = m_Nodes[leaf].ParentIndex;
+		int32_t index = m_Nodes[leaf].ParentIndex;
 		while (index != NULL_NODE)
 		{
-			index = balance(index);
-
 			int32_t child1 = m_Nodes[index].FirstChild;
 			int32_t child2 = m_Nodes[index].SecondChild;
 
 			m_Nodes[index].Height = 1 + std::max(m_Nodes[child1].Height, m_Nodes[child2].Height);
 			m_Nodes[index].Box = AABB::Union(m_Nodes[child1].Box, m_Nodes[child2].Box);
+			rotate(index);
 
 			index = m_Nodes[index].ParentIndex;
 		}
 	}
 
+	int32_t DynamicTree::findBestSibling(const AABB& leafAABB) const
+	{
+		// Branch and bound over cost of new parent plus area added to ancestors,
+		// greedy descent alone builds poor trees when many proxies are inserted
+		const glm::vec3 leafCenter = (leafAABB.Min + leafAABB.Max) * 0.5f;
+		const float leafArea = leafAABB.CalculateArea();
+
+		int32_t bestSibling = m_RootIndex;
+		float bestCost = AABB::Union(m_Nodes[m_RootIndex].Box, leafAABB).CalculateArea();
+		float inheritedCost = 0.0f;
+		int32_t index = m_RootIndex;
+		while (!m_Nodes[index].IsLeaf())
+		{
+			const Node& node = m_Nodes[index];
+			const float directCost = AABB::Union(node.Box, leafAABB).CalculateArea();
+			const float cost = directCost + inheritedCost;
+			if (cost < bestCost)
+			{
+				bestSibling = index;
+				bestCost = cost;
+			}
+			// Ancestors grow by the same amount for any node in subtree
+			inheritedCost += directCost - node.Box.CalculateArea();
+
+			const int32_t children[2] = { node.FirstChild, node.SecondChild };
+			float lowerCosts[2];
+			bool  leaves[2];
+			for (int i = 0; i < 2; ++i)
+			{
+				const Node& child = m_Nodes[children[i]];
+				const float directCost = AABB::Union(child.Box, leafAABB).CalculateArea();
+				leaves[i] = child.IsLeaf();
+				if (leaves[i])
+				{
+					const float childCost = directCost + inheritedCost;
+					if (childCost < bestCost)
+					{
+						bestSibling = children[i];
+						bestCost = childCost;
+					}
+					lowerCosts[i] = std::numeric_limits<float>::max();
+				}
+				else
+				{
+					// Lowest cost of any node in subtree of child
+					lowerCosts[i] = inheritedCost + directCost + std::min(leafArea - child.Box.CalculateArea(), 0.0f);
+				}
+			}
+
+			if (leaves[0] && leaves[1])
+				break;
+			if (bestCost <= lowerCosts[0] && bestCost <= lowerCosts[1])
+				break;
+
+			if (lowerCosts[0] == lowerCosts[1] && !leaves[0])
+			{
+				// Tie is common for boxes inside both children, prefer closer one
+				const Node& first = m_Nodes[children[0]];
+				const Node& second = m_Nodes[children[1]];
+				const glm::vec3 d1 = (first.Box.Min + first.Box.Max) * 0.5f - leafCenter;
+				const glm::vec3 d2 = (second.Box.Min + second.Box.Max) * 0.5f - leafCenter;
+				lowerCosts[0] = glm::dot(d1, d1);
+				lowerCosts[1] = glm::dot(d2, d2);
+			}
+
+			index = (lowerCosts[0] < lowerCosts[1] && !leaves[0]) ? children[0] : children[1];
+		}
+		return bestSibling;
+	}
+
 	void DynamicTree::removeLeaf(int32_t index)
 	{
 		if (index == m_RootIndex)
@@ -283,7 +374,6 @@ namespace XYZ {
 			int32_t tmpIndex = grandParent;
 			while (tmpIndex != NULL_NODE)
 			{
-				tmpIndex = balance(tmpIndex);
 				const int32_t firstChild = m_Nodes[tmpIndex].FirstChild;
 				const int32_t secondChild = m_Nodes[tmpIndex].SecondChild;
 			
@@ -301,121 +391,118 @@ namespace XYZ {
 		}
 	}
 
-	int32_t DynamicTree::balance(int32_t iA)
+	void DynamicTree::rotate(int32_t iA)
 	{
-		Node* A = &m_Nodes[iA];
-		if (A->IsLeaf() || A->Height < 2)
-		{
-			return iA;
-		}
-		const int32_t iB = A->FirstChild;
-		const int32_t iC = A->SecondChild;
+		// Swaps grandchild with child of A if it shrinks surface area of changed inner node,
+		// balancing by height alone makes query cost grow with number of proxies
+		Node& A = m_Nodes[iA];
+		if (A.Height < 2)
+			return;
 
-		Node* B = &m_Nodes[iB];
-		Node* C = &m_Nodes[iC];
+		const int32_t iB = A.FirstChild;
+		const int32_t iC = A.SecondChild;
+		Node& B = m_Nodes[iB];
+		Node& C = m_Nodes[iC];
 
-		const int32_t bal = C->Height - B->Height;
-		// Rotate C up
-		if (bal > 1)
-		{
-			const int32_t iF = C->FirstChild;
-			const int32_t iG = C->SecondChild;
-			Node* F = &m_Nodes[iF];
-			Node* G = &m_Nodes[iG];
-
-			C->FirstChild = iA;
-			C->ParentIndex = A->ParentIndex;
-			A->ParentIndex = iC;
-			if (C->ParentIndex != NULL_NODE)
-			{
-				if (m_Nodes[C->ParentIndex].FirstChild == iA)
-					m_Nodes[C->ParentIndex].FirstChild = iC;
-				else
-					m_Nodes[C->ParentIndex].SecondChild = iC;
-			}
-			else
-				m_RootIndex = iC;
+		enum class Rotation { None, BF, BG, CD, CE };
+		Rotation bestRotation = Rotation::None;
+		float bestCost = 0.0f;
+		AABB aabbBG, aabbBF, aabbCE, aabbCD;
 
-			if (F->Height > G->Height)
+		// Costs are relative to current area of inner node that changes
+		if (!C.IsLeaf())
+		{
+			const float areaC = C.Box.CalculateArea();
+			aabbBG = AABB::Union(B.Box, m_Nodes[C.SecondChild].Box);
+			aabbBF = AABB::Union(B.Box, m_Nodes[C.FirstChild].Box);
+			const float costBF = aabbBG.CalculateArea() - areaC;
+			const float costBG = aabbBF.CalculateArea() - areaC;
+			if (costBF < bestCost)
 			{
-				C->SecondChild = iF;
-				A->SecondChild = iG;
-				G->ParentIndex = iA;
-				A->Box = AABB::Union(B->Box, G->Box);
-				C->Box = AABB::Union(A->Box, F->Box);
-
-				A->Height = 1 + std::max(B->Height, G->Height);
-				C->Height = 1 + std::max(A->Height, F->Height);
+				bestRotation = Rotation::BF;
+				bestCost = costBF;
 			}
-			else
+			if (costBG < bestCost)
 			{
-				C->SecondChild = iG;
-				A->SecondChild = iF;
-				F->ParentIndex = iA;
-				A->Box = AABB::Union(B->Box, F->Box);
-				C->Box = AABB::Union(A->Box, G->Box);
-
-				A->Height = 1 + std::max(B->Height, F->Height);
-				C->Height = 1 + std::max(A->Height, G->Height);
+				bestRotation = Rotation::BG;
+				bestCost = costBG;
 			}
-			return iC;
 		}
-		
-		if (bal < -1)
+		if (!B.IsLeaf())
 		{
-			const int32_t iD = B->FirstChild;
-			const int32_t iE = B->SecondChild;
-			Node* D = &m_Nodes[iD];
-			Node* E = &m_Nodes[iE];
-		
-			// Swap A and B
-			B->FirstChild = iA;
-			B->ParentIndex = A->ParentIndex;
-			A->ParentIndex = iB;
-
-			// A's old parent should point to B
-			if (B->ParentIndex != NULL_NODE)
+			const float areaB = B.Box.CalculateArea();
+			aabbCE = AABB::Union(C.Box, m_Nodes[B.SecondChild].Box);
+			aabbCD = AABB::Union(C.Box, m_Nodes[B.FirstChild].Box);
+			const float costCD = aabbCE.CalculateArea() - areaB;
+			const float costCE = aabbCD.CalculateArea() - areaB;
+			if (costCD < bestCost)
 			{
-				if (m_Nodes[B->ParentIndex].FirstChild == iA)
-				{
-					m_Nodes[B->ParentIndex].FirstChild = iB;
-				}
-				else
-				{
-					m_Nodes[B->ParentIndex].SecondChild = iB;
-				}
-			}
-			else
-			{
-				m_RootIndex = iB;
+				bestRotation = Rotation::CD;
+				bestCost = costCD;
 			}
-
-			// Rotate
-			if (D->Height > E->Height)
-			{
-				B->SecondChild = iD;
-				A->FirstChild = iE;
-				E->ParentIndex = iA;
-				A->Box = AABB::Union(C->Box, E->Box);
-				B->Box = AABB::Union(A->Box, D->Box);
-
-				A->Height = 1 + std::max(C->Height, E->Height);
-				B->Height = 1 + std::max(A->Height, D->Height);
-			}
-			else
+			if (costCE < bestCost)
 			{
-				B->SecondChild = iE;
-				A->FirstChild = iD;
-				D->ParentIndex = iA;
-				A->Box = AABB::Union(C->Box, D->Box);
-				B->Box = AABB::Union(A->Box, E->Box);
-
-				A->Height = 1 + std::max(C->Height, D->Height);
-				B->Height = 1 + std::max(A->Height, E->Height);
+				bestRotation = Rotation::CE;
+				bestCost = costCE;
 			}
+		}
 
-			return iB;
+		switch (bestRotation)
+		{
+		case Rotation::None:
+			break;
+		case Rotation::BF:
+		{
+			const int32_t iF = C.FirstChild;
+			const int32_t iG = C.SecondChild;
+			A.FirstChild = iF;
+			C.FirstChild = iB;
+			B.ParentIndex = iC;
+			m_Nodes[iF].ParentIndex = iA;
+			C.Box = aabbBG;
+			C.Height = 1 + std::max(B.Height, m_Nodes[iG].Height);
+			A.Height = 1 + std::max(C.Height, m_Nodes[iF].Height);
+			break;
+		}
+		case Rotation::BG:
+		{
+			const int32_t iF = C.FirstChild;
+			const int32_t iG = C.SecondChild;
+			A.FirstChild = iG;
+			C.SecondChild = iB;
+			B.ParentIndex = iC;
+			m_Nodes[iG].ParentIndex = iA;
+			C.Box = aabbBF;
+			C.Height = 1 + std::max(B.Height, m_Nodes[iF].Height);
+			A.Height = 1 + std::max(C.Height, m_Nodes[iG].Height);
+			break;
+		}
+		case Rotation::CD:
+		{
+			const int32_t iD = B.FirstChild;
+			const int32_t iE = B.SecondChild;
+			A.SecondChild = iD;
+			B.FirstChild = iC;
+			C.ParentIndex = iB;
+			m_Nodes[iD].ParentIndex = iA;
+			B.Box = aabbCE;
+			B.Height = 1 + std::max(C.Height, m_Nodes[iE].Height);
+			A.Height = 1 + std::max(B.Height, m_Nodes[iD].Height);
+			break;
+		}
+		case Rotation::CE:
+		{
+			const int32_t iD = B.FirstChild;
+			const int32_t iE = B.SecondChild;
+			A.SecondChild = iE;
+			B.SecondChild = iC;
+			C.ParentIndex = iB;
+			m_Nodes[iE].ParentIndex = iA;
+			B.Box = aabbCD;
+			B.Height = 1 + std::max(C.Height, m_Nodes[iD].Height);
+			A.Height = 1 + std::max(B.Height, m_Nodes[iE].Height);
+			break;
+		}
 		}
-		return iA;
 	}
 }
\ No newline at end of file
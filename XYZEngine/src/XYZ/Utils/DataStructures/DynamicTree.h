@@ -5,53 +5,175 @@
 
 #include "XYZ/Renderer/Renderer2D.h"
 
-#include <stack>
+#include <limits>
 
 namespace XYZ {
 
+	class ThreadPool;
+
 #define NULL_NODE (-1)
 	struct Node
 	{
-		AABB	 Box;
+		AABB	 Box; // Fattened for leaves
 		uint32_t DataIndex;
 
 		int32_t ParentIndex = NULL_NODE;
 		int32_t FirstChild = NULL_NODE;
 		int32_t SecondChild = NULL_NODE;
 		int32_t Height = 0;
+		bool	Moved = false;
 
 		bool IsLeaf() const { return FirstChild == NULL_NODE; }
 	};
 
-	using CollisionCallback = std::function<bool(int32_t)>;
+	// Traversal stack, spills to heap only when tree is deeper than inline storage
+	class DynamicTreeStack
+	{
+	public:
+		static constexpr uint32_t sc_InlineSize = 256;
+
+		void Push(int32_t index)
+		{
+			if (m_Size < sc_InlineSize)
+				m_Inline[m_Size] = index;
+			else
+				m_Overflow.push_back(index);
+			m_Size++;
+		}
+		int32_t Pop()
+		{
+			m_Size--;
+			if (m_Size < sc_InlineSize)
+				return m_Inline[m_Size];
+			const int32_t index = m_Overflow.back();
+			m_Overflow.pop_back();
+			return index;
+		}
+		bool Empty() const { return m_Size == 0; }
 
+	private:
+		int32_t				 m_Inline[sc_InlineSize];
+		uint32_t			 m_Size = 0;
+		std::vector<int32_t> m_Overflow;
+	};
+
+	struct ProxyPair
+	{
+		int32_t First;
+		int32_t Second;
+	};
+
+	// Dynamic AABB tree, leaves store fattened bounds so small movement does not touch the tree.
+	// Based on Box2D b2DynamicTree, inner nodes are rotated to reduce surface area instead of height
 	class XYZ_API DynamicTree
 	{
 	public:
-		bool RayCast(const Ray& ray, uint32_t& result);
-		void Query(const CollisionCallback& callback, const AABB& aabb);
+		static constexpr float	  sc_AABBMargin = 0.1f;
+		static constexpr float	  sc_DisplacementMultiplier = 4.0f;
+		static constexpr uint32_t sc_PerJobCount = 256;
+
+		bool RayCast(const Ray& ray, uint32_t& result) const;
+
+		// Calls visitor(proxy) for every leaf overlapping aabb, visitor returns false to stop query
+		template <typename Visitor>
+		void Query(const AABB& aabb, Visitor&& visitor) const;
+
+		// Calls visitor(proxy, maxDistance) for every leaf hit by ray closer than maxDistance,
+		// visitor may shorten maxDistance
+		template <typename Visitor>
+		void RayCast(const Ray& ray, float maxDistance, Visitor&& visitor) const;
 
 		int32_t Insert(uint32_t objectIndex, const AABB& box);
+		// Reinserts proxy only if box left its fattened bounds, returns true if it did.
+		// Fattened bounds are extended in direction of displacement
+		bool Move(int32_t index, const AABB& box, const glm::vec3& displacement);
+		void Move(int32_t index, const glm::vec3& displacement);
 		void Move(int32_t index, const glm::vec2& displacement);
 		void Remove(int32_t index);
 
-		uint32_t GetDataIndex(int32_t index) const { return m_Nodes[index].DataIndex; }
-		const AABB& GetAABB(int32_t index) const { return m_Nodes[index].Box; }
+		// Finds every overlapping pair with at least one proxy moved since last CleanMovedNodes,
+		// each pair is reported once. Moved proxies are split between jobs if pool is provided
+		void FindPairs(std::vector<ProxyPair>& pairs, ThreadPool* pool = nullptr) const;
+		// Runs query for every box, result pairs contain index of box and overlapping proxy
+		void QueryBatch(const std::vector<AABB>& boxes, std::vector<ProxyPair>& result, ThreadPool* pool = nullptr) const;
+
+		uint32_t	GetDataIndex(int32_t index) const { return m_Nodes[index].DataIndex; }
+		const AABB& GetAABB(int32_t index)		const { return m_Nodes[index].Box; }
+		int32_t		GetHeight()					const { return m_RootIndex == NULL_NODE ? 0 : m_Nodes[m_RootIndex].Height; }
 		// Debug
 		void SubmitToRenderer(Ref<Renderer2D> renderer2D);
 
 		void CleanMovedNodes();
-		const std::vector<bool>& GetMovedNodes() const { return m_MovedNodes; }
+		const std::vector<int32_t>& GetMovedNodes() const { return m_MovedNodes; }
 
 	private:
 		void insertLeaf(int32_t index);
+		int32_t findBestSibling(const AABB& leafAABB) const;
 		void removeLeaf(int32_t leaf);
-		int32_t balance(int32_t index);
+		void rotate(int32_t index);
+		void markMoved(int32_t index);
+		void findPairs(size_t begin, size_t end, std::vector<ProxyPair>& pairs) const;
 
 	private:
 		FreeList<Node> m_Nodes;
 
-		std::vector<bool> m_MovedNodes;
+		std::vector<int32_t> m_MovedNodes;
 		int32_t m_RootIndex = NULL_NODE;
 	};
-}
\ No newline at end of file
+
+	template <typename Visitor>
+	inline void DynamicTree::Query(const AABB& aabb, Visitor&& visitor) const
+	{
+		if (m_RootIndex == NULL_NODE)
+			return;
+
+		DynamicTreeStack stack;
+		stack.Push(m_RootIndex);
+		while (!stack.Empty())
+		{
+			const int32_t index = stack.Pop();
+			const Node& node = m_Nodes[index];
+			if (!node.Box.Intersect(aabb))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				if (!visitor(index))
+					return;
+			}
+			else
+			{
+				stack.Push(node.FirstChild);
+				stack.Push(node.SecondChild);
+			}
+		}
+	}
+
+	template <typename Visitor>
+	inline void DynamicTree::RayCast(const Ray& ray, float maxDistance, Visitor&& visitor) const
+	{
+		if (m_RootIndex == NULL_NODE)
+			return;
+
+		DynamicTreeStack stack;
+		stack.Push(m_RootIndex);
+		while (!stack.Empty())
+		{
+			const int32_t index = stack.Pop();
+			const Node& node = m_Nodes[index];
+			float distance = 0.0f;
+			if (!ray.IntersectsAABB(node.Box, distance) || distance > maxDistance)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				visitor(index, maxDistance);
+			}
+			else
+			{
+				stack.Push(node.FirstChild);
+				stack.Push(node.SecondChild);
+			}
+		}
+	}
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+
+#include <vector>
+
+namespace XYZ {
+
+	// Open addressing table of 32 bit values with linear probing. Keys are not stored,
+	// slot keeps only part of hash and value, caller compares key through value
+	class HashIndex
+	{
+	public:
+		static constexpr uint32_t sc_Invalid = UINT32_MAX;
+
+		// Returns value for which equal(value) is true, or sc_Invalid
+		template <typename Equal>
+		uint32_t Find(size_t hash, Equal&& equal) const;
+
+		// Value must not be in table yet
+		void Insert(size_t hash, uint32_t value);
+
+		// Changes value of existing entry, returns false if not found
+		template <typename Equal>
+		bool Replace(size_t hash, Equal&& equal, uint32_t value);
+
+		template <typename Equal>
+		bool Erase(size_t hash, Equal&& equal);
+
+		void Reserve(uint32_t count);
+		void Clear();
+
+		uint32_t Size() const { return m_Count; }
+
+	private:
+		struct Slot
+		{
+			uint32_t Hash;
+			uint32_t Value;
+		};
+
+		template <typename Equal>
+		Slot* findSlot(size_t hash, Equal&& equal);
+		void  rehash(uint32_t capacity);
+
+		static uint32_t shortHash(size_t hash) { return static_cast<uint32_t>(hash ^ (static_cast<uint64_t>(hash) >> 32)); }
+
+	private:
+		std::vector<Slot> m_Slots;
+		uint32_t		  m_Count = 0;
+		uint32_t		  m_Deleted = 0;
+
+		static constexpr uint32_t sc_Empty = UINT32_MAX;
+		static constexpr uint32_t sc_Tombstone = UINT32_MAX - 1;
+		static constexpr uint32_t sc_MinCapacity = 16;
+	};
+
+	template <typename Equal>
+	inline uint32_t HashIndex::Find(size_t hash, Equal&& equal) const
+	{
+		if (m_Slots.empty())
+			return sc_Invalid;
+
+		const uint32_t mask = static_cast<uint32_t>(m_Slots.size()) - 1;
+		const uint32_t shortKey = shortHash(hash);
+		for (uint32_t i = shortKey & mask;; i = (i + 1) & mask)
+		{
+			const Slot& slot = m_Slots[i];
+			if (slot.Value == sc_Empty)
+				return sc_Invalid;
+			if (slot.Value != sc_Tombstone && slot.Hash == shortKey && equal(slot.Value))
+				return slot.Value;
+		}
+	}
+
+	inline void HashIndex::Insert(size_t hash, uint32_t value)
+	{
+		XYZ_ASSERT(value < sc_Tombstone, "Value is reserved");
+		// Tombstones count to load, otherwise probe sequences would never end on empty slot
+		if ((m_Count + m_Deleted + 1) * 4 > m_Slots.size() * 3)
+			rehash(std::max(sc_MinCapacity, static_cast<uint32_t>(m_Slots.size()) * (m_Count * 2 >= m_Slots.size() ? 2 : 1)));
+
+		const uint32_t mask = static_cast<uint32_t>(m_Slots.size()) - 1;
+		const uint32_t shortKey = shortHash(hash);
+		for (uint32_t i = shortKey & mask;; i = (i + 1) & mask)
+		{
+			Slot& slot = m_Slots[i];
+			if (slot.Value == sc_Empty || slot.Value == sc_Tombstone)
+			{
+				if (slot.Value == sc_Tombstone)
+					m_Deleted--;
+				slot = { shortKey, value };
+				m_Count++;
+				return;
+			}
+		}
+	}
+
+	template <typename Equal>
+	inline bool HashIndex::Replace(size_t hash, Equal&& equal, uint32_t value)
+	{
+		XYZ_ASSERT(value < sc_Tombstone, "Value is reserved");
+		Slot* slot = findSlot(hash, std::forward<Equal>(equal));
+		if (!slot)
+			return false;
+		slot->Value = value;
+		return true;
+	}
+
+	template <typename Equal>
+	inline bool HashIndex::Erase(size_t hash, Equal&& equal)
+	{
+		Slot* slot = findSlot(hash, std::forward<Equal>(equal));
+		if (!slot)
+			return false;
+		slot->Value = sc_Tombstone;
+		m_Count--;
+		m_Deleted++;
+		return true;
+	}
+
+	inline void HashIndex::Reserve(uint32_t count)
+	{
+		uint32_t capacity = sc_MinCapacity;
+		while (capacity * 3 < count * 4)
+			capacity *= 2;
+		if (capacity > m_Slots.size())
+			rehash(capacity);
+	}
+
+	inline void HashIndex::Clear()
+	{
+		m_Slots.clear();
+		m_Count = 0;
+		m_Deleted = 0;
+	}
+
+	template <typename Equal>
+	inline HashIndex::Slot* HashIndex::findSlot(size_t hash, Equal&& equal)
+	{
+		if (m_Slots.empty())
+			return nullptr;
+
+		const uint32_t mask = static_cast<uint32_t>(m_Slots.size()) - 1;
+		const uint32_t shortKey = shortHash(hash);
+		for (uint32_t i = shortKey & mask;; i = (i + 1) & mask)
+		{
+			Slot& slot = m_Slots[i];
+			if (slot.Value == sc_Empty)
+				return nullptr;
+			if (slot.Value != sc_Tombstone && slot.Hash == shortKey && equal(slot.Value))
+				return &slot;
+		}
+	}
+
+	inline void HashIndex::rehash(uint32_t capacity)
+	{
+		// Short hash is kept in slot, table grows without touching keys
+		std::vector<Slot> old = std::move(m_Slots);
+		m_Slots.assign(capacity, { 0, sc_Empty });
+		m_Deleted = 0;
+
+		const uint32_t mask = capacity - 1;
+		for (const Slot& slot : old)
+		{
+			if (slot.Value == sc_Empty || slot.Value == sc_Tombstone)
+				continue;
+			uint32_t i = slot.Hash & mask;
+			while (m_Slots[i].Value != sc_Empty)
+				i = (i + 1) & mask;
+			m_Slots[i] = slot;
+		}
+	}
+}
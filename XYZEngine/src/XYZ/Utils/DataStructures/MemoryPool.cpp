@@ -177,6 +177,7 @@ namespace XYZ {
 			if (chunk.Size > sizeReq)
 			{
 				Chunk result(sizeReq, chunk.ChunkIndex, chunk.BlockIndex);
+				chunk.ChunkIndex += sizeReq;
 				chunk.Size -= sizeReq;
 				return result;
 			}
@@ -188,6 +189,9 @@ namespace XYZ {
 			}
 		}
 
+		if (m_Blocks.empty())
+			createBlock();
+
 		Block* inUse = &m_Blocks[m_BlockInUse];
 		if (inUse->NextAvailableIndex + sizeReq > m_BlockSize)
 		{
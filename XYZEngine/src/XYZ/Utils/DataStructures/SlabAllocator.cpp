@@ -0,0 +1,359 @@
+#include "stdafx.h"
+#include "SlabAllocator.h"
+
+#include "XYZ/Debug/Profiler.h"
+
+namespace XYZ {
+
+	namespace {
+		struct SizeClassTable
+		{
+			std::array<uint32_t, SlabAllocator::sc_NumSizeClasses>		   Sizes{};
+			std::array<uint32_t, SlabAllocator::sc_NumSizeClasses>		   CacheLimits{};
+			std::array<uint8_t, SlabAllocator::sc_MaxSmallSize / 16 + 1> Lookup{}; // Size rounded up to 16 bytes to class
+		};
+
+		// 16 byte steps up to 128, then four classes per power of two, waste is at most 25%
+		constexpr SizeClassTable makeSizeClassTable()
+		{
+			SizeClassTable table{};
+			for (uint32_t i = 0; i < 8; ++i)
+				table.Sizes[i] = (i + 1) * 16;
+			for (uint32_t i = 8; i < SlabAllocator::sc_NumSizeClasses; ++i)
+				table.Sizes[i] = ((i - 8) % 4 + 5) << (5 + (i - 8) / 4);
+			for (uint32_t i = 0; i < SlabAllocator::sc_NumSizeClasses; ++i)
+				table.CacheLimits[i] = std::clamp(SlabAllocator::sc_ThreadCacheBytes / table.Sizes[i], 2u, 64u);
+
+			uint32_t sizeClass = 0;
+			for (uint32_t i = 0; i < table.Lookup.size(); ++i)
+			{
+				while (table.Sizes[sizeClass] < i * 16)
+					sizeClass++;
+				table.Lookup[i] = static_cast<uint8_t>(sizeClass);
+			}
+			return table;
+		}
+		constexpr SizeClassTable s_SizeClasses = makeSizeClassTable();
+		static_assert(s_SizeClasses.Sizes[SlabAllocator::sc_NumSizeClasses - 1] == SlabAllocator::sc_MaxSmallSize);
+
+		// Constant initialized, access does not go through guard
+		thread_local uint32_t t_ThreadIndex = UINT32_MAX;
+
+		template <typename T>
+		void addOwned(std::atomic<T>& counter, T value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		void* alignedAllocate(size_t size, size_t alignment)
+		{
+			#ifdef XYZ_PLATFORM_WINDOWS
+			return _aligned_malloc(size, alignment);
+			#else
+			return std::aligned_alloc(alignment, size);
+			#endif
+		}
+		void alignedFree(void* memory)
+		{
+			#ifdef XYZ_PLATFORM_WINDOWS
+			_aligned_free(memory);
+			#else
+			std::free(memory);
+			#endif
+		}
+	}
+
+	SlabAllocator::SlabAllocator()
+	{
+		static_assert(sizeof(Slab) <= sc_HeaderSize);
+	}
+	SlabAllocator::~SlabAllocator()
+	{
+		if (GetNumAllocations() != 0 || GetMemoryUsed() != 0)
+			XYZ_CORE_WARN("Memory not released, number of elements: {} not released memory: {}", GetNumAllocations(), GetMemoryUsed());
+
+		// Blocks left in thread caches belong to slabs, releasing slabs is enough
+		for (SizeClass& sizeClass : m_Classes)
+		{
+			while (sizeClass.Partial)
+			{
+				Slab* slab = sizeClass.Partial;
+				unlinkSlab(sizeClass.Partial, slab);
+				destroySlab(slab);
+			}
+			while (sizeClass.Full)
+			{
+				Slab* slab = sizeClass.Full;
+				unlinkSlab(sizeClass.Full, slab);
+				destroySlab(slab);
+			}
+		}
+		while (m_LargeSlabs)
+		{
+			Slab* slab = m_LargeSlabs;
+			unlinkSlab(m_LargeSlabs, slab);
+			destroySlab(slab);
+		}
+	}
+
+	void* SlabAllocator::Allocate(uint32_t size)
+	{
+		XYZ_PROFILE_FUNC("SlabAllocator::Allocate");
+		if (size > sc_MaxSmallSize)
+			return allocateLarge(size);
+
+		const uint32_t sizeClass = GetSizeClass(size);
+		const uint32_t thread = threadIndex();
+		if (thread < sc_MaxThreadCaches)
+		{
+			ThreadCache& cache = m_ThreadCaches[thread];
+			addOwned<int64_t>(cache.NumAllocations, 1);
+			addOwned<int64_t>(cache.MemoryUsed, s_SizeClasses.Sizes[sizeClass]);
+			if (!cache.Lists[sizeClass])
+				refill(cache, sizeClass);
+
+			FreeBlock* block = cache.Lists[sizeClass];
+			cache.Lists[sizeClass] = block->Next;
+			cache.Counts[sizeClass]--;
+			return block;
+		}
+
+		m_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+		m_MemoryUsed.fetch_add(s_SizeClasses.Sizes[sizeClass], std::memory_order_relaxed);
+		std::scoped_lock lock(m_Classes[sizeClass].Mutex);
+		FreeBlock* block = nullptr;
+		takeBlocks(sizeClass, &block, 1);
+		return block;
+	}
+
+	void SlabAllocator::Deallocate(const void* val)
+	{
+		XYZ_PROFILE_FUNC("SlabAllocator::Deallocate");
+		if (!val)
+			return;
+
+		// Size class is written once when slab is created, reading it without lock is safe
+		Slab* slab = findSlab(val);
+		if (slab->SizeClass == sc_LargeClass)
+		{
+			deallocateLarge(slab);
+			return;
+		}
+
+		const uint32_t sizeClass = slab->SizeClass;
+		FreeBlock* block = static_cast<FreeBlock*>(const_cast<void*>(val));
+		const uint32_t thread = threadIndex();
+		if (thread < sc_MaxThreadCaches)
+		{
+			ThreadCache& cache = m_ThreadCaches[thread];
+			addOwned<int64_t>(cache.NumAllocations, -1);
+			addOwned<int64_t>(cache.MemoryUsed, -static_cast<int64_t>(s_SizeClasses.Sizes[sizeClass]));
+			block->Next = cache.Lists[sizeClass];
+			cache.Lists[sizeClass] = block;
+			const uint32_t limit = s_SizeClasses.CacheLimits[sizeClass];
+			if (++cache.Counts[sizeClass] > limit)
+				flush(cache, sizeClass, cache.Counts[sizeClass] - limit / 2);
+			return;
+		}
+
+		m_NumAllocations.fetch_sub(1, std::memory_order_relaxed);
+		m_MemoryUsed.fetch_sub(s_SizeClasses.Sizes[sizeClass], std::memory_order_relaxed);
+		std::scoped_lock lock(m_Classes[sizeClass].Mutex);
+		returnBlock(sizeClass, block);
+	}
+
+	uint32_t SlabAllocator::GetMemoryUsed() const
+	{
+		int64_t result = m_MemoryUsed.load(std::memory_order_relaxed);
+		for (const ThreadCache& cache : m_ThreadCaches)
+			result += cache.MemoryUsed.load(std::memory_order_relaxed);
+		return static_cast<uint32_t>(result);
+	}
+
+	uint32_t SlabAllocator::GetNumAllocations() const
+	{
+		int64_t result = m_NumAllocations.load(std::memory_order_relaxed);
+		for (const ThreadCache& cache : m_ThreadCaches)
+			result += cache.NumAllocations.load(std::memory_order_relaxed);
+		return static_cast<uint32_t>(result);
+	}
+
+	std::vector<SlabAllocator::SizeClassStats> SlabAllocator::GetSizeClassStats() const
+	{
+		std::vector<SizeClassStats> result;
+		result.reserve(sc_NumSizeClasses + 1);
+		for (uint32_t i = 0; i < sc_NumSizeClasses; ++i)
+		{
+			const SizeClass& sizeClass = m_Classes[i];
+			std::scoped_lock lock(sizeClass.Mutex);
+			result.push_back({ s_SizeClasses.Sizes[i], sizeClass.NumSlabs, sizeClass.UsedBlocks });
+		}
+
+		std::scoped_lock lock(m_LargeMutex);
+		result.push_back({ sc_MaxSmallSize, m_NumLargeSlabs, m_NumLargeSlabs });
+		return result;
+	}
+
+	uint32_t SlabAllocator::GetSizeClass(uint32_t size)
+	{
+		XYZ_ASSERT(size <= sc_MaxSmallSize, "Size does not have size class");
+		return s_SizeClasses.Lookup[(size + 15) >> 4];
+	}
+
+	uint32_t SlabAllocator::GetClassSize(uint32_t sizeClass)
+	{
+		return s_SizeClasses.Sizes[sizeClass];
+	}
+
+	void* SlabAllocator::allocateLarge(uint32_t size)
+	{
+		// Rounded to slab size, header lies on alignment boundary below returned pointer
+		const uint64_t slabSize = (static_cast<uint64_t>(sc_HeaderSize) + size + sc_SlabSize - 1) & ~static_cast<uint64_t>(sc_SlabSize - 1);
+		void* memory = alignedAllocate(slabSize, sc_SlabSize);
+		XYZ_ASSERT(memory, "Failed to allocate slab");
+
+		Slab* slab = new(memory) Slab{ sc_LargeClass, 1, 1, 1, nullptr, nullptr, nullptr, size };
+		{
+			std::scoped_lock lock(m_LargeMutex);
+			linkSlab(m_LargeSlabs, slab);
+			m_NumLargeSlabs++;
+		}
+		m_NumSlabs.fetch_add(1, std::memory_order_relaxed);
+		m_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+		m_MemoryUsed.fetch_add(size, std::memory_order_relaxed);
+		return static_cast<uint8_t*>(memory) + sc_HeaderSize;
+	}
+
+	void SlabAllocator::deallocateLarge(Slab* slab)
+	{
+		m_NumAllocations.fetch_sub(1, std::memory_order_relaxed);
+		m_MemoryUsed.fetch_sub(slab->Size, std::memory_order_relaxed);
+		{
+			std::scoped_lock lock(m_LargeMutex);
+			unlinkSlab(m_LargeSlabs, slab);
+			m_NumLargeSlabs--;
+		}
+		destroySlab(slab);
+	}
+
+	uint32_t SlabAllocator::takeBlocks(uint32_t sizeClass, FreeBlock** head, uint32_t count)
+	{
+		SizeClass& central = m_Classes[sizeClass];
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Slab* slab = central.Partial;
+			if (!slab)
+				slab = createSlab(sizeClass);
+
+			FreeBlock* block = slab->FreeList;
+			if (block)
+				slab->FreeList = block->Next;
+			else
+				block = reinterpret_cast<FreeBlock*>(reinterpret_cast<uint8_t*>(slab) + sc_HeaderSize + slab->BumpIndex++ * s_SizeClasses.Sizes[sizeClass]);
+
+			block->Next = *head;
+			*head = block;
+			if (++slab->UsedCount == slab->Capacity)
+			{
+				unlinkSlab(central.Partial, slab);
+				linkSlab(central.Full, slab);
+			}
+		}
+		central.UsedBlocks += count;
+		return count;
+	}
+
+	void SlabAllocator::returnBlock(uint32_t sizeClass, FreeBlock* block)
+	{
+		SizeClass& central = m_Classes[sizeClass];
+		Slab* slab = findSlab(block);
+		if (slab->UsedCount == slab->Capacity)
+		{
+			unlinkSlab(central.Full, slab);
+			linkSlab(central.Partial, slab);
+		}
+		block->Next = slab->FreeList;
+		slab->FreeList = block;
+		central.UsedBlocks--;
+
+		// Last slab of class is kept, allocation pattern around one slab boundary would create and destroy it repeatedly
+		if (--slab->UsedCount == 0 && central.NumSlabs > 1)
+		{
+			unlinkSlab(central.Partial, slab);
+			destroySlab(slab);
+			central.NumSlabs--;
+		}
+	}
+
+	void SlabAllocator::refill(ThreadCache& cache, uint32_t sizeClass)
+	{
+		std::scoped_lock lock(m_Classes[sizeClass].Mutex);
+		cache.Counts[sizeClass] += takeBlocks(sizeClass, &cache.Lists[sizeClass], s_SizeClasses.CacheLimits[sizeClass] / 2);
+	}
+
+	void SlabAllocator::flush(ThreadCache& cache, uint32_t sizeClass, uint32_t count)
+	{
+		std::scoped_lock lock(m_Classes[sizeClass].Mutex);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			FreeBlock* block = cache.Lists[sizeClass];
+			cache.Lists[sizeClass] = block->Next;
+			returnBlock(sizeClass, block);
+		}
+		cache.Counts[sizeClass] -= count;
+	}
+
+	SlabAllocator::Slab* SlabAllocator::createSlab(uint32_t sizeClass)
+	{
+		void* memory = alignedAllocate(sc_SlabSize, sc_SlabSize);
+		XYZ_ASSERT(memory, "Failed to allocate slab");
+
+		const uint32_t capacity = (sc_SlabSize - sc_HeaderSize) / s_SizeClasses.Sizes[sizeClass];
+		Slab* slab = new(memory) Slab{ sizeClass, capacity, 0, 0, nullptr, nullptr, nullptr, 0 };
+		linkSlab(m_Classes[sizeClass].Partial, slab);
+		m_Classes[sizeClass].NumSlabs++;
+		m_NumSlabs.fetch_add(1, std::memory_order_relaxed);
+		return slab;
+	}
+
+	void SlabAllocator::destroySlab(Slab* slab)
+	{
+		m_NumSlabs.fetch_sub(1, std::memory_order_relaxed);
+		alignedFree(slab);
+	}
+
+	void SlabAllocator::linkSlab(Slab*& list, Slab* slab)
+	{
+		slab->Previous = nullptr;
+		slab->Next = list;
+		if (list)
+			list->Previous = slab;
+		list = slab;
+	}
+
+	void SlabAllocator::unlinkSlab(Slab*& list, Slab* slab)
+	{
+		if (slab->Previous)
+			slab->Previous->Next = slab->Next;
+		else
+			list = slab->Next;
+		if (slab->Next)
+			slab->Next->Previous = slab->Previous;
+		slab->Next = nullptr;
+		slab->Previous = nullptr;
+	}
+
+	SlabAllocator::Slab* SlabAllocator::findSlab(const void* val)
+	{
+		return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(val) & ~static_cast<uintptr_t>(sc_SlabSize - 1));
+	}
+
+	uint32_t SlabAllocator::threadIndex()
+	{
+		// Indices are never reused, threads started after limit is reached go through central lists
+		static std::atomic<uint32_t> s_NextThreadIndex = 0;
+		if (t_ThreadIndex == UINT32_MAX)
+			t_ThreadIndex = s_NextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+		return t_ThreadIndex;
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace XYZ {
+
+	// Segregated free lists, every slab holds blocks of one size class.
+	// Slabs are aligned to their size, owning slab of pointer is found by masking it.
+	// Each thread keeps small list of free blocks per class, central lists are locked only on refill and flush
+	class XYZ_API SlabAllocator
+	{
+	public:
+		static constexpr uint32_t sc_SlabSize = 64 * 1024;
+		static constexpr uint32_t sc_MaxSmallSize = 16 * 1024; // Bigger allocations get dedicated slab
+		static constexpr uint32_t sc_NumSizeClasses = 36;
+		static constexpr uint32_t sc_MaxThreadCaches = 64;	   // Threads over limit use central lists directly
+		static constexpr uint32_t sc_ThreadCacheBytes = 32 * 1024; // Per class, bounds memory stranded in caches of finished threads
+
+		struct SizeClassStats
+		{
+			uint32_t BlockSize = 0;
+			uint32_t NumSlabs = 0;
+			uint32_t UsedBlocks = 0; // Blocks in thread caches are counted as used
+		};
+
+		SlabAllocator();
+		SlabAllocator(const SlabAllocator& other) = delete;
+		~SlabAllocator();
+
+		SlabAllocator& operator=(const SlabAllocator& other) = delete;
+
+		void* Allocate(uint32_t size);
+		void  Deallocate(const void* val);
+
+		// Same meaning as in MemoryPool, block is slab
+		uint32_t GetMemoryUsed()	 const;
+		uint32_t GetNumAllocations() const;
+		uint32_t GetBlockSize()		 const { return sc_SlabSize; }
+		uint32_t GetNumBlocks()		 const { return m_NumSlabs.load(std::memory_order_relaxed); }
+
+		// Dedicated slabs of big allocations are reported as last entry
+		std::vector<SizeClassStats> GetSizeClassStats() const;
+
+		static uint32_t GetSizeClass(uint32_t size);
+		static uint32_t GetClassSize(uint32_t sizeClass);
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* Next;
+		};
+
+		struct Slab
+		{
+			uint32_t   SizeClass;
+			uint32_t   Capacity;
+			uint32_t   UsedCount;  // Blocks taken from slab, includes blocks sitting in thread caches
+			uint32_t   BumpIndex;  // Blocks past it were never used, new slab does not have to be threaded
+			FreeBlock* FreeList;
+			Slab*	   Next;	   // Partial list of size class
+			Slab*	   Previous;
+			uint64_t   Size;	   // Requested size of dedicated slab
+		};
+
+		struct SizeClass
+		{
+			mutable std::mutex Mutex;
+			Slab*	   Partial = nullptr;
+			Slab*	   Full = nullptr;
+			uint32_t   NumSlabs = 0;
+			uint32_t   UsedBlocks = 0;
+		};
+
+		// Counters are written only by owning thread, no read-modify-write is needed.
+		// Block freed by other thread than allocated it makes them negative, only sum is meaningful
+		struct alignas(64) ThreadCache
+		{
+			std::array<FreeBlock*, sc_NumSizeClasses> Lists{};
+			std::array<uint32_t, sc_NumSizeClasses>	  Counts{};
+			std::atomic<int64_t>					  MemoryUsed = 0;
+			std::atomic<int64_t>					  NumAllocations = 0;
+		};
+
+		void* allocateLarge(uint32_t size);
+		void  deallocateLarge(Slab* slab);
+
+		// Called with class mutex locked
+		uint32_t takeBlocks(uint32_t sizeClass, FreeBlock** head, uint32_t count);
+		void	 returnBlock(uint32_t sizeClass, FreeBlock* block);
+
+		void	 refill(ThreadCache& cache, uint32_t sizeClass);
+		void	 flush(ThreadCache& cache, uint32_t sizeClass, uint32_t count);
+
+		Slab* createSlab(uint32_t sizeClass);
+		void  destroySlab(Slab* slab);
+
+		static void	 linkSlab(Slab*& list, Slab* slab);
+		static void	 unlinkSlab(Slab*& list, Slab* slab);
+		static Slab* findSlab(const void* val);
+
+		static uint32_t threadIndex();
+
+	private:
+		std::array<SizeClass, sc_NumSizeClasses>	m_Classes;
+		std::array<ThreadCache, sc_MaxThreadCaches> m_ThreadCaches;
+
+		mutable std::mutex		 m_LargeMutex;
+		Slab*					 m_LargeSlabs = nullptr;
+		uint32_t				 m_NumLargeSlabs = 0;
+
+		// Allocations that did not go through thread cache
+		std::atomic<int64_t>	 m_MemoryUsed = 0;
+		std::atomic<int64_t>	 m_NumAllocations = 0;
+		std::atomic<uint32_t>	 m_NumSlabs = 0;
+
+		static constexpr uint32_t sc_HeaderSize = 64;
+		static constexpr uint32_t sc_LargeClass = sc_NumSizeClasses;
+	};
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+
+#include <string>
+
+namespace XYZ {
+
+	// Read only view of a whole file mapped into address space
+	class XYZ_API MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const std::string& filepath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& filepath);
+		void Close();
+
+		bool		   IsOpen()  const { return m_Data != nullptr; }
+		const uint8_t* GetData() const { return m_Data; }
+		size_t		   GetSize() const { return m_Size; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t		   m_Size = 0;
+
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+	};
+}
@@ -14,7 +14,7 @@ namespace XYZ {
 	float AABB::CalculateArea() const
 	{
 		const glm::vec3 diff = Max - Min;
-		return 2.0f * (diff.x * diff.y * diff.z + diff.z * diff.x);
+		return 2.0f * (diff.x * diff.y + diff.y * diff.z + diff.z * diff.x);
 	}
 
 	float AABB::GetPerimeter() const
@@ -25,25 +25,16 @@ namespace XYZ {
 	}
 	bool AABB::Contains(const AABB& aabb) const
 	{
-		bool result = true;
-		result = result && Min.x <= aabb.Min.x;
-		result = result && Min.y <= aabb.Min.y;
-		result = result && aabb.Max.x <=Max.x;
-		result = result && aabb.Max.y <=Max.y;
-		return result;
+		return Min.x <= aabb.Min.x && Min.y <= aabb.Min.y && Min.z <= aabb.Min.z
+			&& aabb.Max.x <= Max.x && aabb.Max.y <= Max.y && aabb.Max.z <= Max.z;
 	}
 
 	bool AABB::Intersect(const AABB& aabb) const
 	{
-		const float d1x = aabb.Min.x - Max.x;
-		const float d1y = aabb.Min.y - Max.y;
-		const float d2x = Min.x - aabb.Max.x;
-		const float d2y = Min.y - aabb.Max.y;
-
-		if (d1x > 0.0f || d1y > 0.0f)
+		if (aabb.Min.x > Max.x || aabb.Min.y > Max.y || aabb.Min.z > Max.z)
 			return false;
 
-		if (d2x > 0.0f || d2y > 0.0f)
+		if (Min.x > aabb.Max.x || Min.y > aabb.Max.y || Min.z > aabb.Max.z)
 			return false;
 
 		return true;
@@ -51,13 +42,7 @@ namespace XYZ {
 
 	AABB AABB::Union(const AABB& a, const AABB& b)
 	{
-		AABB c;
-		c.Min.x = std::min(a.Min.x, b.Min.x);
-		c.Min.y = std::min(a.Min.y, b.Min.y);
-
-		c.Max.x = std::max(a.Max.x, b.Max.x);
-		c.Max.y = std::max(a.Max.y, b.Max.y);
-		return c;
+		return AABB(glm::min(a.Min, b.Min), glm::max(a.Max, b.Max));
 	}
 
 	AABB AABB::operator+(const glm::vec2& val) const
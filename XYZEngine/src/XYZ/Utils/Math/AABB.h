@@ -13,8 +13,8 @@ namespace XYZ {
 		AABB();
 		AABB(const glm::vec3& min, const glm::vec3& max);
 			
-		float GetPerimeter() const;
-		float CalculateArea() const;
+		float GetPerimeter() const;  // Perimeter of xy projection
+		float CalculateArea() const; // Surface area
 		bool Contains(const AABB& aabb) const;
 		bool Intersect(const AABB& aabb) const;
 
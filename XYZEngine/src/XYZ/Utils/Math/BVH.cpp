@@ -0,0 +1,197 @@
+#include "stdafx.h"
+#include "BVH.h"
+
+#include "XYZ/Debug/Profiler.h"
+
+namespace XYZ {
+
+	void BVH::Build(const std::vector<AABB>& bounds)
+	{
+		XYZ_PROFILE_FUNC("BVH::Build");
+		Clear();
+		if (bounds.empty())
+			return;
+
+		const uint32_t count = static_cast<uint32_t>(bounds.size());
+		std::vector<glm::vec3> centroids(count);
+		m_Indices.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			centroids[i] = (bounds[i].Min + bounds[i].Max) * 0.5f;
+			m_Indices[i] = i;
+		}
+
+		m_Nodes.reserve(2 * static_cast<size_t>(count) - 1);
+		m_Nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), count });
+		updateNodeBounds(0, bounds);
+		subdivide(0, 1, bounds, centroids);
+		m_Nodes.shrink_to_fit();
+	}
+
+	void BVH::Refit(const std::vector<AABB>& bounds)
+	{
+		XYZ_PROFILE_FUNC("BVH::Refit");
+		XYZ_ASSERT(bounds.size() == m_Indices.size(), "Refit requires same primitives as build");
+		// Children are stored after parent, reverse order updates them first
+		for (size_t i = m_Nodes.size(); i-- > 0;)
+		{
+			BVHNode& node = m_Nodes[i];
+			if (node.IsLeaf())
+			{
+				updateNodeBounds(static_cast<uint32_t>(i), bounds);
+			}
+			else
+			{
+				const BVHNode& left = m_Nodes[node.LeftFirst];
+				const BVHNode& right = m_Nodes[node.LeftFirst + 1];
+				node.Min = glm::min(left.Min, right.Min);
+				node.Max = glm::max(left.Max, right.Max);
+			}
+		}
+	}
+
+	void BVH::Clear()
+	{
+		m_Nodes.clear();
+		m_Indices.clear();
+	}
+
+	AABB BVH::GetBounds() const
+	{
+		if (m_Nodes.empty())
+			return AABB();
+		return AABB(m_Nodes[0].Min, m_Nodes[0].Max);
+	}
+
+	float BVH::GetSurfaceArea() const
+	{
+		if (m_Nodes.empty())
+			return 0.0f;
+		return SurfaceArea(m_Nodes[0].Min, m_Nodes[0].Max);
+	}
+
+	float BVH::SurfaceArea(const glm::vec3& min, const glm::vec3& max)
+	{
+		const glm::vec3 size = max - min;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	void BVH::updateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& bounds)
+	{
+		BVHNode& node = m_Nodes[nodeIndex];
+		node.Min = glm::vec3(std::numeric_limits<float>::max());
+		node.Max = glm::vec3(-std::numeric_limits<float>::max());
+		for (uint32_t i = 0; i < node.Count; ++i)
+		{
+			const AABB& box = bounds[m_Indices[node.LeftFirst + i]];
+			node.Min = glm::min(node.Min, box.Min);
+			node.Max = glm::max(node.Max, box.Max);
+		}
+	}
+
+	void BVH::subdivide(uint32_t nodeIndex, uint32_t depth, const std::vector<AABB>& bounds, const std::vector<glm::vec3>& centroids)
+	{
+		struct Bin
+		{
+			glm::vec3 Min = glm::vec3(std::numeric_limits<float>::max());
+			glm::vec3 Max = glm::vec3(-std::numeric_limits<float>::max());
+			uint32_t  Count = 0;
+		};
+
+		const BVHNode node = m_Nodes[nodeIndex];
+		if (node.Count <= sc_MaxLeafSize || depth >= sc_MaxStackDepth - 1)
+			return;
+
+		glm::vec3 centroidMin = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 centroidMax = glm::vec3(-std::numeric_limits<float>::max());
+		for (uint32_t i = 0; i < node.Count; ++i)
+		{
+			const glm::vec3& centroid = centroids[m_Indices[node.LeftFirst + i]];
+			centroidMin = glm::min(centroidMin, centroid);
+			centroidMax = glm::max(centroidMax, centroid);
+		}
+
+		// Find cheapest split over bins of centroid bounds on all axes
+		float bestCost = std::numeric_limits<float>::max();
+		int	  bestAxis = -1;
+		float bestSplit = 0.0f;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float extent = centroidMax[axis] - centroidMin[axis];
+			if (extent <= 0.0f)
+				continue;
+
+			Bin bins[sc_BinCount];
+			const float scale = static_cast<float>(sc_BinCount) / extent;
+			for (uint32_t i = 0; i < node.Count; ++i)
+			{
+				const uint32_t primitive = m_Indices[node.LeftFirst + i];
+				const uint32_t binIndex = std::min(sc_BinCount - 1, static_cast<uint32_t>((centroids[primitive][axis] - centroidMin[axis]) * scale));
+				Bin& bin = bins[binIndex];
+				bin.Min = glm::min(bin.Min, bounds[primitive].Min);
+				bin.Max = glm::max(bin.Max, bounds[primitive].Max);
+				bin.Count++;
+			}
+
+			float	 leftArea[sc_BinCount - 1], rightArea[sc_BinCount - 1];
+			uint32_t leftCount[sc_BinCount - 1], rightCount[sc_BinCount - 1];
+			Bin left, right;
+			for (uint32_t i = 0; i < sc_BinCount - 1; ++i)
+			{
+				left.Count += bins[i].Count;
+				left.Min = glm::min(left.Min, bins[i].Min);
+				left.Max = glm::max(left.Max, bins[i].Max);
+				leftCount[i] = left.Count;
+				leftArea[i] = left.Count ? SurfaceArea(left.Min, left.Max) : 0.0f;
+
+				const uint32_t r = sc_BinCount - 1 - i;
+				right.Count += bins[r].Count;
+				right.Min = glm::min(right.Min, bins[r].Min);
+				right.Max = glm::max(right.Max, bins[r].Max);
+				rightCount[r - 1] = right.Count;
+				rightArea[r - 1] = right.Count ? SurfaceArea(right.Min, right.Max) : 0.0f;
+			}
+
+			const float binWidth = extent / static_cast<float>(sc_BinCount);
+			for (uint32_t i = 0; i < sc_BinCount - 1; ++i)
+			{
+				const float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = centroidMin[axis] + binWidth * static_cast<float>(i + 1);
+				}
+			}
+		}
+
+		const float leafCost = static_cast<float>(node.Count) * SurfaceArea(node.Min, node.Max);
+		if (bestAxis == -1 || bestCost >= leafCost)
+			return;
+
+		// Partition indices of node around split plane
+		uint32_t i = node.LeftFirst;
+		uint32_t j = node.LeftFirst + node.Count;
+		while (i < j)
+		{
+			if (centroids[m_Indices[i]][bestAxis] < bestSplit)
+				++i;
+			else
+				std::swap(m_Indices[i], m_Indices[--j]);
+		}
+		const uint32_t leftCount = i - node.LeftFirst;
+		if (leftCount == 0 || leftCount == node.Count)
+			return;
+
+		const uint32_t leftIndex = static_cast<uint32_t>(m_Nodes.size());
+		m_Nodes.push_back({ glm::vec3(0.0f), node.LeftFirst, glm::vec3(0.0f), leftCount });
+		m_Nodes.push_back({ glm::vec3(0.0f), i, glm::vec3(0.0f), node.Count - leftCount });
+		m_Nodes[nodeIndex].LeftFirst = leftIndex;
+		m_Nodes[nodeIndex].Count = 0;
+
+		updateNodeBounds(leftIndex, bounds);
+		updateNodeBounds(leftIndex + 1, bounds);
+		subdivide(leftIndex, depth + 1, bounds, centroids);
+		subdivide(leftIndex + 1, depth + 1, bounds, centroids);
+	}
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+#include "AABB.h"
+#include "Ray.h"
+
+#include <glm/glm.hpp>
+
+#include <limits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+	#define XYZ_BVH_SSE
+	#include <xmmintrin.h>
+#endif
+
+namespace XYZ {
+
+	// Min and Max are followed by 32 bit value so each half of node loads as one SIMD register
+	struct BVHNode
+	{
+		glm::vec3 Min;
+		uint32_t  LeftFirst; // First child for inner node, first index for leaf
+		glm::vec3 Max;
+		uint32_t  Count;	 // Number of primitives, zero for inner node
+
+		bool IsLeaf() const { return Count != 0; }
+	};
+
+	// Bounding volume hierarchy over primitive bounds, built with binned SAH.
+	// Nodes are flattened to single array, children are always stored after parent
+	class XYZ_API BVH
+	{
+	public:
+		static constexpr uint32_t sc_MaxLeafSize = 4;
+		static constexpr uint32_t sc_BinCount = 12;
+		static constexpr uint32_t sc_MaxStackDepth = 64; // Build stops splitting at this depth so traversal stack never overflows
+
+		void Build(const std::vector<AABB>& bounds);
+		// Recomputes node bounds without changing topology, bounds must have same size as when built
+		void Refit(const std::vector<AABB>& bounds);
+		void Clear();
+
+		// Calls func(primitiveIndex, maxDistance) for every primitive in leaves hit closer than maxDistance.
+		// Func may shorten maxDistance to skip leaves behind closest hit
+		template <typename Func>
+		void Raycast(const Ray& ray, float maxDistance, Func&& func) const;
+
+		// Calls func(primitiveIndex) for every primitive in leaves overlapping aabb
+		template <typename Func>
+		void Query(const AABB& aabb, Func&& func) const;
+
+		bool  Empty()	  const { return m_Nodes.empty(); }
+		AABB  GetBounds() const;
+		float GetSurfaceArea() const;
+
+		const std::vector<BVHNode>&  GetNodes()	  const { return m_Nodes; }
+		const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+
+		static float SurfaceArea(const glm::vec3& min, const glm::vec3& max);
+
+	private:
+		void updateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& bounds);
+		void subdivide(uint32_t nodeIndex, uint32_t depth, const std::vector<AABB>& bounds, const std::vector<glm::vec3>& centroids);
+
+		// Returns entry distance, or infinity when node is missed
+		float intersectNode(const BVHNode& node, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance) const;
+
+	private:
+		std::vector<BVHNode>  m_Nodes;
+		std::vector<uint32_t> m_Indices;
+	};
+
+	inline float BVH::intersectNode(const BVHNode& node, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance) const
+	{
+#ifdef XYZ_BVH_SSE
+		// Fourth lane holds LeftFirst / Count bits, it is overwritten before reduction
+		const __m128 o = _mm_set_ps(0.0f, origin.z, origin.y, origin.x);
+		const __m128 inv = _mm_set_ps(0.0f, invDirection.z, invDirection.y, invDirection.x);
+		const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.Min.x), o), inv);
+		const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.Max.x), o), inv);
+		__m128 tEntry = _mm_min_ps(t1, t2);
+		__m128 tExit = _mm_max_ps(t1, t2);
+
+		tEntry = _mm_shuffle_ps(tEntry, tEntry, _MM_SHUFFLE(2, 2, 1, 0));
+		tExit = _mm_shuffle_ps(tExit, tExit, _MM_SHUFFLE(2, 2, 1, 0));
+		tEntry = _mm_max_ps(tEntry, _mm_shuffle_ps(tEntry, tEntry, _MM_SHUFFLE(1, 0, 3, 2)));
+		tEntry = _mm_max_ps(tEntry, _mm_shuffle_ps(tEntry, tEntry, _MM_SHUFFLE(2, 3, 0, 1)));
+		tExit = _mm_min_ps(tExit, _mm_shuffle_ps(tExit, tExit, _MM_SHUFFLE(1, 0, 3, 2)));
+		tExit = _mm_min_ps(tExit, _mm_shuffle_ps(tExit, tExit, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		const float tmin = _mm_cvtss_f32(tEntry);
+		const float tmax = _mm_cvtss_f32(tExit);
+#else
+		const glm::vec3 t1 = (node.Min - origin) * invDirection;
+		const glm::vec3 t2 = (node.Max - origin) * invDirection;
+		const glm::vec3 tEntry = glm::min(t1, t2);
+		const glm::vec3 tExit = glm::max(t1, t2);
+		const float tmin = glm::max(glm::max(tEntry.x, tEntry.y), tEntry.z);
+		const float tmax = glm::min(glm::min(tExit.x, tExit.y), tExit.z);
+#endif
+		if (tmax >= tmin && tmax >= 0.0f && tmin < maxDistance)
+			return tmin;
+		return std::numeric_limits<float>::infinity();
+	}
+
+	template <typename Func>
+	inline void BVH::Raycast(const Ray& ray, float maxDistance, Func&& func) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		const glm::vec3 invDirection = 1.0f / ray.Direction;
+		uint32_t stack[sc_MaxStackDepth];
+		float	 stackDistances[sc_MaxStackDepth];
+		uint32_t stackSize = 0;
+
+		const float rootDistance = intersectNode(m_Nodes[0], ray.Origin, invDirection, maxDistance);
+		if (rootDistance == std::numeric_limits<float>::infinity())
+			return;
+		stack[stackSize] = 0;
+		stackDistances[stackSize++] = rootDistance;
+
+		while (stackSize != 0)
+		{
+			--stackSize;
+			// Closest hit may have moved since node was pushed
+			if (stackDistances[stackSize] >= maxDistance)
+				continue;
+
+			const BVHNode& node = m_Nodes[stack[stackSize]];
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.Count; ++i)
+					func(m_Indices[node.LeftFirst + i], maxDistance);
+				continue;
+			}
+
+			// Closer child is pushed last so it is visited first
+			uint32_t first = node.LeftFirst;
+			uint32_t second = node.LeftFirst + 1;
+			float firstDistance = intersectNode(m_Nodes[first], ray.Origin, invDirection, maxDistance);
+			float secondDistance = intersectNode(m_Nodes[second], ray.Origin, invDirection, maxDistance);
+			if (firstDistance > secondDistance)
+			{
+				std::swap(first, second);
+				std::swap(firstDistance, secondDistance);
+			}
+			if (secondDistance != std::numeric_limits<float>::infinity())
+			{
+				stack[stackSize] = second;
+				stackDistances[stackSize++] = secondDistance;
+			}
+			if (firstDistance != std::numeric_limits<float>::infinity())
+			{
+				stack[stackSize] = first;
+				stackDistances[stackSize++] = firstDistance;
+			}
+		}
+	}
+
+	template <typename Func>
+	inline void BVH::Query(const AABB& aabb, Func&& func) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		uint32_t stack[sc_MaxStackDepth];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize != 0)
+		{
+			const BVHNode& node = m_Nodes[stack[--stackSize]];
+			if (glm::any(glm::greaterThan(node.Min, aabb.Max)) || glm::any(glm::lessThan(node.Max, aabb.Min)))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.Count; ++i)
+					func(m_Indices[node.LeftFirst + i]);
+			}
+			else
+			{
+				stack[stackSize++] = node.LeftFirst + 1;
+				stack[stackSize++] = node.LeftFirst;
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "Frustum.h"
+
+namespace XYZ {
+
+	Frustum::Frustum()
+	{
+		for (auto& plane : Planes)
+			plane = glm::vec4(0.0f);
+	}
+
+	Frustum::Frustum(const glm::mat4& viewProjection)
+	{
+		const glm::vec4 row0 = { viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+		const glm::vec4 row1 = { viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+		const glm::vec4 row2 = { viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+		const glm::vec4 row3 = { viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+		Planes[Left]   = row3 + row0;
+		Planes[Right]  = row3 - row0;
+		Planes[Bottom] = row3 + row1;
+		Planes[Top]	   = row3 - row1;
+		Planes[Near]   = row2; // Depth range is zero to one
+		Planes[Far]	   = row3 - row2;
+
+		for (auto& plane : Planes)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	bool Frustum::Intersect(const AABB& aabb) const
+	{
+		const glm::vec3 center = (aabb.Min + aabb.Max) * 0.5f;
+		const glm::vec3 extents = (aabb.Max - aabb.Min) * 0.5f;
+		for (const auto& plane : Planes)
+		{
+			const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+			const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+			if (distance + radius < 0.0f)
+				return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+#include "AABB.h"
+
+#include <glm/glm.hpp>
+
+namespace XYZ {
+
+	struct XYZ_API Frustum
+	{
+		enum Plane { Left, Right, Bottom, Top, Near, Far, NumPlanes };
+
+		// Plane normals point inside, w is distance
+		glm::vec4 Planes[NumPlanes];
+
+		Frustum();
+		Frustum(const glm::mat4& viewProjection);
+
+		bool Intersect(const AABB& aabb) const;
+	};
+}
@@ -0,0 +1,50 @@
+#include "stdafx.h"
+#include "RadixSort.h"
+
+
+namespace XYZ {
+
+	static constexpr uint32_t sc_DigitCount = sizeof(uint64_t);
+	static constexpr uint32_t sc_BucketCount = 256;
+
+	void RadixSort(std::vector<SortKey>& keys, std::vector<SortKey>& temp)
+	{
+		const size_t count = keys.size();
+		if (count < 2)
+			return;
+
+		// All histograms are built in single pass over keys
+		uint32_t histograms[sc_DigitCount][sc_BucketCount] = {};
+		for (const SortKey& key : keys)
+		{
+			for (uint32_t digit = 0; digit < sc_DigitCount; ++digit)
+				histograms[digit][(key.Key >> (digit * 8)) & 0xFF]++;
+		}
+
+		temp.resize(count);
+		SortKey* src = keys.data();
+		SortKey* dst = temp.data();
+		for (uint32_t digit = 0; digit < sc_DigitCount; ++digit)
+		{
+			uint32_t* histogram = histograms[digit];
+			const uint32_t shift = digit * 8;
+			if (histogram[(src[0].Key >> shift) & 0xFF] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < sc_BucketCount; ++bucket)
+			{
+				const uint32_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+			for (size_t i = 0; i < count; ++i)
+				dst[histogram[(src[i].Key >> shift) & 0xFF]++] = src[i];
+
+			std::swap(src, dst);
+		}
+
+		if (src != keys.data())
+			keys.swap(temp);
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "XYZ/Core/Core.h"
+
+#include <vector>
+
+namespace XYZ {
+
+	struct SortKey
+	{
+		uint64_t Key;
+		uint32_t Index;
+	};
+
+	// Stable LSD radix sort over 8 bit digits, temp is used as scratch buffer.
+	// Digits shared by all keys are skipped
+	XYZ_API void RadixSort(std::vector<SortKey>& keys, std::vector<SortKey>& temp);
+}
@@ -0,0 +1,48 @@
+#include "Test.h"
+
+#include "XYZ/Asset/AssetScanner.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace XYZ;
+
+static void WriteMetaFile(const std::string& filepath, const AssetHandle& handle, const char* type)
+{
+	std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+	file << "Handle: " << (std::string)handle << "\nFilePath: Assets/Test.asset\nType: " << type << "\n";
+}
+
+static AssetRegistry::FileStamp Stamp(const std::string& filepath, const AssetHandle& handle)
+{
+	return { filepath, AssetScanner::GetWriteTime(filepath), std::filesystem::file_size(filepath), handle };
+}
+
+XYZ_TEST(AssetScannerRefreshesMetaFileEditedInPlace)
+{
+	const std::string filepath = (std::filesystem::temp_directory_path() / "XYZTestsAsset.meta").string();
+	const AssetHandle oldHandle;
+	WriteMetaFile(filepath, oldHandle, "Texture");
+
+	AssetRegistry registry;
+	registry.StoreMetadata({ oldHandle, AssetType::Texture, "Assets/Test.asset" });
+	std::vector<AssetRegistry::FileStamp> files = { Stamp(filepath, oldHandle) };
+
+	uint32_t refreshed = 0;
+	XYZ_CHECK(AssetScanner::RefreshChangedFiles(registry, files, refreshed));
+	XYZ_CHECK(refreshed == 0);
+
+	// Size differs, so change is detected even if write time has coarse resolution
+	const AssetHandle newHandle;
+	WriteMetaFile(filepath, newHandle, "Material");
+	XYZ_CHECK(AssetScanner::RefreshChangedFiles(registry, files, refreshed));
+	XYZ_CHECK(refreshed == 1);
+	XYZ_CHECK(registry.GetCount() == 1);
+	XYZ_CHECK(registry.GetMetadata(oldHandle) == nullptr);
+	XYZ_CHECK(registry.GetMetadata(newHandle) && registry.GetMetadata(newHandle)->Type == AssetType::Material);
+	XYZ_CHECK(files[0].Handle == newHandle);
+
+	// Missing file can not be refreshed, caller scans instead
+	std::filesystem::remove(filepath);
+	XYZ_CHECK(!AssetScanner::RefreshChangedFiles(registry, files, refreshed));
+}
@@ -0,0 +1,181 @@
+#include "Test.h"
+
+#include "XYZ/Core/ThreadPool.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <numeric>
+#include <queue>
+
+using namespace XYZ;
+
+namespace {
+	// Reference for benchmark, same design as pool before work stealing: one mutex and std::function queue
+	class MutexQueuePool
+	{
+	public:
+		MutexQueuePool(uint32_t numThreads)
+		{
+			for (uint32_t i = 0; i < numThreads; ++i)
+				m_Threads.emplace_back(&MutexQueuePool::worker, this);
+		}
+
+		~MutexQueuePool()
+		{
+			{
+				std::scoped_lock lock(m_JobMutex);
+				m_Running = false;
+			}
+			m_JobAvailableCV.notify_all();
+			for (std::thread& thread : m_Threads)
+				thread.join();
+		}
+
+		void PushJob(std::function<void()> job)
+		{
+			{
+				std::scoped_lock lock(m_JobMutex);
+				m_JobQueue.push(std::move(job));
+			}
+			m_JobAvailableCV.notify_one();
+		}
+
+	private:
+		void worker()
+		{
+			std::function<void()> job;
+			while (true)
+			{
+				{
+					std::unique_lock lock(m_JobMutex);
+					m_JobAvailableCV.wait(lock, [&] { return !m_JobQueue.empty() || !m_Running; });
+					if (!m_Running && m_JobQueue.empty())
+						return;
+
+					job = std::move(m_JobQueue.front());
+					m_JobQueue.pop();
+				}
+				job();
+			}
+		}
+
+	private:
+		bool							  m_Running = true;
+		std::vector<std::thread>		  m_Threads;
+		std::mutex						  m_JobMutex;
+		std::queue<std::function<void()>> m_JobQueue;
+		std::condition_variable			  m_JobAvailableCV;
+	};
+}
+
+XYZ_TEST(ThreadPoolExternalJobsRunInOrder)
+{
+	// Render thread relies on one worker executing external jobs in submission order
+	ThreadPool pool;
+	pool.Start(1);
+
+	std::vector<uint32_t> order;
+	for (uint32_t i = 0; i < 1000; ++i)
+		pool.PushJob([&order, i]() { order.push_back(i); });
+	pool.WaitForJobs();
+	pool.Stop();
+
+	XYZ_CHECK(order.size() == 1000);
+	for (uint32_t i = 0; i < order.size(); ++i)
+		XYZ_CHECK(order[i] == i);
+}
+
+XYZ_TEST(ThreadPoolNestedCountersFinish)
+{
+	ThreadPool pool;
+	pool.Start(4);
+
+	std::atomic<uint32_t> sum = 0;
+	JobCounter counter;
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		pool.PushJob(counter, [&pool, &sum]() {
+			// Worker waiting on its own counter executes jobs instead of blocking
+			JobCounter nested;
+			for (uint32_t j = 0; j < 64; ++j)
+				pool.PushJob(nested, [&sum]() { sum++; });
+			pool.Wait(nested);
+		});
+	}
+	pool.Wait(counter);
+	pool.Stop();
+	XYZ_CHECK(sum == 64 * 64);
+}
+
+XYZ_TEST(ThreadPoolSubmitJobReturnsValue)
+{
+	ThreadPool pool;
+	pool.Start(2);
+	std::future<int> future = pool.SubmitJob([](int a, int b) { return a * b; }, 6, 7);
+	XYZ_CHECK(future.get() == 42);
+
+	// Capture bigger than inline storage of job
+	std::array<uint32_t, 64> values;
+	std::iota(values.begin(), values.end(), 0);
+	std::future<uint32_t> bigFuture = pool.SubmitJob([values]() { return std::accumulate(values.begin(), values.end(), 0u); });
+	XYZ_CHECK(bigFuture.get() == 63 * 64 / 2);
+	pool.Stop();
+}
+
+XYZ_BENCHMARK(ThreadPoolJobsPerSecond)
+{
+	const uint32_t jobCount = Test::IsQuick() ? 10000 : 1000000;
+	for (uint32_t workers = 1; workers <= 64; workers *= 2)
+	{
+		ThreadPool pool;
+		pool.Start(workers);
+
+		std::atomic<uint64_t> sum = 0;
+		{
+			Stopwatch timer;
+			JobCounter counter;
+			for (uint32_t i = 0; i < jobCount; ++i)
+				pool.PushJob(counter, [&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); });
+			pool.Wait(counter);
+			Test::Report(std::to_string(workers) + " workers, external push", jobCount, timer.Elapsed());
+		}
+		{
+			// Reference pool has no counters, caller spins on finished jobs. It can not run fork-join, nested wait would block worker
+			MutexQueuePool reference(workers);
+			std::atomic<uint32_t> finished = 0;
+			Stopwatch timer;
+			for (uint32_t i = 0; i < jobCount; ++i)
+			{
+				reference.PushJob([&sum, &finished, i]() {
+					sum.fetch_add(i, std::memory_order_relaxed);
+					finished.fetch_add(1, std::memory_order_release);
+				});
+			}
+			while (finished.load(std::memory_order_acquire) != jobCount)
+				std::this_thread::yield();
+			Test::Report(std::to_string(workers) + " workers, external push, mutex queue", jobCount, timer.Elapsed());
+		}
+		{
+			// Jobs spawned by workers go to their own deques and are stolen by others
+			const uint32_t batches = 256;
+			const uint32_t batchSize = jobCount / batches;
+			Stopwatch timer;
+			JobCounter counter;
+			for (uint32_t i = 0; i < batches; ++i)
+			{
+				pool.PushJob(counter, [&pool, &sum, batchSize]() {
+					JobCounter nested;
+					for (uint32_t j = 0; j < batchSize; ++j)
+						pool.PushJob(nested, [&sum, j]() { sum.fetch_add(j, std::memory_order_relaxed); });
+					pool.Wait(nested);
+				});
+			}
+			pool.Wait(counter);
+			Test::Report(std::to_string(workers) + " workers, fork-join", batches * batchSize, timer.Elapsed());
+		}
+		pool.Stop();
+	}
+}
@@ -0,0 +1,140 @@
+#include "Test.h"
+
+#include "XYZ/Net/NetServer.h"
+#include "XYZ/Net/NetClient.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace XYZ;
+
+namespace {
+	enum class MessageID : uint32_t { Data, Echo };
+
+	template <size_t Size>
+	struct Payload
+	{
+		uint8_t Data[Size];
+	};
+
+	class LoopbackServer : public Net::Server<MessageID>
+	{
+	public:
+		using Net::Server<MessageID>::Server;
+
+		std::atomic<uint64_t> Received = 0;
+
+	protected:
+		virtual void onMessage(std::shared_ptr<Net::Connection<MessageID>> client, Net::Message<MessageID>& msg) override
+		{
+			Received++;
+			if (msg.Header.ID == MessageID::Echo)
+				MessageClient(client, msg);
+		}
+	};
+}
+
+static constexpr uint16_t sc_LoopbackPort = 60123;
+
+template <size_t Size>
+static void RunLoopback(LoopbackServer& server, Net::Client<MessageID>& client, uint32_t count, uint32_t pings)
+{
+	// Biggest payload does not fit on stack
+	auto payload = std::make_unique<Payload<Size>>();
+	auto echoed = std::make_unique<Payload<Size>>();
+	for (size_t i = 0; i < Size; ++i)
+		payload->Data[i] = static_cast<uint8_t>(i);
+
+	const std::string name = std::to_string(Size) + " bytes, ";
+	server.Received = 0;
+	Stopwatch timer;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Net::Message<MessageID> msg;
+		msg.Header.ID = MessageID::Data;
+		msg << *payload;
+		client.Send(std::move(msg));
+	}
+	while (server.Received < count)
+	{
+		server.Update();
+		std::this_thread::yield();
+	}
+	Test::Report(name + "throughput", count, timer.Elapsed());
+
+	// Round trip of one message at a time, server consumes on its own thread
+	std::atomic<bool> running = true;
+	std::thread serverThread([&]() {
+		while (running)
+		{
+			server.Update();
+			std::this_thread::yield();
+		}
+	});
+	Stopwatch pingTimer;
+	for (uint32_t i = 0; i < pings; ++i)
+	{
+		Net::Message<MessageID> msg;
+		msg.Header.ID = MessageID::Echo;
+		msg << *payload;
+		client.Send(std::move(msg));
+
+		auto& incoming = client.GetIncomingMessages();
+		while (incoming.Empty())
+			std::this_thread::yield();
+
+		Net::OwnedMessage<MessageID> reply = incoming.PopFront();
+		reply.Message >> *echoed;
+		XYZ_CHECK(reply.Message.IsValid() && echoed->Data[Size - 1] == static_cast<uint8_t>(Size - 1));
+	}
+	Test::Report(name + "round trips", pings, pingTimer.Elapsed());
+	running = false;
+	serverThread.join();
+}
+
+XYZ_TEST(NetMessageReadPastEndFails)
+{
+	Net::Message<MessageID> msg;
+	const uint32_t first = 7;
+	const uint16_t second = 9;
+	msg << first << second;
+
+	uint32_t a = 0;
+	uint16_t b = 0;
+	msg >> a >> b;
+	XYZ_CHECK(msg.IsValid() && a == first && b == second);
+
+	// Failed read zeroes value, following read fails even if it would fit
+	uint64_t c = 1;
+	msg >> c;
+	XYZ_CHECK(!msg.IsValid());
+	XYZ_CHECK(c == 0);
+
+	Net::Message<MessageID> truncated;
+	truncated << second;
+	truncated >> a;
+	truncated >> b;
+	XYZ_CHECK(!truncated.IsValid());
+	XYZ_CHECK(a == 0 && b == 0);
+}
+
+XYZ_BENCHMARK(NetMessageLoopback)
+{
+	const uint32_t scale = Test::IsQuick() ? 100 : 1;
+	LoopbackServer server(sc_LoopbackPort);
+	XYZ_CHECK(server.Start());
+
+	Net::Client<MessageID> client;
+	XYZ_CHECK(client.Connect("127.0.0.1", sc_LoopbackPort));
+	while (!client.IsConnected())
+		std::this_thread::yield();
+
+	RunLoopback<16>(server, client, 200000 / scale, 5000 / scale);
+	RunLoopback<256>(server, client, 200000 / scale, 5000 / scale);
+	RunLoopback<16384>(server, client, 20000 / scale, 2000 / scale);
+	RunLoopback<262144>(server, client, 2000 / scale, 300 / scale);
+
+	client.Disconnect();
+	server.Stop();
+}
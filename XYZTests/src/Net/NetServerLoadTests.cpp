@@ -0,0 +1,249 @@
+#include "Test.h"
+
+#include "XYZ/Net/NetServer.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace XYZ;
+
+namespace {
+	// Same layout as header and body written by Net::Connection
+	struct WireMessage
+	{
+		Net::MessageHeader<uint32_t> Header;
+		uint32_t					 Connection;
+		uint32_t					 Value;
+		uint8_t						 Padding[24];
+	};
+
+	// Opens raw sockets on own thread and writes messages in batches, server side is measured alone
+	class LoadGenerator
+	{
+	public:
+		static constexpr uint32_t sc_BatchSize = 16;
+
+		LoadGenerator(uint16_t port, uint32_t connections, uint32_t messages)
+			:
+			m_Endpoint(asio::ip::make_address("127.0.0.1"), port),
+			m_Messages(messages),
+			m_Connections(connections)
+		{
+		}
+
+		~LoadGenerator()
+		{
+			Stop();
+		}
+
+		void Start()
+		{
+			for (uint32_t i = 0; i < m_Connections.size(); ++i)
+			{
+				ConnectionState& connection = m_Connections[i];
+				connection.Socket = std::make_unique<asio::ip::tcp::socket>(m_Context);
+				connection.Socket->async_connect(m_Endpoint, [this, i](std::error_code ec) {
+					if (!ec)
+						writeNext(i);
+					m_Finished++;
+				});
+			}
+			m_Thread = std::thread([this]() { m_Context.run(); });
+		}
+
+		// Sockets stay open until server received everything
+		void Stop()
+		{
+			m_Context.stop();
+			if (m_Thread.joinable())
+				m_Thread.join();
+			m_Connections.clear();
+		}
+
+		bool IsConnecting() const { return m_Finished < m_Connections.size(); }
+
+	private:
+		struct ConnectionState
+		{
+			std::unique_ptr<asio::ip::tcp::socket> Socket;
+			std::array<WireMessage, sc_BatchSize>  Batch{};
+			uint32_t							   Sent = 0;
+		};
+
+		void writeNext(uint32_t index)
+		{
+			ConnectionState& connection = m_Connections[index];
+			const uint32_t count = std::min(sc_BatchSize, m_Messages - connection.Sent);
+			if (count == 0)
+				return;
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				WireMessage& message = connection.Batch[i];
+				message.Header.Size = sizeof(WireMessage) - sizeof(message.Header);
+				message.Connection = index;
+				message.Value = connection.Sent++;
+			}
+			asio::async_write(*connection.Socket, asio::buffer(connection.Batch.data(), count * sizeof(WireMessage)), [this, index](std::error_code ec, size_t) {
+				if (!ec)
+					writeNext(index);
+			});
+		}
+
+	private:
+		asio::io_context			 m_Context;
+		asio::ip::tcp::endpoint		 m_Endpoint;
+		uint32_t					 m_Messages;
+		std::vector<ConnectionState> m_Connections;
+		std::thread					 m_Thread;
+		std::atomic<uint32_t>		 m_Finished = 0; // Connect attempts that completed
+	};
+
+	class LoadServer : public Net::Server<uint32_t>
+	{
+	public:
+		LoadServer(uint16_t port, const Net::ServerConfiguration& config, uint32_t connections, uint32_t consumerDelayUs)
+			:
+			Net::Server<uint32_t>(port, config),
+			m_NextValues(connections, 0),
+			m_ConsumerDelay(consumerDelayUs)
+		{
+		}
+
+		size_t GetInboundSize() const
+		{
+			size_t size = 0;
+			for (uint32_t i = 0; i < GetWorkerCount(); ++i)
+				size += Net::Server<uint32_t>::GetInboundSize(i);
+			return size;
+		}
+
+		std::atomic<uint32_t> Accepted = 0;
+		uint64_t			  Received = 0;
+		uint32_t			  OrderErrors = 0;
+
+	protected:
+		virtual void onClientConnect(std::shared_ptr<Net::Connection<uint32_t>> client) override
+		{
+			Accepted++;
+		}
+
+		virtual void onMessage(std::shared_ptr<Net::Connection<uint32_t>> client, Net::Message<uint32_t>& msg) override
+		{
+			uint32_t connection = 0, value = 0;
+			msg >> connection >> value;
+			if (!msg.IsValid() || connection >= m_NextValues.size() || m_NextValues[connection]++ != value)
+				OrderErrors++;
+			Received++;
+
+			// Simulates game thread that can not keep up with network
+			if (m_ConsumerDelay.count() != 0)
+			{
+				const auto end = std::chrono::steady_clock::now() + m_ConsumerDelay;
+				while (std::chrono::steady_clock::now() < end);
+			}
+		}
+
+	private:
+		std::vector<uint32_t>	  m_NextValues;
+		std::chrono::microseconds m_ConsumerDelay;
+	};
+
+	struct LoadResult
+	{
+		uint64_t Received = 0;
+		uint64_t Expected = 0;
+		uint32_t Accepted = 0;
+		uint32_t OrderErrors = 0;
+		size_t	 MaxInbound = 0;
+		float	 Elapsed = 0.0f;
+	};
+}
+
+static constexpr uint16_t sc_LoadPort = 60124;
+
+static LoadResult RunLoad(const Net::ServerConfiguration& config, uint32_t connections, uint32_t messages, uint32_t consumerDelayUs = 0)
+{
+	LoadServer server(sc_LoadPort, config, connections, consumerDelayUs);
+	server.Start();
+
+	LoadResult result;
+	Stopwatch timer;
+	LoadGenerator generator(sc_LoadPort, connections, messages);
+	generator.Start();
+
+	// Includes connect time, run ends early if nothing arrives for a while.
+	// Both ends of every connection are in this process, connections over its socket limit are not accepted
+	Stopwatch idle;
+	while (generator.IsConnecting() || server.Received < static_cast<uint64_t>(server.Accepted) * messages)
+	{
+		result.MaxInbound = std::max(result.MaxInbound, server.GetInboundSize());
+		const uint64_t received = server.Received;
+		server.Update(256);
+		if (server.Received != received)
+			idle.Restart();
+		else if (idle.Elapsed() > 5000.0f)
+			break;
+		else
+			std::this_thread::yield();
+	}
+	result.Elapsed = timer.Elapsed();
+	result.Received = server.Received;
+	result.Accepted = server.Accepted;
+	result.Expected = static_cast<uint64_t>(result.Accepted) * messages;
+	result.OrderErrors = server.OrderErrors;
+
+	generator.Stop();
+	server.Stop();
+	return result;
+}
+
+XYZ_TEST(NetServerKeepsOrderPerConnection)
+{
+	// Connections are spread over workers and io threads, messages of one connection stay in order
+	Net::ServerConfiguration config;
+	config.IOThreads = 2;
+	config.Workers = 2;
+	config.InboundCapacity = 64;
+	const LoadResult result = RunLoad(config, 50, 500);
+	XYZ_CHECK(result.Accepted == 50);
+	XYZ_CHECK(result.Received == result.Expected);
+	XYZ_CHECK(result.OrderErrors == 0);
+	XYZ_CHECK(result.MaxInbound <= 2 * config.InboundCapacity);
+}
+
+XYZ_BENCHMARK(NetServerConnections)
+{
+	struct Load { uint32_t Connections, Messages; };
+	const std::vector<Load> loads = Test::IsQuick()
+		? std::vector<Load>{ { 100, 20 } }
+		: std::vector<Load>{ { 1000, 200 }, { 5000, 40 }, { 10000, 20 } };
+
+	for (const Load& load : loads)
+	{
+		for (const uint32_t ioThreads : { 1u, 4u })
+		{
+			Net::ServerConfiguration config;
+			config.IOThreads = ioThreads;
+			const LoadResult result = RunLoad(config, load.Connections, load.Messages);
+			std::string name = std::to_string(load.Connections) + " connections x " + std::to_string(load.Messages) + ", " + std::to_string(ioThreads) + " io threads";
+			if (result.Accepted != load.Connections)
+				name += " (" + std::to_string(result.Accepted) + " accepted)";
+			Test::Report(name, result.Received, result.Elapsed);
+			XYZ_CHECK(result.Received == result.Expected);
+			XYZ_CHECK(result.OrderErrors == 0);
+		}
+	}
+
+	// Bounded rings cap queued messages when consumer is slower than network
+	const Load slow = Test::IsQuick() ? Load{ 100, 20 } : Load{ 1000, 200 };
+	Net::ServerConfiguration config;
+	config.InboundCapacity = 1024;
+	const LoadResult result = RunLoad(config, slow.Connections, slow.Messages, 10);
+	Test::Report(std::to_string(slow.Connections) + " connections x " + std::to_string(slow.Messages) + ", 10us consumer (" + std::to_string(result.MaxInbound) + " max queued)", result.Received, result.Elapsed);
+	XYZ_CHECK(result.Received == result.Expected);
+	XYZ_CHECK(result.MaxInbound <= config.InboundCapacity);
+}
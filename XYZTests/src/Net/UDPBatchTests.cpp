@@ -0,0 +1,215 @@
+#include "Test.h"
+
+#include "XYZ/Net/UDPServer.h"
+#include "XYZ/Net/UDPBatch.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <thread>
+
+using namespace XYZ;
+
+namespace {
+	class CountingServer : public UDPServer
+	{
+	public:
+		using UDPServer::UDPServer;
+
+		uint64_t Received = 0;
+		bool	 Batched = false;
+
+	protected:
+		virtual void onReceived(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size) override
+		{
+			if (size != 0)
+				Received++;
+			if (!Batched && size != 0)
+				ReceiveAsync();
+		}
+		virtual void onSent(const asio::ip::udp::endpoint& endpoint, size_t size) override {}
+		virtual void onError(std::error_code ec) override {}
+	};
+
+	class PacingClient : public UDPClient
+	{
+	public:
+		using UDPClient::UDPClient;
+
+		void SendNext()
+		{
+			if (Sent < Target)
+			{
+				Sent++;
+				SendAsync(GetEndpoint(), Payload.data(), Payload.size());
+			}
+		}
+
+		uint64_t			 Sent = 0;
+		uint64_t			 Target = 0;
+		std::vector<uint8_t> Payload;
+
+	protected:
+		virtual void onReceived(const asio::ip::udp::endpoint& endpoint, const void* buffer, size_t size) override {}
+		virtual void onSent(const asio::ip::udp::endpoint& endpoint, size_t size) override { SendNext(); }
+		virtual void onError(std::error_code ec) override {}
+	};
+}
+
+static asio::ip::udp::socket OpenLoopbackSocket(asio::io_context& context)
+{
+	asio::ip::udp::socket socket(context, asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0));
+	socket.non_blocking(true);
+	return socket;
+}
+
+// Receives until count datagrams arrived or nothing arrives for a while
+static std::vector<uint32_t> ReceiveSequence(UDPBatch& batch, asio::ip::udp::socket& socket, uint32_t count)
+{
+	std::vector<uint32_t> sequence;
+	Stopwatch idle;
+	while (sequence.size() < count && idle.Elapsed() < 500.0f)
+	{
+		std::error_code ec;
+		const uint32_t received = batch.Receive(socket, ec);
+		for (uint32_t i = 0; i < received; ++i)
+		{
+			const UDPBatch::Datagram& datagram = batch.GetDatagram(i);
+			uint32_t value = UINT32_MAX;
+			if (datagram.Size == sizeof(uint32_t) && !datagram.Truncated)
+				memcpy(&value, datagram.Data, sizeof(uint32_t));
+			sequence.push_back(value);
+		}
+		if (received != 0)
+			idle.Restart();
+		else
+			std::this_thread::yield();
+	}
+	return sequence;
+}
+
+XYZ_TEST(UDPBatchKeepsOrderPerEndpoint)
+{
+	asio::io_context context;
+	asio::ip::udp::socket sender = OpenLoopbackSocket(context);
+	asio::ip::udp::socket first = OpenLoopbackSocket(context);
+	asio::ip::udp::socket second = OpenLoopbackSocket(context);
+
+	// Interleaved queue, every endpoint gets its datagrams in queued order
+	const uint32_t count = 100;
+	UDPBatch sendBatch;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		sendBatch.Queue(first.local_endpoint(), &i, sizeof(i));
+		sendBatch.Queue(second.local_endpoint(), &i, sizeof(i));
+	}
+	while (sendBatch.HasQueued())
+	{
+		std::error_code ec;
+		sendBatch.Flush(sender, ec);
+		XYZ_CHECK(!ec || ec == asio::error::would_block);
+		if (ec && ec != asio::error::would_block)
+			break;
+	}
+	XYZ_CHECK(sendBatch.GetStatistics().PacketsSent == 2 * count);
+
+	UDPBatch receiveBatch;
+	for (asio::ip::udp::socket* socket : { &first, &second })
+	{
+		const std::vector<uint32_t> sequence = ReceiveSequence(receiveBatch, *socket, count);
+		XYZ_CHECK(sequence.size() == count);
+		for (uint32_t i = 0; i < sequence.size(); ++i)
+			XYZ_CHECK(sequence[i] == i);
+	}
+}
+
+XYZ_TEST(UDPBatchQueueAfterFailedFlush)
+{
+	asio::io_context context;
+	asio::ip::udp::socket sender = OpenLoopbackSocket(context);
+	asio::ip::udp::socket first = OpenLoopbackSocket(context);
+	asio::ip::udp::socket second = OpenLoopbackSocket(context);
+
+	// Port 0 is not valid destination, flush stops after dropping its datagram
+	uint32_t value = 0;
+	UDPBatch sendBatch(4);
+	sendBatch.Queue(first.local_endpoint(), &value, sizeof(value));
+	sendBatch.Queue(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0), &value, sizeof(value));
+	sendBatch.Queue(second.local_endpoint(), &value, sizeof(value));
+	std::error_code ec;
+	sendBatch.Flush(sender, ec);
+	XYZ_CHECK(ec && ec != asio::error::would_block);
+
+	// Endpoint that was already flushed gets queued again behind unsent rest
+	value = 1;
+	sendBatch.Queue(first.local_endpoint(), &value, sizeof(value));
+	sendBatch.Flush(sender, ec);
+	XYZ_CHECK(!ec && !sendBatch.HasQueued());
+
+	UDPBatch receiveBatch;
+	XYZ_CHECK(ReceiveSequence(receiveBatch, first, 2) == std::vector<uint32_t>({ 0, 1 }));
+	XYZ_CHECK(ReceiveSequence(receiveBatch, second, 1) == std::vector<uint32_t>({ 0 }));
+}
+
+XYZ_BENCHMARK(UDPBatchLoopback)
+{
+	const uint64_t packets = Test::IsQuick() ? 10000 : 400000;
+	const uint16_t port = 50555;
+	for (const size_t payloadSize : { 64, 1200 })
+	{
+		for (const bool batched : { false, true })
+		{
+			asio::io_context context;
+			auto server = std::make_shared<CountingServer>(context, port, 2048);
+			server->Batched = batched;
+			server->Start();
+			auto client = std::make_shared<PacingClient>(context, 2048);
+			client->Connect("127.0.0.1", port);
+			client->Payload.assign(payloadSize, 7);
+			client->Target = packets;
+
+			Stopwatch timer;
+			if (!batched)
+			{
+				// Next datagram is sent from completion of previous one
+				server->ReceiveAsync();
+				client->SendNext();
+				while (server->Received < packets && timer.Elapsed() < 60000.0f)
+					context.run_for(std::chrono::milliseconds(10));
+			}
+			else
+			{
+				// Window keeps sender from overrunning receive buffer of socket, lost datagrams end run
+				server->ReceiveBatchAsync();
+				uint64_t sent = 0;
+				uint64_t lastReceived = 0;
+				Stopwatch idle;
+				while (server->Received < packets && idle.Elapsed() < 50.0f)
+				{
+					if (server->Received != lastReceived)
+					{
+						lastReceived = server->Received;
+						idle.Restart();
+					}
+					for (; sent < packets && sent - server->Received < 256; ++sent)
+						client->QueueSend(client->GetEndpoint(), client->Payload.data(), payloadSize);
+					client->Flush();
+					context.poll();
+				}
+			}
+			const float elapsed = timer.Elapsed();
+
+			std::string name = std::to_string(payloadSize) + " bytes, " + (batched ? "batched" : "single");
+			if (batched)
+			{
+				const UDPBatch::Statistics& received = server->GetBatchStatistics();
+				const UDPBatch::Statistics& sent = client->GetBatchStatistics();
+				name += " (" + std::to_string(received.PacketsReceived / std::max<uint64_t>(received.ReceiveCalls, 1)) + " received, "
+					+ std::to_string(sent.PacketsSent / std::max<uint64_t>(sent.SendCalls, 1)) + " sent per call)";
+			}
+			Test::Report(name, server->Received, elapsed);
+			XYZ_CHECK(server->Received > 0);
+
+			server->Stop();
+			context.poll();
+		}
+	}
+}
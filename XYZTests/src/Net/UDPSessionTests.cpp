@@ -0,0 +1,224 @@
+#include "Test.h"
+
+#include "XYZ/Net/UDPSession.h"
+#include "XYZ/Net/NetworkSimulator.h"
+#include "XYZ/Net/Replication.h"
+#include "XYZ/Scene/Components.h"
+
+#include <cmath>
+#include <random>
+
+using namespace XYZ;
+
+namespace {
+	// Two sessions connected through simulator, destination 0 is server and 1 is client
+	class SimulatedLink
+	{
+	public:
+		SimulatedLink(const NetworkSimulatorConfiguration& config)
+			:
+			Network(config, 7),
+			Server([this](const void* data, size_t size) { send(1, data, size); }),
+			Client([this](const void* data, size_t size) { send(0, data, size); })
+		{}
+
+		void Step(double deltaTime)
+		{
+			Time += deltaTime;
+			Server.Update(Time);
+			Client.Update(Time);
+			Network.Receive(Time, [this](uint32_t destination, const void* data, size_t size) {
+				(destination == 0 ? Server : Client).Receive(data, size, Time);
+			});
+		}
+
+		NetworkSimulator Network;
+		UDPSession		 Server;
+		UDPSession		 Client;
+		double			 Time = 0.0;
+		size_t			 MaxPacketSize = 0;
+
+	private:
+		void send(uint32_t destination, const void* data, size_t size)
+		{
+			MaxPacketSize = std::max(MaxPacketSize, size);
+			Network.Send(destination, data, size, Time);
+		}
+	};
+
+	NetworkSimulatorConfiguration LossyConfiguration(float packetLoss)
+	{
+		NetworkSimulatorConfiguration config;
+		config.Latency = 0.05f;
+		config.Jitter = 0.02f;
+		config.PacketLoss = packetLoss;
+		config.Duplicates = 0.01f;
+		return config;
+	}
+
+	std::vector<uint8_t> Pattern(uint32_t size, uint32_t seed)
+	{
+		std::vector<uint8_t> data(size);
+		for (uint32_t i = 0; i < size; ++i)
+			data[i] = static_cast<uint8_t>((i * 31 + seed) >> 2);
+		return data;
+	}
+
+	// Carries its index in first two bytes, so receiver can verify it
+	std::vector<uint8_t> UnreliablePayload(uint16_t index)
+	{
+		std::vector<uint8_t> data = Pattern(3000, index);
+		memcpy(data.data(), &index, sizeof(index));
+		return data;
+	}
+}
+
+XYZ_TEST(UDPSessionRejectsMalformedSize)
+{
+	UDPSession session([](const void*, size_t) {});
+	uint32_t received = 0;
+	session.SetMessageHandler([&](UDPChannel, const uint8_t*, uint32_t) { received++; });
+
+	// Size prefix claims 40 bit size
+	BitWriter writer;
+	writer.Write(0, 16);
+	writer.Write(0, 16);
+	writer.Write(0, 32);
+	writer.WriteBool(false);
+	writer.Write(0, 16);
+	writer.WriteBool(false);
+	writer.Write(40, 6);
+	writer.Write(UINT32_MAX, 32);
+	writer.Write(0xFF, 8);
+	XYZ_CHECK(!session.Receive(writer.GetData(), writer.GetSize(), 0.0));
+	XYZ_CHECK(received == 0);
+}
+
+XYZ_TEST(UDPSessionDeliversOverLossyLink)
+{
+	SimulatedLink link(LossyConfiguration(0.2f));
+	// Small messages are interleaved with fragmented ones, all arrive once and in order
+	std::vector<std::vector<uint8_t>> sent;
+	std::vector<std::vector<uint8_t>> reliable;
+	std::vector<uint16_t> unreliableIDs;
+	std::vector<uint16_t> acked;
+	std::vector<uint16_t> delivered;
+	link.Client.SetMessageHandler([&](UDPChannel channel, const uint8_t* data, uint32_t size) {
+		if (channel == UDPChannel::Reliable)
+		{
+			reliable.emplace_back(data, data + size);
+			return;
+		}
+		uint16_t index = 0;
+		memcpy(&index, data, sizeof(index));
+		XYZ_CHECK(std::vector<uint8_t>(data, data + size) == UnreliablePayload(index));
+		delivered.push_back(index);
+	});
+	link.Server.SetAckHandler([&](uint16_t id) { acked.push_back(id); });
+
+	const double deltaTime = 1.0 / 60.0;
+	for (uint32_t tick = 0; tick < 600; ++tick)
+	{
+		if (tick % 3 == 0)
+		{
+			sent.push_back(tick % 60 == 0 ? Pattern(20000 + tick, tick) : Pattern(4, tick));
+			link.Server.SendReliable(sent.back().data(), static_cast<uint32_t>(sent.back().size()));
+		}
+		if (tick % 10 == 0)
+		{
+			const std::vector<uint8_t> data = UnreliablePayload(static_cast<uint16_t>(unreliableIDs.size()));
+			unreliableIDs.push_back(link.Server.SendUnreliable(data.data(), static_cast<uint32_t>(data.size())));
+		}
+		link.Step(deltaTime);
+	}
+	for (uint32_t tick = 0; tick < 300; ++tick)
+		link.Step(deltaTime);
+
+	XYZ_CHECK(link.MaxPacketSize <= UDPSession::sc_MaxPacketSize);
+	XYZ_CHECK(reliable == sent);
+	XYZ_CHECK(link.Server.GetStatistics().ReliableResent > 0);
+
+	// Some fragmented unreliable messages are lost, every acked one was delivered
+	XYZ_CHECK(!delivered.empty() && delivered.size() < unreliableIDs.size());
+	XYZ_CHECK(!acked.empty() && acked.size() <= delivered.size());
+	for (const uint16_t id : acked)
+	{
+		const size_t index = std::find(unreliableIDs.begin(), unreliableIDs.end(), id) - unreliableIDs.begin();
+		XYZ_CHECK(std::find(delivered.begin(), delivered.end(), index) != delivered.end());
+	}
+}
+
+XYZ_TEST(ReplicationConvergesOverLossyLink)
+{
+	// Full snapshot of this many entities does not fit into single datagram
+	const uint32_t entityCount = 5000;
+	SimulatedLink link(LossyConfiguration(0.05f));
+	ReplicationRegistry types;
+	types.RegisterTransform();
+
+	entt::registry serverScene, clientScene;
+	ReplicationServer server(types);
+	ReplicationClient client(types);
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+	std::vector<entt::entity> entities;
+	for (uint32_t i = 0; i < entityCount; ++i)
+	{
+		const entt::entity entity = serverScene.create();
+		serverScene.emplace<TransformComponent>(entity).GetTransform().Translation = { distribution(random), distribution(random), distribution(random) };
+		server.Replicate(entity);
+		entities.push_back(entity);
+	}
+
+	const uint32_t clientID = server.AddClient();
+	link.Server.SetAckHandler([&](uint16_t id) { server.OnSnapshotAcked(clientID, id); });
+	uint32_t badSnapshots = 0;
+	link.Client.SetMessageHandler([&](UDPChannel channel, const uint8_t* data, uint32_t size) {
+		BitReader reader(data, size);
+		badSnapshots += client.ReadSnapshot(reader, clientScene) ? 0 : 1;
+	});
+
+	const double deltaTime = 1.0 / 60.0;
+	uint32_t maxSnapshotSize = 0;
+	BitWriter writer;
+	for (uint32_t tick = 1; tick <= 900; ++tick)
+	{
+		// Quarter of entities moves, last part of run is quiet so client catches up
+		if (tick <= 600)
+		{
+			for (uint32_t i = 0; i < entityCount / 4; ++i)
+				serverScene.get<TransformComponent>(entities[i]).GetTransform().Translation.x += 5.0f * static_cast<float>(deltaTime);
+		}
+		server.CaptureSnapshot(serverScene, tick);
+		writer.Clear();
+		server.WriteSnapshot(clientID, writer);
+		maxSnapshotSize = std::max(maxSnapshotSize, writer.GetSize());
+		server.OnSnapshotSent(clientID, link.Server.SendUnreliable(writer.GetData(), writer.GetSize()));
+		link.Step(deltaTime);
+	}
+
+	XYZ_CHECK(maxSnapshotSize > 65507);
+	XYZ_CHECK(link.MaxPacketSize <= UDPSession::sc_MaxPacketSize);
+	XYZ_CHECK(badSnapshots == 0);
+	uint32_t mismatched = 0;
+	for (const entt::entity entity : entities)
+	{
+		const entt::entity clientEntity = client.GetEntity(server.Replicate(entity));
+		const TransformComponent* clientTransform = clientEntity != entt::null ? clientScene.try_get<TransformComponent>(clientEntity) : nullptr;
+		if (!clientTransform)
+		{
+			mismatched++;
+			continue;
+		}
+		const TransformComponent& serverTransform = serverScene.get<TransformComponent>(entity);
+		for (int i = 0; i < 3; ++i)
+		{
+			if (std::abs(serverTransform->Translation[i] - (*clientTransform)->Translation[i]) > 0.01f)
+			{
+				mismatched++;
+				break;
+			}
+		}
+	}
+	XYZ_CHECK(mismatched == 0);
+}
@@ -0,0 +1,154 @@
+#include "Test.h"
+
+#include "XYZ/Particle/CPU/ParticleKernels.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <cmath>
+
+using namespace XYZ;
+
+static constexpr float sc_LifeTime = 5.0f;
+
+static void FillPool(ParticlePool& pool, uint32_t count)
+{
+	uint32_t seed = count;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24);
+	};
+
+	pool.KillAll();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const uint32_t id = pool.Wake();
+		pool.SetVec3(ParticlePool::PositionX, id, glm::vec3(0.0f));
+		pool.SetVec3(ParticlePool::VelocityX, id, glm::vec3(random(), random(), random()));
+		pool.GetStream(ParticlePool::LifeRemaining)[id] = random() * sc_LifeTime;
+	}
+}
+
+// Layout before particles were split into streams, used as reference for benchmark
+struct AoSParticle
+{
+	glm::vec3 Position;
+	glm::vec3 Velocity;
+
+	glm::vec4 Color;
+	glm::vec2 TexOffset;
+	glm::vec3 Size;
+	glm::quat Rotation;
+
+	glm::vec3 LightColor;
+	float     LightRadius;
+	float     LightIntensity;
+
+	float     LifeRemaining;
+	bool      Alive;
+};
+
+XYZ_TEST(ParticlePoolKillKeepsAliveCompacted)
+{
+	ParticlePool pool(16);
+	for (uint32_t i = 0; i < 4; ++i)
+		pool.GetStream(ParticlePool::LifeRemaining)[pool.Wake()] = static_cast<float>(i);
+
+	pool.Kill(1);
+	XYZ_CHECK(pool.GetAliveParticles() == 3);
+	XYZ_CHECK(pool.GetStream(ParticlePool::LifeRemaining)[1] == 3.0f);
+	XYZ_CHECK(pool.GetStride() % 4 == 0);
+}
+
+XYZ_TEST(ParticleKernelsMatchScalarUpdate)
+{
+	const uint32_t count = 1001; // Not multiple of group size
+	ParticlePool pool(count);
+	FillPool(pool, count);
+
+	std::vector<float> lifeBefore(pool.GetStream(ParticlePool::LifeRemaining), pool.GetStream(ParticlePool::LifeRemaining) + count);
+	ParticleKernels::Integrate(pool, count, 0.5f);
+
+	const glm::vec4 startColor(1.0f, 0.0f, 0.0f, 1.0f), endColor(0.0f, 1.0f, 0.5f, 0.0f);
+	ParticleKernels::LerpChannel channels[4];
+	for (uint32_t c = 0; c < 4; ++c)
+		channels[c] = { pool.GetStream(static_cast<ParticlePool::Attribute>(ParticlePool::ColorR + c)), startColor[c], endColor[c] };
+	ParticleKernels::LerpOverLife(pool.GetStream(ParticlePool::LifeRemaining), sc_LifeTime, channels, 4, count);
+
+	const glm::vec3 endRadians(1.0f, -2.0f, 3.0f);
+	ParticleKernels::RotationOverLife(pool, endRadians, sc_LifeTime, count);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const float life = pool.GetStream(ParticlePool::LifeRemaining)[i];
+		XYZ_CHECK(std::abs(life - (lifeBefore[i] - 0.5f)) < 1e-5f);
+		XYZ_CHECK(glm::length(pool.GetVec3(ParticlePool::PositionX, i) - pool.GetVec3(ParticlePool::VelocityX, i) * 0.5f) < 1e-5f);
+
+		const float ratio = 1.0f - life / sc_LifeTime;
+		XYZ_CHECK(glm::length(pool.GetVec4(ParticlePool::ColorR, i) - glm::mix(startColor, endColor, ratio)) < 1e-5f);
+
+		// SIMD sine approximation differs slightly from std
+		const glm::quat expected(endRadians * ratio);
+		const glm::quat rotation = pool.GetRotation(i);
+		XYZ_CHECK(std::abs(glm::dot(expected, rotation)) > 1.0f - 1e-4f);
+	}
+}
+
+XYZ_BENCHMARK(ParticleUpdatePerMillisecond)
+{
+	const std::vector<uint32_t> counts = Test::IsQuick() ? std::vector<uint32_t>{ 10000 } : std::vector<uint32_t>{ 10000, 100000, 1000000 };
+	const uint32_t iterations = Test::IsQuick() ? 2 : 20;
+	const glm::vec4 startColor(1.0f), endColor(0.0f);
+	const glm::vec3 startSize(1.0f), endSize(0.1f);
+	const glm::vec3 endRadians(1.0f, 2.0f, 3.0f);
+	const float timestep = 0.001f;
+
+	for (const uint32_t count : counts)
+	{
+		// Integration, color, size and rotation over life, same stages as ParticleSystem jobs
+		{
+			ParticlePool pool(count);
+			FillPool(pool, count);
+			ParticleKernels::LerpChannel channels[7];
+			for (uint32_t c = 0; c < 4; ++c)
+				channels[c] = { pool.GetStream(static_cast<ParticlePool::Attribute>(ParticlePool::ColorR + c)), startColor[c], endColor[c] };
+			for (uint32_t c = 0; c < 3; ++c)
+				channels[4 + c] = { pool.GetStream(static_cast<ParticlePool::Attribute>(ParticlePool::SizeX + c)), startSize[c], endSize[c] };
+
+			Stopwatch timer;
+			for (uint32_t i = 0; i < iterations; ++i)
+			{
+				ParticleKernels::Integrate(pool, count, timestep);
+				ParticleKernels::LerpOverLife(pool.GetStream(ParticlePool::LifeRemaining), sc_LifeTime, channels, 7, count);
+				ParticleKernels::RotationOverLife(pool, endRadians, sc_LifeTime, count);
+			}
+			// Rate is per second, divided by 1000 it is particles per ms
+			Test::Report(std::to_string(count) + " particles, SoA kernels", static_cast<uint64_t>(count) * iterations, timer.Elapsed());
+		}
+		{
+			std::vector<AoSParticle> particles(count);
+			for (auto& particle : particles)
+			{
+				particle.Velocity = glm::vec3(1.0f);
+				particle.LifeRemaining = sc_LifeTime;
+				particle.Alive = true;
+			}
+
+			Stopwatch timer;
+			for (uint32_t i = 0; i < iterations; ++i)
+			{
+				for (auto& particle : particles)
+				{
+					if (!particle.Alive)
+						continue;
+					particle.Position += particle.Velocity * timestep;
+					particle.LifeRemaining -= timestep;
+
+					const float ratio = 1.0f - particle.LifeRemaining / sc_LifeTime;
+					particle.Color = glm::mix(startColor, endColor, ratio);
+					particle.Size = glm::mix(startSize, endSize, ratio);
+					particle.Rotation = glm::quat(endRadians * ratio);
+				}
+			}
+			Test::Report(std::to_string(count) + " particles, AoS reference", static_cast<uint64_t>(count) * iterations, timer.Elapsed());
+		}
+	}
+}
@@ -0,0 +1,129 @@
+#include "Test.h"
+#include "TestApplication.h"
+
+#include "XYZ/Scene/Scene.h"
+#include "XYZ/Scene/SceneEntity.h"
+#include "XYZ/Physics/PhysicsWorld2D.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <algorithm>
+
+using namespace XYZ;
+
+static SceneEntity CreateBox(const Ref<Scene>& scene, const glm::vec2& position, const glm::vec2& size, RigidBody2DComponent::BodyType type, uint32_t layer = PhysicsWorld2D::DefaultLayer)
+{
+	SceneEntity entity = scene->CreateEntity("Box");
+	entity.GetComponent<TransformComponent>().GetTransform().Translation = glm::vec3(position, 0.0f);
+	auto& rigidBody = entity.EmplaceComponent<RigidBody2DComponent>();
+	rigidBody.Type = type;
+	rigidBody.Layer = layer;
+	entity.EmplaceComponent<BoxCollider2DComponent>().Size = size;
+	return entity;
+}
+
+// Boxes are stacked in columns above static ground, so they collide and stay awake for a while.
+// Every second box is on particle layer, particles do not collide with each other
+static Ref<Scene> CreatePhysicsScene(uint32_t bodyCount)
+{
+	Test::GetApplication();
+	Ref<Scene> scene = Ref<Scene>::Create("Physics");
+	scene->CreateEntity("Camera").EmplaceComponent<CameraComponent>();
+
+	const uint32_t columns = 100;
+	CreateBox(scene, glm::vec2(0.0f, -1.0f), glm::vec2(columns * 2.0f, 1.0f), RigidBody2DComponent::BodyType::Static);
+	for (uint32_t i = 0; i < bodyCount; ++i)
+	{
+		const glm::vec2 position(static_cast<float>(i % columns) * 2.0f - columns, static_cast<float>(i / columns) * 1.1f);
+		const uint32_t layer = i % 2 ? PhysicsWorld2D::ParticleLayer : PhysicsWorld2D::DefaultLayer;
+		CreateBox(scene, position, glm::vec2(1.0f), RigidBody2DComponent::BodyType::Dynamic, layer);
+	}
+	return scene;
+}
+
+XYZ_TEST(SceneInterpolatesOnlyRenderTransform)
+{
+	Test::GetApplication();
+	Ref<Scene> scene = Ref<Scene>::Create("Physics");
+	scene->CreateEntity("Camera").EmplaceComponent<CameraComponent>();
+	SceneEntity body = CreateBox(scene, glm::vec2(0.0f, 10.0f), glm::vec2(1.0f), RigidBody2DComponent::BodyType::Dynamic);
+	scene->OnPlay();
+
+	// One step per frame with half of step left, second frame copies result of first one
+	const float frameTime = PhysicsWorld2D::Settings().FixedTimestep * 1.5f;
+	scene->OnUpdate(frameTime);
+	scene->OnUpdate(frameTime);
+
+	const TransformComponent& transform = body.GetComponent<TransformComponent>();
+	XYZ_CHECK(transform->Translation.y < 10.0f);
+	XYZ_CHECK(body.HasComponent<RenderTransformComponent>());
+
+	// Falling body is rendered between previous and simulated pose, above simulated one
+	const RenderTransformComponent& renderTransform = body.GetComponent<RenderTransformComponent>();
+	XYZ_CHECK(renderTransform.WorldTransform[3].y > transform->WorldTransform[3].y);
+	XYZ_CHECK(renderTransform.WorldTransform[3].y < 10.0f);
+	scene->OnStop();
+}
+
+XYZ_TEST(SceneFiltersContactsByLayer)
+{
+	Test::GetApplication();
+	Ref<Scene> scene = Ref<Scene>::Create("Physics");
+	scene->CreateEntity("Camera").EmplaceComponent<CameraComponent>();
+	// Overlapping particles ignore each other, particle overlapping default box collides
+	CreateBox(scene, glm::vec2(0.0f), glm::vec2(1.0f), RigidBody2DComponent::BodyType::Dynamic, PhysicsWorld2D::ParticleLayer);
+	CreateBox(scene, glm::vec2(0.0f), glm::vec2(1.0f), RigidBody2DComponent::BodyType::Dynamic, PhysicsWorld2D::ParticleLayer);
+	CreateBox(scene, glm::vec2(10.0f, 0.0f), glm::vec2(1.0f), RigidBody2DComponent::BodyType::Dynamic, PhysicsWorld2D::DefaultLayer);
+	CreateBox(scene, glm::vec2(10.0f, 0.0f), glm::vec2(1.0f), RigidBody2DComponent::BodyType::Dynamic, PhysicsWorld2D::ParticleLayer);
+	scene->OnPlay();
+
+	// Events of step started in first frame are dispatched in second one
+	const float frameTime = PhysicsWorld2D::Settings().FixedTimestep;
+	scene->OnUpdate(frameTime);
+	scene->OnUpdate(frameTime);
+	XYZ_CHECK(scene->GetContactEventCount() == 1);
+	scene->OnStop();
+}
+
+XYZ_BENCHMARK(SceneContactEventThroughput)
+{
+	const uint32_t count = Test::IsQuick() ? 1000 : 10000;
+	const uint32_t frames = Test::IsQuick() ? 30 : 300;
+	const float frameTime = 1.0f / 60.0f;
+	Ref<Scene> scene = CreatePhysicsScene(count);
+	scene->OnPlay();
+
+	// Piles settle over time, frames with most contacts are at start
+	uint64_t events = 0;
+	uint32_t maxEvents = 0;
+	Stopwatch timer;
+	for (uint32_t frame = 0; frame < frames; ++frame)
+	{
+		scene->OnUpdate(frameTime);
+		events += scene->GetContactEventCount();
+		maxEvents = std::max(maxEvents, scene->GetContactEventCount());
+	}
+	const float elapsed = timer.Elapsed();
+	Test::Report(std::to_string(count) + " bodies, frames", frames, elapsed);
+	Test::Report(std::to_string(count) + " bodies, contact events (" + std::to_string(maxEvents) + " max per frame)", events, elapsed);
+	XYZ_CHECK(events > 0);
+	scene->OnStop();
+}
+
+XYZ_BENCHMARK(ScenePhysicsBodies)
+{
+	const std::vector<uint32_t> counts = Test::IsQuick() ? std::vector<uint32_t>{ 500 } : std::vector<uint32_t>{ 1000, 10000, 20000 };
+	const uint32_t frames = Test::IsQuick() ? 10 : 120;
+	const float frameTime = 1.0f / 60.0f;
+	for (const uint32_t count : counts)
+	{
+		Ref<Scene> scene = CreatePhysicsScene(count);
+		scene->OnPlay();
+
+		// Main thread cost, step of previous frame overlaps with rest of frame and is waited for at start of next one
+		Stopwatch timer;
+		for (uint32_t frame = 0; frame < frames; ++frame)
+			scene->OnUpdate(frameTime);
+		Test::Report(std::to_string(count) + " bodies, frames", frames, timer.Elapsed());
+		scene->OnStop();
+	}
+}
@@ -0,0 +1,104 @@
+#include "Test.h"
+#include "TestApplication.h"
+
+#include "XYZ/Renderer/Renderer.h"
+#include "XYZ/Renderer/GeometryRenderQueue.h"
+#include "XYZ/Asset/AssetManager.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace XYZ;
+
+static Ref<MaterialAsset> GetQuadMaterial()
+{
+	Test::GetApplication();
+	return Renderer::GetDefaultResources().RendererAssets.at("QuadMaterial").As<MaterialAsset>();
+}
+
+static std::vector<Ref<SubTexture>> CreateSubTextures(uint32_t count)
+{
+	const uint32_t white = 0xffffffff;
+	std::vector<Ref<SubTexture>> subTextures;
+	for (uint32_t i = 0; i < count; ++i)
+		subTextures.push_back(Ref<SubTexture>::Create(Texture2D::Create(ImageFormat::RGBA, 1, 1, &white)));
+	return subTextures;
+}
+
+static glm::mat4 RandomTransform(uint32_t& seed)
+{
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) * 200.0f - 100.0f;
+	};
+	return glm::translate(glm::mat4(1.0f), glm::vec3(random(), random(), random()));
+}
+
+XYZ_TEST(GeometryRenderQueueSplitsSpriteBatches)
+{
+	Ref<MaterialAsset> material = GetQuadMaterial();
+	const uint32_t maxTextures = Renderer2D::GetMaxTextures();
+	std::vector<Ref<SubTexture>> subTextures = CreateSubTextures(2 * maxTextures + 1);
+
+	GeometryRenderQueue queue;
+	for (const auto& subTexture : subTextures)
+		queue.SubmitSprite(material, subTexture, glm::vec4(1.0f), glm::mat4(1.0f));
+	queue.BuildDrawCommands();
+
+	// Every command gets own texture slots, submissions must point to texture of their command
+	XYZ_CHECK(queue.SpriteDrawCommands.size() == 3);
+	for (const auto& command : queue.SpriteDrawCommands)
+	{
+		XYZ_CHECK(command.TextureCount <= maxTextures);
+		for (uint32_t i = command.First; i < command.First + command.Count; ++i)
+		{
+			const auto& submission = queue.SpriteSubmissions[i];
+			XYZ_CHECK(submission.Data.TextureIndex < command.TextureCount);
+			XYZ_CHECK(command.Textures[submission.Data.TextureIndex].Raw() == submission.Texture.Raw());
+		}
+	}
+}
+
+XYZ_BENCHMARK(GeometryRenderQueueSubmitAndSort)
+{
+	Ref<MaterialAsset> quadMaterial = GetQuadMaterial();
+	std::vector<Ref<MaterialAsset>> materials;
+	for (uint32_t i = 0; i < 8; ++i)
+		materials.push_back(Ref<MaterialAsset>::Create(quadMaterial->GetShaderAsset()));
+
+	std::vector<Ref<SubTexture>> subTextures = CreateSubTextures(64);
+	Ref<Mesh> mesh = AssetManager::GetAsset<Mesh>("Resources/Meshes/Cube.mesh");
+
+	const std::vector<uint32_t> counts = Test::IsQuick() ? std::vector<uint32_t>{ 5000 } : std::vector<uint32_t>{ 50000, 100000, 250000, 500000 };
+	GeometryRenderQueue queue;
+	for (const uint32_t count : counts)
+	{
+		uint32_t seed = count;
+		std::vector<glm::mat4> transforms(count);
+		for (auto& transform : transforms)
+			transform = RandomTransform(seed);
+
+		// Second frame is measured, buffers of queue are already grown like in running scene
+		for (uint32_t frame = 0; frame < 2; ++frame)
+		{
+			queue.Clear();
+			Stopwatch timer;
+			for (uint32_t i = 0; i < count; ++i)
+				queue.SubmitSprite(materials[i % materials.size()], subTextures[i % subTextures.size()], glm::vec4(1.0f), transforms[i]);
+			queue.BuildDrawCommands();
+			if (frame == 1)
+				Test::Report(std::to_string(count) + " sprites, submit + sort", count, timer.Elapsed());
+		}
+		for (uint32_t frame = 0; frame < 2; ++frame)
+		{
+			queue.Clear();
+			Stopwatch timer;
+			for (uint32_t i = 0; i < count; ++i)
+				queue.SubmitMesh(mesh, materials[i % materials.size()], transforms[i]);
+			queue.BuildDrawCommands();
+			if (frame == 1)
+				Test::Report(std::to_string(count) + " meshes, submit + sort", count, timer.Elapsed());
+		}
+	}
+	queue.Clear();
+}
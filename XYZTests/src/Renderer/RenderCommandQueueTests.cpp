@@ -0,0 +1,175 @@
+#include "Test.h"
+
+#include "XYZ/Renderer/RenderCommandQueue.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+using namespace XYZ;
+
+// Same recording as Renderer::Submit
+template <typename FuncT>
+static void Submit(RenderCommandQueue& queue, FuncT&& func)
+{
+	auto renderCmd = [](void* ptr) {
+		auto pFunc = static_cast<FuncT*>(ptr);
+		(*pFunc)();
+		pFunc->~FuncT();
+	};
+	auto storageBuffer = queue.Allocate(renderCmd, sizeof(func));
+	new (storageBuffer) FuncT(std::forward<FuncT>(func));
+	queue.Commit();
+}
+
+XYZ_TEST(RenderCommandQueueKeepsOrderAcrossBlocks)
+{
+	// Small blocks, commands often continue in next block and some do not fit into block at all
+	RenderCommandQueue queue(256);
+	std::vector<uint32_t> order;
+	for (uint32_t frame = 0; frame < 3; ++frame)
+	{
+		order.clear();
+		for (uint32_t i = 0; i < 1000; ++i)
+		{
+			if (i % 7 == 0)
+			{
+				std::array<uint8_t, 300> payload{};
+				payload[299] = 1;
+				Submit(queue, [&order, i, payload]() { order.push_back(i * payload[299]); });
+			}
+			else
+			{
+				Submit(queue, [&order, i]() { order.push_back(i); });
+			}
+		}
+		XYZ_CHECK(queue.GetCommandCount() == 1000);
+		queue.Execute();
+		XYZ_CHECK(queue.GetCommandCount() == 0);
+		XYZ_CHECK(order.size() == 1000);
+		for (uint32_t i = 0; i < order.size(); ++i)
+			XYZ_CHECK(order[i] == i);
+	}
+}
+
+XYZ_TEST(RenderCommandQueueMergesThreadsInSubmissionOrder)
+{
+	RenderCommandQueue queue(1024);
+	std::vector<uint32_t> order;
+	// Threads take turns, so sequence alternates between segments
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		std::thread thread([&queue, &order, i]() { Submit(queue, [&order, i]() { order.push_back(i); }); });
+		thread.join();
+		Submit(queue, [&order, i]() { order.push_back(i + 1000); });
+	}
+	queue.Execute();
+
+	XYZ_CHECK(order.size() == 128);
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		XYZ_CHECK(order[2 * i] == i);
+		XYZ_CHECK(order[2 * i + 1] == i + 1000);
+	}
+}
+
+XYZ_TEST(RenderCommandQueueSubmitDuringExecuteIsNotLost)
+{
+	RenderCommandQueue queue(4096);
+	const uint32_t threadCount = 4;
+	const uint32_t commandCount = 50000;
+
+	std::array<uint32_t, threadCount> executed{};
+	std::atomic<bool> outOfOrder = false;
+	std::atomic<uint32_t> finishedThreads = 0;
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t]() {
+			for (uint32_t i = 0; i < commandCount; ++i)
+			{
+				Submit(queue, [&executed, &outOfOrder, t, i]() {
+					if (executed[t] != i)
+						outOfOrder = true;
+					executed[t]++;
+				});
+			}
+			finishedThreads++;
+		});
+	}
+
+	// Executes concurrently with recording threads
+	while (finishedThreads != threadCount)
+		queue.Execute();
+	queue.Execute();
+	for (auto& thread : threads)
+		thread.join();
+
+	XYZ_CHECK(!outOfOrder);
+	for (uint32_t t = 0; t < threadCount; ++t)
+		XYZ_CHECK(executed[t] == commandCount);
+	XYZ_CHECK(queue.GetCommandCount() == 0);
+}
+
+XYZ_TEST(RenderCommandQueueCommandSubmittedByCommandRunsNextExecute)
+{
+	RenderCommandQueue queue;
+	uint32_t counter = 0;
+	Submit(queue, [&queue, &counter]() {
+		counter++;
+		Submit(queue, [&counter]() { counter += 10; });
+	});
+	queue.Execute();
+	XYZ_CHECK(counter == 1);
+	XYZ_CHECK(queue.GetCommandCount() == 1);
+	queue.Execute();
+	XYZ_CHECK(counter == 11);
+}
+
+XYZ_BENCHMARK(RenderCommandQueueSubmitsPerSecond)
+{
+	const uint32_t commandsPerThread = Test::IsQuick() ? 10000 : 1000000;
+	for (uint32_t threadCount = 1; threadCount <= 16; threadCount *= 2)
+	{
+		RenderCommandQueue queue;
+		std::atomic<uint64_t> sum = 0;
+		// Warm up segments and blocks like in running application
+		for (uint32_t frame = 0; frame < 2; ++frame)
+		{
+			std::atomic<uint32_t> ready = 0;
+			std::atomic<bool> start = false;
+			std::vector<std::thread> threads;
+			for (uint32_t t = 0; t < threadCount; ++t)
+			{
+				threads.emplace_back([&]() {
+					ready++;
+					while (!start)
+						std::this_thread::yield();
+					// Typical command captures a few refs and values
+					std::array<uint64_t, 4> payload{ 1, 2, 3, 4 };
+					for (uint32_t i = 0; i < commandsPerThread; ++i)
+						Submit(queue, [&sum, payload]() { sum.fetch_add(payload[0], std::memory_order_relaxed); });
+				});
+			}
+			while (ready != threadCount)
+				std::this_thread::yield();
+
+			Stopwatch timer;
+			start = true;
+			for (auto& thread : threads)
+				thread.join();
+			const float submitTime = timer.Elapsed();
+
+			Stopwatch executeTimer;
+			queue.Execute();
+			const float executeTime = executeTimer.Elapsed();
+			if (frame == 1)
+			{
+				const uint64_t total = static_cast<uint64_t>(commandsPerThread) * threadCount;
+				Test::Report(std::to_string(threadCount) + " threads, submit", total, submitTime);
+				Test::Report(std::to_string(threadCount) + " threads, execute", total, executeTime);
+			}
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#include "Test.h"
+#include "TestApplication.h"
+
+#include "XYZ/Scene/Scene.h"
+#include "XYZ/Scene/SceneEntity.h"
+#include "XYZ/Scene/Prefab.h"
+#include "XYZ/Asset/AssetManager.h"
+#include "XYZ/Debug/Timer.h"
+
+using namespace XYZ;
+
+static const char* sc_CharacterPrefab = "Assets/Prefabs/Character Running.prefab";
+
+// Characters are placed on grid in front of view at origin, so all animation lods are used
+static Ref<Scene> CreateCharacterScene(uint32_t count)
+{
+	Test::GetApplication();
+	Ref<Prefab> prefab = AssetManager::GetAsset<Prefab>(sc_CharacterPrefab);
+	Ref<Scene> scene = Ref<Scene>::Create("Characters");
+	const uint32_t columns = 100;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const glm::vec3 translation(static_cast<float>(i % columns) * 2.0f - columns, 0.0f, -static_cast<float>(i / columns) * 2.0f);
+		prefab->Instantiate(scene, SceneEntity(), &translation);
+	}
+	scene->GetRegistry().view<AnimationComponent>().each([](AnimationComponent& anim) {
+		anim.Playing = true;
+	});
+	return scene;
+}
+
+static AnimationComponent& GetCharacterAnimation(const Ref<Scene>& scene, entt::entity& meshEntity)
+{
+	auto view = scene->GetRegistry().view<AnimationComponent, AnimatedMeshComponent>();
+	meshEntity = *view.begin();
+	return view.get<AnimationComponent>(meshEntity);
+}
+
+XYZ_TEST(SceneDetectsBoneObservers)
+{
+	Ref<Scene> scene = CreateCharacterScene(1);
+	entt::entity meshEntity = entt::null;
+	AnimationComponent& anim = GetCharacterAnimation(scene, meshEntity);
+	const auto& bones = scene->GetRegistry().get<AnimatedMeshComponent>(meshEntity).BoneEntities;
+	XYZ_CHECK(!bones.empty());
+
+	scene->OnUpdateEditor(0.016f);
+	XYZ_CHECK(!anim.BonesObserved);
+
+	// Entity attached to bone must follow it
+	SceneEntity attached = scene->CreateEntity("Weapon", SceneEntity(bones.back(), scene.Raw()));
+	scene->OnUpdateEditor(0.016f);
+	XYZ_CHECK(anim.BonesObserved);
+
+	scene->DestroyEntity(attached);
+	scene->SetSelectedEntity(bones.front());
+	scene->OnUpdateEditor(0.016f);
+	XYZ_CHECK(anim.BonesObserved);
+
+	scene->SetSelectedEntity(entt::null);
+	scene->OnUpdateEditor(0.016f);
+	XYZ_CHECK(!anim.BonesObserved);
+}
+
+XYZ_BENCHMARK(SceneAnimationUpdate)
+{
+	const std::vector<uint32_t> counts = Test::IsQuick() ? std::vector<uint32_t>{ 100 } : std::vector<uint32_t>{ 1000, 5000, 10000 };
+	const uint32_t frames = Test::IsQuick() ? 4 : 60;
+	for (const uint32_t count : counts)
+	{
+		Ref<Scene> scene = CreateCharacterScene(count);
+		for (const bool forceBones : { false, true })
+		{
+			scene->GetRegistry().view<AnimationComponent>().each([forceBones](AnimationComponent& anim) {
+				anim.UpdateBoneEntities = forceBones;
+			});
+			// First frame samples every character and allocates palettes
+			scene->OnUpdateEditor(0.016f);
+
+			Stopwatch timer;
+			for (uint32_t frame = 0; frame < frames; ++frame)
+				scene->OnUpdateEditor(0.016f);
+			const std::string name = std::to_string(count) + (forceBones ? " characters, bone entities" : " characters, palette only");
+			Test::Report(name, static_cast<uint64_t>(count) * frames, timer.Elapsed());
+		}
+	}
+}
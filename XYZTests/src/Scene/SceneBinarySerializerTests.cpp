@@ -0,0 +1,225 @@
+#include "Test.h"
+#include "TestApplication.h"
+
+#include "XYZ/Scene/Scene.h"
+#include "XYZ/Scene/SceneEntity.h"
+#include "XYZ/Scene/SceneSerializer.h"
+#include "XYZ/Scene/SceneBinarySerializer.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace XYZ;
+
+static std::string TempScenePath(const char* name)
+{
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Every tenth entity is root, others are children of previous root
+static Ref<Scene> CreateTestScene(uint32_t entityCount)
+{
+	Test::GetApplication();
+	Ref<Scene> scene = Ref<Scene>::Create("Test Scene");
+	SceneEntity parent;
+	for (uint32_t i = 0; i < entityCount; ++i)
+	{
+		const std::string name = "Entity " + std::to_string(i);
+		SceneEntity entity = i % 10 == 0 ? scene->CreateEntity(name) : scene->CreateEntity(name, parent);
+		if (i % 10 == 0)
+			parent = entity;
+
+		auto& transform = entity.GetComponent<TransformComponent>().GetTransform();
+		transform.Translation = glm::vec3(static_cast<float>(i), 1.0f, -2.0f);
+		transform.Scale = glm::vec3(2.0f);
+		if (i % 3 == 0)
+			entity.EmplaceComponent<PointLightComponent2D>(glm::vec3(0.5f, 0.25f, 1.0f), 3.0f, static_cast<float>(i));
+		if (i % 5 == 0)
+		{
+			auto& collider = entity.EmplaceComponent<BoxCollider2DComponent>();
+			collider.Size = glm::vec2(static_cast<float>(i), 2.0f);
+		}
+		if (i % 7 == 0)
+		{
+			auto& chain = entity.EmplaceComponent<ChainCollider2DComponent>();
+			chain.Points = { glm::vec2(0.0f), glm::vec2(1.0f, static_cast<float>(i)), glm::vec2(2.0f, 0.0f) };
+		}
+	}
+	return scene;
+}
+
+static GUID ParentGUID(const entt::registry& reg, entt::entity entity)
+{
+	const entt::entity parent = reg.get<Relationship>(entity).GetParent();
+	return reg.valid(parent) ? reg.get<IDComponent>(parent).ID : GUID(0, 0);
+}
+
+static void CheckScenesEqual(const Ref<Scene>& expected, const Ref<Scene>& loaded)
+{
+	XYZ_CHECK(loaded.Raw() != nullptr);
+	XYZ_CHECK(loaded->GetName() == expected->GetName());
+
+	const entt::registry& expectedReg = expected->GetRegistry();
+	const entt::registry& loadedReg = loaded->GetRegistry();
+	XYZ_CHECK(expectedReg.alive() == loadedReg.alive());
+
+	expectedReg.view<const IDComponent>().each([&](const entt::entity entity, const IDComponent& id) {
+		const entt::entity other = loaded->GetEntityByGUID(id.ID).ID();
+		XYZ_CHECK(loadedReg.valid(other));
+		XYZ_CHECK(ParentGUID(expectedReg, entity) == ParentGUID(loadedReg, other));
+		if (expectedReg.all_of<SceneTagComponent>(entity))
+			XYZ_CHECK(expectedReg.get<SceneTagComponent>(entity) == loadedReg.get<SceneTagComponent>(other));
+		if (expectedReg.all_of<TransformComponent>(entity))
+		{
+			XYZ_CHECK(expectedReg.get<TransformComponent>(entity)->Translation == loadedReg.get<TransformComponent>(other)->Translation);
+			XYZ_CHECK(expectedReg.get<TransformComponent>(entity)->Scale == loadedReg.get<TransformComponent>(other)->Scale);
+		}
+
+		XYZ_CHECK(expectedReg.all_of<PointLightComponent2D>(entity) == loadedReg.all_of<PointLightComponent2D>(other));
+		if (expectedReg.all_of<PointLightComponent2D>(entity))
+		{
+			const auto& light = expectedReg.get<PointLightComponent2D>(entity);
+			const auto& loadedLight = loadedReg.get<PointLightComponent2D>(other);
+			XYZ_CHECK(light.Color == loadedLight.Color && light.Radius == loadedLight.Radius && light.Intensity == loadedLight.Intensity);
+		}
+		XYZ_CHECK(expectedReg.all_of<BoxCollider2DComponent>(entity) == loadedReg.all_of<BoxCollider2DComponent>(other));
+		if (expectedReg.all_of<BoxCollider2DComponent>(entity))
+			XYZ_CHECK(expectedReg.get<BoxCollider2DComponent>(entity).Size == loadedReg.get<BoxCollider2DComponent>(other).Size);
+
+		XYZ_CHECK(expectedReg.all_of<ChainCollider2DComponent>(entity) == loadedReg.all_of<ChainCollider2DComponent>(other));
+		if (expectedReg.all_of<ChainCollider2DComponent>(entity))
+			XYZ_CHECK(expectedReg.get<ChainCollider2DComponent>(entity).Points == loadedReg.get<ChainCollider2DComponent>(other).Points);
+	});
+}
+
+static void PatchFile(const std::string& filepath, uint64_t offset, uint32_t value)
+{
+	std::fstream file(filepath, std::ios::binary | std::ios::in | std::ios::out);
+	file.seekp(offset);
+	file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static uint32_t ReadFile(const std::string& filepath, uint64_t offset)
+{
+	std::ifstream file(filepath, std::ios::binary);
+	uint32_t value = 0;
+	file.seekg(offset);
+	file.read(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+}
+
+XYZ_TEST(SceneBinarySerializerRoundTrip)
+{
+	Ref<Scene> scene = CreateTestScene(100);
+	const std::string filepath = TempScenePath("XYZTestsRoundTrip.xyz");
+
+	SceneBinarySerializer serializer;
+	serializer.Serialize(filepath, scene);
+	XYZ_CHECK(SceneBinarySerializer::IsBinaryScene(filepath));
+	Ref<Scene> loaded = serializer.Deserialize(filepath);
+	CheckScenesEqual(scene, loaded);
+
+	// Loaded scene must serialize to same file
+	const std::string secondPath = TempScenePath("XYZTestsRoundTrip2.xyz");
+	serializer.Serialize(secondPath, loaded);
+	CheckScenesEqual(scene, serializer.Deserialize(secondPath));
+
+	std::filesystem::remove(filepath);
+	std::filesystem::remove(secondPath);
+}
+
+XYZ_TEST(SceneBinarySerializerConvertsFromText)
+{
+	Ref<Scene> scene = CreateTestScene(50);
+	const std::string textPath = TempScenePath("XYZTestsText.xyz");
+	const std::string binaryPath = TempScenePath("XYZTestsBinary.xyz");
+
+	SceneSerializer textSerializer;
+	textSerializer.Serialize(textPath, scene);
+	XYZ_CHECK(!SceneBinarySerializer::IsBinaryScene(textPath));
+	Ref<Scene> textScene = textSerializer.Deserialize(textPath);
+
+	SceneBinarySerializer binarySerializer;
+	binarySerializer.Serialize(binaryPath, textScene);
+	CheckScenesEqual(scene, binarySerializer.Deserialize(binaryPath));
+
+	std::filesystem::remove(textPath);
+	std::filesystem::remove(binaryPath);
+}
+
+XYZ_TEST(SceneBinarySerializerRejectsCorruptedFile)
+{
+	// Offsets of FileHeader and ChunkHeader fields
+	const uint64_t sceneNameSizeOffset = 20;
+	const uint64_t chunkTableOffset = 56;
+	const uint64_t recordSizeOffset = 8;
+	const uint64_t entitiesOffset = 16;
+	const uint64_t chunkHeaderSize = 48;
+
+	Ref<Scene> scene = CreateTestScene(20);
+	const std::string filepath = TempScenePath("XYZTestsCorrupted.xyz");
+	SceneBinarySerializer serializer;
+
+	serializer.Serialize(filepath, scene);
+	const uint64_t chunkHeader = ReadFile(filepath, chunkTableOffset);
+	PatchFile(filepath, chunkHeader + recordSizeOffset, ReadFile(filepath, chunkHeader + recordSizeOffset) + 4);
+	XYZ_CHECK(!serializer.Deserialize(filepath).Raw());
+
+	serializer.Serialize(filepath, scene);
+	PatchFile(filepath, sceneNameSizeOffset, UINT32_MAX);
+	XYZ_CHECK(!serializer.Deserialize(filepath).Raw());
+
+	// Entity owns same component twice
+	serializer.Serialize(filepath, scene);
+	const uint64_t entities = ReadFile(filepath, chunkHeader + entitiesOffset);
+	PatchFile(filepath, entities + sizeof(uint32_t), ReadFile(filepath, entities));
+	XYZ_CHECK(!serializer.Deserialize(filepath).Raw());
+
+	// Second chunk is copy of first one
+	serializer.Serialize(filepath, scene);
+	for (uint64_t offset = 0; offset < chunkHeaderSize; offset += sizeof(uint32_t))
+		PatchFile(filepath, chunkHeader + chunkHeaderSize + offset, ReadFile(filepath, chunkHeader + offset));
+	XYZ_CHECK(!serializer.Deserialize(filepath).Raw());
+
+	serializer.Serialize(filepath, scene);
+	std::filesystem::resize_file(filepath, std::filesystem::file_size(filepath) / 2);
+	XYZ_CHECK(!serializer.Deserialize(filepath).Raw());
+
+	std::filesystem::remove(filepath);
+}
+
+XYZ_BENCHMARK(SceneSerializerLoadTime)
+{
+	const std::vector<uint32_t> counts = Test::IsQuick() ? std::vector<uint32_t>{ 1000 } : std::vector<uint32_t>{ 10000, 100000, 1000000 };
+	const std::string binaryPath = TempScenePath("XYZBenchmarkBinary.xyz");
+	const std::string textPath = TempScenePath("XYZBenchmarkText.xyz");
+	for (const uint32_t count : counts)
+	{
+		Ref<Scene> scene = CreateTestScene(count);
+		{
+			SceneBinarySerializer serializer;
+			Stopwatch saveTimer;
+			serializer.Serialize(binaryPath, scene);
+			Test::Report(std::to_string(count) + " entities, binary save", count, saveTimer.Elapsed());
+
+			Stopwatch loadTimer;
+			Ref<Scene> loaded = serializer.Deserialize(binaryPath);
+			Test::Report(std::to_string(count) + " entities, binary load", count, loadTimer.Elapsed());
+		}
+		// Text format takes minutes for million entities
+		if (count <= 100000)
+		{
+			SceneSerializer serializer;
+			Stopwatch saveTimer;
+			serializer.Serialize(textPath, scene);
+			Test::Report(std::to_string(count) + " entities, text save", count, saveTimer.Elapsed());
+
+			Stopwatch loadTimer;
+			Ref<Scene> loaded = serializer.Deserialize(textPath);
+			Test::Report(std::to_string(count) + " entities, text load", count, loadTimer.Elapsed());
+		}
+	}
+	std::filesystem::remove(binaryPath);
+	std::filesystem::remove(textPath);
+}
@@ -0,0 +1,126 @@
+#include "Test.h"
+#include "TestApplication.h"
+
+#include "XYZ/Scene/Scene.h"
+#include "XYZ/Scene/SceneEntity.h"
+#include "XYZ/Scene/SceneIntersection.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <cmath>
+
+using namespace XYZ;
+
+// Grid of quads in xy plane facing +z, spans from -0.5 to 0.5
+static Ref<StaticMesh> CreateGridMesh(uint32_t columns, uint32_t rows)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y <= rows; ++y)
+	{
+		for (uint32_t x = 0; x <= columns; ++x)
+		{
+			Vertex vertex{};
+			vertex.Position = glm::vec3(static_cast<float>(x) / columns - 0.5f, static_cast<float>(y) / rows - 0.5f, 0.0f);
+			vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			vertices.push_back(vertex);
+		}
+	}
+	for (uint32_t y = 0; y < rows; ++y)
+	{
+		for (uint32_t x = 0; x < columns; ++x)
+		{
+			const uint32_t first = y * (columns + 1) + x;
+			const uint32_t above = first + columns + 1;
+			indices.insert(indices.end(), { first, first + 1, above + 1, above + 1, above, first });
+		}
+	}
+	return Ref<StaticMesh>::Create(Ref<MeshSource>::Create(std::move(vertices), std::move(indices)));
+}
+
+static SceneEntity CreateGridEntity(const Ref<Scene>& scene, const Ref<StaticMesh>& mesh, const glm::vec3& translation)
+{
+	SceneEntity entity = scene->CreateEntity("Grid");
+	entity.GetComponent<TransformComponent>().GetTransform().Translation = translation;
+	entity.EmplaceComponent<MeshComponent>(mesh, Ref<MaterialAsset>());
+	return entity;
+}
+
+static Ray DownRay(float x, float y)
+{
+	return { glm::vec3(x, y, 10.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+}
+
+XYZ_TEST(SceneIntersectionRaycastHitsClosest)
+{
+	Test::GetApplication();
+	Ref<Scene> scene = Ref<Scene>::Create("Intersection");
+	Ref<StaticMesh> mesh = CreateGridMesh(4, 4);
+	SceneEntity front = CreateGridEntity(scene, mesh, glm::vec3(0.0f, 0.0f, 1.0f));
+	SceneEntity back = CreateGridEntity(scene, mesh, glm::vec3(0.0f, 0.0f, -1.0f));
+	scene->OnUpdateEditor(0.016f);
+
+	SceneIntersection::HitData hit;
+	XYZ_CHECK(SceneIntersection::Raycast(DownRay(0.1f, 0.1f), scene, hit));
+	XYZ_CHECK(hit.Entity == front);
+	XYZ_CHECK(std::abs(hit.Distance - 9.0f) < 1e-4f);
+	XYZ_CHECK(SceneIntersection::Intersect(DownRay(0.1f, 0.1f), scene).size() == 2);
+	XYZ_CHECK(!SceneIntersection::Raycast(DownRay(2.0f, 0.1f), scene, hit));
+
+	// Moved entity is refit after next frame
+	front.GetComponent<TransformComponent>().GetTransform().Translation.x = 5.0f;
+	scene->OnUpdateEditor(0.016f);
+	XYZ_CHECK(SceneIntersection::Raycast(DownRay(0.1f, 0.1f), scene, hit));
+	XYZ_CHECK(hit.Entity == back);
+
+	// Removed renderable must not be returned even before next frame
+	back.RemoveComponent<MeshComponent>();
+	XYZ_CHECK(!SceneIntersection::Raycast(DownRay(0.1f, 0.1f), scene, hit));
+	XYZ_CHECK(SceneIntersection::Overlap(AABB(glm::vec3(4.0f, -1.0f, 0.0f), glm::vec3(6.0f, 1.0f, 2.0f)), scene).size() == 1);
+}
+
+XYZ_BENCHMARK(SceneIntersectionMillionTriangles)
+{
+	Test::GetApplication();
+	const uint32_t rayCount = Test::IsQuick() ? 1000 : 100000;
+	const uint32_t frames = Test::IsQuick() ? 2 : 20;
+	// Same triangle count in one big mesh and in many small instances, 2 * 512 * 1024 is about one million
+	struct Layout { uint32_t Columns, Rows, Instances; const char* Name; };
+	const std::vector<Layout> layouts = Test::IsQuick()
+		? std::vector<Layout>{ { 64, 32, 1, "1 mesh" }, { 8, 4, 64, "64 meshes" } }
+		: std::vector<Layout>{ { 1024, 512, 1, "1 mesh" }, { 32, 16, 1024, "1024 meshes" } };
+
+	for (const Layout& layout : layouts)
+	{
+		Ref<Scene> scene = Ref<Scene>::Create("Intersection");
+		Ref<StaticMesh> mesh = CreateGridMesh(layout.Columns, layout.Rows);
+		const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(layout.Instances))));
+		for (uint32_t i = 0; i < layout.Instances; ++i)
+			CreateGridEntity(scene, mesh, glm::vec3(static_cast<float>(i % side), static_cast<float>(i / side), 0.0f));
+		scene->OnUpdateEditor(0.016f);
+
+		const uint64_t triangles = static_cast<uint64_t>(layout.Columns) * layout.Rows * 2 * layout.Instances;
+		const std::string name = std::to_string(triangles) + " triangles, " + layout.Name;
+
+		// First query after frame refits scene, following queries reuse it
+		Stopwatch updateTimer;
+		SceneIntersection::HitData hit;
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			scene->OnUpdateEditor(0.016f);
+			SceneIntersection::Raycast(DownRay(0.0f, 0.0f), scene, hit);
+		}
+		Test::Report(name + ", frame + first raycast", frames, updateTimer.Elapsed());
+
+		uint32_t seed = layout.Instances;
+		auto random = [&seed, side]() {
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) * side - 0.5f;
+		};
+		uint32_t hits = 0;
+		Stopwatch raycastTimer;
+		for (uint32_t i = 0; i < rayCount; ++i)
+			hits += SceneIntersection::Raycast(DownRay(random(), random()), scene, hit);
+		Test::Report(name + ", raycasts", rayCount, raycastTimer.Elapsed());
+		XYZ_CHECK(hits > 0);
+	}
+}
@@ -0,0 +1,99 @@
+#include "Test.h"
+#include "TestApplication.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace XYZ {
+	namespace Test {
+
+		static bool s_Quick = false;
+
+		std::vector<Case>& GetCases()
+		{
+			static std::vector<Case> cases;
+			return cases;
+		}
+
+		bool IsQuick()
+		{
+			return s_Quick;
+		}
+
+		void Report(const std::string& name, uint64_t operations, float milliseconds)
+		{
+			const double rate = milliseconds > 0.0f ? operations / (milliseconds * 0.001) : 0.0;
+			printf("  %-56s %12.3f ms %16.0f ops/s\n", name.c_str(), milliseconds, rate);
+		}
+
+		void Fail(const char* expression, const char* file, int line)
+		{
+			throw Failure{ std::string(file) + ":" + std::to_string(line) + ": " + expression };
+		}
+	}
+}
+
+using namespace XYZ;
+
+// Usage: XYZTests [--tests | --benchmarks | --all] [--quick] [filter]
+// Without arguments only tests are run, filter is matched against case name.
+// Renderer cases need working directory with engine Resources (XYZEditor)
+int main(int argc, char** argv)
+{
+	bool runTests = true;
+	bool runBenchmarks = false;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--tests") == 0)
+		{
+			runTests = true;
+			runBenchmarks = false;
+		}
+		else if (strcmp(argv[i], "--benchmarks") == 0)
+		{
+			runTests = false;
+			runBenchmarks = true;
+		}
+		else if (strcmp(argv[i], "--all") == 0)
+		{
+			runTests = true;
+			runBenchmarks = true;
+		}
+		else if (strcmp(argv[i], "--quick") == 0)
+		{
+			Test::s_Quick = true;
+		}
+		else
+		{
+			filter = argv[i];
+		}
+	}
+
+	uint32_t passed = 0;
+	uint32_t failed = 0;
+	for (const Test::Case& testCase : Test::GetCases())
+	{
+		const bool enabled = testCase.Type == Test::CaseType::Test ? runTests : runBenchmarks;
+		if (!enabled || (filter && !strstr(testCase.Name, filter)))
+			continue;
+
+		printf("[ RUN  ] %s\n", testCase.Name);
+		fflush(stdout);
+		try
+		{
+			testCase.Function();
+			printf("[  OK  ] %s\n", testCase.Name);
+			passed++;
+		}
+		catch (const Test::Failure& failure)
+		{
+			printf("[ FAIL ] %s\n         %s\n", testCase.Name, failure.Message.c_str());
+			failed++;
+		}
+		fflush(stdout);
+	}
+	Test::DestroyApplication();
+	printf("%u passed, %u failed\n", passed, failed);
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace XYZ {
+	namespace Test {
+
+		enum class CaseType
+		{
+			Test,
+			Benchmark
+		};
+
+		struct Case
+		{
+			const char* Name;
+			CaseType	Type;
+			void(*Function)();
+		};
+
+		// Thrown by XYZ_CHECK, fails current case and continues with next one
+		struct Failure
+		{
+			std::string Message;
+		};
+
+		std::vector<Case>& GetCases();
+
+		struct Registrar
+		{
+			Registrar(const char* name, CaseType type, void(*function)())
+			{
+				GetCases().push_back({ name, type, function });
+			}
+		};
+
+		// Benchmarks run with fewer iterations when true, used to check that they still work
+		bool IsQuick();
+
+		// Prints one benchmark line, rate is operations per second
+		void Report(const std::string& name, uint64_t operations, float milliseconds);
+
+		[[noreturn]] void Fail(const char* expression, const char* file, int line);
+	}
+}
+
+#define XYZ_TEST_CASE(name, type)\
+	static void name();\
+	static XYZ::Test::Registrar s_##name##Registrar(#name, type, &name);\
+	static void name()
+
+#define XYZ_TEST(name)		XYZ_TEST_CASE(name, XYZ::Test::CaseType::Test)
+#define XYZ_BENCHMARK(name) XYZ_TEST_CASE(name, XYZ::Test::CaseType::Benchmark)
+
+#define XYZ_CHECK(expression) { if (!(expression)) XYZ::Test::Fail(#expression, __FILE__, __LINE__); }
@@ -0,0 +1,25 @@
+#include "TestApplication.h"
+
+namespace XYZ {
+	namespace Test {
+
+		static Application* s_Application = nullptr;
+
+		Application& GetApplication()
+		{
+			if (!s_Application)
+			{
+				ApplicationSpecification specification;
+				specification.EnableImGui = false;
+				s_Application = new Application(specification);
+			}
+			return *s_Application;
+		}
+
+		void DestroyApplication()
+		{
+			delete s_Application;
+			s_Application = nullptr;
+		}
+	}
+}
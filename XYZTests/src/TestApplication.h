@@ -0,0 +1,13 @@
+#pragma once
+#include "XYZ/Core/Application.h"
+
+namespace XYZ {
+	namespace Test {
+
+		// Creates application with window and renderer on first call,
+		// cases that need renderer or assets must run from directory with engine Resources
+		Application& GetApplication();
+
+		void DestroyApplication();
+	}
+}
@@ -0,0 +1,205 @@
+#include "Test.h"
+
+#include "XYZ/Utils/DataStructures/DynamicTree.h"
+#include "XYZ/Core/ThreadPool.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <thread>
+
+using namespace XYZ;
+
+class RandomBoxes
+{
+public:
+	RandomBoxes(uint32_t seed, float worldSize)
+		: m_Seed(seed), m_WorldSize(worldSize)
+	{}
+
+	float Next()
+	{
+		m_Seed = m_Seed * 1664525u + 1013904223u;
+		return static_cast<float>(m_Seed >> 8) / static_cast<float>(1 << 24);
+	}
+	glm::vec3 Position() { return glm::vec3(Next(), Next(), Next()) * m_WorldSize; }
+	AABB Box()
+	{
+		const glm::vec3 position = Position();
+		return AABB(position, position + glm::vec3(0.5f + Next()));
+	}
+
+private:
+	uint32_t m_Seed;
+	float	 m_WorldSize;
+};
+
+static AABB Translated(const AABB& box, const glm::vec3& displacement)
+{
+	return AABB(box.Min + displacement, box.Max + displacement);
+}
+
+static std::set<std::pair<int32_t, int32_t>> SortedPairs(const std::vector<ProxyPair>& pairs)
+{
+	std::set<std::pair<int32_t, int32_t>> result;
+	for (const ProxyPair& pair : pairs)
+		result.insert({ std::min(pair.First, pair.Second), std::max(pair.First, pair.Second) });
+	return result;
+}
+
+XYZ_TEST(DynamicTreeQueryMatchesBruteForce)
+{
+	RandomBoxes random(7, 50.0f);
+	DynamicTree tree;
+	std::vector<AABB> boxes;
+	std::vector<int32_t> proxies;
+	for (uint32_t i = 0; i < 1000; ++i)
+	{
+		boxes.push_back(random.Box());
+		proxies.push_back(tree.Insert(i, boxes.back()));
+	}
+	// Half of proxies move, small part of them leaves fattened bounds
+	for (uint32_t i = 0; i < boxes.size(); i += 2)
+	{
+		const glm::vec3 displacement = (glm::vec3(random.Next(), random.Next(), random.Next()) - 0.5f) * (i % 10 == 0 ? 10.0f : 0.1f);
+		boxes[i] = Translated(boxes[i], displacement);
+		tree.Move(proxies[i], boxes[i], displacement);
+	}
+	for (uint32_t i = 1; i < boxes.size(); i += 4)
+		tree.Remove(proxies[i]);
+
+	for (uint32_t q = 0; q < 100; ++q)
+	{
+		const AABB query = random.Box();
+		std::set<uint32_t> found;
+		tree.Query(query, [&](int32_t proxy) {
+			found.insert(tree.GetDataIndex(proxy));
+			return true;
+		});
+		// Tree may report extra proxies because of fattened bounds, never miss one
+		for (uint32_t i = 0; i < boxes.size(); ++i)
+		{
+			const bool removed = i % 4 == 1;
+			if (removed)
+			{
+				XYZ_CHECK(found.count(i) == 0);
+				continue;
+			}
+			XYZ_CHECK(tree.GetAABB(proxies[i]).Contains(boxes[i]));
+			if (boxes[i].Intersect(query))
+				XYZ_CHECK(found.count(i) == 1);
+		}
+	}
+}
+
+XYZ_TEST(DynamicTreeFindPairsMatchesBruteForce)
+{
+	RandomBoxes random(11, 30.0f);
+	DynamicTree tree;
+	std::vector<int32_t> proxies;
+	for (uint32_t i = 0; i < 2000; ++i)
+		proxies.push_back(tree.Insert(i, random.Box()));
+	tree.CleanMovedNodes();
+
+	for (uint32_t i = 0; i < proxies.size(); i += 3)
+		tree.Move(proxies[i], glm::vec3(random.Next() * 5.0f, 0.0f, 0.0f));
+
+	std::set<std::pair<int32_t, int32_t>> expected;
+	for (const int32_t moved : tree.GetMovedNodes())
+	{
+		for (const int32_t other : proxies)
+		{
+			if (other != moved && tree.GetAABB(moved).Intersect(tree.GetAABB(other)))
+				expected.insert({ std::min(moved, other), std::max(moved, other) });
+		}
+	}
+
+	std::vector<ProxyPair> pairs;
+	tree.FindPairs(pairs);
+	XYZ_CHECK(pairs.size() == expected.size());
+	XYZ_CHECK(SortedPairs(pairs) == expected);
+
+	// Parallel mode splits moved proxies between jobs, result is the same
+	ThreadPool pool;
+	pool.Start(4);
+	tree.FindPairs(pairs, &pool);
+	pool.Stop();
+	XYZ_CHECK(pairs.size() == expected.size());
+	XYZ_CHECK(SortedPairs(pairs) == expected);
+}
+
+XYZ_BENCHMARK(DynamicTreeProxies)
+{
+	const uint32_t count = Test::IsQuick() ? 10000 : 100000;
+	const uint32_t frames = Test::IsQuick() ? 2 : 10;
+	// Density is roughly constant, every proxy overlaps a few others
+	const float worldSize = std::cbrt(static_cast<float>(count)) * 4.0f;
+
+	ThreadPool pool;
+	pool.Start(std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+	RandomBoxes random(count, worldSize);
+	std::vector<AABB> boxes(count);
+	for (AABB& box : boxes)
+		box = random.Box();
+	std::vector<glm::vec3> velocities(count);
+	for (glm::vec3& velocity : velocities)
+		velocity = (glm::vec3(random.Next(), random.Next(), random.Next()) - 0.5f) * 0.2f;
+
+	DynamicTree tree;
+	std::vector<int32_t> proxies(count);
+	{
+		Stopwatch timer;
+		for (uint32_t i = 0; i < count; ++i)
+			proxies[i] = tree.Insert(i, boxes[i]);
+		Test::Report(std::to_string(count) + " proxies, insert", count, timer.Elapsed());
+	}
+	tree.CleanMovedNodes();
+
+	std::vector<ProxyPair> pairs;
+	float moveTime = 0.0f, pairsTime = 0.0f, parallelPairsTime = 0.0f;
+	uint32_t reinserted = 0;
+	for (uint32_t frame = 0; frame < frames; ++frame)
+	{
+		Stopwatch moveTimer;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			boxes[i] = Translated(boxes[i], velocities[i]);
+			reinserted += tree.Move(proxies[i], boxes[i], velocities[i]);
+		}
+		moveTime += moveTimer.Elapsed();
+
+		Stopwatch pairsTimer;
+		tree.FindPairs(pairs);
+		pairsTime += pairsTimer.Elapsed();
+
+		Stopwatch parallelPairsTimer;
+		tree.FindPairs(pairs, &pool);
+		parallelPairsTime += parallelPairsTimer.Elapsed();
+		tree.CleanMovedNodes();
+	}
+	const uint64_t operations = static_cast<uint64_t>(count) * frames;
+	Test::Report(std::to_string(count) + " proxies, move (" + std::to_string(reinserted) + " reinserted)", operations, moveTime);
+	Test::Report(std::to_string(count) + " proxies, find pairs of moved", frames, pairsTime);
+	Test::Report(std::to_string(count) + " proxies, find pairs of moved, parallel", frames, parallelPairsTime);
+
+	uint64_t found = 0;
+	Stopwatch queryTimer;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		tree.Query(boxes[i], [&found](int32_t) {
+			found++;
+			return true;
+		});
+	}
+	Test::Report(std::to_string(count) + " proxies, query", count, queryTimer.Elapsed());
+	XYZ_CHECK(found >= count);
+
+	std::vector<ProxyPair> result;
+	Stopwatch batchTimer;
+	tree.QueryBatch(boxes, result, &pool);
+	Test::Report(std::to_string(count) + " proxies, parallel batch query", count, batchTimer.Elapsed());
+	XYZ_CHECK(result.size() == found);
+	pool.Stop();
+}
@@ -0,0 +1,158 @@
+#include "Test.h"
+
+#include "XYZ/Utils/DataStructures/SlabAllocator.h"
+#include "XYZ/Utils/DataStructures/MemoryPool.h"
+#include "XYZ/Asset/AssetAllocator.h"
+#include "XYZ/Debug/Timer.h"
+
+#include <cstdlib>
+#include <set>
+#include <thread>
+
+using namespace XYZ;
+
+namespace {
+	class TestAsset : public Asset
+	{
+	public:
+		virtual AssetType GetAssetType() const override { return AssetType::None; }
+
+		uint8_t Data[200]{};
+	};
+
+	struct SlabAlloc
+	{
+		void* Allocate(uint32_t size) { return Allocator.Allocate(size); }
+		void  Deallocate(void* val) { Allocator.Deallocate(val); }
+
+		SlabAllocator Allocator;
+	};
+
+	struct PoolAlloc
+	{
+		void* Allocate(uint32_t size) { return Pool.Allocate(size); }
+		void  Deallocate(void* val) { Pool.Deallocate(val); }
+
+		MemoryPool Pool{ 1024 * 1024 };
+	};
+
+	struct MallocAlloc
+	{
+		void* Allocate(uint32_t size) { return std::malloc(size); }
+		void  Deallocate(void* val) { std::free(val); }
+	};
+}
+
+// Allocates batch and frees it in same order, allocator reuses memory of previous round
+template <typename Allocator>
+static float BatchRounds(Allocator& allocator, uint32_t size, uint32_t batch, uint32_t rounds)
+{
+	std::vector<void*> blocks(batch);
+	Stopwatch timer;
+	for (uint32_t round = 0; round < rounds; ++round)
+	{
+		for (void*& block : blocks)
+			block = allocator.Allocate(size);
+		for (void* block : blocks)
+			allocator.Deallocate(block);
+	}
+	return timer.Elapsed();
+}
+
+// Every operation frees random slot and allocates it again, so free order is random
+template <typename Allocator>
+static float RandomChurn(Allocator& allocator, uint32_t size, uint32_t operations)
+{
+	std::vector<void*> slots(1024);
+	for (void*& slot : slots)
+		slot = allocator.Allocate(size);
+
+	uint32_t seed = size;
+	Stopwatch timer;
+	for (uint32_t i = 0; i < operations; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		void*& slot = slots[(seed >> 8) % slots.size()];
+		allocator.Deallocate(slot);
+		slot = allocator.Allocate(size);
+	}
+	const float elapsed = timer.Elapsed();
+	for (void* slot : slots)
+		allocator.Deallocate(slot);
+	return elapsed;
+}
+
+XYZ_TEST(SlabAllocatorReturnsDistinctAlignedBlocks)
+{
+	SlabAllocator allocator;
+	std::set<uintptr_t> addresses;
+	std::vector<void*> blocks;
+	for (uint32_t i = 0; i < 5000; ++i)
+	{
+		const uint32_t size = 1 + (i * 37) % 2048;
+		void* block = allocator.Allocate(size);
+		XYZ_CHECK(reinterpret_cast<uintptr_t>(block) % 16 == 0);
+		XYZ_CHECK(addresses.insert(reinterpret_cast<uintptr_t>(block)).second);
+		memset(block, 0xAB, size);
+		blocks.push_back(block);
+	}
+	XYZ_CHECK(allocator.GetNumAllocations() == blocks.size());
+
+	// Big allocation gets dedicated slab
+	void* large = allocator.Allocate(SlabAllocator::sc_MaxSmallSize * 4);
+	memset(large, 0xCD, SlabAllocator::sc_MaxSmallSize * 4);
+	allocator.Deallocate(large);
+
+	// Blocks freed by other thread return to slabs
+	std::thread([&]() {
+		for (size_t i = 0; i < blocks.size(); i += 2)
+			allocator.Deallocate(blocks[i]);
+	}).join();
+	for (size_t i = 1; i < blocks.size(); i += 2)
+		allocator.Deallocate(blocks[i]);
+
+	XYZ_CHECK(allocator.GetNumAllocations() == 0);
+	XYZ_CHECK(allocator.GetMemoryUsed() == 0);
+}
+
+XYZ_TEST(AssetIsAllocatedByAssetAllocator)
+{
+	SlabAllocator& allocator = AssetAllocator::GetAllocator();
+	const uint32_t allocations = allocator.GetNumAllocations();
+	{
+		Ref<TestAsset> asset = Ref<TestAsset>::Create();
+		XYZ_CHECK(allocator.GetNumAllocations() == allocations + 1);
+		XYZ_CHECK(reinterpret_cast<uintptr_t>(asset.Raw()) % 16 == 0);
+	}
+	XYZ_CHECK(allocator.GetNumAllocations() == allocations);
+}
+
+XYZ_BENCHMARK(SlabAllocatorAllocFree)
+{
+	const uint32_t batch = 1000;
+	const uint32_t rounds = Test::IsQuick() ? 10 : 1000;
+	const uint32_t operations = Test::IsQuick() ? 10000 : 1000000;
+
+	for (const uint32_t size : { 32u, 256u, 2048u })
+	{
+		const std::string name = std::to_string(size) + " bytes, ";
+		const uint64_t batchOps = static_cast<uint64_t>(batch) * rounds * 2;
+		{
+			SlabAlloc slab;
+			Test::Report(name + "batch, slab allocator", batchOps, BatchRounds(slab, size, batch, rounds));
+			Test::Report(name + "random churn, slab allocator", static_cast<uint64_t>(operations) * 2, RandomChurn(slab, size, operations));
+			XYZ_CHECK(slab.Allocator.GetNumAllocations() == 0);
+		}
+		{
+			PoolAlloc pool;
+			Test::Report(name + "batch, memory pool", batchOps, BatchRounds(pool, size, batch, rounds));
+			Test::Report(name + "random churn, memory pool", static_cast<uint64_t>(operations) * 2, RandomChurn(pool, size, operations));
+			XYZ_CHECK(pool.Pool.GetNumAllocations() == 0);
+		}
+		{
+			MallocAlloc heap;
+			Test::Report(name + "batch, malloc", batchOps, BatchRounds(heap, size, batch, rounds));
+			Test::Report(name + "random churn, malloc", static_cast<uint64_t>(operations) * 2, RandomChurn(heap, size, operations));
+		}
+	}
+}